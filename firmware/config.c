@@ -69,6 +69,16 @@ volatile __code __at(CONFIG_ADDRESS) config_t config = {
       {0x01, 0x06, 5}, // NAV-SOL: approximately 1 Hz
     },},
   },
+  { // data_hub
+    2,      // segments : double buffer
+    1,      // flush_watermark : write each segment as soon as it is filled
+    1,      // status_interval : 1 sec
+    4,      // cdc_pages : 128 bytes per packet
+  },
+  { // inertial_fifo
+    FALSE,  // burst : A page
+    4,      // sampling_div : 200 Hz in burst mode
+  },
 };
 
 // temporary buffer for renewal at the same address of USB FIFO EP3
@@ -59,6 +59,16 @@ typedef struct {
       ubx_cfg_t item[4];
     } g_page;
   } telemetry_truncate;
+  struct {
+    u8 segments; // number of segments in the log buffer, power of 2 (2-32)
+    u8 flush_watermark; // number of filled segments to start writing to the SD card
+    u8 status_interval; // interval of S page in seconds, 0 disables it
+    u8 cdc_pages; // pages packed in a packet to USB CDC, 1 (fixed length) or power of 2 (2-16)
+  } data_hub;
+  struct {
+    u8 burst; // TRUE: samples in FIFO are burst-read and packed into I page, FALSE: A page per sample at 100 Hz
+    u8 sampling_div; // SMPLRT_DIV of MPU-9250 in burst mode, sampling rate is 1 kHz / (1 + sampling_div) (0-63)
+  } inertial_fifo;
 } config_t;
 
 #define CONFIG_ADDRESS 0xF800
@@ -55,21 +55,52 @@ static void packet_init(
   p->buf_end = p->current + max_size;
 }
 
-#define BUFFER_SIZE (SYLPHIDE_PAGESIZE * 16 * 2) // "*2" means double buffer
-#define PAGES (BUFFER_SIZE / SYLPHIDE_PAGESIZE)
+#define BUFFER_SIZE (SYLPHIDE_PAGESIZE * DATA_HUB_BUFFER_PAGES) // ring of segments
+#define PAGES DATA_HUB_BUFFER_PAGES
 
 static payload_t payload_buf[BUFFER_SIZE];
 
 static payload_t * __xdata free_page;
 static payload_t * __xdata locked_page;
 
+/*
+ * S page design (status of data_hub) =>
+ * 'S', segments, flush_watermark, tickcount & 0xFF, // + 4
+ * global_ms(4 bytes), // + 8
+ * accepted(4 bytes), // + 12; number of pages stored in the buffer
+ * refused(4 bytes), // + 16; number of page requests refused due to full buffer
+ * lost(4 bytes), // + 20; number of pages not accepted by the SD card or USB
+ * high_water(1 byte), pages(1 byte), // + 22; maximum used pages since previous S page, and buffer size
+ * max_flush_ms(2 bytes), // + 24; maximum blocking time of writing since previous S page
+ * reserved(8 bytes) // + 32
+ * Counters are little endian and accumulated since power up.
+ * Producers having their own FIFO (G page) retry refused requests,
+ * therefore refused is not always equal to the number of lost samples.
+ */
+static __xdata struct {
+  u32 accepted, refused, lost;
+  u8 high_water;
+  u16 max_flush_ms;
+} status;
+
+static __xdata u8 flush_watermark;
+
+static u8 used_pages(){
+  return (u8)(((free_page >= locked_page)
+      ? (free_page - locked_page)
+      : (free_page + BUFFER_SIZE - locked_page)) / SYLPHIDE_PAGESIZE);
+}
+
 payload_size_t data_hub_assign_page(void (* packet_maker)(packet_t *)){
   payload_t *next_free_page = free_page + SYLPHIDE_PAGESIZE;
   if(next_free_page >= (payload_buf + sizeof(payload_buf))){
     next_free_page -= sizeof(payload_buf);
   }
   
-  if(next_free_page == locked_page){return 0;}
+  if(next_free_page == locked_page){
+    status.refused++;
+    return 0;
+  }
   
   packet_init(&packet, free_page, SYLPHIDE_PAGESIZE);
   packet_maker(&packet);
@@ -78,6 +109,11 @@ payload_size_t data_hub_assign_page(void (* packet_maker)(packet_t *)){
   }
 
   free_page = next_free_page;
+  status.accepted++;
+  {
+    u8 used = used_pages();
+    if(used > status.high_water){status.high_water = used;}
+  }
 
   do{
 #define whether_send_telemetry(page, frequency) \
@@ -87,6 +123,7 @@ if(*packet.buf_begin == page){ \
   count = 0; \
 }
     whether_send_telemetry('A', config.telemetry_truncate.a_page) // 'A' page : approximately 5 Hz
+    else whether_send_telemetry('I', config.telemetry_truncate.a_page) // 'I' page : the same truncation as 'A'
     else whether_send_telemetry('P', config.telemetry_truncate.p_page) // 'P' page : approximately 1 Hz
     else whether_send_telemetry('M', config.telemetry_truncate.m_page) // 'M' page : approximately 1 Hz
     else break;
@@ -164,7 +201,37 @@ void data_hub_load_config(char *fname, void (*load_func)(FIL *file)){
 }
 
 static __bit log_file_opened;
-static __xdata u16 log_block_size; // Must be multiple number of SYLPHIDE_PAGESIZE
+static __xdata u16 log_block_size; // Segment size, which must be BUFFER_SIZE / (power of 2)
+
+/**
+ * Divide the log buffer into segments in accordance with config.data_hub.
+ * Invalid settings fall back to double buffer.
+ */
+static void setup_segments(){
+  u8 segments = config.data_hub.segments;
+  if((segments < 2) || (segments > PAGES) || (segments & (segments - 1))){
+    segments = 2;
+  }
+  log_block_size = BUFFER_SIZE / segments;
+  flush_watermark = config.data_hub.flush_watermark;
+  if(flush_watermark < 1){
+    flush_watermark = 1;
+  }else if(flush_watermark >= segments){
+    flush_watermark = segments - 1; // at least one segment must be writable
+  }
+}
+
+/**
+ * Segment size for USB CDC in accordance with config.data_hub.cdc_pages.
+ * Invalid settings fall back to one page, i.e., fixed length packet.
+ */
+static u16 host_block_size(){
+  u8 pages = config.data_hub.cdc_pages;
+  if((pages < 1) || (pages > (PAGES / 2)) || (pages & (pages - 1))){
+    pages = 1;
+  }
+  return (u16)pages * SYLPHIDE_PAGESIZE;
+}
 
 
 #if USE_DIRECT_CONNECTION
@@ -220,6 +287,7 @@ void data_hub_init(){
   log_file_opened = FALSE;
   free_page = locked_page = payload_buf;
   log_block_size = SYLPHIDE_PAGESIZE;
+  flush_watermark = 1;
 
   disk_initialize(0);
 
@@ -236,6 +304,37 @@ static __xdata s16 log_file_suffix = -1;
 
 static u8 open_file();
 
+#if _USE_EXPAND
+static __xdata u32 log_file_allocated;
+
+static void preallocate_file(){
+  if(file.fsize + (LOG_DAT_PREALLOCATION_SIZE / 2) < log_file_allocated){return;}
+  // failure (no contiguous free area) is harmless; clusters are allocated one by one as usual.
+  f_expand(&file, LOG_DAT_PREALLOCATION_SIZE);
+  log_file_allocated = file.fsize + LOG_DAT_PREALLOCATION_SIZE;
+}
+
+/**
+ * Release clusters linked beyond the end of the opened file,
+ * which preallocate_file() leaves when the power is lost before close_file().
+ * The file pointer is moved to the end of the file.
+ */
+static void release_preallocated(){
+  f_lseek(&file, file.fsize);
+  f_expand(&file, 0);
+}
+#else
+#define preallocate_file()
+#define release_preallocated() f_lseek(&file, file.fsize)
+#endif
+
+static void close_file(){
+#if _USE_EXPAND
+  f_expand(&file, 0); // release preallocated clusters
+#endif
+  f_close(&file); // internally f_sync(&file) is invoked
+}
+
 static u16 log_to_file(){
   u16 accepted_bytes;
   
@@ -243,15 +342,17 @@ static u16 log_to_file(){
     locked_page,
     log_block_size, &accepted_bytes);
   {
-    static __xdata u8 loop = 0;
-    if((++loop) == 64){
+    static __xdata u16 loop = 0; // in pages
+    loop += (log_block_size / SYLPHIDE_PAGESIZE);
+    if(loop >= (0x8000 / SYLPHIDE_PAGESIZE)){ // every 32KB, independent of segment size
       loop = 0;
 
       if(file.fsize < MAXIMUM_LOG_DAT_FILE_SIZE){
+        preallocate_file();
         f_sync(&file);
       }else{
         // close current log file when its size exceeds predefined bytes
-        f_close(&file); // internally f_sync(&file) is invoked
+        close_file();
         log_file_suffix++;
         if(!open_file()){ // try to open another file
           log_file_opened = FALSE;
@@ -265,12 +366,36 @@ static u16 log_to_file(){
 
 const u8 sylphide_protocol_header[2] = {0xF7, 0xE0};
 
+/**
+ * Send a segment to host as a Sylphide packet.
+ * A segment of one page is sent as a fixed length (32 bytes) packet,
+ * and a larger one is sent as a variable length packet consisting of the pages.
+ * The header, sequence number, and size are passed to cdc_tx() at once,
+ * which packs the stream into full 64 bytes packets of the bulk endpoint.
+ */
 static u16 log_to_host(){
   static __xdata u16 sequence_num = 0;
-  u16 crc = crc16(locked_page, log_block_size, 
-      crc16((u8 *)&(++sequence_num), sizeof(sequence_num), 0));
-  if(!(cdc_tx(sylphide_protocol_header, sizeof(sylphide_protocol_header))
-      && cdc_tx((u8 *)&sequence_num, sizeof(sequence_num))
+  static __xdata u8 head[6]; // header, sequence number, and size (variable length only)
+  u8 head_size = 4;
+  u16 crc;
+  u16 i;
+  
+  head[0] = sylphide_protocol_header[0];
+  head[1] = sylphide_protocol_header[1];
+  ++sequence_num;
+  memcpy(&head[2], &sequence_num, sizeof(sequence_num));
+  if(log_block_size > SYLPHIDE_PAGESIZE){
+    head[1] |= 0x01; // variable length payload
+    memcpy(&head[4], &log_block_size, sizeof(log_block_size));
+    head_size += sizeof(log_block_size);
+  }
+  
+  crc = crc16(&head[2], head_size - 2, 0);
+  for(i = 0; i < log_block_size; i += SYLPHIDE_PAGESIZE){ // crc16() accepts up to 255 bytes
+    crc = crc16(locked_page + i, SYLPHIDE_PAGESIZE, crc);
+  }
+  
+  if(!(cdc_tx(head, head_size)
       && (cdc_tx(locked_page, log_block_size) == log_block_size)
       && cdc_tx((u8 *)&crc, sizeof(crc)))){
     return 0;
@@ -278,6 +403,14 @@ static u16 log_to_host(){
   return log_block_size;
 }
 
+static void set_log_suffix(char *fname, u16 num){
+  u8 i;
+  for(i = 6; i >= 4; i--){
+    fname[i] = '0' + (num % 10);
+    num /= 10;
+  } // Generate file name such as log.000
+}
+
 static u8 open_file(){
   char fname[] = "log.dat";
 
@@ -290,21 +423,25 @@ static u8 open_file(){
       f_lseek(&file, file.fsize);
       f_write(&file, "*", 1, &num); // Add 1 byte to log.inc
       f_close(&file);
+#if _USE_EXPAND
+      // the log file of the previous session may not have been closed.
+      set_log_suffix(fname, (log_file_suffix > 0) ? (log_file_suffix - 1) : 999);
+      if(f_open(&file, fname, (FA_OPEN_EXISTING | FA_WRITE)) == FR_OK){
+        release_preallocated();
+        f_close(&file);
+      }
+#endif
     }
 #endif
 
     if(log_file_suffix >= 0){
-      u8 i;
-      num = log_file_suffix;
-      for(i = 6; i >= 4; i--){
-        fname[i] = '0' + (num % 10);
-        num /= 10;
-      } // Generate file name such as log.000
+      set_log_suffix(fname, log_file_suffix);
     }
 
     if(f_open(&file, fname, (FA_OPEN_ALWAYS | FA_WRITE)) != FR_OK){
       return FALSE;
     }
+    release_preallocated(); // for an existing file, to which log is appended
 
     // file size check; up to bytes defined by MAXIMUM_LOG_DAT_FILE_SIZE
     if(file.fsize < MAXIMUM_LOG_DAT_FILE_SIZE){break;}
@@ -312,14 +449,55 @@ static u8 open_file(){
     log_file_suffix++;
   }
 
-  f_lseek(&file, file.fsize);
+#if _USE_EXPAND
+  log_file_allocated = 0;
+  preallocate_file();
+#endif
   return TRUE;
 }
 
+static __bit status_due = FALSE;
+static __xdata u32 status_next_ms = 0;
+
+static void make_status_packet(packet_t *packet){
+  payload_t *dst = packet->current;
+  
+  *(dst++) = 'S';
+  *(dst++) = (u8)(BUFFER_SIZE / log_block_size);
+  *(dst++) = flush_watermark;
+  *(dst++) = u32_lsbyte(tickcount);
+  
+  // Record time and counters, LSB first
+  memcpy(dst, &global_ms, sizeof(global_ms));
+  dst += sizeof(global_ms);
+  memcpy(dst, &status.accepted, sizeof(status.accepted));
+  dst += sizeof(status.accepted);
+  memcpy(dst, &status.refused, sizeof(status.refused));
+  dst += sizeof(status.refused);
+  memcpy(dst, &status.lost, sizeof(status.lost));
+  dst += sizeof(status.lost);
+  *(dst++) = status.high_water;
+  *(dst++) = PAGES;
+  memcpy(dst, &status.max_flush_ms, sizeof(status.max_flush_ms));
+  dst += sizeof(status.max_flush_ms);
+  memset(dst, 0, packet->buf_end - dst);
+  
+  status.high_water = 0;
+  status.max_flush_ms = 0;
+  
+  packet->current = packet->buf_end;
+}
+
 void data_hub_polling() {
   
   __code u16 (* log_func)() = NULL;
   
+  if(config.data_hub.status_interval
+      && ((s32)(global_ms - status_next_ms) >= 0)){
+    status_next_ms = global_ms + (u32)config.data_hub.status_interval * 1000;
+    status_due = TRUE;
+  }
+  
   switch(usb_mode){
     case USB_INACTIVE:
     case USB_CABLE_CONNECTED:
@@ -327,15 +505,16 @@ void data_hub_polling() {
         if(f_mount(0, &fs) != FR_OK){break;}
         if(!open_file()){break;}
         log_file_opened = TRUE;
-        log_block_size = BUFFER_SIZE / 2;
+        setup_segments();
         free_page = locked_page = payload_buf;
         return;
       }
       log_func = log_to_file;
       break;
     case USB_CDC_ACTIVE:
-      if(log_block_size != SYLPHIDE_PAGESIZE){
-        log_block_size = SYLPHIDE_PAGESIZE;
+      if((log_block_size != host_block_size()) || (flush_watermark != 1)){
+        log_block_size = host_block_size();
+        flush_watermark = 1;
         free_page = locked_page = payload_buf;
         return;
       }
@@ -349,33 +528,45 @@ void data_hub_polling() {
     case USB_MSC_ACTIVE:
       if(log_file_opened){
         log_file_opened = FALSE;
-        f_close(&file);
+        close_file();
         f_mount(0, NULL);
       }
       break;
   }
     
-  // Dump when the data size exceeds predefined boundary.
-  while(TRUE){
-    payload_t * next_locked_page = locked_page + log_block_size;
-    if(next_locked_page >= (payload_buf + sizeof(payload_buf))){
-      next_locked_page -= sizeof(payload_buf);
-    }
-    
-    if((next_locked_page > locked_page) 
-        ? ((free_page >= locked_page) && (free_page < next_locked_page))
-        : !((free_page >= next_locked_page) && (free_page < locked_page))){
-      break;
+  if(status_due){
+    // Retried until accepted, or discarded when not logged.
+    if((!log_func) || data_hub_assign_page(make_status_packet)){
+      status_due = FALSE;
     }
-    
-    if(log_func){
-      if(log_func()){
-        __critical {
-          sys_state |= SYS_LOG_ACTIVE;
+  }
+  
+  // Dump filled segments when their number reaches the watermark.
+  {
+    u8 segments = used_pages() / (u8)(log_block_size / SYLPHIDE_PAGESIZE);
+    if(segments < flush_watermark){return;}
+    for(; segments > 0; segments--){
+      payload_t * next_locked_page = locked_page + log_block_size;
+      if(next_locked_page >= (payload_buf + sizeof(payload_buf))){
+        next_locked_page -= sizeof(payload_buf);
+      }
+      
+      if(log_func){
+        u32 t = global_ms;
+        u16 accepted = log_func();
+        if(accepted){
+          __critical {
+            sys_state |= SYS_LOG_ACTIVE;
+          }
+        }
+        status.lost += (log_block_size - accepted) / SYLPHIDE_PAGESIZE;
+        t = global_ms - t;
+        if(t > status.max_flush_ms){
+          status.max_flush_ms = (t > 0xFFFF) ? 0xFFFF : (u16)t;
         }
       }
+      
+      locked_page = next_locked_page;
     }
-    
-    locked_page = next_locked_page;
   }
 }
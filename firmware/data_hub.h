@@ -48,11 +48,34 @@ typedef struct{
 
 extern const u8 sylphide_protocol_header[2];
 
+/* Number of pages in the log buffer, which is a ring divided into
+ * config.data_hub.segments segments. Each filled segment is written at once,
+ * and writing starts when config.data_hub.flush_watermark segments are filled.
+ * It must be a power of 2, and 32 pages (1KB) consume half of XRAM.
+ */
+#ifndef DATA_HUB_BUFFER_PAGES
+#define DATA_HUB_BUFFER_PAGES 32
+#endif
+
 /* Maximum log size in bytes per a file
  * For example, (1UL << 30) means log increases up to 1GB
  */
 #define MAXIMUM_LOG_DAT_FILE_SIZE (1UL << 30)
 
+/* Preallocation size in bytes for a log file
+ * Contiguous clusters of this size are linked beyond the end of the log file
+ * (when _USE_EXPAND of ffconf.h is enabled), and topped up when half of them are consumed.
+ * Then, log is written to consecutive sectors without FAT update per cluster,
+ * which lets the SD card keep a multi-block write (CMD25).
+ * Unused clusters are released when the log file is closed.
+ * When the power is lost before closing, they remain linked beyond the file size,
+ * and are released when the file is opened at the next mount.
+ * The size is kept small in order to limit such clusters.
+ */
+#ifndef LOG_DAT_PREALLOCATION_SIZE
+#define LOG_DAT_PREALLOCATION_SIZE (1UL << 18)
+#endif
+
 /* Incremental log file name policy
  * The "incremental" means log.NNN (N is digit).
  * '1' uses "log.inc" file to assign NNN with "log.inc" file size.
@@ -47,7 +47,7 @@ DSTATUS disk_status (BYTE drive){
 
 DRESULT disk_read (BYTE drive, BYTE *buf, DWORD start_sector, BYTE sectors){
   if(drive != 0){return RES_NOTRDY;}
-  while(sectors--){
+  for(; sectors--; start_sector++, buf += MMC_PHYSICAL_BLOCK_SIZE){
     if(mmc_read(start_sector, buf) != MMC_NORMAL){
       mmc_get_status();
       return RES_ERROR;
@@ -82,7 +82,8 @@ DRESULT disk_ioctl (BYTE drive, BYTE ctrl, void *buff){
 
 DRESULT disk_write (BYTE drive, const BYTE *buf, DWORD start_sector, BYTE sectors){
   if(drive != 0){return STA_NODISK;}
-  while(sectors--){
+  // Consecutive sectors are streamed with multiple block write in mmc_write().
+  for(; sectors--; start_sector++, buf += MMC_PHYSICAL_BLOCK_SIZE){
     if(mmc_write(start_sector, buf) != MMC_NORMAL){
       mmc_get_status();
       return RES_ERROR;
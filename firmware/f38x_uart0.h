@@ -54,8 +54,10 @@ void interrupt_uart0() __interrupt (INTERRUPT_UART0);
 
 #define uart0_tx_active() (TB80 == 1)
 
+#if (defined(__SDCC) || defined(SDCC))
 // For stdio.h
 char getchar();
 void putchar(char c);
+#endif
 
 #endif
@@ -2706,6 +2706,116 @@ FRESULT f_sync (
 	LEAVE_FF(fp->fs, res);
 }
 
+
+
+
+#if _USE_EXPAND
+/*-----------------------------------------------------------------------*/
+/* Preallocate Contiguous Clusters to the File                           */
+/*-----------------------------------------------------------------------*/
+/* Free clusters are linked to the end of the cluster chain without changing
+/  the file size, so that the following f_write() streams data to consecutive
+/  sectors without searching and updating FAT. The file pointer must be at
+/  the end of the file. fsz = 0 releases the clusters beyond the file size,
+/  which should be done before f_close(). */
+
+FRESULT f_expand (
+	FIL *fp,		/* Pointer to the file object */
+	DWORD fsz		/* Number of bytes to be preallocated beyond the file size, 0:Release */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD bcs, lcl, ecl, scl, ncl, cs, n, cnt, left;
+
+
+	res = validate(fp);						/* Check validity */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->flag & FA__ERROR)				/* Aborted file? */
+		LEAVE_FF(fp->fs, FR_INT_ERR);
+	if (!(fp->flag & FA_WRITE) || fp->fptr != fp->fsize)	/* Check access mode and pointer */
+		LEAVE_FF(fp->fs, FR_DENIED);
+	fs = fp->fs;
+	bcs = (DWORD)fs->csize * SS(fs);		/* Cluster size [byte] */
+	lcl = fp->fsize ? fp->clust : 0;		/* Last cluster holding data, 0:None */
+
+	if (!fsz) {								/* Release clusters beyond the file size */
+		ncl = lcl ? get_fat(fs, lcl) : fp->sclust;
+		if (ncl == 1) LEAVE_FF(fs, FR_INT_ERR);
+		if (ncl == 0xFFFFFFFF) LEAVE_FF(fs, FR_DISK_ERR);
+		if (ncl >= 2 && ncl < fs->n_fatent) {
+			res = remove_chain(fs, ncl);
+			if (res == FR_OK) {
+				if (lcl) {
+					res = put_fat(fs, lcl, 0x0FFFFFFF);
+				} else {
+					fp->sclust = 0;
+					fp->flag |= FA__WRITTEN;	/* Directory entry will be updated */
+				}
+			}
+		}
+		LEAVE_FF(fs, res);
+	}
+
+	n = (fsz + bcs - 1) / bcs;				/* Number of clusters required */
+	ecl = lcl;								/* Find the end of the chain */
+	cs = lcl ? get_fat(fs, lcl) : fp->sclust;
+	while (cs >= 2 && cs < fs->n_fatent) {	/* Skip already preallocated clusters */
+		if (n) n--;
+		ecl = cs;
+		cs = get_fat(fs, cs);
+	}
+	if (cs == 1) LEAVE_FF(fs, FR_INT_ERR);
+	if (cs == 0xFFFFFFFF) LEAVE_FF(fs, FR_DISK_ERR);
+	if (!n) LEAVE_FF(fs, FR_OK);
+
+	/* Search n contiguous free clusters, preferably just after the chain */
+	scl = ncl = ecl ? ecl : fs->last_clust;
+	if (ncl < 2 || ncl >= fs->n_fatent) scl = ncl = 1;
+	cnt = 0;
+	left = fs->n_fatent - 2;
+	for (;;) {
+		ncl++;
+		if (ncl >= fs->n_fatent) {			/* Wrap around; a run can not continue */
+			ncl = 2;
+			cnt = 0;
+		}
+		if (!left--) LEAVE_FF(fs, FR_DENIED);	/* No contiguous area */
+		cs = get_fat(fs, ncl);
+		if (cs == 1) LEAVE_FF(fs, FR_INT_ERR);
+		if (cs == 0xFFFFFFFF) LEAVE_FF(fs, FR_DISK_ERR);
+		if (cs) {
+			cnt = 0;
+			continue;
+		}
+		if (!cnt) scl = ncl;				/* Top of a run */
+		if (++cnt == n) break;
+	}
+
+	/* Link the run to the chain */
+	for (ncl = scl; res == FR_OK && ncl < scl + n; ncl++) {
+		res = put_fat(fs, ncl, (ncl + 1 < scl + n) ? ncl + 1 : 0x0FFFFFFF);
+	}
+	if (res == FR_OK) {
+		if (ecl) {
+			res = put_fat(fs, ecl, scl);
+		} else {
+			fp->sclust = scl;
+			fp->flag |= FA__WRITTEN;		/* Directory entry will be updated */
+		}
+	}
+	if (res == FR_OK) {
+		fs->last_clust = scl + n - 1;		/* Update FSINFO */
+		if (fs->free_clust != 0xFFFFFFFF) {
+			fs->free_clust -= n;
+			fs->fsi_flag = 1;
+		}
+	}
+
+	LEAVE_FF(fs, res);
+}
+#endif /* _USE_EXPAND */
+
 #endif /* !_FS_READONLY */
 
 
@@ -92,6 +92,13 @@
 /* To enable f_forward function, set _USE_FORWARD to 1 and set _FS_TINY to 1. */
 
 
+#if !defined(_USE_EXPAND)
+#define	_USE_EXPAND		1	/* 0:Disable or 1:Enable */
+#endif
+/* To enable f_expand function, which preallocates contiguous clusters to a file,
+/  set _USE_EXPAND to 1 and set _FS_READONLY to 0. */
+
+
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
 /----------------------------------------------------------------------------*/
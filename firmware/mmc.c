@@ -96,6 +96,7 @@ __code command_t command_list[] = {
     {58, CMD, R3},  // CMD58; READ_OCR: read OCR register;
     {59, CMD, R1},  // CMD59; CRC_ON_OFF: toggles CRC checking; arg required;
     { 8, CMD, R7},  // CMD8;  SEND_IF_COND: Sends SD Memory Card interface condition; arg required;
+    {23, CMD, R1},  // For ACMD23; SET_WR_BLK_ERASE_COUNT: pre-erase before multiple block write; arg required;
   };
 
 // Command Table Index Constants:
@@ -131,6 +132,7 @@ enum {
   READ_OCR,
   CRC_ON_OFF,
   SEND_IF_COND,
+  SET_WR_BLK_ERASE_COUNT,
 };
 
 // MMC block length;  Set during initialization;
@@ -143,6 +145,17 @@ __bit mmc_initialized = FALSE;
 static __bit require_busy_check = FALSE;
 static __bit block_addressing = 0;
 static __bit sdhc = 0;
+static __bit sd_card = 0;
+
+/*
+ * Sequential writes are automatically streamed with WRITE_MULTIPLE_BLOCK,
+ * which is terminated by any other command or mmc_flush().
+ */
+static __bit multi_writing = FALSE;
+static __xdata unsigned long next_write_address = 0xFFFFFFFF;
+
+// Number of blocks pre-erased by ACMD23 when multiple block write starts
+#define MMC_PRE_ERASE_BLOCKS 64
 
 #define select_MMC() spi_assert_cs()
 #define deselect_MMC() spi_deassert_cs()
@@ -165,19 +178,83 @@ static __bit sdhc = 0;
   spi_send_8clock(); \
 }
 
+/*
+ * wait for end of busy signal;
+ * 
+ * Start SPI transfer to receive busy tokens;
+ * When a non-zero Token is returned,
+ * card is no longer busy;
+ */
+#define wait_busy() { \
+  if(require_busy_check){ \
+    require_busy_check = FALSE; \
+    while(spi_write_read_byte(0xFF) == 0x00); \
+  } \
+}
+
+/**
+ * Send a data block following a start token,
+ * and check its data response.
+ * The card may be busy after return, which is marked with require_busy_check.
+ * 
+ * @param token start token, START_SBW or START_MBW
+ * @param pchar data
+ * @param length length of data
+ * @return MMC_NORMAL when the data is accepted
+ */
+static mmc_res_t send_block(
+    unsigned char token,
+    unsigned char *pchar,
+    unsigned short length){
+  
+  /*
+   * Start by sending 8 SPI clocks so the MMC can prepare for the write;
+   */
+  spi_send_8clock();
+  spi_write_read_byte(token);
+  
+  spi_write(pchar, length);
+  
+  // Write CRC bytes (don't cares);
+  spi_write_read_byte(0xFF);
+  spi_write_read_byte(0xFF);
+  
+  /*
+   * Read Data Response from card;
+   * 
+   * When bit 0 of the MMC response is clear, a valid data response
+   * has been received;
+   */
+  if((spi_write_read_byte(0xFF) & DATA_RESP_MASK) != 0x05){
+    return MMC_ERROR;
+  }
+  spi_send_8clock();
+  if(spi_write_read_byte(0xFF) == 0x00){
+    require_busy_check = TRUE;
+  }
+  return MMC_NORMAL;
+}
+
+/**
+ * Terminate WRITE_MULTIPLE_BLOCK with Stop Tran token.
+ * The card becomes busy, which is checked by the next access.
+ */
+static void stop_multi_write(){
+  multi_writing = FALSE;
+  prologue();
+  wait_busy();
+  spi_send_8clock();
+  spi_write_read_byte(STOP_MBW);
+  spi_send_8clock(); // 1 byte is skipped before busy
+  require_busy_check = TRUE;
+  epilogue();
+}
+
 mmc_res_t mmc_flush() {
+  if(multi_writing){stop_multi_write();}
   if(require_busy_check){
-    require_busy_check = FALSE;
-    
     prologue();
-    /*
-     * wait for end of busy signal;
-     * 
-     * Start SPI transfer to receive busy tokens;
-     * When a non-zero Token is returned,
-     * card is no longer busy;
-     */
-    while(spi_write_read_byte(0xFF) == 0x00);
+    wait_busy();
     epilogue();
   }
   return MMC_NORMAL;
@@ -225,24 +302,16 @@ static unsigned char _issue_command(
   // Variable for storing card res;
   unsigned char res;
   
-  if(current_command == &command_list[APP_SEND_OP_CMD]){
+  if(multi_writing){stop_multi_write();}
+  
+  if((current_command == &command_list[APP_SEND_OP_CMD])
+      || (current_command == &command_list[SET_WR_BLK_ERASE_COUNT])){
     issue_command(APP_CMD, 0, NULL);
   }
   
   prologue();
   
-  if(require_busy_check){
-    require_busy_check = FALSE;
-    
-    /*
-     * wait for end of busy signal;
-     * 
-     * Start SPI transfer to receive busy tokens;
-     * When a non-zero Token is returned,
-     * card is no longer busy;
-     */
-    while(spi_write_read_byte(0xFF) == 0x00);
-  }
+  wait_busy();
   
   // Issue command opcode;
   spi_write_read_byte(current_command->command_index | 0x40);
@@ -350,35 +419,14 @@ static unsigned char _issue_command(
    */
   switch(current_command->trans_type){
     case WR: {
-      unsigned char data_res;
-      /*
-       * Write data to the MMC;
-       * Start by sending 8 SPI clocks so the MMC can prepare for the write;
-       */
-      spi_send_8clock();
-      spi_write_read_byte(START_SBW);
-      
-      spi_write(pchar, rw_block_length);
-      
-      // Write CRC bytes (don't cares);
-      spi_write_read_byte(0xFF);
-      spi_write_read_byte(0xFF);
-      
-      /*
-       * Read Data Response from card;
-       * 
-       * When bit 0 of the MMC response is clear, a valid data response
-       * has been received;
-       */
-      data_res = spi_write_read_byte(0xFF);
-      if((data_res & DATA_RESP_MASK) != 0x05){
+      if(res != MMC_NORMAL){break;}
+      // Write data to the MMC;
+      if(send_block(
+          ((current_command->command_index == 25) ? START_MBW : START_SBW),
+          pchar, rw_block_length) != MMC_NORMAL){
         epilogue();
         return MMC_ERROR;
       }
-      spi_send_8clock();
-      if(spi_write_read_byte(0xFF) == 0x00){
-        require_busy_check = TRUE;
-      }
       break;
     }
     case RD: {
@@ -464,6 +512,7 @@ void mmc_init(){
   if(issue_command(SEND_IF_COND, 0x01AA, buffer) == 1) {
     /* SDHC */
     sdhc = 1;
+    sd_card = 1;
     if((buffer[2] == 0x01) && (buffer[3] == 0xAA)){
       /* The card can work at vdd range of 2.7-3.6V */
       /* Wait for leaving idle state (ACMD41 with HCS bit) */
@@ -483,6 +532,7 @@ void mmc_init(){
     if(issue_command(APP_SEND_OP_CMD, 0, NULL) <= 1){
       /* SDSC */
       cmd = APP_SEND_OP_CMD;
+      sd_card = 1;
     }else{
       /* MMC */
       cmd = SEND_OP_COND;
@@ -582,6 +632,10 @@ mmc_res_t mmc_read(
  * doesn't require a 512-byte buffer (and it's faster too, it doesn't
  * require a read operation first). And it has a smaller ROM footprint too.
  * 
+ * When the address follows that of the previous write,
+ * WRITE_MULTIPLE_BLOCK is started (with pre-erase by ACMD23 for SD),
+ * or the block is appended to it without command overhead.
+ * 
  * @param address address of block
  * @param wdata pointer to data
  * @return card status
@@ -589,8 +643,30 @@ mmc_res_t mmc_read(
 mmc_res_t mmc_write(
     unsigned long address, 
     unsigned char *wdata){
-  return (issue_command(WRITE_BLOCK, address, wdata) == MMC_NORMAL
-      ? MMC_NORMAL : MMC_ERROR);
+  mmc_res_t res;
+  if(address != next_write_address){
+    res = (issue_command(WRITE_BLOCK, address, wdata) == MMC_NORMAL)
+        ? MMC_NORMAL : MMC_ERROR;
+  }else if(multi_writing){
+    prologue();
+    wait_busy();
+    res = send_block(START_MBW, wdata, mmc_block_length);
+    epilogue();
+  }else{
+    if(sd_card){
+      issue_command(SET_WR_BLK_ERASE_COUNT, MMC_PRE_ERASE_BLOCKS, NULL); // just a hint
+    }
+    res = (issue_command(WRITE_MULTIPLE_BLOCK, address, wdata) == MMC_NORMAL)
+        ? MMC_NORMAL : MMC_ERROR;
+    multi_writing = TRUE; // Stop Tran token is harmless even if the command is rejected
+  }
+  if(res != MMC_NORMAL){
+    if(multi_writing){stop_multi_write();}
+    next_write_address = 0xFFFFFFFF;
+  }else{
+    next_write_address = address + 1;
+  }
+  return res;
 }
 
 /**
@@ -32,6 +32,8 @@
 #ifndef __MMC_H__
 #define __MMC_H__
 
+#include "type.h"
+
 typedef enum {
   MMC_NORMAL = 0, MMC_ERROR = 0xFF,
 } mmc_res_t;
@@ -40,7 +42,7 @@ typedef enum {
 #define MMC_PHYSICAL_BLOCK_SIZE 512
 
 extern __bit mmc_initialized;
-extern __xdata unsigned int mmc_block_length;
+extern __xdata unsigned short mmc_block_length;
 extern __xdata unsigned long mmc_physical_sectors;
 
 void mmc_init();
@@ -148,6 +148,19 @@ typedef enum {
  *  P1.7(IN)  <=  MISO
  */
 
+#if !(defined(__SDCC) || defined(SDCC))
+/*
+ * Host build, for example, firmware/sim;
+ * the SPI bus is connected to a register model of MPU-9250 instead of port 1.
+ */
+void mpu9250_cs(u8 asserted);
+void mpu9250_write(u8 *buf, u8 size);
+void mpu9250_read(u8 *buf, u8 size);
+#define clk_up()
+#define cs_assert()   mpu9250_cs(TRUE)
+#define cs_deassert() mpu9250_cs(FALSE)
+#else
+
 #ifdef USE_ASM_FOR_SFR_MANIP
 #define clk_up()      {__asm orl _P1,SHARP  0x20 __endasm; }
 #define clk_down()    {__asm anl _P1,SHARP ~0x20 __endasm; }
@@ -193,6 +206,8 @@ static void mpu9250_read(u8 *buf, u8 size){
   }
 }
 
+#endif
+
 #define _mpu9250_set(address, value, attr) { \
   attr addr_value[2] = {address, value}; \
   cs_assert(); \
@@ -224,6 +239,8 @@ volatile __bit mpu9250_capture = FALSE;
 
 static __bit mpu9250_available = FALSE;
 static __bit ak8963_available = FALSE;
+static __bit fifo_burst = FALSE;
+static __xdata u8 smplrt_div = 9; // 100Hz sampling
 
 void mpu9250_init(){
   u8 v;
@@ -235,7 +252,13 @@ void mpu9250_init(){
   mpu9250_set(PWR_MGMT_1, 0x01); // Wake up device and select the best available clock
   
   mpu9250_set(USER_CTRL, 0x34); // Enable Master I2C, disable primary I2C I/F, and reset FIFO.
-  mpu9250_set(SMPLRT_DIV, 9); // SMPLRT_DIV = 9, 100Hz sampling;
+  fifo_burst = (config.inertial_fifo.burst ? TRUE : FALSE);
+  smplrt_div = 9;
+  if(fifo_burst){
+    smplrt_div = config.inertial_fifo.sampling_div;
+    if(smplrt_div > 63){smplrt_div = 63;} // I page has 6 bits for it
+  }
+  mpu9250_set2(SMPLRT_DIV, smplrt_div); // 1kHz / (1 + SMPLRT_DIV) sampling, default 100Hz
   mpu9250_set(CONFIG, (1 << 6) | (1 << 0)); // FIFO_mode = 1 (accept overflow), Use LPF, Bandwidth_gyro = 184 Hz, Bandwidth_temperature = 188 Hz,
   mpu9250_set2(GYRO_CONFIG, config.inertial.gyro_config);
   mpu9250_set2(ACCEL_CONFIG, config.inertial.accel_config);
@@ -374,6 +397,150 @@ static void make_packet_mag(packet_t *packet){
   packet->current = dst;
 }
 
+static __xdata u8 * __xdata mag_next = mag_data;
+
+/**
+ * Store AK8963 data of slave 0
+ *
+ * @param buf HXL to HZH, 6 bytes
+ * @return TRUE when M page is ready
+ */
+static u8 mag_push(u8 *buf){
+  memcpy(mag_next, buf, 6);
+  mag_next += 6;
+
+  // Rotate
+  if(mag_next >= mag_data + sizeof(mag_data)){
+    mag_next = mag_data;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+#define FIFO_RECORD_SIZE 21 // accelerometer(6), temperature(2), gyro(6), and slave 0(7)
+
+/*
+ * I page design, packing samples burst-read from FIFO =>
+ * 'I', (samples << 6) | SMPLRT_DIV, temperature(upper byte), tickcount & 0xFF, // + 4
+ * global_ms(4 bytes), at which the last sample in this page is expected, // + 8
+ * {accel_XYZ, gyro_XYZ}[0-1](big endian, 2 * 6 bytes) // + 32
+ *
+ * Samples are stored in order of time at an interval of (1 + SMPLRT_DIV) ms,
+ * and the most significant bit of each value is flipped like A page.
+ * The unused sample is filled with zero.
+ */
+static __xdata u8 fifo_records; // records remaining in the current burst read
+static __xdata u32 fifo_read_ms; // time when the burst read starts
+static __xdata u8 fifo_temperature;
+static __xdata u8 mag_elapsed_ms = 0;
+static __bit mag_ready = FALSE;
+
+/**
+ * Read a record in the current burst read transaction of FIFO
+ *
+ * @param dst destination of accelerometer and gyro values (12 bytes), NULL to discard them
+ */
+static void fifo_pop(payload_t *dst){
+  static __xdata u8 buf[FIFO_RECORD_SIZE];
+  u8 i;
+
+  mpu9250_read(buf, sizeof(buf));
+  fifo_records--;
+
+  if(dst){
+    for(i = 0; i < 6; i += 2){ // accel
+      *(dst++) = buf[i] ^ 0x80;
+      *(dst++) = buf[i + 1];
+    }
+    for(i = 8; i < 14; i += 2){ // gyro, next to temperature
+      *(dst++) = buf[i] ^ 0x80;
+      *(dst++) = buf[i + 1];
+    }
+  }
+  fifo_temperature = buf[6] ^ 0x80;
+
+  // AK8963 at approximately 6.25 Hz, which is the same as A page mode
+  mag_elapsed_ms += (1 + smplrt_div);
+  if(mag_elapsed_ms >= 160){
+    mag_elapsed_ms -= 160;
+    if(mag_push(&buf[14])){mag_ready = TRUE;}
+  }
+}
+
+static void make_packet_packed(packet_t *packet){
+  payload_t *dst = packet->current;
+  u8 samples = (fifo_records >= 2) ? 2 : fifo_records;
+  u32 t;
+
+  // Check whether buffer has sufficient margin
+  if((packet->buf_end - dst) < SYLPHIDE_PAGESIZE){
+    return;
+  }
+
+  *(dst++) = 'I';
+  *(dst++) = (samples << 6) | smplrt_div;
+  dst++; // temperature, which is filled after reading samples
+  *(dst++) = u32_lsbyte(tickcount);
+
+  // Record time of the last sample, LSB first
+  t = fifo_read_ms - (u32)(fifo_records - samples) * (1 + smplrt_div);
+  memcpy(dst, &t, sizeof(t));
+  dst += sizeof(t);
+
+  memset(dst, 0, packet->buf_end - dst);
+
+  do{
+    fifo_pop(dst);
+    dst += 12;
+  }while(--samples);
+  packet->current[2] = fifo_temperature;
+
+  packet->current = packet->buf_end;
+}
+
+/**
+ * Read all records in FIFO within a single SPI transaction,
+ * and pack them into I pages.
+ *
+ * @param fifo_bytes value of FIFO_COUNT
+ */
+static void fifo_reset(){
+  mpu9250_set(USER_CTRL, 0x34); // Reset FIFO, keeping Master I2C enabled and primary I2C I/F disabled.
+  mpu9250_set(USER_CTRL, 0x70); // Enable FIFO again
+}
+
+static void polling_burst(u16 fifo_bytes){
+  static const __code u8 addr[1] = {0x80 | FIFO_R_W};
+
+  // A partial record, for example, after overflow in which the oldest bytes are overwritten,
+  // means that the head of FIFO is no longer aligned to a record.
+  // Then, FIFO is reset without reading, because every record parsed from it is broken.
+  if(fifo_bytes % FIFO_RECORD_SIZE){
+    fifo_reset();
+    return;
+  }
+
+  fifo_records = fifo_bytes / FIFO_RECORD_SIZE;
+  fifo_read_ms = global_ms;
+
+  cs_assert();
+  cs_wait();
+  mpu9250_write(addr, sizeof(addr));
+  while(fifo_records){
+    if(!data_hub_assign_page(make_packet_packed)){
+      // The log buffer is full, therefore the remaining samples are discarded.
+      while(fifo_records){fifo_pop(NULL);}
+    }
+  }
+  cs_deassert();
+  cs_wait();
+
+  if(mag_ready){
+    data_hub_assign_page(make_packet_mag);
+    mag_ready = FALSE;
+  }
+}
+
 void mpu9250_polling(){
   if(!mpu9250_available){return;}
   if(mpu9250_capture){
@@ -383,33 +550,31 @@ void mpu9250_polling(){
     mpu9250_get(FIFO_COUNTH, fifo_count.c[1]);
     mpu9250_get(FIFO_COUNTL, fifo_count.c[0]);
 
-    if(fifo_count.i < 21){return;}
+    if(fifo_count.i < FIFO_RECORD_SIZE){return;}
     
     mpu9250_capture = FALSE;
+    if(fifo_burst){
+      polling_burst(fifo_count.i);
+      return;
+    }
+
     data_hub_assign_page(make_packet_inertial);
     
     do{ // check AK8963 data
       u8 buf[7];
       static __xdata u8 cycle = 0;
-      static __xdata u8 * __xdata next_buf = mag_data;
 
       mpu9250_get(FIFO_R_W, buf);
       if((++cycle) % 16){break;}
 
-      memcpy(next_buf, buf, 6);
-      next_buf += 6;
-
-      // Rotate
-      if(next_buf >= mag_data + sizeof(mag_data)){
+      if(mag_push(buf)){
         data_hub_assign_page(make_packet_mag);
-        next_buf = mag_data;
       }
     }while(0);
 
     // Reset FIFO if size is greater than expected
-    if(fifo_count.i > 21){
-      mpu9250_set(USER_CTRL, 0x34);
-      mpu9250_set(USER_CTRL, 0x70);
+    if(fifo_count.i > FIFO_RECORD_SIZE){
+      fifo_reset();
     }
   }
 }
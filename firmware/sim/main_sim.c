@@ -0,0 +1,685 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ * 
+ * - Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, 
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+/*
+ * Host-side simulator of data_hub logging pipeline
+ *
+ * data_hub.c, fifo.c, ff.c, diskio.c, mmc.c, mpu9250.c and util.c of the firmware are compiled for a host,
+ * and driven by simulated sensors in the same order as the main loop in main.c;
+ * sensor polling, data_hub_polling() and usb_polling().
+ * The SD card is replaced with a model backed by a disk image file (sd_sim.c),
+ * which is accessed through SPI functions,
+ * MPU-9250 is optionally replaced with a register model filling its FIFO with synthetic records
+ * (mpu9250_sim.c), which is driven by mpu9250.c,
+ * and USB CDC is replaced with a sink packing the stream into 64 bytes bulk packets
+ * like cdc_tx() of usb_cdc.c, whose cost consists of per call, per byte, and per packet ones.
+ *
+ * Like the firmware, samples are generated periodically and stored in each sensor
+ * (capture flag or hardware FIFO) until the main loop picks them up.
+ * Samples are lost either when the sensor holds too many samples while the main loop
+ * is blocked (overrun), or when data_hub has no free page (dropped,
+ * i.e., next_free_page == locked_page in data_hub_assign_page()).
+ *
+ * Usage: data_hub_sim [options]
+ *   --mode=<file|cdc>   destination of log; SD card or USB CDC. The default is file.
+ *   --duration=(sec)    simulated time per run. The default is 60.
+ *   --rate_(A|G|M|P)=(Hz)  page generation rate of each sensor.
+ *   --imu=<page|poll|burst>  source of inertial pages; "page" generates A pages at --rate_A,
+ *                       and the others run mpu9250.c with the register model,
+ *                       whose logged samples are checked against the synthetic records.
+ *                       "poll" reads a sample per 10 ms into A page, and "burst" reads FIFO
+ *                       in a single transaction into I pages (config.inertial_fifo.burst).
+ *   --imu_div=(n)       config.inertial_fifo.sampling_div; 1 kHz / (1 + n) sampling in burst mode.
+ *   --imu_byte_ns=(ns), --imu_cs_us=(us)  cost model of bit-banged SPI of MPU-9250.
+ *   --loop_us=(us)      cost of one iteration of the main loop excluding logging.
+ *   --page_us=(us)      cost to make one page.
+ *   --disk_byte_ns=(ns), --disk_(read|write|multi_write|stop|erase)_us=(us),
+ *   --disk_erase_interval=(blocks)
+ *                       cost model of SD card, see sim_disk_spec_t.
+ *   --cdc_ns_per_byte=(ns), --cdc_call_us=(us), --cdc_packet_us=(us)
+ *                       cost model of USB CDC transfer; per byte, per cdc_tx() call, and per bulk packet.
+ *   --cdc_pages=(n)     config.data_hub.cdc_pages; pages packed in a Sylphide packet to host.
+ *   --segments=(n), --watermark=(n), --status_interval=(sec)
+ *                       config.data_hub; segments of the log buffer, and so on.
+ *   --dump=(file)       copy log.dat to the file after a run, for example, to be checked by log_CSV.
+ *                       In cdc mode, the stream to host is saved, which is decoded by "log_CSV --in_sylphide=on".
+ *   --image=(file)      disk image file. The default is data_hub_sim.img.
+ *   --image_MB=(MB)     size of disk image. The default is 64.
+ *   --search            finds the maximum sustainable rates, with which no sample is lost,
+ *                       by scaling all rates.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "config.h"
+#include "data_hub.h"
+#include "usb_cdc.h"
+#include "f38x_usb.h"
+#include "f38x_uart0.h"
+#include "f38x_uart1.h"
+#include "mpu9250.h"
+#include "ff.h"
+
+#include "sim.h"
+
+// Stubs of the firmware modules excluded from simulation
+
+__xdata void (*main_loop_prologue)() = NULL;
+
+volatile __xdata u32 global_ms = 0;
+volatile __xdata u32 tickcount = 0;
+volatile __xdata u8 sys_state = 0;
+volatile u8 timeout_10ms = 0;
+
+volatile config_t config = {
+  {9600, 9600}, // baudrate
+  {{0, 0}}, // gps
+  {0, 0}, // inertial
+  {20, 10, 10}, // telemetry_truncate
+  {2, 1, 1, 4}, // data_hub
+  {FALSE, 4}, // inertial_fifo
+};
+void config_renew(config_t *new_one){}
+
+volatile usb_mode_t usb_mode = USB_INACTIVE;
+
+volatile __bit cdc_force = FALSE;
+cdc_line_coding_t __xdata cdc_line_coding;
+__xdata void (*cdc_change_line_spec)() = NULL;
+
+static unsigned long cdc_ns_per_byte = 1000; // approximately 1 MB/s of USB full speed bulk transfer
+static unsigned long cdc_call_us = 10; // argument passing, and so on
+static unsigned long cdc_packet_us = 20; // usb_write() to the endpoint FIFO
+static unsigned long long cdc_bytes = 0;
+static unsigned long cdc_calls = 0;
+static unsigned long cdc_packets = 0, cdc_short_packets = 0;
+static FILE *cdc_dump = NULL;
+static unsigned long pages_consumed = 0; // excluding S pages
+static unsigned long status_pages = 0;
+static u8 status_page[SYLPHIDE_PAGESIZE]; // latest S page
+
+static enum {
+  IMU_PAGE,
+  IMU_POLL,
+  IMU_BURST,
+} imu_mode = IMU_PAGE;
+
+static struct {
+  unsigned long logged, missing, mismatched;
+  unsigned long next; // expected sample number
+  long max_delay_ms; // from sampling to time stamp
+} imu;
+
+/**
+ * Check a sample logged by mpu9250.c against the synthetic record
+ *
+ * @param values accelerometer and gyro values (big endian, MSB flipped, 12 bytes)
+ * @param t_ms time stamp
+ */
+static void check_imu_sample(const u8 *values, u32 t_ms){
+  u8 record[21];
+  unsigned long k;
+  long delay_ms;
+  int i;
+
+  // Sample number is recovered from the lower 16 bits in accelerometer X
+  k = imu.next + (u16)((((u16)(values[0] ^ 0x80) << 8) | values[1]) - (u16)imu.next);
+  imu.missing += k - imu.next;
+  imu.next = k + 1;
+  imu.logged++;
+
+  sim_mpu9250_record(k, record);
+  for(i = 0; i < 6; ++i){
+    u8 offset = (i < 3) ? 0 : 2; // skip temperature
+    if((values[i * 2] != (record[offset + i * 2] ^ 0x80))
+        || (values[i * 2 + 1] != record[offset + i * 2 + 1])){
+      imu.mismatched++;
+      break;
+    }
+  }
+
+  delay_ms = (long)t_ms
+      - (long)((sim_mpu9250_stat.first_us + (unsigned long long)k * sim_mpu9250_stat.interval_us) / 1000);
+  if(labs(delay_ms) > labs(imu.max_delay_ms)){imu.max_delay_ms = delay_ms;}
+}
+
+static void check_imu_page(const u8 *buf){
+  u32 t;
+  if(buf[0] == 'A'){ // 'A', tickcount, global_ms, 24 bits * 8 channels, temperature
+    u8 values[12];
+    int i;
+    for(i = 0; i < 6; ++i){
+      values[i * 2] = buf[7 + i * 3];
+      values[i * 2 + 1] = buf[8 + i * 3];
+    }
+    memcpy(&t, &buf[2], sizeof(t));
+    check_imu_sample(values, t);
+  }else if(buf[0] == 'I'){ // see mpu9250.c for its design
+    u8 samples = buf[1] >> 6, i;
+    u32 interval_ms = 1 + (buf[1] & 0x3F);
+    memcpy(&t, &buf[4], sizeof(t));
+    for(i = 0; i < samples; ++i){
+      check_imu_sample(&buf[8 + i * 12], t - (samples - 1 - i) * interval_ms);
+    }
+  }
+}
+
+static void count_pages(const u8 *buf, u16 size){
+  for(; size >= SYLPHIDE_PAGESIZE; buf += SYLPHIDE_PAGESIZE, size -= SYLPHIDE_PAGESIZE){
+    if(buf[0] == 'S'){
+      status_pages++;
+      memcpy(status_page, buf, sizeof(status_page));
+    }else{
+      pages_consumed++;
+      if(imu_mode != IMU_PAGE){check_imu_page(buf);}
+    }
+  }
+}
+
+#define CDC_PACKET_SIZE 64 // PACKET_SIZE_EP2
+static u8 cdc_margin = CDC_PACKET_SIZE;
+
+static void cdc_send_packet(){
+  if(cdc_margin == CDC_PACKET_SIZE){return;}
+  sim_elapse(cdc_packet_us);
+  if(cdc_margin > 0){cdc_short_packets++;}
+  cdc_packets++;
+  cdc_margin = CDC_PACKET_SIZE;
+}
+
+u16 cdc_tx(u8 *buf, u16 size){
+  u16 rest = size;
+  if(size == 0){ // flush
+    cdc_send_packet();
+    return 0;
+  }
+  cdc_calls++;
+  sim_elapse(cdc_call_us + (cdc_ns_per_byte * size + 999) / 1000);
+  while(rest >= cdc_margin){
+    rest -= cdc_margin;
+    cdc_margin = 0;
+    cdc_send_packet();
+  }
+  cdc_margin -= rest;
+  cdc_bytes += size;
+  if(cdc_dump){fwrite(buf, 1, size, cdc_dump);}
+  if(size % SYLPHIDE_PAGESIZE == 0){ // pages, not header, sequence or CRC
+    count_pages(buf, size);
+  }
+  return size;
+}
+u16 cdc_rx(u8 *buf, u16 size){return 0;}
+
+void usb_polling(){
+  // cdc_polling() flushes a partially filled packet every 16 frames (ms).
+  static unsigned long previous_frame = 0;
+  unsigned long frame = (unsigned long)(sim_now_us / 1000) & ~0xFUL;
+  if((usb_mode != USB_CDC_ACTIVE) || (previous_frame == frame)){return;}
+  previous_frame = frame;
+  cdc_tx(NULL, 0);
+}
+
+void uart0_bauding(u32 baudrate){}
+FIFO_SIZE_T uart0_write(char *buf, FIFO_SIZE_T size){return size;}
+FIFO_SIZE_T uart0_read(char *buf, FIFO_SIZE_T size){return 0;}
+void uart1_bauding(u32 baudrate){}
+FIFO_SIZE_T uart1_write(char *buf, FIFO_SIZE_T size){return size;}
+FIFO_SIZE_T uart1_read(char *buf, FIFO_SIZE_T size){return 0;}
+
+static unsigned long telemetry_pages = 0;
+void telemeter_send(char buf[SYLPHIDE_PAGESIZE]){
+  telemetry_pages++;
+}
+
+DWORD get_fattime(){
+  return ((DWORD)(2020 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
+
+/*
+ * Log data is written with f_write() only by log_to_file() except for 1 byte of LOG.INC.
+ * Its call is hooked with "-Wl,--wrap=f_write" to count the pages which leave the buffer.
+ */
+FRESULT __real_f_write(FIL* fp, const void* buff, UINT btw, UINT* bw);
+FRESULT __wrap_f_write(FIL* fp, const void* buff, UINT btw, UINT* bw){
+  FRESULT res = __real_f_write(fp, buff, btw, bw);
+  if((btw > 0) && (btw % SYLPHIDE_PAGESIZE == 0)){
+    count_pages((const u8 *)buff, btw);
+  }
+  return res;
+}
+
+// Simulated sensors
+
+typedef struct {
+  char page_type;
+  double rate; // pages per second
+  unsigned char depth; // maximum number of samples held by the sensor
+  unsigned char retry; // when data_hub is full, TRUE: sample is kept (UART FIFO), FALSE: lost
+  double next_us;
+  unsigned char pending;
+  unsigned long generated, accepted, dropped, overrun;
+} sensor_t;
+
+static sensor_t sensors[] = {
+  {'A', 100, 1, FALSE}, // mpu9250_capture flag set every 10 ms
+  {'G', 50, (UART0_RX_BUFFER_SIZE / (SYLPHIDE_PAGESIZE - 1)), TRUE}, // UART0 RX FIFO
+  {'M', 100.0 / 64, 1, FALSE}, // 4 samples at 6.25 Hz per page
+  {'P', 12.5 / 4, 1, FALSE}, // 4 captures at 12.5 Hz per page
+};
+#define SENSORS (sizeof(sensors) / sizeof(sensors[0]))
+
+static double rate_scale = 1;
+static unsigned long long sim_end_us = 0;
+unsigned long long sim_now_us = 0;
+
+void sim_elapse(unsigned long us){
+  unsigned long long target = sim_now_us + us;
+  int i;
+  for(i = 0; i < SENSORS; ++i){
+    sensor_t *s = &sensors[i];
+    if(s->rate * rate_scale <= 0){continue;}
+    while((s->next_us <= target) && (s->next_us < sim_end_us)){
+      s->generated++;
+      if(s->pending < s->depth){
+        s->pending++;
+      }else{
+        s->overrun++;
+      }
+      s->next_us += 1E6 / (s->rate * rate_scale);
+    }
+  }
+  if(sim_now_us / 10000 != target / 10000){
+    timeout_10ms += (u8)(target / 10000 - sim_now_us / 10000);
+    mpu9250_capture = TRUE; // timer3
+  }
+  sim_now_us = target;
+  global_ms = (u32)(sim_now_us / 1000);
+  tickcount = (u32)(sim_now_us / 10000);
+}
+
+static sensor_t *sensor_current;
+
+static void make_packet(packet_t *packet){
+  payload_t *dst = packet->buf_begin;
+  u32 t = global_ms;
+  *(dst++) = sensor_current->page_type;
+  *(dst++) = 0;
+  *(dst++) = 0;
+  *(dst++) = u32_lsbyte(sensor_current->accepted);
+  memcpy(dst, &t, sizeof(t));
+  dst += sizeof(t);
+  memset(dst, 0, packet->buf_end - dst);
+  packet->current = packet->buf_end;
+}
+
+static unsigned long loop_us = 20;
+static unsigned long page_us = 100;
+
+static unsigned long pages_accepted = 0;
+static unsigned long pages_high_water = 0;
+
+/*
+ * Pages from the simulated sensors and mpu9250.c are counted by hooking data_hub_assign_page()
+ * with "-Wl,--wrap=data_hub_assign_page"; S pages made inside data_hub.c are excluded.
+ */
+payload_size_t __real_data_hub_assign_page(void (* packet_maker)(packet_t *));
+payload_size_t __wrap_data_hub_assign_page(void (* packet_maker)(packet_t *)){
+  payload_size_t res = __real_data_hub_assign_page(packet_maker);
+  if(res){
+    pages_accepted++;
+    if(pages_accepted - pages_consumed > pages_high_water){
+      pages_high_water = pages_accepted - pages_consumed;
+    }
+  }
+  return res;
+}
+
+static void sensors_polling(){
+  int i;
+  if(imu_mode != IMU_PAGE){mpu9250_polling();}
+  for(i = 0; i < SENSORS; ++i){
+    sensor_t *s = &sensors[i];
+    while(s->pending > 0){
+      sim_elapse(page_us);
+      sensor_current = s;
+      if(data_hub_assign_page(make_packet)){
+        s->accepted++;
+        s->pending--;
+      }else if(s->retry){
+        break;
+      }else{
+        s->dropped++;
+        s->pending--;
+      }
+    }
+  }
+}
+
+// Simulation runner
+
+static struct {
+  usb_mode_t usb_mode;
+  double duration;
+  const char *image;
+  unsigned long image_MB;
+  const char *dump;
+} options = {USB_INACTIVE, 60, "data_hub_sim.img", 64, NULL};
+
+extern FATFS fs; // data_hub.c
+
+typedef struct {
+  unsigned long generated, accepted, lost;
+  unsigned long long elapsed_us;
+} result_t;
+
+static int run(double scale, result_t *res){
+  int i;
+
+  sim_now_us = 0;
+  sim_end_us = (unsigned long long)-1;
+  if(sim_disk_open(options.image, options.image_MB * 2048) != 0){
+    fprintf(stderr, "Failed to create %s\n", options.image);
+    return -1;
+  }
+  if((f_mount(0, &fs) != FR_OK) || (f_mkfs(0, 1, 0) != FR_OK)){
+    fprintf(stderr, "Failed to format %s\n", options.image);
+    return -1;
+  }
+  f_mount(0, NULL);
+
+  usb_mode = options.usb_mode;
+  data_hub_init();
+  data_hub_polling(); // Open log file, or switch to CDC, which resets the buffer
+  memset(&sim_disk_stat, 0, sizeof(sim_disk_stat));
+  cdc_bytes = 0;
+  cdc_calls = cdc_packets = cdc_short_packets = 0;
+  cdc_margin = CDC_PACKET_SIZE;
+  if((usb_mode == USB_CDC_ACTIVE) && options.dump){
+    cdc_dump = fopen(options.dump, "wb");
+  }
+  if(imu_mode != IMU_PAGE){
+    sim_mpu9250_reset();
+    config.inertial_fifo.burst = (imu_mode == IMU_BURST);
+    mpu9250_init();
+  }
+  memset(&imu, 0, sizeof(imu));
+  pages_accepted = pages_consumed = pages_high_water = 0;
+  status_pages = 0;
+  memset(status_page, 0, sizeof(status_page));
+  telemetry_pages = 0;
+
+  {
+    unsigned long long start_us = sim_now_us;
+    sim_end_us = start_us + (unsigned long long)(options.duration * 1E6);
+    rate_scale = scale;
+    for(i = 0; i < SENSORS; ++i){
+      sensor_t *s = &sensors[i];
+      s->next_us = start_us;
+      s->pending = 0;
+      s->generated = s->accepted = s->dropped = s->overrun = 0;
+    }
+    while(sim_now_us < sim_end_us){
+      sensors_polling();
+      data_hub_polling();
+      usb_polling();
+      sim_elapse(loop_us);
+    }
+    res->elapsed_us = sim_now_us - start_us;
+  }
+  cdc_tx(NULL, 0);
+  if(cdc_dump){
+    fclose(cdc_dump);
+    cdc_dump = NULL;
+  }
+  usb_mode = USB_MSC_ACTIVE;
+  data_hub_polling(); // Close log file
+
+  res->generated = res->lost = 0;
+  res->accepted = pages_accepted;
+  for(i = 0; i < SENSORS; ++i){
+    res->generated += sensors[i].generated;
+    res->lost += sensors[i].dropped + sensors[i].overrun;
+  }
+  if(imu_mode != IMU_PAGE){
+    // Samples remaining in FIFO or the log buffer at the end are not counted as missing.
+    res->generated += sim_mpu9250_stat.generated;
+    res->lost += imu.missing;
+  }
+  return 0;
+}
+
+static int check_log(){
+  // Whole pages which left the buffer should be found in the log file.
+  static FIL file;
+  DWORD expected = (DWORD)(pages_consumed + status_pages) * SYLPHIDE_PAGESIZE, actual = 0;
+  if(f_mount(0, &fs) != FR_OK){return -1;}
+  if(f_open(&file, "log.dat", (FA_OPEN_EXISTING | FA_READ)) == FR_OK){
+    actual = f_size(&file);
+    if(options.dump){
+      FILE *out = fopen(options.dump, "wb");
+      char buf[512];
+      UINT read_bytes;
+      while(out && (f_read(&file, buf, sizeof(buf), &read_bytes) == FR_OK) && (read_bytes > 0)){
+        fwrite(buf, 1, read_bytes, out);
+      }
+      if(out){fclose(out);}
+    }
+    f_close(&file);
+  }
+  f_mount(0, NULL);
+  printf("log.dat: %lu bytes (%s)\n", (unsigned long)actual,
+      (actual == expected) ? "OK" : "mismatch");
+  return (actual == expected) ? 0 : -1;
+}
+
+static void report(const result_t *res, double scale){
+  int i;
+  double sec = 1E-6 * res->elapsed_us;
+  printf("mode: %s, simulated: %.3f s, rate scale: %g\n",
+      (options.usb_mode == USB_CDC_ACTIVE) ? "cdc" : "file", sec, scale);
+  printf("page, rate[Hz], generated, accepted, dropped, overrun\n");
+  for(i = 0; i < SENSORS; ++i){
+    sensor_t *s = &sensors[i];
+    printf("%c, %g, %lu, %lu, %lu, %lu\n",
+        s->page_type, s->rate * scale, s->generated, s->accepted, s->dropped, s->overrun);
+  }
+  // The actual settings are recorded in S page, because cdc mode uses its own segments.
+  printf("buffer: %u segments, watermark %u, high-water mark %lu / %u pages\n",
+      (unsigned int)(status_pages ? status_page[1] : config.data_hub.segments),
+      (unsigned int)(status_pages ? status_page[2] : config.data_hub.flush_watermark),
+      pages_high_water, (unsigned int)(DATA_HUB_BUFFER_PAGES - 1));
+  if(status_pages > 0){
+    u32 counter[3];
+    u16 max_flush_ms;
+    memcpy(counter, &status_page[8], sizeof(counter));
+    memcpy(&max_flush_ms, &status_page[22], sizeof(max_flush_ms));
+    printf("S page: %lu pages, last: accepted %lu, refused %lu, lost %lu, high-water %u, max flush %u ms\n",
+        status_pages, (unsigned long)counter[0], (unsigned long)counter[1], (unsigned long)counter[2],
+        (unsigned int)status_page[20], (unsigned int)max_flush_ms);
+  }
+  if(imu_mode != IMU_PAGE){
+    printf("imu: %s, %.1f Hz, generated %lu, FIFO overflow %lu, logged %lu, missing %lu, mismatched %lu, "
+        "max delay %ld ms\n",
+        (imu_mode == IMU_BURST) ? "burst" : "poll",
+        sim_mpu9250_stat.interval_us ? (1E6 / sim_mpu9250_stat.interval_us) : 0.0,
+        sim_mpu9250_stat.generated, sim_mpu9250_stat.overflow,
+        imu.logged, imu.missing, imu.mismatched, imu.max_delay_ms);
+  }
+  printf("throughput: %.1f pages/s (%.1f bytes/s)\n",
+      res->accepted / sec, res->accepted * SYLPHIDE_PAGESIZE / sec);
+  if(options.usb_mode == USB_CDC_ACTIVE){
+    printf("cdc: %u pages per packet, %llu bytes (framing %.1f%%), %.1f bytes/s, "
+        "%lu calls, %lu bulk packets (%lu short, %.1f bytes/packet)\n",
+        (unsigned int)config.data_hub.cdc_pages, cdc_bytes,
+        100.0 * (cdc_bytes - (double)(pages_consumed + status_pages) * SYLPHIDE_PAGESIZE) / cdc_bytes,
+        cdc_bytes / sec, cdc_calls, cdc_packets, cdc_short_packets,
+        (double)cdc_bytes / cdc_packets);
+  }else{
+    printf("disk: %lu commands (CMD24 %lu, CMD25 %lu), %lu blocks written, %lu blocks read, busy %.1f%%\n",
+        sim_disk_stat.commands, sim_disk_stat.single_writes, sim_disk_stat.multi_writes,
+        sim_disk_stat.blocks_written, sim_disk_stat.blocks_read,
+        100.0 * sim_disk_stat.busy_us / res->elapsed_us);
+  }
+}
+
+int main(int argc, char *argv[]){
+  int search = FALSE;
+  result_t res;
+  int i;
+
+  for(i = 1; i < argc; ++i){
+    const char *arg = argv[i];
+    const char *value = strchr(arg, '=');
+    value = value ? (value + 1) : "";
+#define CHECK_OPTION(name) (strncmp(arg, "--" name "=", sizeof("--" name "=") - 1) == 0)
+    if(CHECK_OPTION("mode")){
+      options.usb_mode = (strcmp(value, "cdc") == 0) ? USB_CDC_ACTIVE : USB_INACTIVE;
+    }else if(CHECK_OPTION("duration")){
+      options.duration = atof(value);
+    }else if(CHECK_OPTION("loop_us")){
+      loop_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("page_us")){
+      page_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_byte_ns")){
+      sim_disk_spec.byte_ns = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_read_us")){
+      sim_disk_spec.read_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_write_us")){
+      sim_disk_spec.write_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_multi_write_us")){
+      sim_disk_spec.multi_write_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_stop_us")){
+      sim_disk_spec.stop_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_erase_us")){
+      sim_disk_spec.erase_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("disk_erase_interval")){
+      sim_disk_spec.erase_interval = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("cdc_ns_per_byte")){
+      cdc_ns_per_byte = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("cdc_call_us")){
+      cdc_call_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("cdc_packet_us")){
+      cdc_packet_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("cdc_pages")){
+      config.data_hub.cdc_pages = (u8)strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("imu")){
+      if(strcmp(value, "poll") == 0){
+        imu_mode = IMU_POLL;
+      }else if(strcmp(value, "burst") == 0){
+        imu_mode = IMU_BURST;
+      }else{
+        imu_mode = IMU_PAGE;
+      }
+    }else if(CHECK_OPTION("imu_div")){
+      config.inertial_fifo.sampling_div = (u8)strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("imu_byte_ns")){
+      sim_mpu9250_spec.byte_ns = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("imu_cs_us")){
+      sim_mpu9250_spec.cs_us = strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("segments")){
+      config.data_hub.segments = (u8)strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("watermark")){
+      config.data_hub.flush_watermark = (u8)strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("status_interval")){
+      config.data_hub.status_interval = (u8)strtoul(value, NULL, 10);
+    }else if(CHECK_OPTION("dump")){
+      options.dump = value;
+    }else if(CHECK_OPTION("image")){
+      options.image = value;
+    }else if(CHECK_OPTION("image_MB")){
+      options.image_MB = strtoul(value, NULL, 10);
+    }else if(strcmp(arg, "--search") == 0){
+      search = TRUE;
+    }else if((strncmp(arg, "--rate_", 7) == 0) && arg[7] && (arg[8] == '=')){
+      int j;
+      for(j = 0; j < SENSORS; ++j){
+        if(sensors[j].page_type != arg[7]){continue;}
+        sensors[j].rate = atof(value);
+        break;
+      }
+      if(j == SENSORS){
+        fprintf(stderr, "Unknown page type: %s\n", arg);
+        return -1;
+      }
+    }else{
+      fprintf(stderr, "Unknown option: %s\n", arg);
+      return -1;
+    }
+#undef CHECK_OPTION
+  }
+  if((options.duration <= 0) || (options.image_MB == 0)){
+    fprintf(stderr, "Invalid option\n");
+    return -1;
+  }
+  if(imu_mode != IMU_PAGE){
+    // A and M pages are made by mpu9250.c instead.
+    for(i = 0; i < SENSORS; ++i){
+      if((sensors[i].page_type == 'A') || (sensors[i].page_type == 'M')){
+        sensors[i].rate = 0;
+      }
+    }
+  }
+
+  if(!search){
+    if(run(1, &res) != 0){return -1;}
+    report(&res, 1);
+    if(options.usb_mode != USB_CDC_ACTIVE){check_log();}
+  }else{
+    // Expand upper bound, then bisect
+    double lower = 0, upper = 1;
+    while(1){
+      if(run(upper, &res) != 0){return -1;}
+      printf("scale %g: %lu lost\n", upper, res.lost);
+      if(res.lost > 0){break;}
+      lower = upper;
+      upper *= 2;
+      if(upper > 1024){break;}
+    }
+    for(i = 0; i < 10; ++i){
+      double mid = (lower + upper) / 2;
+      if(run(mid, &res) != 0){return -1;}
+      printf("scale %g: %lu lost\n", mid, res.lost);
+      if(res.lost > 0){upper = mid;}else{lower = mid;}
+    }
+    if(lower <= 0){
+      printf("No sustainable rate found\n");
+      return 0;
+    }
+    if(run(lower, &res) != 0){return -1;}
+    printf("Maximum sustainable rates:\n");
+    report(&res, lower);
+  }
+  sim_disk_close();
+  return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ * 
+ * - Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, 
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+/*
+ * Register model of MPU-9250 connected via SPI, used with mpu9250.c of the firmware.
+ * Its host build calls mpu9250_cs(), mpu9250_write() and mpu9250_read() instead of
+ * driving port 1, whose cost advances simulated time in accordance with sim_mpu9250_spec.
+ *
+ * Once FIFO is enabled, a record of 21 bytes, which is a synthetic register dump of
+ * accelerometer, temperature, gyro and AK8963 (via slave 0), is pushed to FIFO
+ * every (1 + SMPLRT_DIV) ms. Like the real chip with FIFO_MODE = 1,
+ * FIFO stops accepting bytes when 512 bytes are stored, which may leave a partial record.
+ */
+
+#include <string.h>
+
+#include "main.h"
+#include "type.h"
+#include "sim.h"
+
+enum {
+  SMPLRT_DIV = 0x19,
+  USER_CTRL = 0x6A,
+  I2C_SLV4_DI = 0x35,
+  FIFO_COUNTH = 0x72,
+  FIFO_COUNTL = 0x73,
+  FIFO_R_W = 0x74,
+  WHO_AM_I = 0x75,
+};
+
+#define FIFO_SIZE 512
+#define RECORD_SIZE 21
+
+sim_mpu9250_spec_t sim_mpu9250_spec = {
+  17000, // byte_ns; 8 clocks of bit-banged SPI, approximately 100 SYSCLK per clock
+  9,     // cs_us; cs_wait() after each change of chip select
+};
+sim_mpu9250_stat_t sim_mpu9250_stat;
+
+static u8 regs[0x80];
+static u8 fifo[FIFO_SIZE];
+static unsigned int fifo_head, fifo_stored;
+static int fifo_enabled;
+static unsigned long long next_sample_us;
+
+static u8 selected; // chip select is asserted
+static u8 address, address_given, reading;
+
+static unsigned long elapsed_ns = 0;
+
+static void elapse_byte(){
+  elapsed_ns += sim_mpu9250_spec.byte_ns;
+  if(elapsed_ns >= 1000){
+    sim_elapse(elapsed_ns / 1000);
+    elapsed_ns %= 1000;
+  }
+}
+
+static void put_be16(u8 *dst, s16 v){
+  dst[0] = (u8)((u16)v >> 8);
+  dst[1] = (u8)(v & 0xFF);
+}
+
+static void put_le16(u8 *dst, s16 v){
+  dst[0] = (u8)(v & 0xFF);
+  dst[1] = (u8)((u16)v >> 8);
+}
+
+void sim_mpu9250_record(unsigned long k, u8 record[21]){
+  put_be16(&record[0], (s16)k); // accel X
+  put_be16(&record[2], (s16)~k); // accel Y
+  put_be16(&record[4], 4096); // accel Z
+  put_be16(&record[6], 0x0A5A); // temperature
+  put_be16(&record[8], (s16)(k * 3)); // gyro X
+  put_be16(&record[10], (s16)-(k * 3)); // gyro Y
+  put_be16(&record[12], (s16)(k >> 4)); // gyro Z
+  put_le16(&record[14], (s16)(k >> 4)); // AK8963 HX
+  put_le16(&record[16], (s16)-(k >> 4)); // HY
+  put_le16(&record[18], 100); // HZ
+  record[20] = 0x10; // ST2, 16 bit output
+}
+
+static void fifo_reset(){
+  fifo_head = fifo_stored = 0;
+}
+
+static void fifo_update(){
+  unsigned long interval_us = 1000UL * (1 + regs[SMPLRT_DIV]);
+  if(!fifo_enabled){return;}
+  while(next_sample_us <= sim_now_us){
+    u8 record[RECORD_SIZE];
+    int i;
+    if(sim_mpu9250_stat.generated == 0){
+      sim_mpu9250_stat.first_us = next_sample_us;
+      sim_mpu9250_stat.interval_us = interval_us;
+    }
+    sim_mpu9250_record(sim_mpu9250_stat.generated++, record);
+    if(fifo_stored + RECORD_SIZE > FIFO_SIZE){sim_mpu9250_stat.overflow++;}
+    for(i = 0; (i < RECORD_SIZE) && (fifo_stored < FIFO_SIZE); ++i){
+      fifo[(fifo_head + fifo_stored++) % FIFO_SIZE] = record[i];
+    }
+    next_sample_us += interval_us;
+  }
+}
+
+void sim_mpu9250_reset(){
+  memset(regs, 0, sizeof(regs));
+  memset(&sim_mpu9250_stat, 0, sizeof(sim_mpu9250_stat));
+  regs[WHO_AM_I] = 0x71;
+  regs[I2C_SLV4_DI] = 0x48; // WIA of AK8963
+  fifo_reset();
+  fifo_enabled = FALSE;
+  selected = FALSE;
+}
+
+void mpu9250_cs(u8 asserted){
+  if(asserted == selected){return;}
+  selected = asserted;
+  address_given = FALSE;
+  sim_elapse(sim_mpu9250_spec.cs_us);
+}
+
+static void write_reg(u8 v){
+  regs[address] = v;
+  if(address == USER_CTRL){
+    if(v & 0x04){fifo_reset();} // FIFO_RST
+    if((v & 0x40) && !fifo_enabled){ // FIFO_EN
+      next_sample_us = sim_now_us + 1000UL * (1 + regs[SMPLRT_DIV]);
+    }
+    fifo_enabled = (v & 0x40);
+  }
+}
+
+static u8 read_reg(){
+  switch(address){
+    case FIFO_COUNTH: // FIFO_COUNTL is latched at the same time
+      fifo_update();
+      regs[FIFO_COUNTL] = (u8)(fifo_stored & 0xFF);
+      return (u8)(fifo_stored >> 8);
+    case FIFO_R_W: {
+      u8 v = 0;
+      if(fifo_stored > 0){
+        v = fifo[fifo_head];
+        fifo_head = (fifo_head + 1) % FIFO_SIZE;
+        fifo_stored--;
+      }
+      return v;
+    }
+  }
+  return regs[address];
+}
+
+void mpu9250_write(u8 *buf, u8 size){
+  if(!selected){return;}
+  for(; size--; buf++){
+    elapse_byte();
+    if(!address_given){
+      address = (*buf) & 0x7F;
+      reading = ((*buf) & 0x80);
+      address_given = TRUE;
+      continue;
+    }
+    if(reading){continue;}
+    write_reg(*buf);
+    if(address != FIFO_R_W){address = (address + 1) & 0x7F;}
+  }
+}
+
+void mpu9250_read(u8 *buf, u8 size){
+  for(; size--; buf++){
+    elapse_byte();
+    *buf = 0xFF;
+    if(!(selected && address_given && reading)){continue;}
+    *buf = read_reg();
+    if(address != FIFO_R_W){address = (address + 1) & 0x7F;}
+  }
+}
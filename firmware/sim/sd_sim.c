@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ * 
+ * - Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, 
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+/*
+ * SD card model backed by a disk image file, used instead of f38x_spi.c.
+ * mmc.c and diskio.c of the firmware drive it byte by byte via SPI functions,
+ * thus command overhead, data transfer and busy of the card advance simulated time
+ * in accordance with sim_disk_spec.
+ *
+ * The card behaves as SDHC (block addressing) in SPI mode, and supports
+ * CMD0, CMD8, CMD9, CMD13, CMD17, CMD24, CMD25, CMD55, CMD58, ACMD23 and ACMD41.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "c8051f380.h"
+#include "main.h"
+#include "type.h"
+#include "f38x_spi.h"
+#include "sim.h"
+
+#define SECTOR_SIZE 512
+
+sim_disk_spec_t sim_disk_spec = {
+  700,  // byte_ns; software overhead of byte-by-byte transfer
+  100,  // read_us
+  500,  // write_us
+  100,  // multi_write_us
+  500,  // stop_us
+  5000, // erase_us
+  16,   // erase_interval
+};
+sim_disk_stat_t sim_disk_stat;
+
+static FILE *image = NULL;
+static DWORD image_sectors = 0;
+
+static enum {
+  SD_COMMAND,     // waiting for a command
+  SD_WRITE_TOKEN, // waiting for a start token of CMD24 or CMD25
+  SD_WRITE_DATA,  // receiving a data block and CRC
+  SD_STOP,        // 1 byte is skipped after Stop Tran token
+} state;
+static u8 idle, app_cmd;
+static u8 cmd[6], cmd_len;
+static u8 multi; // CMD25 is active
+static DWORD address; // next block to be written
+static unsigned long pre_erased; // number of blocks pre-erased by ACMD23
+static unsigned long not_erased; // number of written blocks not pre-erased
+static u8 block[SECTOR_SIZE + 2];
+static unsigned int block_len;
+
+static u8 resp[8 + SECTOR_SIZE + 4]; // response, possibly followed by data
+static unsigned int resp_len, resp_pos;
+static unsigned long long resp_after_us; // data token of read is delayed
+static unsigned int resp_data_pos; // position of data token in resp
+static unsigned long long busy_until_us;
+
+static u8 ckr = 0;
+static unsigned long elapsed_ns = 0;
+
+u8 spi_ckr(u8 new_value){
+  u8 old_value = ckr;
+  ckr = new_value;
+  return old_value;
+}
+
+void spi_init(){
+  spi_clock(400);
+}
+
+static void elapse_byte(){
+  // SPI clock = SYSCLK / (2 * (SPI0CKR + 1))
+  elapsed_ns += sim_disk_spec.byte_ns
+      + (unsigned long)(8E9 * 2 * ((unsigned long)ckr + 1) / SYSCLK);
+  if(elapsed_ns >= 1000){
+    sim_disk_stat.busy_us += elapsed_ns / 1000;
+    sim_elapse(elapsed_ns / 1000);
+    elapsed_ns %= 1000;
+  }
+}
+
+static void push(u8 v){
+  resp[resp_len++] = v;
+}
+
+static void busy(unsigned long us){
+  busy_until_us = sim_now_us + us;
+}
+
+static u32 cmd_arg(){
+  return ((u32)cmd[1] << 24) | ((u32)cmd[2] << 16) | ((u32)cmd[3] << 8) | cmd[4];
+}
+
+static u8 seek(DWORD sector){
+  return (sector < image_sectors)
+      && (fseek(image, (long)sector * SECTOR_SIZE, SEEK_SET) == 0);
+}
+
+static void command(){
+  u8 index = cmd[0] & 0x3F, app = app_cmd;
+  u8 r1 = idle ? 0x01 : 0x00;
+  resp_len = resp_pos = 0;
+  resp_after_us = 0;
+  app_cmd = 0;
+  sim_disk_stat.commands++;
+  push(0xFF); // N_CR
+  switch(app ? (index | 0x80) : index){
+    case 0: // GO_IDLE_STATE
+      idle = 1;
+      push(0x01);
+      break;
+    case 8: // SEND_IF_COND, R7
+      push(r1);
+      push(0x00); push(0x00); push(cmd[3] & 0x0F); push(cmd[4]);
+      break;
+    case 9: { // SEND_CSD, CSD version 2.0
+      u8 csd[16] = {0x40};
+      u32 c_size = image_sectors / 1024 - 1;
+      csd[7] = (u8)((c_size >> 16) & 0x3F);
+      csd[8] = (u8)(c_size >> 8);
+      csd[9] = (u8)c_size;
+      push(r1);
+      push(0xFF);
+      push(0xFE);
+      memcpy(&resp[resp_len], csd, sizeof(csd));
+      resp_len += sizeof(csd);
+      push(0xFF); push(0xFF);
+      break;
+    }
+    case 13: // SEND_STATUS, R2
+      push(r1);
+      push(0x00);
+      break;
+    case 17: // READ_SINGLE_BLOCK
+      push(r1);
+      if(!seek(cmd_arg())){
+        push(0x08); // Error token; out of range
+        break;
+      }
+      resp_data_pos = resp_len;
+      push(0xFE);
+      if(fread(&resp[resp_len], SECTOR_SIZE, 1, image) != 1){
+        memset(&resp[resp_len], 0, SECTOR_SIZE);
+      }
+      resp_len += SECTOR_SIZE;
+      push(0xFF); push(0xFF);
+      resp_after_us = sim_now_us + sim_disk_spec.read_us;
+      sim_disk_stat.blocks_read++;
+      break;
+    case 24: // WRITE_BLOCK
+    case 25: // WRITE_MULTIPLE_BLOCK
+      if(cmd_arg() >= image_sectors){
+        push(r1 | 0x40); // Parameter error
+        break;
+      }
+      push(r1);
+      address = cmd_arg();
+      multi = (index == 25);
+      if(multi){
+        sim_disk_stat.multi_writes++;
+      }else{
+        sim_disk_stat.single_writes++;
+        pre_erased = 0;
+      }
+      state = SD_WRITE_TOKEN;
+      break;
+    case 55: // APP_CMD
+      app_cmd = 1;
+      push(r1);
+      break;
+    case 58: // READ_OCR, R3; powered up, CCS = 1
+      push(r1);
+      push(0xC0); push(0xFF); push(0x80); push(0x00);
+      break;
+    case (0x80 | 23): // SET_WR_BLK_ERASE_COUNT
+      pre_erased = cmd_arg() & 0x7FFFFF;
+      push(r1);
+      break;
+    case (0x80 | 41): // APP_SEND_OP_CMD
+      idle = 0;
+      push(0x00);
+      break;
+    default:
+      push(r1 | 0x04); // Illegal command
+      break;
+  }
+}
+
+static u8 write_block(){
+  unsigned long us = multi ? sim_disk_spec.multi_write_us : sim_disk_spec.write_us;
+  if(!(seek(address) && (fwrite(block, SECTOR_SIZE, 1, image) == 1))){
+    multi = 0;
+    return 0x0D; // Write error
+  }
+  address++;
+  sim_disk_stat.blocks_written++;
+  if(pre_erased > 0){
+    pre_erased--;
+  }else if((sim_disk_spec.erase_interval > 0)
+      && (++not_erased >= sim_disk_spec.erase_interval)){
+    us += sim_disk_spec.erase_us;
+    not_erased = 0;
+  }
+  busy(us);
+  return 0x05; // Data accepted
+}
+
+unsigned char spi_write_read_byte(unsigned char byte){
+  u8 res = 0xFF;
+  elapse_byte();
+  if(NSSMD0){return 0xFF;} // deselected
+
+  if(resp_pos < resp_len){
+    if((resp_pos == resp_data_pos) && (sim_now_us < resp_after_us)){
+      return 0xFF; // data token is not ready
+    }
+    res = resp[resp_pos++];
+    if(resp_pos == resp_len){resp_data_pos = 0; resp_after_us = 0;}
+    return res;
+  }
+  if(sim_now_us < busy_until_us){return 0x00;} // busy
+
+  switch(state){
+    case SD_COMMAND:
+      if(cmd_len == 0){
+        if((byte & 0xC0) != 0x40){break;}
+      }
+      cmd[cmd_len++] = byte;
+      if(cmd_len == sizeof(cmd)){
+        cmd_len = 0;
+        command();
+      }
+      break;
+    case SD_WRITE_TOKEN:
+      if(byte == 0xFF){break;}
+      if(multi && (byte == 0xFD)){ // Stop Tran
+        multi = 0;
+        pre_erased = 0;
+        state = SD_STOP;
+        break;
+      }
+      if(byte == (multi ? 0xFC : 0xFE)){
+        block_len = 0;
+        state = SD_WRITE_DATA;
+        break;
+      }
+      if((byte & 0xC0) == 0x40){ // command aborts the transfer
+        multi = 0;
+        state = SD_COMMAND;
+        cmd[cmd_len++] = byte;
+      }
+      break;
+    case SD_WRITE_DATA:
+      block[block_len++] = byte;
+      if(block_len == sizeof(block)){
+        resp_len = resp_pos = 0;
+        push(0xE0 | write_block()); // data response
+        state = multi ? SD_WRITE_TOKEN : SD_COMMAND;
+      }
+      break;
+    case SD_STOP:
+      busy(sim_disk_spec.stop_us);
+      state = SD_COMMAND;
+      break;
+  }
+  return res;
+}
+
+void spi_send_8clock(){
+  spi_write_read_byte(0xFF);
+}
+
+void spi_read(unsigned char * pchar, unsigned int length){
+  while(length--){
+    *(pchar++) = spi_write_read_byte(0xFF);
+  }
+}
+
+void spi_write(unsigned char * pchar, unsigned int length){
+  while(length--){
+    spi_write_read_byte(*(pchar++));
+  }
+}
+
+int sim_disk_open(const char *fname, unsigned long sectors){
+  static const u8 zero[SECTOR_SIZE] = {0};
+  sim_disk_close();
+  if(!(image = fopen(fname, "w+b"))){return -1;}
+  // Extend to the specified size, which is sparse on most file systems
+  if((fseek(image, (long)(sectors - 1) * SECTOR_SIZE, SEEK_SET) != 0)
+      || (fwrite(zero, SECTOR_SIZE, 1, image) != 1)){
+    sim_disk_close();
+    return -1;
+  }
+  image_sectors = sectors;
+  memset(&sim_disk_stat, 0, sizeof(sim_disk_stat));
+  state = SD_COMMAND;
+  idle = app_cmd = multi = 0;
+  cmd_len = 0;
+  resp_len = resp_pos = 0;
+  resp_data_pos = 0;
+  resp_after_us = busy_until_us = 0;
+  pre_erased = not_erased = 0;
+  return 0;
+}
+
+void sim_disk_close(){
+  if(image){
+    fclose(image);
+    image = NULL;
+  }
+  image_sectors = 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ * 
+ * - Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, 
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#ifndef __SIM_H__
+#define __SIM_H__
+
+/*
+ * Common definitions of host-side simulator of data_hub logging pipeline.
+ * Simulated time advances only by the modeled cost of each operation,
+ * therefore results do not depend on the performance of the host.
+ */
+
+extern unsigned long long sim_now_us; ///< simulated time in microseconds
+
+/**
+ * Advance simulated time, during which sensors generate samples
+ *
+ * @param us elapsed time in microseconds
+ */
+void sim_elapse(unsigned long us);
+
+/**
+ * Cost model of SD card accessed via SPI.
+ * Transfer time of each byte is derived from SPI clock and byte_ns.
+ */
+typedef struct {
+  unsigned long byte_ns; ///< software overhead per byte in addition to 8 SPI clocks
+  unsigned long read_us; ///< access time before data token of read
+  unsigned long write_us; ///< busy time after a block of single block write (CMD24)
+  unsigned long multi_write_us; ///< busy time after a block of multiple block write (CMD25)
+  unsigned long stop_us; ///< busy time after Stop Tran token of multiple block write
+  unsigned long erase_us; ///< additional busy time to erase
+  unsigned long erase_interval; ///< erase_us is inserted after every this number of written blocks not pre-erased by ACMD23
+} sim_disk_spec_t;
+
+typedef struct {
+  unsigned long commands;
+  unsigned long single_writes; ///< number of CMD24
+  unsigned long multi_writes; ///< number of CMD25
+  unsigned long blocks_written;
+  unsigned long blocks_read;
+  unsigned long long busy_us; ///< total time spent for SPI transfer including busy wait
+} sim_disk_stat_t;
+
+extern sim_disk_spec_t sim_disk_spec;
+extern sim_disk_stat_t sim_disk_stat;
+
+/**
+ * Open or create a disk image file used as SD card
+ *
+ * @param fname file name
+ * @param sectors number of sectors
+ * @return 0 on success
+ */
+int sim_disk_open(const char *fname, unsigned long sectors);
+void sim_disk_close();
+
+/**
+ * Cost model of MPU-9250 accessed via bit-banged SPI
+ */
+typedef struct {
+  unsigned long byte_ns; ///< transfer time of each byte
+  unsigned long cs_us; ///< wait after each change of chip select
+} sim_mpu9250_spec_t;
+
+typedef struct {
+  unsigned long generated; ///< number of samples
+  unsigned long overflow; ///< samples not stored entirely due to full FIFO
+  unsigned long long first_us; ///< time of the first sample
+  unsigned long interval_us; ///< sampling interval
+} sim_mpu9250_stat_t;
+
+extern sim_mpu9250_spec_t sim_mpu9250_spec;
+extern sim_mpu9250_stat_t sim_mpu9250_stat;
+
+/**
+ * Generate the synthetic FIFO record of MPU-9250
+ *
+ * @param k sample number
+ * @param record accelerometer, temperature, gyro (big endian),
+ * and AK8963 HXL to ST2 (little endian), 21 bytes in total
+ */
+void sim_mpu9250_record(unsigned long k, unsigned char record[21]);
+
+/**
+ * Reset MPU-9250 model, which must be followed by mpu9250_init()
+ */
+void sim_mpu9250_reset();
+
+#endif /* __SIM_H__ */
@@ -32,6 +32,20 @@
 #ifndef __TYPE_H__
 #define __TYPE_H__
 
+#if !(defined(__SDCC) || defined(SDCC))
+/* Host build, such as simulator; widths are adjusted to those of 8051 */
+#include <stdint.h>
+typedef uint8_t u8;
+typedef int8_t s8;
+typedef uint16_t u16;
+typedef int16_t s16;
+typedef uint32_t u32;
+typedef int32_t s32;
+
+typedef uint8_t UCHAR;
+typedef uint16_t UINT;
+typedef uint32_t ULONG;
+#else
 typedef unsigned char u8;
 typedef signed char s8;
 typedef unsigned short u16;
@@ -42,6 +56,7 @@ typedef signed long s32;
 typedef unsigned char UCHAR;
 typedef unsigned int UINT;
 typedef unsigned long ULONG;
+#endif
 
 #ifndef TRUE
 #define TRUE 1
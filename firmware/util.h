@@ -70,11 +70,12 @@ u16 swap_u16(u16 w);
     nop \
   __endasm; \
 }
-#else
-#define le_u32(dw)
-#define le_u16(w)
-#define be_u32(dw)
-#define be_u16(w)
+#else // Host build, assuming little endian
+#define le_u32(dw) (dw)
+#define le_u16(w) (w)
+#define be_u32(dw) swap_u32(dw)
+#define be_u16(w) swap_u16(w)
+#define _nop_()
 #endif
 
 #define min(a,b) (((a)<(b))?(a):(b))
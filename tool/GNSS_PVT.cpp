@@ -0,0 +1,204 @@
+/**
+ * @file GNSS standalone PVT calculator for RINEX observation
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program calculates position, velocity, and time (PVT) of a GNSS receiver
+ * epoch by epoch from a RINEX observation file and RINEX navigation file(s).
+ * Epochs are solved in parallel, and the results are output in the input order
+ * with the same CSV format as the GPS solution of INS_GPS.
+ *
+ * Its usage is
+ *   GNSS_PVT [option(s)] --rinex_nav=<nav_file> <obs_file>,
+ * where <obs_file> is RINEX (version 2) observation file, and - (hyphen)
+ * stands for the standard input.
+ *
+ * The options are
+ *   --rinex_nav=<nav_file>
+ *     specifies RINEX navigation file, which can be specified multiple times.
+ *   --threads=<N>
+ *     specifies the number of threads. Its default is the number of cores.
+ *   --batch_size=<N>
+ *     specifies the number of epochs loaded and solved at once (default 4096).
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ *   --start_gpst=[week:]itow, --end_gpst=[week:]itow
+ *     limit the time range of output.
+ *   --GNSS_elv_mask_deg, --F10.7, --GNSS_RAIM, --GNSS_RAIM_sigma,
+ *   --GNSS_delay_cache, --GNSS_smoothing, --GNSS_with, --GNSS_without, --GNSS_L2
+ *     are the same as those of INS_GPS.
+ */
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#define _USE_MATH_DEFINES
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include "INS_GPS/GNSS_Receiver.h"
+#include "navigation/GPS_Solver_Batch.h"
+#include "navigation/ninjascan_nav.h"
+
+#include "analyze_common.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+typedef GNSS_Receiver<float_sylph_t> receiver_t;
+typedef GPS_Solver_Batch<float_sylph_t, receiver_t::gps_solver_t> batch_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  unsigned int threads;
+  unsigned int batch_size;
+
+  Options()
+      : super_t(),
+      threads(batch_t::concurrency()), batch_size(0x1000) {}
+  ~Options(){}
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+    if(value = get_value(spec, "threads", false)){
+      int v(std::atoi(value));
+      if(v <= 0){
+        cerr << "(error!) Invalid number of threads!" << value << endl;
+        exit(-1);
+      }
+      threads = v;
+      cerr << "threads: " << threads << endl;
+      return true;
+    }
+    if(value = get_value(spec, "batch_size", false)){
+      int v(std::atoi(value));
+      if(v <= 0){
+        cerr << "(error!) Invalid batch size!" << value << endl;
+        exit(-1);
+      }
+      batch_size = v;
+      cerr << "batch_size: " << batch_size << endl;
+      return true;
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+struct pvt_writer_t {
+  unsigned int solved, total;
+  pvt_writer_t() : solved(0), total(0) {}
+  void operator()(const batch_t::epoch_t &epoch, const batch_t::user_pvt_t &pvt){
+    if(!options.is_time_in_range(epoch.t.seconds, epoch.t.week)){return;}
+    ++total;
+    if(pvt.position_solved()){++solved;}
+    options.out() << receiver_t::pvt_printer_t(pvt) << endl;
+  }
+};
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "GNSS standalone PVT calculator" << endl;
+  cerr << "Usage: (exe) [options] --rinex_nav=nav_file obs_file" << endl;
+  if(argc < 2){
+    cerr << "Error: too few arguments; " << argc << " < min(2)" << endl;
+    return -1;
+  }
+
+  receiver_t receiver;
+  int obs_index(0);
+
+  for(int i(1); i < argc; i++){
+    if(receiver.check_spec(options, argv[i], true)){
+      if(!receiver.check_spec(options, argv[i])){exit(-1);}
+      continue;
+    }
+    if(options.check_spec(argv[i])){continue;}
+    if(obs_index != 0){ // Detect unknown option by multiple substitution to obs_index.
+      cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+      return -1;
+    }
+    obs_index = i;
+  }
+
+  if(obs_index == 0){
+    cerr << "(error!) No observation file." << endl;
+    return -1;
+  }
+
+  cerr << "RINEX Observation file: ";
+  RINEX_OBS_Reader<float_sylph_t> reader(options.spec2istream(argv[obs_index]));
+
+  batch_t batch(receiver.data.gps.space_node, receiver.data.gps.solver_options);
+  batch.threads = options.threads;
+  batch.batch_size = options.batch_size;
+  batch.smoother = receiver.smoother();
+#if !defined(BUILD_WITHOUT_GNSS_MULTI_FREQUENCY)
+  batch.add_rule("C2", receiver_t::gps_solver_t::measurement_items_t::L2CM_PSEUDORANGE);
+#endif
+  if(batch.resolve(reader) == 0){
+    cerr << "(error!) No available observation type." << endl;
+    return -1;
+  }
+
+  options.out() << setprecision(10);
+  options.out() << receiver_t::pvt_printer_t::label << endl;
+
+  pvt_writer_t writer;
+  int epochs(batch.run(reader, writer));
+
+  cerr << "Epochs (read, output, solved) = "
+      << epochs << ", " << writer.total << ", " << writer.solved << endl;
+  if(batch.smoother){
+    const batch_t::smoother_t::statistics_t &stat(batch.smoother->statistics);
+    cerr << "Smoothed pseudoranges: " << stat.smoothed
+        << ", Slips (Doppler, geometry-free, code) = "
+        << stat.slips_doppler << ", "
+        << stat.slips_geometry_free << ", "
+        << stat.slips_code << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file GNSS signal acquisition for recorded IF/baseband samples
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program searches GPS L1 C/A signals in recorded IF or baseband samples,
+ * and outputs a CSV table of PRN, acquisition flag, code phase, Doppler and C/N0.
+ *
+ * Its usage is
+ *   GNSS_acquisition [option(s)] <sample_file>,
+ * where <sample_file> is a binary file of signed integer samples, and - (hyphen)
+ * stands for the standard input.
+ *
+ * The options are
+ *   --sampling_rate=<Hz>
+ *     specifies the sampling rate (default 4.092E6).
+ *   --IF=<Hz>
+ *     specifies the intermediate frequency (default 0, i.e., baseband).
+ *   --format=<int8|int16>
+ *     specifies the sample type (default int8).
+ *   --real=<on|off>
+ *     specifies real (I only) samples; otherwise interleaved I/Q samples (default off).
+ *   --skip=<seconds>
+ *     skips the beginning of the samples.
+ *   --doppler_max=<Hz>, --doppler_step=<Hz>
+ *     specify the Doppler search range and step (default 5000 and 500).
+ *   --coherent_ms=<N>, --non_coherent=<N>
+ *     specify the coherent integration length [ms] and the number of
+ *     non-coherent accumulation (default 1 and 10).
+ *   --threshold=<ratio>
+ *     specifies the threshold of the first to second peak ratio (default 2.5).
+ *   --PRN=<N>
+ *     specifies a PRN to be searched, which can be specified multiple times.
+ *     All PRNs (1-32) are searched if not specified.
+ *   --threads=<N>
+ *     specifies the number of threads. Its default is the number of cores.
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ */
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#define _USE_MATH_DEFINES
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "navigation/GPS_Acquisition.h"
+#include "util/thread_pool.h"
+#include "navigation/ninjascan_nav.h"
+
+#include "analyze_common.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+typedef GPS_Acquisition<float_sylph_t> acquisition_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  acquisition_t::options_t acq;
+  int sample_bytes;
+  bool real_sample;
+  float_sylph_t skip;
+  vector<int> prns;
+
+  Options()
+      : super_t(),
+      acq(), sample_bytes(1), real_sample(false), skip(0), prns() {
+    acq.non_coherent = 10;
+    acq.threads = ThreadPool::concurrency();
+  }
+  ~Options(){}
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+#define CHECK_FLOAT(key, target) \
+    if(value = get_value(spec, key, false)){ \
+      target = std::atof(value); \
+      cerr << key << ": " << target << endl; \
+      return true; \
+    }
+#define CHECK_POSITIVE_INT(key, target) \
+    if(value = get_value(spec, key, false)){ \
+      int v(std::atoi(value)); \
+      if(v <= 0){ \
+        cerr << "(error!) Invalid " << key << "!" << value << endl; \
+        exit(-1); \
+      } \
+      target = v; \
+      cerr << key << ": " << target << endl; \
+      return true; \
+    }
+    CHECK_FLOAT("sampling_rate", acq.sampling_rate);
+    CHECK_FLOAT("IF", acq.intermediate_frequency);
+    CHECK_FLOAT("doppler_max", acq.doppler_max);
+    CHECK_FLOAT("doppler_step", acq.doppler_step);
+    CHECK_FLOAT("threshold", acq.peak_ratio_threshold);
+    CHECK_FLOAT("skip", skip);
+    CHECK_POSITIVE_INT("coherent_ms", acq.coherent_ms);
+    CHECK_POSITIVE_INT("non_coherent", acq.non_coherent);
+    CHECK_POSITIVE_INT("threads", acq.threads);
+#undef CHECK_FLOAT
+#undef CHECK_POSITIVE_INT
+    if(value = get_value(spec, "format", false)){
+      if(std::strcmp(value, "int8") == 0){
+        sample_bytes = 1;
+      }else if(std::strcmp(value, "int16") == 0){
+        sample_bytes = 2;
+      }else{
+        cerr << "(error!) Unknown format!" << value << endl;
+        exit(-1);
+      }
+      cerr << "format: " << value << endl;
+      return true;
+    }
+    if(value = get_value(spec, "real", true)){
+      real_sample = is_true(value);
+      cerr << "real: " << (real_sample ? "on" : "off") << endl;
+      return true;
+    }
+    if(value = get_value(spec, "PRN", false)){
+      int prn(std::atoi(value));
+      if((prn < 1) || (prn > 32)){
+        cerr << "(error!) Invalid PRN!" << value << endl;
+        exit(-1);
+      }
+      prns.push_back(prn);
+      cerr << "PRN: " << prn << endl;
+      return true;
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+/**
+ * Read samples and convert them to complex
+ *
+ * @param in input stream
+ * @param buf output buffer, whose length is the number of samples to be read
+ * @return (bool) true when all samples are read
+ */
+bool read_samples(istream &in, vector<acquisition_t::complex_t> &buf){
+  const int values_per_sample(options.real_sample ? 1 : 2);
+  const int chunk_samples(0x1000);
+  vector<char> raw(chunk_samples * values_per_sample * options.sample_bytes);
+  for(unsigned int i(0); i < buf.size(); ){
+    unsigned int n(buf.size() - i);
+    if(n > (unsigned int)chunk_samples){n = chunk_samples;}
+    in.read(&raw[0], n * values_per_sample * options.sample_bytes);
+    if(in.gcount() != (streamsize)(n * values_per_sample * options.sample_bytes)){return false;}
+    for(unsigned int j(0); j < n * values_per_sample; j += values_per_sample, ++i){
+      float_sylph_t v[2] = {0};
+      for(int k(0); k < values_per_sample; ++k){
+        if(options.sample_bytes == 1){
+          v[k] = (signed char)raw[j + k];
+        }else{ // little endian
+          const unsigned char *p((const unsigned char *)&raw[(j + k) * 2]);
+          v[k] = (short)(p[0] | (p[1] << 8));
+        }
+      }
+      buf[i] = acquisition_t::complex_t(v[0], v[1]);
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "GNSS signal acquisition" << endl;
+  cerr << "Usage: (exe) [options] sample_file" << endl;
+  if(argc < 2){
+    cerr << "Error: too few arguments; " << argc << " < min(2)" << endl;
+    return -1;
+  }
+
+  int in_index(0);
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    if(in_index != 0){ // Detect unknown option by multiple substitution to in_index.
+      cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+      return -1;
+    }
+    in_index = i;
+  }
+
+  if(in_index == 0){
+    cerr << "(error!) No sample file." << endl;
+    return -1;
+  }
+
+  cerr << "Sample file: ";
+  istream &in(options.spec2istream(argv[in_index]));
+
+  acquisition_t acq(options.acq, options.prns);
+
+  { // skip
+    const int bytes_per_sample(options.sample_bytes * (options.real_sample ? 1 : 2));
+    vector<char> buf(0x10000);
+    for(unsigned long long skip_bytes(
+          (unsigned long long)(options.skip * options.acq.sampling_rate) * bytes_per_sample);
+        skip_bytes > 0; ){
+      streamsize n((skip_bytes > buf.size()) ? buf.size() : (streamsize)skip_bytes);
+      in.read(&buf[0], n);
+      if(in.gcount() != n){
+        cerr << "(error!) Too short sample file." << endl;
+        return -1;
+      }
+      skip_bytes -= n;
+    }
+  }
+
+  vector<acquisition_t::complex_t> samples(acq.required_samples());
+  if(!read_samples(in, samples)){
+    cerr << "(error!) Too short sample file; "
+        << samples.size() << " samples are required." << endl;
+    return -1;
+  }
+
+  vector<acquisition_t::result_t> res(acq.search(&samples[0]));
+
+  options.out() << "PRN,acquired,code_phase(chip),code_offset(sample),doppler(Hz),CN0(dB-Hz),peak_ratio" << endl;
+  int acquired(0);
+  for(unsigned int i(0); i < res.size(); ++i){
+    const acquisition_t::result_t &r(res[i]);
+    if(r.acquired){++acquired;}
+    options.out() << r.prn << ','
+        << (r.acquired ? 1 : 0) << ','
+        << fixed << setprecision(3) << r.code_phase << ','
+        << r.code_offset << ','
+        << setprecision(1) << r.doppler << ','
+        << r.cn0 << ','
+        << setprecision(3) << r.peak_ratio << endl;
+  }
+  cerr << "Acquired satellites: " << acquired << " / " << res.size() << endl;
+
+  return 0;
+}
@@ -135,11 +135,19 @@
  *      "--loosely=self_pv(t)" are methods to use the raw measurement, but solve position, and
  *      velocity (and clock in "self_pvt") with them by using a built-in solver instead of
  *      a GPS receiver.
+ *   --tdcp=<off|on|sigma [m]>
+ *      uses time-differenced carrier phase (TDCP) between successive epochs in addition to
+ *      pseudo-range and range rate. This option is active when the integration method is
+ *      "--tightly". Its standard deviation can be specified instead of "on" (default 0.05).
+ *      The default is off.
  *   --out_raw_pvt=file
  *      generates outputs of PVT solution to the specified file.
  *      This option is active when the integration method is other than "--loosely".
  *   --rinex_nav=file
  *      assists built-in GNSS solver by using ephemeris data in the specified file.
+ *      When it contains Galileo ephemerides, which are not excluded by --GNSS_without,
+ *      an inter-system bias between Galileo and GPS is added to the states of
+ *      the methods using raw measurement.
  *   --GNSS_elv_mask_deg=(angle [deg])
  *      excludes observation of GNSS satellites which locates under the specified angle.
  *      The default mask angle is zero.
@@ -149,8 +157,58 @@
  *      to --GNSS_with=GPS:-4, --GNSS_without=4, and --GNSS_with=-4.
  *      If "specific_satellite" does not include satellite number, whole satellites of a specific
  *      system are excluded. For example, "--without=GPS" filters out whole GPS satellites.
+ *   --GNSS_RAIM=<off|on>
+ *      applies receiver autonomous integrity monitoring with fault detection and exclusion
+ *      to the built-in GNSS solver. Protection levels are appended to --out_raw_pvt outputs.
+ *      The default is off.
+ *   --GNSS_RAIM_sigma=(sigma [m])
+ *      specifies standard deviation of range error used for RAIM. The default is 5.
+ *   --GNSS_smoothing=<off|on|length>
+ *      smooths pseudoranges with carrier phase (or Doppler when carrier phase is unavailable)
+ *      before they are used in the built-in GNSS solver and the tightly coupled filter.
+ *      Smoothing is restarted when a cycle slip is detected. "on" means length of 100 epochs.
+ *      The default is off.
+ *   --GNSS_delay_cache=<on|off>
+ *      reuses ionospheric and tropospheric delays of each satellite unless its geometry
+ *      changes noticeably. The default is on.
+ *   --profile=<off|on|json>
+ *      prints elapsed time, number of calls and allocations of the major routines, such as
+ *      decoding, sorting, filtering, GNSS solving and output, to stderr at exit.
+ *      "json" changes the format of the report to JSON. The default is off.
+ *      This option is effective only when the program is built with USE_PROFILE macro,
+ *      for example, "make CPPFLAGS=-DUSE_PROFILE".
+ *   --debug=<KF_P|KF_FULL|KF_P_trace|pure_inertial> --out_debug=file
+ *      outputs internal information of the filter to the file specified by --out_debug.
+ *      "KF_P" and "KF_FULL" generate CSV of the error covariance matrix P and the other
+ *      matrices of Kalman filter, respectively. "KF_P_trace" generates a compact binary trace
+ *      of the upper triangle of P, which can be converted to CSV with trace_CSV.
+ *      "pure_inertial" disables measurement updates.
+ *   --checkpoint=file --checkpoint_interval=(interval [s]) --checkpoint_keep
+ *      saves the navigation state to the specified file periodically (default every 60 s
+ *      in GPS time). With --checkpoint_keep, each checkpoint is kept as "file.(itow)" instead of
+ *      being overwritten. A checkpoint is effective only for the same log and the same options.
+ *   --resume=file
+ *      resumes processing from a checkpoint. The outputs following it are the same as the ones
+ *      of the run without interruption.
+ *   --stop_itow=(itow [s])
+ *      stops processing at the specified time (and saves a checkpoint with --checkpoint).
+ *      Combined with --resume, a log can be divided into time ranges processed separately.
+ *
+ * Build note:
+ *   By default (BUILD_WITH_COMPOSED_NAV), only the options affecting the filter computation,
+ *   such as Kalman filter, gravity model, coupling, bias estimation and synchronization strategy,
+ *   are instantiated as distinct filter types, and time stamp format and debug output are
+ *   switched at runtime. When the program is built with BUILD_WITH_DISTINCT_NAV macro,
+ *   for example, "make CPPFLAGS=-DBUILD_WITH_DISTINCT_NAV", a filter type is instantiated
+ *   for every combination of the options. The results are the same, which is checked by
+ *   "make check_composed_nav", and the default binary is less than half the size
+ *   and builds about twice as fast.
  */
 
+#if !defined(BUILD_WITH_DISTINCT_NAV)
+#define BUILD_WITH_COMPOSED_NAV
+#endif
+
 // Comment-In when QNAN DEBUG
 //#include <float.h>
 //unsigned int fp_control_state = _controlfp(_EM_INEXACT, _MCW_EM);
@@ -166,6 +224,7 @@
 #include <cmath>
 #include <cstring>
 #include <cctype>
+#include <typeinfo>
 
 #include <vector>
 #include <list>
@@ -175,6 +234,10 @@
 #include <algorithm>
 #include <bitset>
 
+#define PROFILE_MAIN // to count allocations when USE_PROFILE is defined
+#include "util/profile.h"
+#include "util/checkpoint.h"
+
 #define IS_LITTLE_ENDIAN 1
 #include "SylphideStream.h"
 #include "SylphideProcessor.h"
@@ -189,14 +252,9 @@ typedef double float_sylph_t;
 //signal_status̃t@Ci[ϐ`
 std::vector < std::vector < std::string >> signal_status(36000, std::vector <std::string>(74));
 
-template <>
-struct Vector3Data_TypeMapper<float_sylph_t> {
-  typedef Vector3Data_NoFlyWeight<float_sylph_t> res_t;
-};
-template <>
-struct QuaternionData_TypeMapper<float_sylph_t> {
-  typedef QuaternionData_NoFlyWeight<float_sylph_t> res_t;
-};
+// Vector3<float_sylph_t> and Quaternion<float_sylph_t> without flyweight,
+// whose INS products are provided by libninjascan_nav_no_flyweight
+#include "navigation/ninjascan_nav_no_flyweight.h"
 
 #include "algorithm/kalman.h"
 
@@ -213,6 +271,8 @@ struct QuaternionData_TypeMapper<float_sylph_t> {
 #include "INS_GPS/GNSS_Data.h"
 #include "INS_GPS/GNSS_Receiver.h"
 
+#include "navigation/ninjascan_nav.h"
+
 struct Options : public GlobalOptions<float_sylph_t> {
   typedef GlobalOptions<float_sylph_t> super_t;
 
@@ -274,6 +334,7 @@ struct Options : public GlobalOptions<float_sylph_t> {
 
   INS_GPS_Back_Propagate_Property<float_sylph_t> back_propagate_property;
   INS_GPS_RealTime_Property<float_sylph_t> realttime_property;
+  INS_GPS2_Tightly_TDCP_Property<float_sylph_t> tdcp_property;
 
   // GPS options
   bool gps_fake_lock; ///< true when gps dummy date is used.
@@ -323,6 +384,23 @@ struct Options : public GlobalOptions<float_sylph_t> {
 
   // Debug
   INS_GPS_Debug_Property<float_sylph_t> debug_property;
+  enum {
+    PROFILE_OFF,
+    PROFILE_ON,
+    PROFILE_JSON,
+  } profile; ///< Report of instrumentation at exit
+
+  // Checkpoint
+  struct checkpoint_t {
+    const char *fname; ///< file to which checkpoints are written, or NULL
+    float_sylph_t interval; ///< interval [s] of checkpoints in log time
+    bool keep; ///< true for keeping every checkpoint, whose file name is suffixed with its time
+    const char *resume_fname; ///< checkpoint from which processing is resumed, or NULL
+    float_sylph_t stop_itow; ///< processing is stopped after this time, or ignored when non-positive
+    checkpoint_t()
+        : fname(NULL), interval(60), keep(false),
+        resume_fname(NULL), stop_itow(0) {}
+  } checkpoint;
 
   Options()
       : super_t(),
@@ -333,6 +411,7 @@ struct Options : public GlobalOptions<float_sylph_t> {
       est_bias(true), use_udkf(false), use_egm(false),
       back_propagate_property(),
       realttime_property(),
+      tdcp_property(),
       gps_fake_lock(false), gps_threshold(),
       use_magnet(false),
       mag_heading_accuracy_deg(3),
@@ -340,7 +419,8 @@ struct Options : public GlobalOptions<float_sylph_t> {
       initial_attitude(),
       init_misc_buf(), init_misc(&init_misc_buf),
       out_raw_pvt(NULL),
-      debug_property() {
+      debug_property(), profile(PROFILE_OFF),
+      checkpoint() {
     realttime_property.rt_mode = INS_GPS_RealTime_Property<float_sylph_t>::RT_LIGHT_WEIGHT;
   }
   ~Options(){}
@@ -416,6 +496,14 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION(bp_depth, false,
         back_propagate_property.back_propagate_depth = std::atof(value),
         back_propagate_property.back_propagate_depth);
+    CHECK_OPTION(tdcp, true,
+        if(is_true(value)){tdcp_property.enabled = true;}
+        else if(std::atof(value) > 0){
+          tdcp_property.enabled = true;
+          tdcp_property.sigma = std::atof(value);
+        }else{tdcp_property.enabled = false;},
+        (tdcp_property.enabled ? "on" : "off")
+          << " (sigma: " << tdcp_property.sigma << " [m])");
 
     CHECK_ALIAS(fake_lock);
     CHECK_OPTION_BOOL(gps_fake_lock);
@@ -463,6 +551,27 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION(debug, false,
         if(!debug_property.check_debug_property_spec(value)){break;},
         debug_property.show_debug_property());
+    CHECK_OPTION(profile, true,
+        if(is_true(value)){profile = PROFILE_ON;}
+        else if(std::strcmp(value, "json") == 0){profile = PROFILE_JSON;}
+        else{profile = PROFILE_OFF;},
+        (profile == PROFILE_JSON ? "json" : (profile == PROFILE_ON ? "on" : "off")));
+
+    CHECK_OPTION(checkpoint, false,
+        checkpoint.fname = value,
+        value);
+    CHECK_OPTION(checkpoint_interval, false,
+        if((checkpoint.interval = std::atof(value)) <= 0){return false;},
+        checkpoint.interval << " [s]");
+    CHECK_OPTION(checkpoint_keep, true,
+        checkpoint.keep = is_true(value),
+        (checkpoint.keep ? "on" : "off"));
+    CHECK_OPTION(resume, false,
+        checkpoint.resume_fname = value,
+        value);
+    CHECK_OPTION(stop_itow, false,
+        checkpoint.stop_itow = std::atof(value),
+        checkpoint.stop_itow << " [s]");
 #undef CHECK_OPTION
     
     return super_t::check_spec(spec);
@@ -489,6 +598,11 @@ struct CalendarTimeStamp : public CalendarTime<FloatT> {
     operator=(t);
   }
   operator float_t() const {return itow;}
+  template <class Archive>
+  void checkpoint(Archive &ar){
+    ar & super_t::year & super_t::month & super_t::mday & super_t::hour & super_t::min
+        & super_t::sec & itow;
+  }
   static struct label_t {
     friend std::ostream &operator<<(std::ostream &out, const label_t &){
       return out << "year" << ','
@@ -511,6 +625,37 @@ struct CalendarTimeStamp : public CalendarTime<FloatT> {
 template <class FloatT>
 typename CalendarTimeStamp<FloatT>::label_t CalendarTimeStamp<FloatT>::label;
 
+/**
+ * Time stamp whose format, time of week or calendar time, is selected at runtime
+ * in accordance with options.time_stamp.mode.
+ * It is used instead of switching types of time stamp with BUILD_WITH_COMPOSED_NAV.
+ */
+template <class FloatT>
+struct SelectableTimeStamp : public CalendarTimeStamp<FloatT> {
+  typedef CalendarTimeStamp<FloatT> super_t;
+#if defined(__GNUC__) && (__GNUC__ < 5)
+  typedef typename super_t::float_t float_t;
+#else
+  using typename super_t::float_t;
+#endif
+  SelectableTimeStamp(const CalendarTime<FloatT> &t1, const float_t &t2)
+      : super_t(t1, t2) {}
+  SelectableTimeStamp(const float_t &t = 0) : super_t(t) {}
+  static bool is_calendar_time(){
+    return options.time_stamp.mode == Options::time_stamp_t::CALENDAR_TIME;
+  }
+  static struct label_t {
+    friend std::ostream &operator<<(std::ostream &out, const label_t &){
+      return is_calendar_time() ? (out << super_t::label) : (out << "itow");
+    }
+  } label;
+  friend std::ostream &operator<<(std::ostream &out, const SelectableTimeStamp &time){
+    return is_calendar_time() ? (out << (const super_t &)time) : (out << time.itow);
+  }
+};
+template <class FloatT>
+typename SelectableTimeStamp<FloatT>::label_t SelectableTimeStamp<FloatT>::label;
+
 struct A_Packet;
 struct G_Packet;
 struct G_Packet_Measurement;
@@ -541,8 +686,28 @@ class NAV : public Updatable {
       return updated_items_t();
     }
     virtual void inspect(std::ostream &out) const {}
+    virtual void trace(std::ostream &out, const float_sylph_t &t) const {}
     virtual float_sylph_t &operator[](const unsigned &index) = 0;
 
+    /**
+     * Save state for checkpoint
+     *
+     * @param ar archive
+     * @throw std::runtime_error when checkpoint is not supported
+     */
+    virtual void checkpoint(Checkpoint::Writer &ar){
+      throw std::runtime_error("Checkpoint: unsupported NAV");
+    }
+    /**
+     * Restore state from checkpoint
+     *
+     * @param ar archive
+     * @throw std::runtime_error when checkpoint is not supported, or is broken
+     */
+    virtual void checkpoint(Checkpoint::Reader &ar){
+      throw std::runtime_error("Checkpoint: unsupported NAV");
+    }
+
     template <class Container>
     static typename Container::const_iterator nearest(
         const Container &packets_time_series, const float_sylph_t &itow,
@@ -644,6 +809,7 @@ struct NAV_Factory {
     void updated() const {
       const NAV::updated_items_t &items(BaseNAV::updated_items());
       if(items.empty()){return;}
+      PROFILE_SCOPE("NAV::output");
 
       for(NAV::updated_items_t::const_iterator it(items.begin());
           it != items.end(); ++it){
@@ -657,6 +823,11 @@ struct NAV_Factory {
         }
       }
 
+      if(options.debug_property.debug_target
+          == INS_GPS_Debug_Property<float_sylph_t>::DEBUG_KF_P_TRACE){
+        BaseNAV::trace(options.out_debug(), (**(items.rbegin())).time_stamp());
+        return;
+      }
       options.out_debug() << (**(items.rbegin())).time_stamp() << ',';
       BaseNAV::inspect(options.out_debug());
       options.out_debug() << std::endl;
@@ -728,6 +899,10 @@ struct BasicPacket : public Packet {
 struct A_Packet : public BasicPacket<A_Packet> {
   Vector3<float_sylph_t> accel; ///< Acceleration
   Vector3<float_sylph_t> omega; ///< Angular speed
+  template <class Archive>
+  void checkpoint(Archive &ar){
+    ar & itow & accel & omega;
+  }
 };
 
 /**
@@ -756,8 +931,9 @@ struct G_Packet_Measurement
   };
 
   Vector3<float_sylph_t> *lever_arm;
+  GNSS_Receiver<float_sylph_t>::gps_smoother_t *smoother;
 
-  G_Packet_Measurement() : raw_data_t(), lever_arm(NULL) {}
+  G_Packet_Measurement() : raw_data_t(), lever_arm(NULL), smoother(NULL) {}
 
   void update_measurement(
       const raw_data_t::gps_time_t &t,
@@ -775,6 +951,9 @@ struct G_Packet_Measurement
     BasicPacket<G_Packet_Measurement>::itow = raw_data_t::gpstime.seconds;
 
     raw_data_t::measurement = meas;
+    if(smoother){ // carrier phase smoothing of pseudorange
+      smoother->update(t, raw_data_t::measurement);
+    }
 #if defined(USE_GNSS_RANGE_TIME_DIFFERENCE_AS_RATE) \
 || defined(CHECK_GNSS_DOPPLER_CONSISTENCY)
     { // calculate range rate by using difference between current and previous range.
@@ -864,6 +1043,10 @@ void Updatable::update(const G_Packet_GPS_Ephemeris &packet){
  */
 struct M_Packet : public BasicPacket<M_Packet> {
   Vector3<float_sylph_t> mag;
+  template <class Archive>
+  void checkpoint(Archive &ar){
+    ar & itow & mag;
+  }
 };
 
 struct TimePacket : public BasicPacket<TimePacket> {
@@ -996,26 +1179,40 @@ class INS_GPS_NAV : public NAV {
       {
         mat_t P(ins_gps->getFilter().getP());
         static const unsigned NP(Filtered_INS_ClockErrorEstimated<BaseFINS>::P_SIZE_WITHOUT_CLOCK_ERROR);
-        for(int i(0); i < Filtered_INS_ClockErrorEstimated<BaseFINS>::P_SIZE_CLOCK_ERROR; i += 2){
+        int i(0);
+        for(; i < Filtered_INS_ClockErrorEstimated<BaseFINS>::CLOCKS_SUPPORTED * 2; i += 2){
           P(NP + i,     NP + i)     = 1E4; // TODO
           P(NP + i + 1, NP + i + 1) = 1E2;
         }
+        for(; i < Filtered_INS_ClockErrorEstimated<BaseFINS>::P_SIZE_CLOCK_ERROR; ++i){
+          P(NP + i, NP + i) = 1E2; // inter-system bias, TODO
+        }
         ins_gps->getFilter().setP(P);
       }
 
       {
         mat_t Q(ins_gps->getFilter().getQ());
         static const unsigned NQ(Filtered_INS_ClockErrorEstimated<BaseFINS>::Q_SIZE_WITHOUT_CLOCK_ERROR);
-        for(int i(0); i < Filtered_INS_ClockErrorEstimated<BaseFINS>::P_SIZE_CLOCK_ERROR; i += 2){
+        int i(0);
+        for(; i < Filtered_INS_ClockErrorEstimated<BaseFINS>::CLOCKS_SUPPORTED * 2; i += 2){
           Q(NQ + i,     NQ + i)     = 1E3; // TODO
           Q(NQ + i + 1, NQ + i + 1) = 1E1;
         }
+        for(; i < Filtered_INS_ClockErrorEstimated<BaseFINS>::Q_SIZE_CLOCK_ERROR; ++i){
+          Q(NQ + i, NQ + i) = 1E-4; // inter-system bias is almost constant, TODO
+        }
         ins_gps->getFilter().setQ(Q);
       }
 
       ins_gps->beta_clock_error() *= 1; // TODO
     }
 
+    template <class BaseFINS>
+    void setup_filter(INS_GPS2_Tightly<BaseFINS> *){
+      setup_filter((BaseFINS *)ins_gps);
+      ins_gps->setup_tdcp(options.tdcp_property);
+    }
+
     template <class Base_INS_GPS>
     void setup_filter(INS_GPS_Back_Propagate<Base_INS_GPS> *){
       setup_filter((Base_INS_GPS *)ins_gps);
@@ -1061,6 +1258,15 @@ class INS_GPS_NAV : public NAV {
       inspect(out, ins_gps);
     }
 
+    void trace(std::ostream &out, const float_sylph_t &t, void *) const {}
+    template <class INS_GPS_base>
+    void trace(std::ostream &out, const float_sylph_t &t, INS_GPS_Debug<INS_GPS_base> *) const {
+      ins_gps->trace(out, t);
+    }
+    void trace(std::ostream &out, const float_sylph_t &t) const {
+      trace(out, t, ins_gps);
+    }
+
   protected:
     static void set_matrix_full(mat_t &mat, const char *spec){
       char *_spec(const_cast<char *>(spec));
@@ -1141,6 +1347,16 @@ class INS_GPS_NAV : public NAV {
     }
     
     float_t &operator[](const unsigned &index){return ins_gps->operator[](index);}
+
+  protected:
+    template <class Archive>
+    void checkpoint_nav(Archive &ar){
+      helper.checkpoint(ar);
+      ins_gps->checkpoint(ar);
+    }
+  public:
+    void checkpoint(Checkpoint::Writer &ar){checkpoint_nav(ar);}
+    void checkpoint(Checkpoint::Reader &ar){checkpoint_nav(ar);}
     
     NAV &update(
         const vec3_t &accel,
@@ -1251,15 +1467,21 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
   struct Checker {
     template <class Calibration>
     static NAV *check_covariance(const Calibration &calibration){
+#if defined(BUILD_WITH_COMPOSED_NAV)
+      // debug output is selected at runtime in INS_GPS_Debug_Covariance::inspect() and trace()
+      return INS_GPS_NAV_Factory<INS_GPS_Debug_Covariance<T> >::generate(calibration);
+#else
       typedef INS_GPS_Debug_Property<float_sylph_t> prop_t;
       switch(options.debug_property.debug_target){
         case prop_t::DEBUG_KF_P:
         case prop_t::DEBUG_KF_FULL:
+        case prop_t::DEBUG_KF_P_TRACE:
           return INS_GPS_NAV_Factory<INS_GPS_Debug_Covariance<T> >::generate(calibration);
         case prop_t::DEBUG_NONE:
         default:
           return INS_GPS_NAV_Factory<T>::generate(calibration);
       }
+#endif
     }
 
     template <class Calibration>
@@ -1302,8 +1524,18 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
   public:
   template <class Calibration>
   static NAV *get_nav(const Calibration &calibration){
+#if defined(BUILD_WITH_COMPOSED_NAV)
+    return Checker<INS_GPS>::check_navdata(calibration); // pure inertial is handled by get_pure_ins()
+#else
     return Checker<INS_GPS>::check_pure_ins(calibration);
+#endif
+  }
+#if defined(BUILD_WITH_COMPOSED_NAV)
+  template <class Calibration>
+  static NAV *get_pure_ins(const Calibration &calibration){
+    return Checker<INS_GPS_Debug_PureInertial<INS_GPS> >::check_navdata(calibration);
   }
+#endif
 };
 
 template <class PureINS, class TimeStamp = typename PureINS::float_t>
@@ -1335,6 +1567,12 @@ typename PureINS::float_t fname() const {return PureINS::fname();}
 #undef MAKE_PROXY_FUNC
     typename PureINS::float_t time_stamp() const {return (typename PureINS::float_t)itow;}
 
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      PureINS::checkpoint(ar);
+      ar & itow; // mode is always set before output, however itow may be reused.
+    }
+
     void set_header(const char *_mode) const {
       mode = _mode;
     }
@@ -1352,6 +1590,10 @@ typename PureINS::float_t fname() const {return PureINS::fname();}
       static std::ostream &label(std::ostream &out, const CalendarTimeStamp<FloatT> &){
         return out << CalendarTimeStamp<FloatT>::label;
       }
+      template <class FloatT>
+      static std::ostream &label(std::ostream &out, const SelectableTimeStamp<FloatT> &){
+        return out << SelectableTimeStamp<FloatT>::label;
+      }
       friend std::ostream &operator<<(std::ostream &out, const label_time_t &){
         return label(out, time_stamp_t());
       }
@@ -1430,14 +1672,17 @@ class INS_GPS_NAVData : public INS_GPS {
       }
     }
 
-    template <class BaseINS, unsigned int Clocks>
+    template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
     static void label2(
-        std::ostream &out, const INS_ClockErrorEstimated<BaseINS, Clocks> *ins){
+        std::ostream &out, const INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> *ins){
       label2(out, (const BaseINS *)ins);
-      for(unsigned i(0); i < INS_ClockErrorEstimated<BaseINS, Clocks>::CLOCKS_SUPPORTED; ++i){
+      for(unsigned i(0); i < Clocks; ++i){
         out << ',' << "receiver_clock_error[" << i << "]"
             << ',' << "receiver_clock_error_rate[" << i << "]";
       }
+      for(unsigned i(0); i < InterSystemBiases; ++i){
+        out << ',' << "inter_system_bias[" << i << "]";
+      }
     }
 
     template <class BaseFINS>
@@ -1449,6 +1694,9 @@ class INS_GPS_NAVData : public INS_GPS {
           out << ',' << "s1(receiver_clock_error[" << i << "])"
               << ',' << "s1(receiver_clock_error_rate[" << i << "])";
         }
+        for(unsigned i(0); i < Filtered_INS_ClockErrorEstimated<BaseFINS>::INTER_SYSTEM_BIASES; ++i){
+          out << ',' << "s1(inter_system_bias[" << i << "])";
+        }
       }
     }
 
@@ -1508,13 +1756,17 @@ class INS_GPS_NAVData : public INS_GPS {
       }
     }
 
-    template <class BaseINS, unsigned int Clocks>
+    template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
     void dump2(
-        std::ostream &out, const INS_ClockErrorEstimated<BaseINS, Clocks> *ins) const {
+        std::ostream &out, const INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> *ins) const {
       dump2(out, (const BaseINS *)ins);
-      for(unsigned i(0); i < INS_ClockErrorEstimated<BaseINS, Clocks>::CLOCKS_SUPPORTED; ++i){
-        out << ',' << const_cast<INS_ClockErrorEstimated<BaseINS, Clocks> *>(ins)->clock_error(i)
-            << ',' << const_cast<INS_ClockErrorEstimated<BaseINS, Clocks> *>(ins)->clock_error_rate(i);
+      typedef INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> ins_t;
+      for(unsigned i(0); i < Clocks; ++i){
+        out << ',' << const_cast<ins_t *>(ins)->clock_error(i)
+            << ',' << const_cast<ins_t *>(ins)->clock_error_rate(i);
+      }
+      for(unsigned i(0); i < InterSystemBiases; ++i){
+        out << ',' << const_cast<ins_t *>(ins)->inter_system_bias(i);
       }
     }
 
@@ -1587,6 +1839,7 @@ class StreamProcessor
       }
       ~AHandler(){}
       void operator()(const A_Observer_t &observer){
+        PROFILE_SCOPE("StreamProcessor::AHandler");
         if(!observer.validate()){return;}
 
         float_sylph_t itow(observer.fetch_ITOW());
@@ -2046,6 +2299,7 @@ class StreamProcessor
       }
 
       void operator()(const G_Observer_t &observer){
+        PROFILE_SCOPE("StreamProcessor::GHandler");
         if(!observer.validate()){return;}
 
         G_Observer_t::packet_type_t packet_type(observer.packet_type());
@@ -2074,6 +2328,7 @@ class StreamProcessor
       }
       ~MHandler(){}
       void operator()(const M_Observer_t &observer){
+        PROFILE_SCOPE("StreamProcessor::MHandler");
         if(!observer.validate()){return;}
 
         M_Observer_t::values_t values(observer.fetch_values());
@@ -2135,6 +2390,13 @@ class StreamProcessor
       return updatable;
     }
 
+    /**
+     * @return (int) number of pages read from the stream
+     */
+    int processed_pages() const {
+      return invoked;
+    }
+
     const StandardCalibration<float_sylph_t> &calibration() const{
       return a_handler.calibration;
     }
@@ -2147,6 +2409,7 @@ class StreamProcessor
       receiver.setup(g_handler.loader);
       g_handler.packet_raw_latest.solver = &(receiver.solver());
       g_handler.packet_raw_latest.clock_index = clock_index;
+      g_handler.packet_raw_latest.smoother = receiver.smoother();
     }
 
     /**
@@ -2156,6 +2419,7 @@ class StreamProcessor
      * @return (bool) true when success, otherwise false.
      */
     bool process_1page(){
+      PROFILE_SCOPE("StreamProcessor::process_1page");
       char buffer[SYLPHIDE_PAGE_SIZE];
       
       int read_count;
@@ -2271,7 +2535,7 @@ receivers_t receivers;
 template <class INS_GPS>
 class INS_GPS_NAV<INS_GPS>::Helper {
   protected:
-    enum {
+    enum status_t {
       UNINITIALIZED,
       JUST_INITIALIZED,
       TIME_UPDATED,
@@ -2352,8 +2616,57 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       }
     };
 
+    template <class FloatT>
+    struct TimeStampGenerator<SelectableTimeStamp<FloatT> > {
+      typedef SelectableTimeStamp<FloatT> stamp_t;
+      typename stamp_t::Converter itow2calendar;
+      bool calendar_time;
+      TimeStampGenerator() : itow2calendar(), calendar_time(stamp_t::is_calendar_time()) {
+        if(calendar_time){
+          itow2calendar.correction_sec
+              = 60 * 60 * options.time_stamp.calendar_spec_parse().correction_hr;
+        }
+      }
+      void update(const TimePacket &packet){
+        if(calendar_time){packet.apply<FloatT>(itow2calendar);}
+      }
+      stamp_t operator()(const FloatT &itow) const {
+        return calendar_time ? stamp_t(itow2calendar.convert(itow), itow) : stamp_t(itow);
+      }
+      stamp_t operator()(const FloatT &itow, const int &wn) const {
+        return calendar_time ? stamp_t(itow2calendar.convert(itow, wn), itow) : stamp_t(itow);
+      }
+    };
+
     TimeStampGenerator<typename INS_GPS::time_stamp_t> t_stamp_generator;
 
+    /**
+     * Save or restore state for checkpoint.
+     * t_stamp_generator is excluded, because it is rebuilt by TimePacket during resume.
+     *
+     * @param ar archive
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      ar.enumeration(status);
+      ar & recent_a.buf & recent_m.buf;
+
+      // Only the members of the last PVT used as a hint of the next solution
+      bool pvt_hint(gps_raw_pvt.error_code == G_Packet_Measurement::pvt_t::ERROR_NO);
+      ar & pvt_hint;
+      if(Archive::loading){
+        gps_raw_pvt.error_code = pvt_hint
+            ? G_Packet_Measurement::pvt_t::ERROR_NO
+            : G_Packet_Measurement::pvt_t::ERROR_UNSOLVED;
+      }
+      ar & gps_raw_pvt.receiver_time.week & gps_raw_pvt.receiver_time.seconds
+          & gps_raw_pvt.receiver_error & gps_raw_pvt.receiver_error_rate;
+      for(int i(0); i < 3; ++i){
+        ar & gps_raw_pvt.user_position.xyz[i] & gps_raw_pvt.user_position.llh[i]
+            & gps_raw_pvt.user_velocity_enu[i];
+      }
+    }
+
     void before_any_update(){
       if(status >= JUST_INITIALIZED){
         status = WAITING_UPDATE;
@@ -2361,6 +2674,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     }
 
     void compass(const M_Packet &packet){
+      PROFILE_SCOPE("Helper::compass");
       recent_m.push(packet);
     }
 
@@ -2442,6 +2756,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
 
   protected:
     void time_update(const A_Packet &a_packet, float_t deltaT){
+      PROFILE_SCOPE("Helper::time_update");
 
       static const int one_week(60 * 60 * 7 * 24);
       if(deltaT <= -(one_week / 2)){ // Check roll over
@@ -2568,6 +2883,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
 
     template <class GPS_Packet>
     void measurement_update_common(const GPS_Packet &g_packet){
+      PROFILE_SCOPE("Helper::measurement_update");
       cerr << "MU : " << setprecision(10) << g_packet.itow << endl;
 
       // calculate GPS data timing;
@@ -2697,6 +3013,12 @@ class INS_GPS_NAV<INS_GPS>::Helper {
 
         ins_gps->clock_error(g_packet.clock_index) = gps_raw_pvt.receiver_error;
         ins_gps->clock_error_rate(g_packet.clock_index) = gps_raw_pvt.receiver_error_rate;
+        for(unsigned int i(0); i < INS_GPS2_Tightly<BaseFINS>::INTER_SYSTEM_BIASES; ++i){
+          // ISB of system group (i + 1) from the grouped solution, the same as clock error
+          if((gps_raw_pvt.system_groups & 0x1) && (gps_raw_pvt.system_groups & (2u << i))){
+            ins_gps->inter_system_bias(i) = gps_raw_pvt.inter_system_bias[i + 1];
+          }
+        }
         
         time_update_after_initialization(g_packet);
       }
@@ -2708,50 +3030,345 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     }
 };
 
+/**
+ * Generator of NAV, whose type is determined by options.
+ *
+ * With BUILD_WITH_COMPOSED_NAV (default), only the options changing the filter kernels
+ * (state size, Kalman filter, gravity model, and synchronization strategy) are
+ * instantiated, and the others (time stamp format and debug output) are
+ * selected at runtime, which reduces binary size and build time drastically.
+ * With BUILD_WITH_DISTINCT_NAV, every combination of options is instantiated as a distinct type.
+ */
 class NAV_Generator {
   private:
-    template <class T>
-    static NAV *final(){
-      return INS_GPS_NAV_Factory<typename T::product>::get_nav(processors.front().calibration());
+    struct final_t {
+      template <class T>
+      static NAV *generate(){
+        return INS_GPS_NAV_Factory<typename T::product>::get_nav(processors.front().calibration());
+      }
+    };
+#if defined(BUILD_WITH_COMPOSED_NAV)
+    struct final_pure_ins_t {
+      template <class T>
+      static NAV *generate(){
+        return INS_GPS_NAV_Factory<typename T::product>::get_pure_ins(processors.front().calibration());
+      }
+    };
+#endif
+    /**
+     * @return (int) maximum number of system groups of the configured receivers;
+     * inter-system bias states are added to tightly coupled mode only when it exceeds 1.
+     */
+    static int system_groups(){
+      int res(1);
+      for(receivers_t::const_iterator it(receivers.begin()); it != receivers.end(); ++it){
+        int groups(it->system_groups());
+        if(groups > res){res = groups;}
+      }
+      return res;
     }
-    template <class T>
+    template <class Final, class T>
     static NAV *check_bias(){
-      return options.est_bias ? final<typename T::template bias<> >() : final<T>();
+      return options.est_bias
+          ? Final::template generate<typename T::template bias<> >()
+          : Final::template generate<T>();
     }
-    template <class T>
+    template <class Final, class T>
     static NAV *check_coupling(){
       switch(options.ins_gps_integration){
         case Options::INS_GPS_INTEGRATION_TIGHTLY: // Tightly
         case Options::INS_GPS_INTEGRATION_LOOSELY_SELF_PV: // Loosely with built-in GNSS PV solver
         case Options::INS_GPS_INTEGRATION_LOOSELY_SELF_PVT: // Loosely with built-in GNSS PVT solver
-          return check_bias<typename T::template tightly<> >();
+#if !defined(BUILD_WITHOUT_GNSS_MULTI_CONSTELLATION)
+          if(system_groups() > 1){
+            // ISB of Galileo against GPS/QZSS, see GNSS_Receiver::solver_t::system_group
+            return check_bias<Final, typename T::template tightly<1, 1> >();
+          }
+#endif
+          return check_bias<Final, typename T::template tightly<> >();
         case Options::INS_GPS_INTEGRATION_LOOSELY: // Loosely
         default:
-          return check_bias<T>();
+          return check_bias<Final, T>();
       }
     }
-    template <class T>
+    template <class Final, class T>
     static NAV *check_udkf(){
       return options.use_udkf
-          ? check_coupling<typename T::template kf<KalmanFilterUD> >()
-          : check_coupling<typename T::template kf<KalmanFilter> >();
+          ? check_coupling<Final, typename T::template kf<KalmanFilterUD> >()
+          : check_coupling<Final, typename T::template kf<KalmanFilter> >();
     }
-    template <class T>
+    template <class Final, class T>
     static NAV *check_egm(){
-      return options.use_egm ? check_udkf<typename T::template egm<> >() : check_udkf<T>();
+      return options.use_egm
+          ? check_udkf<Final, typename T::template egm<> >()
+          : check_udkf<Final, T>();
     }
   public:
+#if defined(BUILD_WITH_COMPOSED_NAV)
+    static NAV *generate(){
+      typedef INS_GPS_Factory<
+          INS_NAVData<INS<float_sylph_t>, SelectableTimeStamp<float_sylph_t> > > factory_t;
+      if(options.debug_property.debug_target
+          == INS_GPS_Debug_Property<float_sylph_t>::DEBUG_PURE_INERTIAL){
+        // Kalman filter is not used, therefore its variation is omitted.
+        return options.use_egm
+            ? check_coupling<final_pure_ins_t, factory_t::egm<>::kf<KalmanFilter> >()
+            : check_coupling<final_pure_ins_t, factory_t::kf<KalmanFilter> >();
+      }
+      return check_egm<final_t, factory_t>();
+    }
+#else
     static NAV *generate(){
       switch(options.time_stamp.mode){
         case Options::time_stamp_t::CALENDAR_TIME:
-          return check_egm<INS_GPS_Factory<
+          return check_egm<final_t, INS_GPS_Factory<
               INS_NAVData<INS<float_sylph_t>, CalendarTimeStamp<float_sylph_t> > > >();
         case Options::time_stamp_t::ITOW:
         default:
-          return check_egm<INS_GPS_Factory<
+          return check_egm<final_t, INS_GPS_Factory<
               INS_NAVData<INS<float_sylph_t> > > >();
       }
     }
+#endif
+};
+
+/**
+ * Packet sorter, which applies packets to NAV in time order, and supports checkpoint.
+ *
+ * A checkpoint is taken between pages, and consists of the number of the read pages,
+ * the serial numbers of the packets pending in the pool, the space nodes of the receivers,
+ * and the NAV state.
+ * The other states, such as the pseudorange smoother and partially received packets,
+ * depend only on the log.
+ * Therefore, they are rebuilt during resume by reading the pages again without navigation,
+ * which also regenerates the pending packets.
+ * The space nodes are restored after the reading, and replace the ephemerides loaded by it.
+ */
+struct PacketSorter : public Updatable {
+  struct item_t {
+    const Packet *packet;
+    unsigned int serial;
+    static bool compare_rollover(const item_t &a, const item_t &b){
+      return Packet::compare_rollover(a.packet, b.packet);
+    }
+  };
+  typedef deque<item_t> packet_pool_t;
+  packet_pool_t packet_pool;
+  NAV &nav;
+  const unsigned int depth; ///< number of packets applied at once, zero means without sort
+  unsigned int serial; ///< serial number of the next packet
+  float_sylph_t itow_applied; ///< time of the latest applied packet
+  float_sylph_t itow_checkpoint; ///< time of the latest checkpoint, negative means not yet
+
+  bool resuming;
+  typedef std::map<unsigned int, const Packet *> resumed_t;
+  resumed_t resumed; ///< pending packets in checkpoint, which are regenerated during resume
+
+  void sort_and_apply(int packets){
+    {
+      PROFILE_SCOPE("loop::sort");
+      stable_sort(packet_pool.begin(), packet_pool.end(), item_t::compare_rollover);
+    }
+    while(packets-- > 0){
+      PROFILE_SCOPE("loop::apply");
+      const Packet *front(packet_pool.front().packet);
+      front->apply(nav);
+      if(front->itow > 0){itow_applied = front->itow;}
+      delete front;
+      packet_pool.pop_front();
+    }
+  }
+  void sort_and_apply2 () {
+    if(packet_pool.size() < depth * 2){return;}
+    sort_and_apply(depth > 0 ? depth : packet_pool.size());
+  }
+  PacketSorter(NAV &_nav, const unsigned int &_depth = 0x100)
+      : packet_pool(), nav(_nav), depth(_depth),
+      serial(0), itow_applied(0), itow_checkpoint(-1),
+      resuming(false), resumed() {}
+  ~PacketSorter() {
+    sort_and_apply(packet_pool.size());
+    for(resumed_t::iterator it(resumed.begin()); it != resumed.end(); ++it){
+      delete it->second;
+    }
+  }
+  /**
+   * Drop pending packets without applying them
+   */
+  void discard(){
+    for(packet_pool_t::iterator it(packet_pool.begin()); it != packet_pool.end(); ++it){
+      delete it->packet;
+    }
+    packet_pool.clear();
+  }
+
+  template <class T>
+  void replay(const T &packet){
+    updatable_blackhole.update(packet); // Ephemeris is loaded, and the others are dropped.
+  }
+  void replay(const TimePacket &packet){
+    nav.update(packet);
+  }
+  template <class T>
+  void push(const T &packet){
+    if(resuming){
+      resumed_t::iterator it(resumed.find(serial++));
+      if(it == resumed.end()){
+        replay(packet);
+      }else{
+        it->second = new T(packet);
+      }
+      return;
+    }
+    item_t item = {new T(packet), serial++};
+    packet_pool.push_back(item);
+    sort_and_apply2();
+  }
+#define update_func(type) \
+virtual void update(const type &packet){ \
+  PROFILE_COUNT("loop::push(" #type ")"); \
+  push(packet); \
+}
+  update_func(A_Packet);
+  update_func(G_Packet);
+  update_func(G_Packet_Measurement);
+  update_func(G_Packet_Data);
+  update_func(G_Packet_GPS_Ephemeris);
+  update_func(M_Packet);
+  update_func(TimePacket);
+#undef update_func
+
+  static float_sylph_t interval(const float_sylph_t &from, const float_sylph_t &to){
+    float_sylph_t delta(to - from);
+    static const int one_week(60 * 60 * 24 * 7);
+    return delta - (std::floor((delta / one_week) + 0.5) * one_week);
+  }
+  bool checkpoint_due(){
+    if((!options.checkpoint.fname) || (itow_applied <= 0)){return false;}
+    if(itow_checkpoint < 0){
+      itow_checkpoint = itow_applied;
+      return false;
+    }
+    return interval(itow_checkpoint, itow_applied) >= options.checkpoint.interval;
+  }
+  bool stop_due() const {
+    return (options.checkpoint.stop_itow > 0) && (itow_applied > 0)
+        && (interval(options.checkpoint.stop_itow, itow_applied) >= 0);
+  }
+
+  std::string signature() const {
+    return std::string(typeid(receiver_t).name()).append(",").append(typeid(nav).name());
+  }
+  template <class Archive>
+  void checkpoint(Archive &ar,
+      int &pages, unsigned int &packets, std::vector<unsigned int> &pending){
+    ar & pages & packets & itow_applied & pending;
+  }
+  /**
+   * Save or restore the states which are not rebuilt from the log
+   *
+   * @param ar archive
+   * @throw std::runtime_error when the number of receivers is different
+   */
+  template <class Archive>
+  void checkpoint_states(Archive &ar){
+    unsigned int n((unsigned int)receivers.size());
+    ar & n;
+    if(n != receivers.size()){
+      throw std::runtime_error("Checkpoint: receiver mismatch");
+    }
+    for(receivers_t::iterator it(receivers.begin()); it != receivers.end(); ++it){
+      ar & *it;
+    }
+    nav.checkpoint(ar);
+  }
+
+  /**
+   * Write a checkpoint
+   *
+   * @param pages number of the read pages
+   * @throw std::runtime_error when writing is failed
+   */
+  void save(int pages){
+    PROFILE_SCOPE("loop::checkpoint");
+    std::string fname(options.checkpoint.fname);
+    if(options.checkpoint.keep){
+      std::stringstream ss;
+      ss << fname << '.' << (int)itow_applied;
+      fname = ss.str();
+    }
+    std::string fname_tmp(fname + ".tmp"); // not to break the previous one on failure
+    {
+      std::vector<unsigned int> pending;
+      for(packet_pool_t::const_iterator it(packet_pool.begin()); it != packet_pool.end(); ++it){
+        pending.push_back(it->serial);
+      }
+      std::ofstream out(fname_tmp.c_str(), std::ios::out | std::ios::binary);
+      Checkpoint::Writer ar(out, signature());
+      checkpoint(ar, pages, serial, pending);
+      checkpoint_states(ar);
+      if(!ar.flush()){
+        throw std::runtime_error(std::string("Checkpoint: failed to write ").append(fname_tmp));
+      }
+    }
+#if defined(_WIN32)
+    std::remove(fname.c_str()); // rename() fails when the destination exists
+#endif
+    if(std::rename(fname_tmp.c_str(), fname.c_str()) != 0){
+      throw std::runtime_error(std::string("Checkpoint: failed to rename to ").append(fname));
+    }
+    itow_checkpoint = itow_applied;
+    cerr << "Checkpoint: " << fname
+        << " (itow: " << itow_applied << ", page: " << pages << ")" << endl;
+  }
+
+  /**
+   * Resume from a checkpoint
+   *
+   * @param proc stream processor, which has not read any page yet
+   * @throw std::runtime_error when the checkpoint is invalid, or does not match the log
+   */
+  void resume(StreamProcessor &proc){
+    std::ifstream in(options.checkpoint.resume_fname, std::ios::in | std::ios::binary);
+    if(!in){
+      throw std::runtime_error(
+          std::string("Checkpoint: failed to open ").append(options.checkpoint.resume_fname));
+    }
+    Checkpoint::Reader ar(in, signature());
+    int pages;
+    unsigned int packets;
+    std::vector<unsigned int> pending;
+    checkpoint(ar, pages, packets, pending);
+
+    for(std::vector<unsigned int>::const_iterator it(pending.begin()); it != pending.end(); ++it){
+      resumed[*it] = NULL;
+    }
+    Updatable *target(proc.update_target());
+    proc.update_target() = this;
+    resuming = true;
+    while(proc.processed_pages() < pages){
+      if(!proc.process_1page()){break;}
+    }
+    resuming = false;
+    proc.update_target() = target;
+    if((proc.processed_pages() != pages) || (serial != packets)){
+      throw std::runtime_error("Checkpoint: log mismatch");
+    }
+    checkpoint_states(ar); // solvers have not used the space nodes yet
+
+    // Restore the pool in the same order as that of checkpoint
+    for(std::vector<unsigned int>::const_iterator it(pending.begin()); it != pending.end(); ++it){
+      const Packet *packet(resumed[*it]);
+      if(!packet){throw std::runtime_error("Checkpoint: log mismatch");}
+      item_t item = {packet, *it};
+      packet_pool.push_back(item);
+      resumed[*it] = NULL;
+    }
+    resumed.clear();
+    itow_checkpoint = itow_applied;
+    cerr << "Resume: " << options.checkpoint.resume_fname
+        << " (itow: " << itow_applied << ", page: " << pages << ")" << endl;
+  }
 };
 
 void loop(){
@@ -2767,50 +3384,27 @@ void loop(){
 
   // TODO multiple log stream will be support.
   StreamProcessor &proc(processors.front());
-  if(options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME){
-    // Realtime mode supports only one stream.
-    proc.update_target() = nav_manager.nav;
-    while(proc.process_1page());
-    return;
-  }
 
-  struct buffer_t : public Updatable {
-    typedef deque<const Packet *> packet_pool_t;
-    packet_pool_t packet_pool;
-    NAV &nav;
-    void sort_and_apply(int packets){
-      stable_sort(packet_pool.begin(), packet_pool.end(), Packet::compare_rollover);
-      while(packets-- > 0){
-        packet_pool_t::reference front(packet_pool.front());
-        front->apply(nav);
-        delete front;
-        packet_pool.pop_front();
+  // Realtime mode supports only one stream, and its packets are applied without sort.
+  PacketSorter sorter(*nav_manager.nav,
+      (options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME) ? 0 : 0x100);
+
+  try{
+    if(options.checkpoint.resume_fname){sorter.resume(proc);}
+    proc.update_target() = &sorter;
+
+    while(proc.process_1page()){
+      if(sorter.stop_due()){
+        if(options.checkpoint.fname){sorter.save(proc.processed_pages());}
+        sorter.discard();
+        break;
       }
+      if(sorter.checkpoint_due()){sorter.save(proc.processed_pages());}
     }
-    void sort_and_apply2 () {
-      if(packet_pool.size() < 0x200){return;}
-      sort_and_apply(0x100);
-    }
-    buffer_t(NAV &_nav) : packet_pool(), nav(_nav) {}
-    ~buffer_t() {
-      sort_and_apply(packet_pool.size());
-    }
-#define update_func(type) \
-virtual void update(const type &packet){ \
-  packet_pool.push_back(new type(packet)); \
-  sort_and_apply2(); \
-}
-    update_func(A_Packet);
-    update_func(G_Packet);
-    update_func(G_Packet_Measurement);
-    update_func(G_Packet_GPS_Ephemeris);
-    update_func(M_Packet);
-    update_func(TimePacket);
-#undef update_func
-  } buffer(*nav_manager.nav);
-  proc.update_target() = &buffer;
-
-  while(proc.process_1page());
+  }catch(std::exception &e){
+    cerr << "(error!) " << e.what() << endl;
+    exit(-1);
+  }
 }
 
 int main(int argc, char *argv[]){
@@ -2909,5 +3503,13 @@ int main(int argc, char *argv[]){
 
   loop();
 
+  if(options.profile != Options::PROFILE_OFF){
+#if defined(USE_PROFILE)
+    Profile::report(cerr, options.profile == Options::PROFILE_JSON);
+#else
+    cerr << "(warning!) --profile requires a build with USE_PROFILE macro." << endl;
+#endif
+  }
+
   return 0;
 }
@@ -56,6 +56,7 @@ struct GNSS_Data {
   struct Loader {
     typedef GPS_SpaceNode<FloatT> gps_t;
     gps_t *gps;
+    gps_t *qzss; ///< QZSS space node, whose key is PRN (193-)
 
     typedef typename gps_t::Satellite::Ephemeris gps_ephemeris_t;
     struct gps_ephemeris_raw_t : public gps_ephemeris_t::raw_t {
@@ -64,14 +65,17 @@ struct GNSS_Data {
       typedef typename gps_ephemeris_t::raw_t super_t;
       gps_ephemeris_raw_t()
           : set_iodc(false), iode_subframe2(-1), iode_subframe3(-1) {}
-    } gps_ephemeris[32];
+    } gps_ephemeris[32], qzss_ephemeris[10];
 
     typedef typename gps_t::Ionospheric_UTC_Parameters gps_iono_utc_t;
 
-    Loader() : gps(NULL) {
+    Loader() : gps(NULL), qzss(NULL) {
       for(unsigned int i(0); i < sizeof(gps_ephemeris) / sizeof(gps_ephemeris[0]); ++i){
         gps_ephemeris[i].svid = i + 1;
       }
+      for(unsigned int i(0); i < sizeof(qzss_ephemeris) / sizeof(qzss_ephemeris[0]); ++i){
+        qzss_ephemeris[i].svid = i + 193;
+      }
     }
 
     /**
@@ -103,13 +107,32 @@ struct GNSS_Data {
     };
 
     bool load(const gps_ephemeris_t &eph){
-      if(!gps){return false;}
-      gps->satellite(eph.svid).register_ephemeris(eph);
+      gps_t *dst((eph.svid >= 193) ? qzss : gps);
+      if(!dst){return false;}
+      dst->satellite(eph.svid).register_ephemeris(eph);
       return true;
     }
 
+    /**
+     * Load subframe of GPS, or QZSS whose LNAV message has the same format as GPS
+     */
     bool load(const GNSS_Data &data){
-      if(data.subframe.gnssID != observer_t::gnss_svid_t::GPS){return false;}
+      gps_t *dst(NULL);
+      gps_ephemeris_raw_t *eph_buf(NULL);
+      switch(data.subframe.gnssID){
+        case observer_t::gnss_svid_t::GPS:
+          if((data.subframe.sv_number < 1) || (data.subframe.sv_number > 32)){return false;}
+          dst = gps;
+          eph_buf = &gps_ephemeris[data.subframe.sv_number - 1];
+          break;
+        case observer_t::gnss_svid_t::QZSS:
+          if((data.subframe.sv_number < 1) || (data.subframe.sv_number > 10)){return false;}
+          dst = qzss;
+          eph_buf = &qzss_ephemeris[data.subframe.sv_number - 1];
+          break;
+        default:
+          return false;
+      }
 
       int week_number(data.time_of_reception.week);
       // If invalid week number, estimate it based on current time
@@ -121,7 +144,7 @@ struct GNSS_Data {
       int subframe_no(parser_t::subframe_id(buf));
 
       if(subframe_no <= 3){
-        gps_ephemeris_raw_t &eph(gps_ephemeris[data.subframe.sv_number - 1]);
+        gps_ephemeris_raw_t &eph(*eph_buf);
 
         switch(subframe_no){
           case 1: eph.template update_subframe1<2, 0>(buf); eph.set_iodc = true; break;
@@ -145,8 +168,8 @@ struct GNSS_Data {
         int week_number_base(week_number - (week_number % 0x100));
         iono_utc.WN_t = week_number_base + (iono_utc.WN_t % 0x100);
         iono_utc.WN_LSF = week_number_base + (iono_utc.WN_LSF % 0x100);
-        if(gps){
-          gps->update_iono_utc(iono_utc);
+        if(dst){
+          dst->update_iono_utc(iono_utc);
           return true;
         }
       }
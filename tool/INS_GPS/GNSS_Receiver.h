@@ -37,7 +37,9 @@
 #include <cstring>
 
 #include "navigation/GPS.h"
+#include "navigation/Galileo.h"
 #include "navigation/GPS_Solver.h"
+#include "navigation/GPS_Hatch_Filter.h"
 #include "navigation/RINEX.h"
 
 #include "navigation/INS_GPS2_Tightly.h"
@@ -54,11 +56,13 @@
 template <class FloatT>
 struct GNSS_Receiver {
   typedef GPS_SpaceNode<FloatT> gps_space_node_t;
+  typedef Galileo_SpaceNode<FloatT> galileo_space_node_t;
 #if !defined(BUILD_WITHOUT_GNSS_MULTI_FREQUENCY)
   typedef GPS_Solver_MultiFrequency<FloatT, GPS_SinglePositioning> gps_solver_t;
 #else
   typedef GPS_SinglePositioning<FloatT> gps_solver_t;
 #endif
+  typedef GPS_Hatch_Filter<FloatT, gps_solver_t> gps_smoother_t;
 
   struct system_t;
 
@@ -66,34 +70,98 @@ struct GNSS_Receiver {
     struct {
       gps_space_node_t space_node;
       typename gps_solver_t::options_t solver_options;
+      gps_smoother_t smoother;
     } gps;
+    /*
+     * QZSS and Galileo are processed by the GPS solver, because QZSS has the same signal
+     * and message as GPS, and Galileo ephemeris is converted to the GPS form.
+     * Their space nodes are keyed by satellite serial.
+     * For Galileo E1, GPS ionospheric parameters are used instead of NeQuick
+     * because its frequency is identical to L1.
+     */
+    struct {
+      gps_space_node_t space_node;
+      typename gps_solver_t::options_t solver_options;
+    } qzss;
+    struct {
+      galileo_space_node_t space_node;
+      typename gps_solver_t::options_t solver_options;
+    } galileo;
+    typename GPS_Solver_Base<FloatT>::user_pvt_t::satellite_mask_t excluded; ///< indexed by serial
     std::ostream *out_rinex_nav;
-    data_t() : gps(), out_rinex_nav(NULL) {}
+    data_t() : gps(), qzss(), galileo(), out_rinex_nav(NULL) {
+      excluded.clear();
+      gps.smoother.options.window = 0; // smoothing is disabled by default
+#if !defined(BUILD_WITHOUT_GNSS_MULTI_FREQUENCY)
+      gps.smoother
+          .add_signal(gps_solver_t::L2CM, gps_space_node_t::L2_WaveLength())
+          .add_signal(gps_solver_t::L2CL, gps_space_node_t::L2_WaveLength());
+#endif
+    }
     ~data_t(){
       if(out_rinex_nav){
         RINEX_NAV_Writer<FloatT>::write_all(*out_rinex_nav, gps.space_node);
       }
     }
+    /**
+     * Save or restore space nodes for checkpoint.
+     * Options are excluded because they are given by command line.
+     *
+     * @param ar archive
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      ar & gps.space_node & qzss.space_node & galileo.space_node;
+    }
   } data;
 
+  template <class Archive>
+  void checkpoint(Archive &ar){
+    ar & data;
+  }
+
   struct solver_t : public GPS_Solver_Base<FloatT> {
     typedef GPS_Solver_Base<FloatT> base_t;
-    gps_solver_t gps;
+    const GNSS_Receiver &rcv;
+    gps_solver_t gps, qzss, galileo;
     struct measurement_items_t : public gps_solver_t::measurement_items_t {
       // TODO
     };
-    solver_t(const GNSS_Receiver &rcv)
-        : base_t(),
-        gps(rcv.data.gps.space_node)
+    solver_t(const GNSS_Receiver &_rcv)
+        : base_t(), rcv(_rcv),
+        gps(_rcv.data.gps.space_node),
+        qzss(_rcv.data.qzss.space_node),
+        galileo(_rcv.data.galileo.space_node)
         {}
 
     // Proxy functions
     const base_t &select(const typename base_t::prn_t &serial) const {
       switch(system_t::serial2system(serial)){
         case system_t::GPS: return gps;
+        case system_t::QZSS: return rcv.data.excluded[serial] ? (const base_t &)*this : qzss;
+        case system_t::Galileo: return rcv.data.excluded[serial] ? (const base_t &)*this : galileo;
       }
       return *this;
     }
+    /**
+     * QZSS shares the receiver clock error with GPS, because QZSS system time
+     * is steered to GPS time and its signal is identical to GPS L1 C/A.
+     * Galileo has its own group, whose inter-system bias is estimated.
+     */
+    int system_group(const typename base_t::prn_t &serial) const {
+      switch(system_t::serial2system(serial)){
+        case system_t::GPS:
+        case system_t::QZSS: return 0;
+        case system_t::Galileo: return 1;
+      }
+      return -1;
+    }
+    /**
+     * RAIM/FDE is performed over all the systems, whose options are common.
+     */
+    const typename base_t::raim_options_t &raim_options() const {
+      return gps.raim_options();
+    }
   } solver_GNSS;
 
   GNSS_Receiver() : data(), solver_GNSS(*this) {}
@@ -106,6 +174,16 @@ struct GNSS_Receiver {
 
   void setup(typename GNSS_Data<FloatT>::Loader &loader) const {
     loader.gps = &const_cast<gps_space_node_t &>(data.gps.space_node);
+    loader.qzss = &const_cast<gps_space_node_t &>(data.qzss.space_node);
+  }
+
+  /**
+   * @return (gps_smoother_t *) smoother of pseudorange, or NULL when smoothing is disabled.
+   */
+  gps_smoother_t *smoother() const {
+    return (data.gps.smoother.options.window > 1)
+        ? &const_cast<gps_smoother_t &>(data.gps.smoother)
+        : NULL;
   }
 
   const GPS_Solver_Base<FloatT> &solver() const {
@@ -116,13 +194,42 @@ struct GNSS_Receiver {
 #endif
   }
 
+  /**
+   * Number of system groups which may be used, see solver_t::system_group().
+   * A group other than GPS/QZSS is counted only when its satellites are configured,
+   * i.e., Galileo ephemerides are loaded and not all of them are excluded.
+   * @return (int) 1 or 2
+   */
+  int system_groups() const {
+#if !defined(BUILD_WITHOUT_GNSS_MULTI_CONSTELLATION)
+    const typename gps_space_node_t::satellites_t &sats(data.galileo.space_node.satellites());
+    for(typename gps_space_node_t::satellites_t::const_iterator it(sats.begin());
+        it != sats.end(); ++it){
+      if(!data.excluded[it->first]){return 2;}
+    }
+#endif
+    return 1;
+  }
+
   void adjust(const GPS_Time<FloatT> &t){
     // Select most preferable ephemeris
     data.gps.space_node.update_all_ephemeris(t);
+    data.qzss.space_node.update_all_ephemeris(t);
+    data.galileo.space_node.update_all_ephemeris(t);
+
+    // GPS ionospheric parameters are shared unless the own ones are available
+    if(data.gps.space_node.is_valid_iono()){
+      if(!data.qzss.space_node.is_valid_iono()){
+        data.qzss.space_node.update_iono_utc(data.gps.space_node.iono_utc(), true, false);
+      }
+      data.galileo.space_node.update_iono_utc(data.gps.space_node.iono_utc(), true, false);
+    }
 
     // Solver update mainly for preferable ionospheric model selection
     // based on their availability
     solver_GNSS.gps.update_options(data.gps.solver_options);
+    solver_GNSS.qzss.update_options(data.qzss.solver_options);
+    solver_GNSS.galileo.update_options(data.galileo.solver_options);
   }
 
   struct system_t {
@@ -220,6 +327,9 @@ struct GNSS_Receiver {
       case decorder_t::gnss_svid_t::BeiDou:   type = system_t::Beido;   break;
       case decorder_t::gnss_svid_t::GLONASS:  type = system_t::GLONASS; break;
     }
+    if((type == system_t::QZSS) && (sv_id < 193)){
+      return satellite_id_t(type, sv_id + 192); // UBX SV ID (1-10) => PRN (193-202)
+    }
     return satellite_id_t(type, sv_id);
   }
 
@@ -245,6 +355,10 @@ struct GNSS_Receiver {
       case decorder_t::gnss_signal_t::GPS_L2CL:
         return &(gps_solver_t::L2CL);
 #endif
+      case decorder_t::gnss_signal_t::Galileo_E1C:
+      case decorder_t::gnss_signal_t::Galileo_E1B:
+        // Galileo E1 is treated as L1 because of the same frequency
+        return &(gps_solver_t::L1CA);
     }
     return NULL; // TODO support other GNSS, signals
   }
@@ -261,7 +375,8 @@ struct GNSS_Receiver {
       std::cerr << "RINEX Navigation file (" << value << ") reading..." << std::endl;
       std::istream &in(options.spec2istream(value));
       int ephemeris(RINEX_NAV_Reader<FloatT>::read_all(
-          in, data.gps.space_node));
+          in, &data.gps.space_node, &data.qzss.space_node,
+          &data.galileo.space_node, system_t::Galileo));
       if(ephemeris < 0){
         std::cerr << "(error!) Invalid format!" << std::endl;
         return false;
@@ -278,7 +393,9 @@ struct GNSS_Receiver {
     }
 
 #define option_apply(expr) \
-data.gps.solver_options. expr
+data.gps.solver_options. expr; \
+data.qzss.solver_options. expr; \
+data.galileo.solver_options. expr
     if(value = runtime_opt_t::get_value(spec, "GNSS_elv_mask_deg", false)){
       if(dry_run){return true;}
       FloatT mask_deg(std::atof(value));
@@ -300,8 +417,55 @@ data.gps.solver_options. expr
           gps_solver_t::options_t::IONOSPHERIC_NTCM_GL));
       return true;
     }
+
+    if(value = runtime_opt_t::get_value(spec, "GNSS_RAIM", true)){
+      if(dry_run){return true;}
+      bool use(runtime_opt_t::is_true(value));
+      std::cerr << "GNSS_RAIM: " << (use ? "on" : "off") << std::endl;
+      option_apply(raim.enabled = use);
+      return true;
+    }
+
+    if(value = runtime_opt_t::get_value(spec, "GNSS_RAIM_sigma", false)){
+      if(dry_run){return true;}
+      FloatT sigma(std::atof(value));
+      if(sigma <= 0){
+        std::cerr << "(error!) Abnormal RAIM sigma!" << value << std::endl;
+        return false;
+      }
+      std::cerr << "GNSS_RAIM_sigma: " << sigma << " [m]" << std::endl;
+      option_apply(raim.range_sigma = sigma);
+      return true;
+    }
+
+    if(value = runtime_opt_t::get_value(spec, "GNSS_delay_cache", true)){
+      if(dry_run){return true;}
+      bool use(runtime_opt_t::is_true(value));
+      std::cerr << "GNSS_delay_cache: " << (use ? "on" : "off") << std::endl;
+      option_apply(delay_cache.enabled = use);
+      return true;
+    }
 #undef option_apply
 
+    if(value = runtime_opt_t::get_value(spec, "GNSS_smoothing", true)){
+      if(dry_run){return true;}
+      int window(runtime_opt_t::is_true(value)
+          ? typename gps_smoother_t::options_t().window
+          : std::atoi(value));
+      if(window < 0){
+        std::cerr << "(error!) Abnormal smoothing length!" << value << std::endl;
+        return false;
+      }
+      data.gps.smoother.options.window = window;
+      std::cerr << "GNSS_smoothing: ";
+      if(window > 1){
+        std::cerr << window << " [epochs]" << std::endl;
+      }else{
+        std::cerr << "off" << std::endl;
+      }
+      return true;
+    }
+
     /* --GNSS_with[out]=(system|[system:][+-]sat_id)
      *    --GNSS_without=GPS excludes all GPS satellites
      *    --GNSS_without=GPS:4, --GNSS_with=GPS:-4, or --GNSS_without=-4 exclude GPS(4).
@@ -344,6 +508,18 @@ data.gps.solver_options. expr
               ? data.gps.solver_options.exclude_prn.set(without)
               : data.gps.solver_options.exclude_prn.set(sv_id, without);
           break;
+        case system_t::QZSS:
+        case system_t::Galileo: {
+          int serial_begin(satellite_id_t(sys, (sys == system_t::QZSS) ? 193 : 1));
+          int serial_end(satellite_id_t(sys, (sys == system_t::QZSS) ? 202 : 36));
+          if(!select_all){
+            serial_begin = serial_end = satellite_id_t(sys, sv_id);
+          }
+          for(int serial(serial_begin); serial <= serial_end; ++serial){
+            data.excluded.set(serial, without);
+          }
+          break;
+        }
         default:
           std::cerr << "(error!) Unsupported satellite! [" << value << "]" << std::endl;
           return false;
@@ -390,7 +566,12 @@ data.gps.solver_options. expr
             << ',' << "v_down"
             << ',' << "receiver_clock_error_dot_ms"
             << ',' << "used_satellites"
-            << ',' << "PRN";
+            << ',' << "PRN"
+            << ',' << "HPL"
+            << ',' << "VPL"
+            << ',' << "QZSS_PRN"
+            << ',' << "Galileo_SV"
+            << ',' << "inter_system_bias_Galileo";
       }
     } label;
 
@@ -450,6 +631,23 @@ data.gps.solver_options. expr
       }else{
         out << ",,";
       }
+      if(p.pvt.position_solved()
+          && (p.pvt.raim.state != pvt_t::raim_t::RAIM_UNAVAILABLE)){
+        out << ',' << p.pvt.raim.hpl
+            << ',' << p.pvt.raim.vpl;
+      }else{
+        out << ",,";
+      }
+      if(p.pvt.position_solved()){
+        out << ',' << mask_printer_t(p.pvt.used_satellite_mask, 193, 202)
+            << ',' << mask_printer_t(p.pvt.used_satellite_mask, system_t::Galileo + 1, system_t::Galileo + 36);
+      }else{
+        out << ",,";
+      }
+      out << ',';
+      if(p.pvt.position_solved() && (p.pvt.system_groups & 0x02)){
+        out << p.pvt.inter_system_bias[1];
+      }
       return out;
     }
   };
@@ -308,6 +308,114 @@ class M_Packet_Observer : public Data24Bytes_Packet_Observer<FloatType>{
     }
 };
 
+template <class FloatType = double>
+class S_Packet_Observer : public Data24Bytes_Packet_Observer<FloatType>{
+  public:
+    S_Packet_Observer(const unsigned int &buffer_size) 
+        : Data24Bytes_Packet_Observer<FloatType>(buffer_size){
+      
+    }
+    ~S_Packet_Observer(){}
+    
+    typedef Data24Bytes_Packet_Observer<FloatType> super_t;
+    typedef typename super_t::v8_t v8_t;
+    typedef typename super_t::u8_t u8_t;
+    typedef typename super_t::u16_t u16_t;
+    typedef typename super_t::u32_t u32_t;
+
+    /**
+     * Status of data_hub of the firmware, whose counters are accumulated since power up.
+     */
+    struct values_t {
+      unsigned int segments; ///< number of segments in the log buffer
+      unsigned int flush_watermark; ///< number of filled segments to start writing
+      unsigned int accepted; ///< pages stored in the buffer
+      unsigned int refused; ///< page requests refused due to full buffer
+      unsigned int lost; ///< pages not accepted by the SD card or USB
+      unsigned int high_water; ///< maximum used pages since previous S page
+      unsigned int pages; ///< buffer size in pages
+      unsigned int max_flush_ms; ///< maximum blocking time of writing since previous S page
+    };
+    values_t fetch_values() const {
+      values_t result;
+      
+      v8_t buf[2];
+      this->inspect(buf, 2, 0);
+      result.segments = (u8_t)buf[0];
+      result.flush_watermark = (u8_t)buf[1];
+      
+      {
+        v8_t buf[18];
+        this->inspect(buf, sizeof(buf), 7);
+        result.accepted = le_char4_2_num<u32_t>(buf[0]);
+        result.refused = le_char4_2_num<u32_t>(buf[4]);
+        result.lost = le_char4_2_num<u32_t>(buf[8]);
+        result.high_water = (u8_t)buf[12];
+        result.pages = (u8_t)buf[13];
+        result.max_flush_ms = le_char2_2_num<u16_t>(buf[14]);
+      }
+      
+      return result;
+    }
+};
+
+template <class FloatType = double>
+class I_Packet_Observer : public Data24Bytes_Packet_Observer<FloatType>{
+  public:
+    I_Packet_Observer(const unsigned int &buffer_size) 
+        : Data24Bytes_Packet_Observer<FloatType>(buffer_size){
+      
+    }
+    ~I_Packet_Observer(){}
+    
+    typedef Data24Bytes_Packet_Observer<FloatType> super_t;
+    typedef typename super_t::v8_t v8_t;
+    typedef typename super_t::u8_t u8_t;
+    typedef typename super_t::u16_t u16_t;
+
+    /**
+     * Inertial samples burst-read from FIFO of MPU-9250, up to 2 samples per page.
+     * fetch_ITOW() returns time of the last sample.
+     */
+    struct values_t {
+      unsigned int samples; ///< number of valid samples, 1 or 2
+      unsigned int interval_ms; ///< sampling interval
+      unsigned int values[2][6]; ///< accelerometer XYZ and gyro XYZ, the same format as ch.0-5 of A page
+      unsigned short temperature; ///< the same format as A page, whose lower byte is approximated
+      /**
+       * @param index sample index
+       * @return time of the sample relative to the page in seconds
+       */
+      FloatType time_offset(const unsigned int &index) const {
+        return (FloatType)-1E-3 * (FloatType)((samples - 1 - index) * interval_ms);
+      }
+    };
+    values_t fetch_values() const {
+      values_t result;
+      
+      {
+        v8_t buf[2];
+        this->inspect(buf, 2, 0);
+        result.samples = ((u8_t)buf[0] >> 6);
+        if(result.samples > 2){result.samples = 2;}
+        result.interval_ms = ((u8_t)buf[0] & 0x3F) + 1;
+        result.temperature = (((u16_t)(u8_t)buf[1]) << 8) | 0x80;
+      }
+      
+      {
+        v8_t buf[12];
+        for(int i = 0; i < 2; i++){
+          this->inspect(buf, sizeof(buf), 7 + (12 * i));
+          for(int j = 0; j < 6; j++){
+            result.values[i][j] = be_char2_2_num<u16_t>(buf[j * 2]);
+          }
+        }
+      }
+      
+      return result;
+    }
+};
+
 template <class FloatType = double>
 class G_Packet_Observer : public Packet_Observer<>{
   public:
@@ -1293,6 +1401,8 @@ protected: \
     assign_observer(P);
     assign_observer(M);
     assign_observer(N);
+    assign_observer(S);
+    assign_observer(I);
 
 #undef assign_observer
   
@@ -1312,6 +1422,8 @@ previous_seek_next_ ## type(observer_ ## type.ready())
         assign_initializer(P),
         assign_initializer(M),
         assign_initializer(N),
+        assign_initializer(S),
+        assign_initializer(I),
         process_count(0) {
       
     }
@@ -1328,6 +1440,8 @@ void set_ ## mark ## _handler(void (*handler)(const type ## _Observer_t &)){ \
     assign_setter(P, p);
     assign_setter(M, m);
     assign_setter(N, n);
+    assign_setter(S, s);
+    assign_setter(I, i);
 #undef assign_setter
   
   public:
@@ -1348,6 +1462,8 @@ case header : { \
         assign_case(P, 'P');
         assign_case(M, 'M');
         assign_case(N, 'N');
+        assign_case(S, 'S');
+        assign_case(I, 'I');
 #undef assign_case
       }
     }
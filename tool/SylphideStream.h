@@ -46,6 +46,11 @@ struct generic_SylphideProtocol {
   static const unsigned int capsule_tail_size;
   static const unsigned int capsule_size;
   static const unsigned int payload_fixed_length = 0x20;
+  /**
+   * Maximum number of pages bundled in a variable length packet by firmware,
+   * which corresponds to the maximum of config.data_hub.cdc_pages
+   */
+  static const unsigned int payload_units_max = 16;
   
   typedef Uint16 v_u16_t;
   
@@ -600,6 +605,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
     
     container_t buffer;
     bool mode_fixed_size; ///< ܂̃pPbgEȂ悤ɂ郂[h
+    unsigned int payload_size_unit; ///< Payload size in the fixed size mode, whose multiples are also accepted
     unsigned int payload_size;
     _Elem *payload;
     unsigned int payload_bufsize;
@@ -646,7 +652,16 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
               SylphideProtocol::Decorder::payload_size(buffer));
           if(new_payload_size){
             if(mode_fixed_size){
-              if(payload_size == new_payload_size){break;}
+              // A variable length packet bundling several units, for example,
+              // pages sent by firmware in a batch, is also accepted.
+              // The number of units is a power of 2, and does not exceed payload_units_max.
+              unsigned int units(new_payload_size / payload_size_unit);
+              if((new_payload_size % payload_size_unit == 0)
+                  && (units <= SylphideProtocol::payload_units_max)
+                  && ((units & (units - 1)) == 0)){
+                payload_size = new_payload_size;
+                break;
+              }
             }else{
               payload_size = new_payload_size;
               break;
@@ -684,7 +699,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
     basic_SylphideStreambuf_in(std::istream &_in)
         : buffer(_in), payload_size(0),
         payload(NULL), payload_bufsize(0),
-        sequence_num(0), mode_fixed_size(false) {
+        sequence_num(0), mode_fixed_size(false), payload_size_unit(0) {
       setg(payload, payload, payload);
     }
     /**
@@ -699,7 +714,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
         std::istream &_in, const unsigned int &size)
         : buffer(_in), payload_size(size),
         payload(NULL), payload_bufsize(0),
-        sequence_num(0), mode_fixed_size(size > 0) {
+        sequence_num(0), mode_fixed_size(size > 0), payload_size_unit(size) {
       setg(payload, payload, payload);
     }
     ~basic_SylphideStreambuf_in(){
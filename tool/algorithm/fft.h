@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FFT_H__
+#define __FFT_H__
+
+/** @file
+ * @brief Discrete Fourier transform of arbitrary length
+ *
+ * Power of two length is transformed by iterative radix-2 FFT,
+ * and the other length is reduced to a radix-2 circular convolution
+ * by Bluestein's (chirp z-transform) algorithm.
+ * Both directions are not normalized, i.e., inverse(forward(x)) = n * x.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <complex>
+#include <cmath>
+
+template <class FloatT>
+class FFT {
+  public:
+    typedef FloatT float_t;
+    typedef std::complex<float_t> complex_t;
+
+  protected:
+    unsigned int n; ///< transform length
+    unsigned int m; ///< radix-2 length, which is equal to n, or is at least 2n-1 for Bluestein
+    std::vector<unsigned int> bit_reversed;
+    std::vector<complex_t> twiddle; ///< exp(-2 pi i k / m), k = 0, ..., m / 2 - 1
+    std::vector<complex_t> chirp; ///< exp(-pi i k^2 / n), k = 0, ..., n - 1
+    std::vector<complex_t> chirp_fft; ///< radix-2 FFT of the conjugated chirp filter
+    mutable std::vector<complex_t> work;
+
+    static bool is_power_of_2(const unsigned int &v){
+      return (v > 0) && ((v & (v - 1)) == 0);
+    }
+
+    void radix2(complex_t *data, const bool &inverse) const {
+      for(unsigned int i(0); i < m; ++i){
+        unsigned int j(bit_reversed[i]);
+        if(i < j){std::swap(data[i], data[j]);}
+      }
+      for(unsigned int len(2), step(m / 2); len <= m; len <<= 1, step >>= 1){
+        unsigned int half(len / 2);
+        for(unsigned int i(0); i < m; i += len){
+          for(unsigned int j(0), k(0); j < half; ++j, k += step){
+            complex_t w(inverse ? std::conj(twiddle[k]) : twiddle[k]);
+            complex_t u(data[i + j]), v(data[i + j + half] * w);
+            data[i + j] = u + v;
+            data[i + j + half] = u - v;
+          }
+        }
+      }
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param length transform length
+     */
+    FFT(const unsigned int &length = 1)
+        : n(length), m(length),
+        bit_reversed(), twiddle(), chirp(), chirp_fft(), work() {
+      if(!is_power_of_2(n)){
+        for(m = 1; m < (n * 2 - 1); m <<= 1);
+      }
+      unsigned int bits(0);
+      for(unsigned int j(m); j > 1; j >>= 1, ++bits);
+      bit_reversed.assign(m, 0);
+      for(unsigned int i(1); i < m; ++i){
+        bit_reversed[i] = (bit_reversed[i >> 1] >> 1) | ((i & 1) << (bits - 1));
+      }
+      twiddle.resize(m / 2);
+      for(unsigned int k(0); k < m / 2; ++k){
+        twiddle[k] = std::polar(float_t(1), float_t(-2 * M_PI * k / m));
+      }
+      if(m == n){return;}
+
+      chirp.resize(n);
+      for(unsigned int k(0); k < n; ++k){
+        unsigned long long k2(((unsigned long long)k * k) % (2ULL * n)); // for precision
+        chirp[k] = std::polar(float_t(1), float_t(-M_PI * k2 / n));
+      }
+      chirp_fft.assign(m, complex_t(0));
+      chirp_fft[0] = std::conj(chirp[0]);
+      for(unsigned int k(1); k < n; ++k){
+        chirp_fft[k] = chirp_fft[m - k] = std::conj(chirp[k]);
+      }
+      radix2(&chirp_fft[0], false);
+      work.resize(m);
+    }
+
+    unsigned int length() const {return n;}
+
+    /**
+     * In-place transform. Because of internal work buffer,
+     * an instance should not be shared among threads; use its copy for each thread.
+     *
+     * @param data data whose length is length()
+     * @param inverse true for inverse transform (not normalized)
+     */
+    void transform(complex_t *data, const bool &inverse = false) const {
+      if(m == n){
+        radix2(data, inverse);
+        return;
+      }
+      // Bluestein: X_k = w_k sum_j (x_j w_j) conj(w_{k-j}), where w_k = chirp[k]
+      for(unsigned int k(0); k < n; ++k){
+        work[k] = (inverse ? std::conj(data[k]) : data[k]) * chirp[k];
+      }
+      std::fill(work.begin() + n, work.end(), complex_t(0));
+      radix2(&work[0], false);
+      for(unsigned int k(0); k < m; ++k){work[k] *= chirp_fft[k];}
+      radix2(&work[0], true);
+      float_t scale(float_t(1) / m);
+      for(unsigned int k(0); k < n; ++k){
+        complex_t v(work[k] * chirp[k] * scale);
+        data[k] = inverse ? std::conj(v) : v;
+      }
+    }
+    void forward(complex_t *data) const {transform(data, false);}
+    void inverse(complex_t *data) const {transform(data, true);}
+};
+
+#endif /* __FFT_H__ */
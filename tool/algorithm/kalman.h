@@ -33,6 +33,7 @@
 #define __KALMAN_H__
 
 #include "param/matrix.h"
+#include "util/profile.h"
 
 /** @file
  * @brief Kalman FilterLqt@CłB
@@ -112,6 +113,16 @@ class KalmanFilter{
      */
     virtual ~KalmanFilter(){}
     
+    /**
+     * Save or restore matrices for checkpoint
+     * 
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      ar & m_P & m_Q;
+    }
+    
     /**
      * tB^[ԍXV܂B
      * Uno[W
@@ -123,6 +134,7 @@ class KalmanFilter{
      * @param Gamma @f$ \Gamma @f$s
      */
     virtual void predict(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma){
+      PROFILE_SCOPE("KalmanFilter::predict");
     
 #if DEBUG > 2
       std::cerr << "Phi:" << Phi << std::endl;
@@ -165,6 +177,7 @@ class KalmanFilter{
      * @return (Matrix<FloatT>) J}QC@f$ K @f$
      */
     virtual Matrix<FloatT> correct(const Matrix<FloatT> &H, const Matrix<FloatT> &R){
+      PROFILE_SCOPE("KalmanFilter::correct");
 
       // J}QČvZ
       Matrix<FloatT> K(m_P * H.transpose() * ((H * m_P * H.transpose()) + R).inverse());
@@ -470,6 +483,17 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
      */
     ~KalmanFilterUD(){}
     
+    /**
+     * Save or restore matrices including UD decomposed ones for checkpoint
+     * 
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      KalmanFilter<FloatT>::checkpoint(ar);
+      ar & m_U & m_D & need_update_P;
+    }
+    
     using KalmanFilter<FloatT>::predict;
 
     /**
@@ -484,6 +508,7 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
      * @param Gamma @f$ \Gamma @f$s
      */
     void predict(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma){
+      PROFILE_SCOPE("KalmanFilterUD::predict");
      
 #if DEBUG     
       KalmanFilter<FloatT>::predict(Phi, Gamma);
@@ -552,6 +577,7 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
      * @return (Matrix<FloatT>) J}QC@f$ K @f$
      */
     Matrix<FloatT> correct(const Matrix<FloatT> &H, const Matrix<FloatT> &R){
+      PROFILE_SCOPE("KalmanFilterUD::correct");
 #if DEBUG
       std::cerr << "correct_KF_K:" << KalmanFilter<FloatT>::correct(H, R) << std::endl;
       std::cerr << "correct_KF_P:" << KalmanFilter<FloatT>::m_P << std::endl;
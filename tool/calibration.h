@@ -34,6 +34,7 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cmath>
 
 template <class FloatT>
 struct StandardCalibration {
@@ -169,6 +170,51 @@ if(value = get_value(line, TO_STRING(name))){ \
     }
   }
 
+  /**
+   * Inverse of calibrate(), which converts physical quantity to raw values.
+   * Misalignment is inverted by Gaussian elimination with partial pivoting.
+   */
+  template <std::size_t N>
+  static void calibrate_inverse(
+      const FloatT (&value)[N],
+      const FloatT &bias_mod,
+      const calibration_info_t<N> &info,
+      FloatT (&res)[N]) {
+
+    // Misalignment compensation (inverse), solve alignment * tmp = value
+    FloatT a[N][N + 1];
+    for(std::size_t i(0); i < N; i++){
+      for(std::size_t j(0); j < N; j++){
+        a[i][j] = info.alignment[i][j];
+      }
+      a[i][N] = value[i];
+    }
+    for(std::size_t j(0); j < N; j++){
+      std::size_t pivot(j);
+      for(std::size_t i(j + 1); i < N; i++){
+        if(std::abs(a[i][j]) > std::abs(a[pivot][j])){pivot = i;}
+      }
+      if(pivot != j){
+        for(std::size_t k(j); k <= N; k++){
+          FloatT v(a[j][k]); a[j][k] = a[pivot][k]; a[pivot][k] = v;
+        }
+      }
+      for(std::size_t i(0); i < N; i++){
+        if(i == j){continue;}
+        FloatT r(a[i][j] / a[j][j]);
+        for(std::size_t k(j); k <= N; k++){
+          a[i][k] -= a[j][k] * r;
+        }
+      }
+    }
+
+    // Convert physical quantity to raw values by using scale factor and bias
+    for(std::size_t i(0); i < N; i++){
+      res[i] = (a[i][N] / a[i][i]) * info.sf[i]
+          + (info.bias_base[i] + (info.bias_tc[i] * bias_mod));
+    }
+  }
+
   StandardCalibration()
       : index_base(0), index_temp_ch(0), accel(pass_through), gyro(pass_through) {}
   ~StandardCalibration() {}
@@ -199,6 +245,30 @@ if(value = get_value(line, TO_STRING(name))){ \
     return res;
   }
 
+  /**
+   * Get raw values from acceleration in m/s^2, which is the inverse of raw2accel().
+   * The temperature channel raw_data[index_temp_ch] must be set in advance.
+   */
+  void accel2raw(const FloatT (&accel_)[3], int *raw_data) const {
+    FloatT res[3];
+    calibrate_inverse(accel_, (FloatT)raw_data[index_temp_ch], accel, res);
+    for(int i(0); i < 3; i++){
+      raw_data[index_base + i] = (int)std::floor(res[i] + 0.5);
+    }
+  }
+
+  /**
+   * Get raw values from angular speed in rad/sec, which is the inverse of raw2omega().
+   * The temperature channel raw_data[index_temp_ch] must be set in advance.
+   */
+  void omega2raw(const FloatT (&omega)[3], int *raw_data) const {
+    FloatT res[3];
+    calibrate_inverse(omega, (FloatT)raw_data[index_temp_ch], gyro, res);
+    for(int i(0); i < 3; i++){
+      raw_data[index_base + 3 + i] = (int)std::floor(res[i] + 0.5);
+    }
+  }
+
   /**
    * Accelerometer output variance in [m/s^2]^2
    */
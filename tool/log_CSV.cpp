@@ -54,7 +54,7 @@ using namespace std;
 struct Options : public GlobalOptions<float_sylph_t> {
   typedef GlobalOptions<float_sylph_t> super_t;
   enum {
-    PAGE_A, PAGE_G, PAGE_F, PAGE_P, PAGE_M, PAGE_N, PAGE_OTHER,
+    PAGE_A, PAGE_G, PAGE_F, PAGE_P, PAGE_M, PAGE_N, PAGE_S, PAGE_I, PAGE_OTHER,
     PAGE_KINDS
   };
   typedef enum {
@@ -188,6 +188,8 @@ struct Options : public GlobalOptions<float_sylph_t> {
         case 'M': page_selected[PAGE_M] = flag; break;
         case 'N': page_selected[PAGE_N] = flag; break;
         case 'P': page_selected[PAGE_P] = flag; break;
+        case 'S': page_selected[PAGE_S] = flag; break;
+        case 'I': page_selected[PAGE_I] = flag; break;
         default: return false;
       }
       return true;
@@ -286,6 +288,34 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
       HandlerA() : count(0), formatter(&HandlerA::dump_raw) {}
     } handler_A;
     
+    /**
+     * Check I page (inertial samples packed by the firmware),
+     * each of whose samples is output in the same format as A page.
+     * 
+     * @param observer I page observer
+     */
+    struct HandlerI : public HandlerA {
+      void operator()(const super_t::I_Observer_t &observer){
+        if(!observer.validate()){return;} // check validity
+        
+        float_sylph_t itow(StreamProcessor::get_corrected_ITOW(observer));
+        I_Observer_t::values_t values(observer.fetch_values());
+        
+        for(unsigned int i(0); i < values.samples; i++){
+          float_sylph_t current(itow + values.time_offset(i));
+          if(!options.is_time_in_range(current)){continue;}
+          
+          A_Observer_t::values_t values_A = {{0}};
+          for(int j(0); j < 6; j++){
+            values_A.values[j] = values.values[i][j];
+          }
+          values_A.temperature = values.temperature;
+          (this->*formatter)(current, values_A);
+          count++;
+        }
+      }
+    } handler_I;
+    
     /**
      * Check G page (u-blox GPS receiver output)
      * 
@@ -593,6 +623,31 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
       }
     } handler_N;
     
+    /**
+     * check S page (status of logging in the firmware)
+     * 
+     * @param observer S page observer
+     */
+    struct HandlerS {
+      void operator()(const S_Observer_t &observer){
+        if(!observer.validate()){return;}
+        
+        float_sylph_t current(observer.fetch_ITOW()); // periodic, therefore no 1pps correction
+        if(!options.is_time_in_range(current)){return;}
+        
+        S_Observer_t::values_t values(observer.fetch_values());
+        options.out() << options.format_time(current) << ", "
+            << values.segments << ", "
+            << values.flush_watermark << ", "
+            << values.accepted << ", "
+            << values.refused << ", "
+            << values.lost << ", "
+            << values.high_water << ", "
+            << values.pages << ", "
+            << values.max_flush_ms << endl;
+      }
+    } handler_S;
+    
 #if 0
     /**
      * checker for C page in SylphideProtocol format
@@ -646,6 +701,8 @@ break;
         assign_case(P, 'P');
         assign_case(M, 'M');
         assign_case(N, 'N');
+        assign_case(S, 'S');
+        assign_case(I, 'I');
 #undef assign_case
 #undef assign_case_cnd
 #if 0
@@ -682,6 +739,8 @@ case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELE
         filter_page(P, 'P');
         filter_page(M, 'M');
         filter_page(N, 'N');
+        filter_page(S, 'S');
+        filter_page(I, 'I');
 #undef filter_page
         case 'G':
           super_t::process_packet(
@@ -707,6 +766,7 @@ case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELE
       
       if(options.physical_converter.is_active){
         handler_A.formatter = &HandlerA::dump_physical;
+        handler_I.formatter = &HandlerA::dump_physical;
         handler_P.formatter = &HandlerP::dump_physical;
         handler_M.formatter = &HandlerM::dump_physical;
         cerr << "Units are [m/s^2], [deg/s], [Pa], and [degC] "
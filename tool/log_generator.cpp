@@ -0,0 +1,1028 @@
+/**
+ * @file Synthetic NinjaScan log generator for load testing
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program generates a synthetic log.dat of NinjaScan, which consists of
+ * A (inertial sensors), G (u-blox receiver) and M (magnetic sensor) pages,
+ * by simulating a flight. It is intended to make inputs of INS_GPS and log_CSV
+ * for load testing without real flight logs.
+ *
+ * Its usage is
+ *   log_generator [option(s)]
+ * and the log is written to the standard output unless --out is specified.
+ *
+ * The flight is a horizontal circle at constant speed and height, whose turns
+ * are coordinated; a straight flight northward is selected by zero turn rate.
+ * The pages are generated as follows.
+ *   A: Specific force and angular speed in the body frame, including the Earth rotation,
+ *      are converted to raw values with the inverse of the calibration parameters.
+ *   G: UBX NAV-SOL, NAV-POSLLH, NAV-VELNED and RXM-RAW are output at each epoch,
+ *      and RXM-SFRB is output at every subframe (6 seconds) for each visible satellite.
+ *      Ranges are calculated with a GPS_SpaceNode having a synthetic constellation of
+ *      24 satellites, whose ephemeris is updated every 2 hours and broadcasted by the subframes.
+ *   M: Magnetic field of IGRF is rotated to the body frame.
+ *
+ * The options are
+ *   --duration=<time>
+ *     specifies the duration of the log (default 600). Suffix s, m, h or d is
+ *     acceptable as the unit; e.g., 3d means 3 days.
+ *   --start_gpst=<WN>:<seconds>
+ *     specifies the start time of the log (default 2000:0).
+ *   --rate_A=<Hz>, --rate_G=<Hz>, --rate_M=<Hz>
+ *     specify the output rates of A, G and M pages (default 100, 1 and 10).
+ *     Zero disables the corresponding page.
+ *   --latitude=<deg>, --longitude=<deg>, --height=<m>
+ *     specify the center of the flight (default 35, 139 and 100).
+ *   --speed=<m/s>, --turn_rate=<deg/s>
+ *     specify the speed and the turn rate (default 20 and 3).
+ *   --accel_noise=<m/s^2>, --gyro_noise=<rad/s>
+ *     specify standard deviations of noise of inertial sensors (default 0.05 and 5E-3).
+ *   --pos_noise=<m>, --vel_noise=<m/s>, --range_noise=<m>
+ *     specify standard deviations of noise of the receiver outputs,
+ *     horizontal position (vertical one is 1.5 times), velocity and pseudo range
+ *     (default 2, 0.1 and 1).
+ *   --mag_lsb=<nT>
+ *     specifies the resolution of the magnetic sensor (default 76.9, HMC5843).
+ *   --calib_file=<file>
+ *     specifies the calibration file of inertial sensors, whose format is the same as INS_GPS.
+ *     NinjaScan default calibration parameters are used if not specified.
+ *   --seed=<N>
+ *     specifies the seed of random numbers (default 0).
+ *   --block=<seconds>
+ *     specifies the duration of a unit which is generated by a thread (default 60).
+ *   --threads=<N>
+ *     specifies the number of threads. Its default is the number of cores.
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ */
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#define _USE_MATH_DEFINES
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if __cplusplus >= 201103L
+#include <thread>
+#define LOG_GENERATOR_THREAD
+#endif
+
+#include "SylphideProcessor.h"
+
+#include "navigation/WGS84.h"
+#include "navigation/GPS.h"
+#include "navigation/MagneticField.h"
+#include "navigation/ninjascan_nav.h"
+
+#include "analyze_common.h"
+#include "calibration.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+typedef GPS_SpaceNode<float_sylph_t> space_node_t;
+typedef space_node_t::gps_time_t gps_time_t;
+typedef space_node_t::Satellite::eph_t ephemeris_t;
+typedef StandardCalibration<float_sylph_t> calibration_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  float_sylph_t duration; ///< [s]
+  float_sylph_t rate_A, rate_G, rate_M; ///< [Hz]
+  float_sylph_t latitude, longitude, height; ///< [rad], [rad], [m]
+  float_sylph_t speed, turn_rate; ///< [m/s], [rad/s]
+  float_sylph_t accel_noise, gyro_noise; ///< [m/s^2], [rad/s]
+  float_sylph_t pos_noise, vel_noise, range_noise; ///< [m], [m/s], [m]
+  float_sylph_t mag_lsb; ///< [nT]
+  float_sylph_t block; ///< [s]
+  unsigned int seed;
+  int threads;
+  calibration_t calibration;
+
+  Options()
+      : super_t(),
+      duration(600),
+      rate_A(100), rate_G(1), rate_M(10),
+      latitude(deg2rad(35.)), longitude(deg2rad(139.)), height(100),
+      speed(20), turn_rate(deg2rad(3.)),
+      accel_noise(0.05), gyro_noise(5E-3),
+      pos_noise(2), vel_noise(0.1), range_noise(1),
+      mag_lsb(1E5 / 1300),
+      block(60),
+      seed(0), threads(1),
+      calibration() {
+    set_typical_calibration_specs(calibration);
+#if defined(LOG_GENERATOR_THREAD)
+    threads = std::thread::hardware_concurrency();
+    if(threads < 1){threads = 1;}
+#endif
+  }
+  ~Options(){}
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+#define CHECK_FLOAT(key, target, conv) \
+    if(value = get_value(spec, key, false)){ \
+      target = conv(std::atof(value)); \
+      cerr << key << ": " << std::atof(value) << endl; \
+      return true; \
+    }
+#define CHECK_NON_NEGATIVE(key, target) \
+    if(value = get_value(spec, key, false)){ \
+      float_sylph_t v(std::atof(value)); \
+      if(v < 0){ \
+        cerr << "(error!) Invalid " << key << "!" << value << endl; \
+        exit(-1); \
+      } \
+      target = v; \
+      cerr << key << ": " << target << endl; \
+      return true; \
+    }
+#define as_is(v) (v)
+    CHECK_NON_NEGATIVE("rate_A", rate_A);
+    CHECK_NON_NEGATIVE("rate_G", rate_G);
+    CHECK_NON_NEGATIVE("rate_M", rate_M);
+    CHECK_FLOAT("latitude", latitude, deg2rad);
+    CHECK_FLOAT("longitude", longitude, deg2rad);
+    CHECK_FLOAT("height", height, as_is);
+    CHECK_NON_NEGATIVE("speed", speed);
+    CHECK_FLOAT("turn_rate", turn_rate, deg2rad);
+    CHECK_NON_NEGATIVE("accel_noise", accel_noise);
+    CHECK_NON_NEGATIVE("gyro_noise", gyro_noise);
+    CHECK_NON_NEGATIVE("pos_noise", pos_noise);
+    CHECK_NON_NEGATIVE("vel_noise", vel_noise);
+    CHECK_NON_NEGATIVE("range_noise", range_noise);
+#undef as_is
+#undef CHECK_NON_NEGATIVE
+#undef CHECK_FLOAT
+    if(value = get_value(spec, "duration", false)){
+      char *suffix;
+      duration = std::strtod(value, &suffix);
+      switch(*suffix){
+        case 'd': duration *= 24;
+        case 'h': duration *= 60;
+        case 'm': duration *= 60;
+        case 's': case '\0': break;
+        default:
+          cerr << "(error!) Invalid duration!" << value << endl;
+          exit(-1);
+      }
+      cerr << "duration: " << duration << " [s]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "mag_lsb", false)){
+      mag_lsb = std::atof(value);
+      if(mag_lsb <= 0){
+        cerr << "(error!) Invalid mag_lsb!" << value << endl;
+        exit(-1);
+      }
+      cerr << "mag_lsb: " << mag_lsb << " [nT]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "block", false)){
+      block = std::atof(value);
+      if(block < 1){
+        cerr << "(error!) Invalid block!" << value << endl;
+        exit(-1);
+      }
+      cerr << "block: " << block << " [s]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "seed", false)){
+      seed = std::strtoul(value, NULL, 0);
+      cerr << "seed: " << seed << endl;
+      return true;
+    }
+    if(value = get_value(spec, "threads", false)){
+      threads = std::atoi(value);
+      if(threads < 1){
+        cerr << "(error!) Invalid threads!" << value << endl;
+        exit(-1);
+      }
+      cerr << "threads: " << threads << endl;
+      return true;
+    }
+    if(value = get_value(spec, "calib_file", false)){
+      return load_calibration_file(calibration, value);
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+/**
+ * Pseudo random number generator (xorshift64*), which is deterministic
+ * for each block so that the output does not depend on the number of threads.
+ */
+struct random_t {
+  unsigned long long state;
+  bool has_spare;
+  float_sylph_t spare;
+  random_t(const unsigned long long &seed)
+      : state((seed + 1) * 0x9E3779B97F4A7C15ULL), has_spare(false), spare(0) {
+    for(int i(0); i < 4; ++i){next();}
+  }
+  unsigned long long next(){
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+  }
+  /**
+   * @return (float_sylph_t) uniform random number in (0, 1)
+   */
+  float_sylph_t uniform(){
+    return ((float_sylph_t)(next() >> 11) + 0.5) / (1ULL << 53);
+  }
+  /**
+   * @return (float_sylph_t) normal random number by Box-Muller method
+   */
+  float_sylph_t normal(const float_sylph_t &sigma = 1){
+    if(has_spare){
+      has_spare = false;
+      return spare * sigma;
+    }
+    float_sylph_t r(std::sqrt(-2 * std::log(uniform()))), theta(2 * M_PI * uniform());
+    spare = r * std::sin(theta);
+    has_spare = true;
+    return r * std::cos(theta) * sigma;
+  }
+};
+
+/**
+ * True state of the flight at a time
+ */
+struct truth_t {
+  float_sylph_t latitude, longitude, height; ///< [rad], [rad], [m]
+  float_sylph_t v_ned[3]; ///< velocity in the NED frame [m/s]
+  float_sylph_t dcm_b2n[3][3]; ///< direction cosine matrix from the body to the NED frame
+  float_sylph_t accel[3]; ///< specific force in the body frame [m/s^2]
+  float_sylph_t omega[3]; ///< angular speed with respect to the inertial frame in the body frame [rad/s]
+
+  /**
+   * Calculate the state of a horizontal circular flight with coordinated turn.
+   * Position is approximated on the tangent plane at the center.
+   *
+   * @param t elapsed time from the start [s]
+   */
+  truth_t(const float_sylph_t &t){
+    const float_sylph_t &v(options.speed), &w(options.turn_rate);
+    float_sylph_t psi(w * t), c_psi(std::cos(psi)), s_psi(std::sin(psi));
+
+    { // position
+      float_sylph_t north, east;
+      if(w != 0){
+        north = v / w * s_psi;
+        east = v / w * (1. - c_psi);
+      }else{
+        north = v * t;
+        east = 0;
+      }
+      latitude = options.latitude
+          + north / (WGS84::R_meridian(options.latitude) + options.height);
+      longitude = options.longitude
+          + east / ((WGS84::R_normal(options.latitude) + options.height) * std::cos(options.latitude));
+      height = options.height;
+    }
+
+    v_ned[0] = v * c_psi;
+    v_ned[1] = v * s_psi;
+    v_ned[2] = 0;
+
+    float_sylph_t g(WGS84::gravity(latitude, height));
+    float_sylph_t phi(std::atan2(v * w, g)), c_phi(std::cos(phi)), s_phi(std::sin(phi));
+
+    { // yaw(psi), pitch(0), roll(phi)
+      dcm_b2n[0][0] = c_psi; dcm_b2n[0][1] = -s_psi * c_phi; dcm_b2n[0][2] = s_psi * s_phi;
+      dcm_b2n[1][0] = s_psi; dcm_b2n[1][1] = c_psi * c_phi;  dcm_b2n[1][2] = -c_psi * s_phi;
+      dcm_b2n[2][0] = 0;     dcm_b2n[2][1] = s_phi;          dcm_b2n[2][2] = c_phi;
+    }
+
+    // Earth rotation (e/i) and transport rate (n/e) in the NED frame
+    float_sylph_t c_lat(std::cos(latitude)), s_lat(std::sin(latitude));
+    float_sylph_t r_m(WGS84::R_meridian(latitude) + height), r_n(WGS84::R_normal(latitude) + height);
+    float_sylph_t omega_ei[3] = {WGS84::Omega_Earth * c_lat, 0, -WGS84::Omega_Earth * s_lat};
+    float_sylph_t omega_ne[3] = {v_ned[1] / r_n, -v_ned[0] / r_m, -v_ned[1] * s_lat / c_lat / r_n};
+
+    // Specific force; f = a + (2 * omega_ei + omega_ne) * v - g
+    float_sylph_t a_ned[3] = {-v * w * s_psi, v * w * c_psi, -g};
+    float_sylph_t omega_cor[3];
+    for(int i(0); i < 3; ++i){omega_cor[i] = omega_ei[i] * 2 + omega_ne[i];}
+    a_ned[0] += omega_cor[1] * v_ned[2] - omega_cor[2] * v_ned[1];
+    a_ned[1] += omega_cor[2] * v_ned[0] - omega_cor[0] * v_ned[2];
+    a_ned[2] += omega_cor[0] * v_ned[1] - omega_cor[1] * v_ned[0];
+
+    float_sylph_t omega_body[3] = {0, w * s_phi, w * c_phi};
+    for(int i(0); i < 3; ++i){
+      accel[i] = omega[i] = 0;
+      for(int j(0); j < 3; ++j){
+        accel[i] += dcm_b2n[j][i] * a_ned[j];
+        omega[i] += dcm_b2n[j][i] * (omega_ei[j] + omega_ne[j]);
+      }
+      omega[i] += omega_body[i];
+    }
+  }
+
+  space_node_t::llh_t llh() const {
+    return space_node_t::llh_t(latitude, longitude, height);
+  }
+  space_node_t::xyz_t velocity_xyz() const {
+    float_sylph_t
+        s1(std::sin(longitude)), c1(std::cos(longitude)),
+        s2(std::sin(latitude)), c2(std::cos(latitude));
+    const float_sylph_t &n(v_ned[0]), &e(v_ned[1]), u(-v_ned[2]);
+    return space_node_t::xyz_t(
+        -e * s1 - n * c1 * s2 + u * c1 * c2,
+         e * c1 - n * s1 * s2 + u * s1 * c2,
+                  n * c2      + u * s2);
+  }
+  /**
+   * Rotate a vector in the NED frame to the body frame
+   */
+  void n2b(const float_sylph_t (&v_n)[3], float_sylph_t (&v_b)[3]) const {
+    for(int i(0); i < 3; ++i){
+      v_b[i] = 0;
+      for(int j(0); j < 3; ++j){v_b[i] += dcm_b2n[j][i] * v_n[j];}
+    }
+  }
+};
+
+/**
+ * Synthetic GPS constellation of 6 orbital planes and 4 satellites for each plane.
+ * A new ephemeris is broadcasted every 2 hours, and its reference time (t_oe)
+ * is the end of the broadcast period.
+ * The orbits are continuous over ephemeris updates and week boundaries.
+ */
+struct constellation_t {
+  static const int satellites = 24;
+  static const int update_interval = 2 * 60 * 60;
+  static const float_sylph_t elevation_mask;
+
+  int week_ref; ///< orbits are defined at the beginning of this week
+
+  constellation_t(const int &week) : week_ref(week) {}
+
+  /**
+   * Ephemeris whose parameters are quantized as broadcasted ones
+   *
+   * @param prn satellite number (1-24)
+   * @param t_oe_abs reference time, elapsed seconds from the beginning of week_ref
+   */
+  ephemeris_t ephemeris(const int &prn, const long long &t_oe_abs) const {
+    ephemeris_t eph = ephemeris_t();
+    int plane((prn - 1) / 4), slot((prn - 1) % 4);
+    int weeks((int)(t_oe_abs / gps_time_t::seconds_week));
+    eph.svid = prn;
+    eph.WN = week_ref + weeks;
+    eph.t_oc = eph.t_oe = (float_sylph_t)(t_oe_abs - (long long)weeks * gps_time_t::seconds_week);
+    eph.iodc = eph.iode = (int)((t_oe_abs / update_interval) % 0x100);
+    eph.fit_interval = 4 * 60 * 60;
+    eph.a_f0 = 1E-6 * (prn - 12);
+    eph.sqrt_A = 5153.6;
+    eph.e = 0.01;
+    eph.i0 = 55. / 180 * M_PI;
+    eph.dot_Omega0 = -8E-9;
+    eph.omega = 0;
+    // Mean anomaly and longitude of ascending node (referenced to the weekly epoch)
+    eph.M0 = M_PI / 2 * slot + M_PI / 12 * plane
+        + std::sqrt(WGS84::mu_Earth) / std::pow(eph.sqrt_A, 3) * t_oe_abs;
+    eph.Omega0 = M_PI / 3 * plane
+        + eph.dot_Omega0 * t_oe_abs
+        - WGS84::Omega_Earth * gps_time_t::seconds_week * weeks;
+    eph.M0 -= std::floor(eph.M0 / (M_PI * 2) + 0.5) * (M_PI * 2);
+    eph.Omega0 -= std::floor(eph.Omega0 / (M_PI * 2) + 0.5) * (M_PI * 2);
+
+    ephemeris_t::raw_t raw;
+    raw = eph;
+    return (ephemeris_t)raw;
+  }
+
+  /**
+   * Reference time of ephemeris broadcasted at a time
+   *
+   * @param t elapsed seconds from the beginning of week_ref
+   */
+  static long long t_oe_broadcasted(const float_sylph_t &t){
+    return ((long long)std::floor(t / update_interval) + 1) * update_interval;
+  }
+
+  /**
+   * Register ephemerides which are required in a period
+   *
+   * @param since elapsed seconds from the beginning of week_ref
+   * @param until elapsed seconds from the beginning of week_ref
+   */
+  void register_ephemeris(space_node_t &space_node,
+      const float_sylph_t &since, const float_sylph_t &until) const {
+    for(long long t_oe(t_oe_broadcasted(since) - update_interval);
+        t_oe <= t_oe_broadcasted(until); t_oe += update_interval){
+      if(t_oe < 0){continue;}
+      for(int prn(1); prn <= satellites; ++prn){
+        space_node.satellite(prn).register_ephemeris(ephemeris(prn, t_oe));
+      }
+    }
+  }
+
+  static space_node_t::Ionospheric_UTC_Parameters::raw_t iono_utc(const int &week){
+    space_node_t::Ionospheric_UTC_Parameters::raw_t raw = {
+      12, -1, -1, 2, // alpha[0-3], typical values
+      57, -14, -2, 16, // beta[0-3]
+      0, 0, // A1, A0
+      0, (space_node_t::u8_t)(week & 0xFF), // t_ot, WN_t
+      18, // delta_t_LS
+      (space_node_t::u8_t)(1929 & 0xFF), 1, 18, // WN_LSF, DN, delta_t_LSF; 2017/1/1
+    };
+    return raw;
+  }
+};
+const float_sylph_t constellation_t::elevation_mask = 10. / 180 * M_PI;
+
+/**
+ * Builder of a GPS LNAV subframe, whose bit layout is identical to the decoder
+ * GPS_SpaceNode::BroadcastedMessage. Parity bits are not calculated
+ * because they are removed in UBX RXM-SFRB.
+ */
+struct subframe_t {
+  unsigned int word[10]; ///< 30 bits of each word are right aligned
+
+  subframe_t(const unsigned int &tow_count, const unsigned int &subframe_id){
+    for(int i(0); i < 10; ++i){word[i] = 0;}
+    set(0, 8, 0x8B); // preamble
+    set(30, 17, tow_count);
+    set(49, 3, subframe_id);
+  }
+  void set(const unsigned int &offset, const unsigned int &length, const unsigned int &value){
+    for(unsigned int i(0); i < length; ++i){
+      if(((value >> (length - i - 1)) & 0x01) == 0){continue;}
+      unsigned int bit(offset + i);
+      word[bit / 30] |= (0x20000000u >> (bit % 30));
+    }
+  }
+  void set(
+      const unsigned int &offset1, const unsigned int &length1,
+      const unsigned int &offset2, const unsigned int &length2,
+      const unsigned int &value){
+    set(offset1, length1, value >> length2);
+    set(offset2, length2, value);
+  }
+
+  static subframe_t ephemeris(
+      const ephemeris_t::raw_t &raw, const unsigned int &tow_count, const unsigned int &subframe_id){
+    subframe_t res(tow_count, subframe_id);
+    switch(subframe_id){
+      case 1:
+        res.set(60, 10, raw.WN & 0x3FF);
+        res.set(72, 4, raw.URA);
+        res.set(76, 6, raw.SV_health);
+        res.set(82, 2, 210, 8, raw.iodc);
+        res.set(196, 8, raw.t_GD);
+        res.set(218, 16, raw.t_oc);
+        res.set(240, 8, raw.a_f2);
+        res.set(248, 16, raw.a_f1);
+        res.set(270, 22, raw.a_f0);
+        break;
+      case 2:
+        res.set(60, 8, raw.iode);
+        res.set(68, 16, raw.c_rs);
+        res.set(90, 16, raw.delta_n);
+        res.set(106, 8, 120, 24, raw.M0);
+        res.set(150, 16, raw.c_uc);
+        res.set(166, 8, 180, 24, raw.e);
+        res.set(210, 16, raw.c_us);
+        res.set(226, 8, 240, 24, raw.sqrt_A);
+        res.set(270, 16, raw.t_oe);
+        res.set(286, 1, raw.fit_interval_flag ? 1 : 0);
+        break;
+      case 3:
+        res.set(60, 16, raw.c_ic);
+        res.set(76, 8, 90, 24, raw.Omega0);
+        res.set(120, 16, raw.c_is);
+        res.set(136, 8, 150, 24, raw.i0);
+        res.set(180, 16, raw.c_rc);
+        res.set(196, 8, 210, 24, raw.omega);
+        res.set(240, 24, raw.dot_Omega0);
+        res.set(270, 8, raw.iode);
+        res.set(278, 14, raw.dot_i0);
+        break;
+    }
+    return res;
+  }
+
+  /**
+   * Subframe 4 page 18 (ionospheric and UTC parameters)
+   */
+  static subframe_t iono_utc(
+      const space_node_t::Ionospheric_UTC_Parameters::raw_t &raw, const unsigned int &tow_count){
+    subframe_t res(tow_count, 4);
+    res.set(60, 2, 1); // data ID
+    res.set(62, 6, 56); // SV ID
+    res.set(68, 8, raw.alpha0);
+    res.set(76, 8, raw.alpha1);
+    res.set(90, 8, raw.alpha2);
+    res.set(98, 8, raw.alpha3);
+    res.set(106, 8, raw.beta0);
+    res.set(120, 8, raw.beta1);
+    res.set(128, 8, raw.beta2);
+    res.set(136, 8, raw.beta3);
+    res.set(150, 24, raw.A1);
+    res.set(180, 24, 210, 8, raw.A0);
+    res.set(218, 8, raw.t_ot);
+    res.set(226, 8, raw.WN_t);
+    res.set(240, 8, raw.delta_t_LS);
+    res.set(248, 8, raw.WN_LSF);
+    res.set(256, 8, raw.DN);
+    res.set(270, 8, raw.delta_t_LSF);
+    return res;
+  }
+
+  /**
+   * Subframe 5 page 25 (almanac reference week and health), whose data is all zero,
+   * which means all satellites are healthy.
+   */
+  static subframe_t health(const unsigned int &tow_count){
+    subframe_t res(tow_count, 5);
+    res.set(60, 2, 1); // data ID
+    res.set(62, 6, 51); // SV ID
+    return res;
+  }
+};
+
+/**
+ * Writer of UBX packets, which accumulates a payload in little endian.
+ */
+struct ubx_t {
+  std::string payload;
+  ubx_t() : payload() {}
+  template <class T>
+  ubx_t &le(const T &v, const int &bytes = sizeof(T)){
+    unsigned long long u((unsigned long long)v);
+    for(int i(0); i < bytes; ++i, u >>= 8){payload += (char)(u & 0xFF);}
+    return *this;
+  }
+  ubx_t &r4(const float &v){
+    union {float f; unsigned int u;} buf;
+    buf.f = v;
+    return le(buf.u, 4);
+  }
+  ubx_t &r8(const double &v){
+    union {double d; unsigned long long u;} buf;
+    buf.d = v;
+    return le(buf.u, 8);
+  }
+  /**
+   * Append the packet with header and checksum to a stream
+   */
+  void write(std::string &out, const unsigned char &klass, const unsigned char &id) const {
+    std::string packet;
+    packet += (char)0xB5;
+    packet += (char)0x62;
+    packet += (char)klass;
+    packet += (char)id;
+    packet += (char)(payload.size() & 0xFF);
+    packet += (char)((payload.size() >> 8) & 0xFF);
+    packet += payload;
+    unsigned char ck_a(0), ck_b(0);
+    for(unsigned int i(2); i < packet.size(); ++i){
+      ck_a += (unsigned char)packet[i];
+      ck_b += ck_a;
+    }
+    packet += (char)ck_a;
+    packet += (char)ck_b;
+    out += packet;
+  }
+};
+
+/**
+ * Generator of a block, i.e., a period of the log.
+ * Outputs of blocks are independent of each other, therefore blocks can be processed
+ * in parallel, and concatenated in order.
+ */
+struct block_t {
+  long long since_ms, until_ms; ///< period from the start [ms]
+  std::string buf;
+  random_t random;
+  const constellation_t &constellation;
+  const MagneticField::model_t &mag_model;
+
+  block_t(const long long &since, const long long &until,
+      const constellation_t &constellation_, const MagneticField::model_t &mag_model_)
+      : since_ms(since), until_ms(until), buf(),
+      random(((unsigned long long)options.seed << 32) ^ (unsigned long long)since),
+      constellation(constellation_), mag_model(mag_model_) {}
+
+  static long long start_ms(){
+    return (long long)std::floor(options.start_gpstime.sec * 1000 + 0.5);
+  }
+  /**
+   * @return (unsigned int) time of week in milliseconds
+   */
+  static unsigned int itow_ms(const long long &elapsed_ms){
+    return (unsigned int)((start_ms() + elapsed_ms) % (gps_time_t::seconds_week * 1000));
+  }
+  static gps_time_t gpst(const long long &elapsed_ms){
+    return gps_time_t(options.start_gpstime.wn, 0)
+        + ((float_sylph_t)(start_ms() + elapsed_ms) / 1000);
+  }
+
+  /**
+   * @return (long long) the first index of events whose time is since_ms or later
+   */
+  static long long first_index(const long long &since_ms, const float_sylph_t &rate){
+    long long res((long long)std::ceil((float_sylph_t)since_ms / 1000 * rate));
+    while((res > 0) && (event_ms(res - 1, rate) >= since_ms)){--res;}
+    while(event_ms(res, rate) < since_ms){++res;}
+    return res;
+  }
+  static long long event_ms(const long long &index, const float_sylph_t &rate){
+    return (long long)std::floor((float_sylph_t)index * 1000 / rate + 0.5);
+  }
+
+  void page(const char &type, const char *data){
+    buf += type;
+    buf.append(data, SYLPHIDE_PAGE_SIZE - 1);
+  }
+
+  void generate_A(const long long &index, const long long &t_ms){
+    truth_t truth((float_sylph_t)t_ms / 1000);
+    int raw[9] = {0};
+    {
+      float_sylph_t accel[3], omega[3];
+      for(int i(0); i < 3; ++i){
+        accel[i] = truth.accel[i] + random.normal(options.accel_noise);
+        omega[i] = truth.omega[i] + random.normal(options.gyro_noise);
+      }
+      options.calibration.accel2raw(accel, raw);
+      options.calibration.omega2raw(omega, raw);
+    }
+
+    char data[SYLPHIDE_PAGE_SIZE - 1] = {(char)(index & 0xFF)};
+    unsigned int itow(itow_ms(t_ms));
+    for(int i(0); i < 4; ++i){data[1 + i] = (char)((itow >> (8 * i)) & 0xFF);}
+    for(int i(0); i < 8; ++i){ // 24 bits, big endian
+      int v(raw[i]);
+      if(v < 0){v = 0;}else if(v > 0xFFFFFF){v = 0xFFFFFF;}
+      data[5 + (3 * i)] = (char)((v >> 16) & 0xFF);
+      data[6 + (3 * i)] = (char)((v >> 8) & 0xFF);
+      data[7 + (3 * i)] = (char)(v & 0xFF);
+    }
+    data[29] = (char)(raw[8] & 0xFF); // temperature, little endian
+    data[30] = (char)((raw[8] >> 8) & 0xFF);
+    page('A', data);
+  }
+
+  void generate_M(const long long &t_ms){
+    char data[SYLPHIDE_PAGE_SIZE - 1] = {(char)0x80}; // big endian
+    unsigned int itow(itow_ms(t_ms));
+    for(int i(0); i < 4; ++i){data[3 + i] = (char)((itow >> (8 * i)) & 0xFF);}
+
+    truth_t truth((float_sylph_t)t_ms / 1000);
+    MagneticField::field_components_res_t field(MagneticField::field_components(
+        mag_model, truth.latitude, truth.longitude, truth.height));
+    float_sylph_t field_ned[3] = {field.north, field.east, field.down};
+
+    float_sylph_t sample_interval(1. / options.rate_M / 4);
+    for(int i(0); i < 4; ++i){ // 4 samples, the last one is at t_ms
+      truth_t truth_sample((float_sylph_t)t_ms / 1000 - sample_interval * (3 - i));
+      float_sylph_t field_body[3];
+      truth_sample.n2b(field_ned, field_body);
+      for(int j(0); j < 3; ++j){
+        float_sylph_t v(std::floor(field_body[j] / options.mag_lsb + 0.5));
+        short v2((v > 0x7FFF) ? 0x7FFF : ((v < -0x8000) ? -0x8000 : (short)v));
+        data[7 + (6 * i) + (2 * j)] = (char)((v2 >> 8) & 0xFF);
+        data[8 + (6 * i) + (2 * j)] = (char)(v2 & 0xFF);
+      }
+    }
+    page('M', data);
+  }
+
+  struct measurement_t {
+    int prn;
+    float_sylph_t pseudo_range, carrier_phase, doppler;
+  };
+
+  void generate_G(const long long &index, const long long &t_ms){
+    std::string ubx;
+    truth_t truth((float_sylph_t)t_ms / 1000);
+    space_node_t::llh_t usr_llh(truth.llh());
+    space_node_t::xyz_t usr(usr_llh.xyz()), usr_vel(truth.velocity_xyz());
+    unsigned int itow(itow_ms(t_ms));
+    gps_time_t t(gpst(t_ms));
+
+    space_node_t space_node;
+    { // ephemeris and ionospheric parameters
+      float_sylph_t t_ref((float_sylph_t)(start_ms() + t_ms) / 1000);
+      constellation.register_ephemeris(space_node, t_ref, t_ref);
+      space_node.update_iono_utc(
+          (space_node_t::Ionospheric_UTC_Parameters)constellation_t::iono_utc(t.week));
+      space_node.update_all_ephemeris(t);
+    }
+
+    // Receiver clock error, whose drift is constant
+    static const float_sylph_t clock_bias(1E-6), clock_drift(1E-9);
+    float_sylph_t rx_clock(clock_bias + clock_drift * t_ms / 1000);
+
+    std::vector<measurement_t> measurements;
+    std::vector<int> visible;
+    for(int prn(1); prn <= constellation_t::satellites; ++prn){
+      const space_node_t::Satellite &sat(space_node.satellite(prn));
+      float_sylph_t range(2E7);
+      space_node_t::xyz_t sat_pos;
+      for(int i(0); i < 3; ++i){ // transit time
+        sat_pos = sat.position(t, range);
+        range = sat_pos.dist(usr);
+      }
+      space_node_t::enu_t relative_pos(space_node_t::enu_t::relative(sat_pos, usr));
+      if(relative_pos.elevation() < constellation_t::elevation_mask){continue;}
+      visible.push_back(prn);
+
+      float_sylph_t delay(
+          -space_node.iono_correction(relative_pos, usr_llh, t)
+          - space_node.tropo_correction(relative_pos, usr_llh));
+      float_sylph_t range_clock(
+          (rx_clock - sat.clock_error(t, range)) * space_node_t::light_speed);
+
+      space_node_t::xyz_t sat_vel(sat.velocity(t, range));
+      float_sylph_t range_rate(0);
+      for(int i(0); i < 3; ++i){
+        range_rate += (sat_vel[i] - usr_vel[i]) * (sat_pos[i] - usr[i]) / range;
+      }
+      range_rate += (clock_drift - sat.clock_error_dot(t, range)) * space_node_t::light_speed;
+
+      measurement_t m = {
+        prn,
+        range + range_clock + delay + random.normal(options.range_noise),
+        (range + range_clock - delay) / space_node_t::L1_WaveLength() + 1000 * prn, // with ambiguity
+        -range_rate / space_node_t::L1_WaveLength() + random.normal(0.1),
+      };
+      measurements.push_back(m);
+    }
+
+    float_sylph_t pos_ned_error[3] = {
+      random.normal(options.pos_noise),
+      random.normal(options.pos_noise),
+      random.normal(options.pos_noise * 1.5)};
+    float_sylph_t vel_ned[3];
+    for(int i(0); i < 3; ++i){vel_ned[i] = truth.v_ned[i] + random.normal(options.vel_noise);}
+    space_node_t::llh_t pos_llh(
+        usr_llh.latitude() + pos_ned_error[0] / (WGS84::R_meridian(usr_llh.latitude()) + usr_llh.height()),
+        usr_llh.longitude() + pos_ned_error[1]
+          / ((WGS84::R_normal(usr_llh.latitude()) + usr_llh.height()) * std::cos(usr_llh.latitude())),
+        usr_llh.height() - pos_ned_error[2]);
+    space_node_t::xyz_t pos_xyz(pos_llh.xyz());
+    truth.v_ned[0] = vel_ned[0]; truth.v_ned[1] = vel_ned[1]; truth.v_ned[2] = vel_ned[2];
+    space_node_t::xyz_t vel_xyz(truth.velocity_xyz());
+    unsigned int h_acc_mm((unsigned int)(options.pos_noise * 1E3)),
+        v_acc_mm((unsigned int)(options.pos_noise * 1.5E3)),
+        s_acc_cm_s((unsigned int)(options.vel_noise * 1E2));
+
+    { // NAV-SOL
+      ubx_t packet;
+      packet.le(itow).le((int)0).le((short)t.week)
+          .le((unsigned char)0x03) // 3D fix
+          .le((unsigned char)0x0D) // FIX_OK, WN_VALID, TOW_VALID
+          .le((int)std::floor(pos_xyz.x() * 1E2 + 0.5))
+          .le((int)std::floor(pos_xyz.y() * 1E2 + 0.5))
+          .le((int)std::floor(pos_xyz.z() * 1E2 + 0.5))
+          .le((unsigned int)(h_acc_mm / 10 * 2))
+          .le((int)std::floor(vel_xyz.x() * 1E2 + 0.5))
+          .le((int)std::floor(vel_xyz.y() * 1E2 + 0.5))
+          .le((int)std::floor(vel_xyz.z() * 1E2 + 0.5))
+          .le(s_acc_cm_s)
+          .le((unsigned short)150) // PDOP 1.5
+          .le((unsigned char)0)
+          .le((unsigned char)visible.size())
+          .le((unsigned int)0);
+      packet.write(ubx, 0x01, 0x06);
+    }
+    { // NAV-POSLLH
+      ubx_t packet;
+      packet.le(itow)
+          .le((int)std::floor(rad2deg(pos_llh.longitude()) * 1E7 + 0.5))
+          .le((int)std::floor(rad2deg(pos_llh.latitude()) * 1E7 + 0.5))
+          .le((int)std::floor(pos_llh.height() * 1E3 + 0.5))
+          .le((int)std::floor(pos_llh.height() * 1E3 + 0.5)) // geoid is not considered
+          .le(h_acc_mm).le(v_acc_mm);
+      packet.write(ubx, 0x01, 0x02);
+    }
+    { // NAV-VELNED
+      float_sylph_t speed_2d(std::sqrt(std::pow(vel_ned[0], 2) + std::pow(vel_ned[1], 2)));
+      float_sylph_t heading(rad2deg(std::atan2(vel_ned[1], vel_ned[0])));
+      if(heading < 0){heading += 360;}
+      ubx_t packet;
+      packet.le(itow)
+          .le((int)std::floor(vel_ned[0] * 1E2 + 0.5))
+          .le((int)std::floor(vel_ned[1] * 1E2 + 0.5))
+          .le((int)std::floor(vel_ned[2] * 1E2 + 0.5))
+          .le((unsigned int)std::floor(std::sqrt(std::pow(speed_2d, 2) + std::pow(vel_ned[2], 2)) * 1E2 + 0.5))
+          .le((unsigned int)std::floor(speed_2d * 1E2 + 0.5))
+          .le((int)std::floor(heading * 1E5 + 0.5))
+          .le(s_acc_cm_s)
+          .le((unsigned int)(1E5 * 5)); // 5 [deg]
+      packet.write(ubx, 0x01, 0x12);
+    }
+    { // RXM-RAW
+      ubx_t packet;
+      packet.le((int)itow).le((short)t.week)
+          .le((unsigned char)measurements.size()).le((unsigned char)0);
+      for(unsigned int i(0); i < measurements.size(); ++i){
+        packet.r8(measurements[i].carrier_phase)
+            .r8(measurements[i].pseudo_range)
+            .r4((float)measurements[i].doppler)
+            .le((unsigned char)measurements[i].prn)
+            .le((signed char)7) // quality; carrier phase locked
+            .le((signed char)45) // C/N0 [dB-Hz]
+            .le((unsigned char)0);
+      }
+      packet.write(ubx, 0x02, 0x10);
+    }
+    { // RXM-SFRB of subframes completed after the previous epoch
+      long long t_abs_ms(start_ms() + t_ms);
+      long long t_prev_abs_ms(t_abs_ms - (t_ms - event_ms(index - 1, options.rate_G)));
+      for(long long end_ms((t_prev_abs_ms / 6000 + 1) * 6000); end_ms <= t_abs_ms; end_ms += 6000){
+        if(end_ms < 6000){continue;}
+        unsigned int subframe_id((unsigned int)(((end_ms / 6000) - 1) % 5) + 1);
+        unsigned int tow_count((unsigned int)((end_ms / 6000) % (gps_time_t::seconds_week / 6)));
+        for(unsigned int i(0); i < visible.size(); ++i){
+          subframe_t subframe(tow_count, subframe_id);
+          switch(subframe_id){
+            case 1: case 2: case 3: {
+              ephemeris_t::raw_t raw;
+              raw = constellation.ephemeris(
+                  visible[i], constellation_t::t_oe_broadcasted((float_sylph_t)(end_ms - 6000) / 1000));
+              subframe = subframe_t::ephemeris(raw, tow_count, subframe_id);
+              break;
+            }
+            case 4:
+              subframe = subframe_t::iono_utc(
+                  constellation_t::iono_utc((int)(end_ms / 1000 / gps_time_t::seconds_week) + constellation.week_ref),
+                  tow_count);
+              break;
+            case 5:
+              subframe = subframe_t::health(tow_count);
+              break;
+          }
+          ubx_t packet;
+          packet.le((unsigned char)i).le((unsigned char)visible[i]);
+          for(int j(0); j < 10; ++j){
+            packet.le(subframe.word[j] >> 6); // parity is removed
+          }
+          packet.write(ubx, 0x02, 0x11);
+        }
+      }
+    }
+
+    // Split into G pages, whose unused tail is padded with zero
+    ubx.resize(((ubx.size() + (SYLPHIDE_PAGE_SIZE - 2)) / (SYLPHIDE_PAGE_SIZE - 1)) * (SYLPHIDE_PAGE_SIZE - 1), 0);
+    for(unsigned int i(0); i < ubx.size(); i += (SYLPHIDE_PAGE_SIZE - 1)){
+      page('G', &ubx[i]);
+    }
+  }
+
+  /**
+   * Generate pages in chronological order
+   */
+  void generate(){
+    static const long long never(-1);
+    long long
+        index_A(options.rate_A > 0 ? first_index(since_ms, options.rate_A) : never),
+        index_G(options.rate_G > 0 ? first_index(since_ms, options.rate_G) : never),
+        index_M(options.rate_M > 0 ? first_index(since_ms, options.rate_M) : never);
+    while(true){
+      long long
+          t_A(index_A == never ? until_ms : event_ms(index_A, options.rate_A)),
+          t_G(index_G == never ? until_ms : event_ms(index_G, options.rate_G)),
+          t_M(index_M == never ? until_ms : event_ms(index_M, options.rate_M));
+      if((t_A >= until_ms) && (t_G >= until_ms) && (t_M >= until_ms)){break;}
+      if((t_A <= t_G) && (t_A <= t_M)){
+        generate_A(index_A++, t_A);
+      }else if(t_G <= t_M){
+        generate_G(index_G++, t_G);
+      }else{
+        generate_M(t_M);
+        ++index_M;
+      }
+    }
+  }
+
+#if defined(LOG_GENERATOR_THREAD)
+  static void run(block_t *block){
+    block->generate();
+  }
+#endif
+};
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "NinjaScan log generator" << endl;
+  cerr << "Usage: (exe) [options]" << endl;
+
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+    return -1;
+  }
+  if(options.start_gpstime.wn == Options::gps_time_t::WN_INVALID){
+    options.start_gpstime.wn = 2000;
+  }
+  if((options.turn_rate == 0) && (options.speed * options.duration > 1E5)){
+    cerr << "(warning!) Straight flight over 100 km is distorted." << endl;
+  }
+
+  constellation_t constellation(options.start_gpstime.wn);
+  const MagneticField::model_t &mag_model(IGRF12::IGRF2015);
+
+  long long duration_ms((long long)std::floor(options.duration * 1000 + 0.5)),
+      block_ms((long long)std::floor(options.block * 1000 + 0.5));
+  unsigned int threads(options.threads);
+#if !defined(LOG_GENERATOR_THREAD)
+  threads = 1;
+#endif
+
+  ostream &out(options.out());
+  unsigned long long bytes(0);
+  std::vector<block_t *> blocks_done;
+  for(long long since(0); ; ){
+    std::vector<block_t *> blocks;
+    for(unsigned int i(0); (i < threads) && (since < duration_ms); ++i, since += block_ms){
+      blocks.push_back(new block_t(
+          since, std::min(since + block_ms, duration_ms), constellation, mag_model));
+    }
+
+    // Generate blocks in parallel, while the previous blocks are written
+#if defined(LOG_GENERATOR_THREAD)
+    std::vector<std::thread> pool;
+    for(unsigned int i(0); i < blocks.size(); ++i){
+      pool.push_back(std::thread(block_t::run, blocks[i]));
+    }
+#else
+    for(unsigned int i(0); i < blocks.size(); ++i){
+      blocks[i]->generate();
+    }
+#endif
+    for(unsigned int i(0); i < blocks_done.size(); ++i){
+      out.write(blocks_done[i]->buf.data(), blocks_done[i]->buf.size());
+      bytes += blocks_done[i]->buf.size();
+      delete blocks_done[i];
+    }
+#if defined(LOG_GENERATOR_THREAD)
+    for(unsigned int i(0); i < pool.size(); ++i){pool[i].join();}
+#endif
+    if(blocks.empty()){break;}
+    blocks_done.swap(blocks);
+  }
+  out.flush();
+
+  cerr << "Generated: " << bytes << " [bytes], "
+      << (bytes / SYLPHIDE_PAGE_SIZE) << " [pages]" << endl;
+
+  return 0;
+}
@@ -0,0 +1,473 @@
+/**
+ * @file Mixer of external u-blox and inertial data into NinjaScan log
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program generates a log.dat of NinjaScan by merging external data,
+ * and is a native replacement of log_mixer.rb.
+ * The following inputs are converted into pages, which are merged in order of time.
+ *   u-blox (UBX) stream: packets are grouped by their time stamps, and each group
+ *     is split into G pages of 31 bytes. A packet without time stamp belongs to
+ *     the preceding group.
+ *   NinjaScan log: pages are passed through. A page without time stamp, such as G page,
+ *     follows the preceding page.
+ *   IMU CSV: each line is converted into an A page. Its columns are GPS time [s]
+ *     (both cumulative seconds and time of week are acceptable), XYZ acceleration [m/s^2],
+ *     and XYZ angular speed [deg/s]. Separators are comma, space or tab, and
+ *     lines which are not numeric, such as a header, are skipped.
+ * Each input is read sequentially and only the current group of each input is held,
+ * therefore the memory usage does not depend on the length of the inputs.
+ * When time stamps are the same, the input specified earlier is output first.
+ *
+ * Its usage is
+ *   log_mixer [option(s)] [ubx_data [imu_csv]],
+ * where the positional arguments are compatible with log_mixer.rb.
+ *
+ * The options are
+ *   --ubx=<file>, --log=<file>, --imu_csv=<file>
+ *     specify an input of u-blox stream, NinjaScan log, and IMU CSV, respectively.
+ *     They can be specified multiple times, and - (hyphen) stands for the standard input.
+ *   --ubx_delay=<seconds>
+ *     specifies a delay added to time stamps of u-blox inputs (default 0).
+ *   --log_G=<on|off>
+ *     specifies whether G pages in NinjaScan log inputs are passed through (default on).
+ *     Use off when the u-blox data in the log is replaced by another one.
+ *   --calib_file=<file>
+ *     specifies the calibration file of inertial sensors used for IMU CSV inputs,
+ *     whose format is the same as INS_GPS.
+ *     NinjaScan default calibration parameters are used if not specified.
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "SylphideProcessor.h"
+
+#include "analyze_common.h"
+#include "calibration.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+typedef StandardCalibration<float_sylph_t> calibration_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  enum input_type_t {INPUT_UBX, INPUT_LOG, INPUT_IMU_CSV};
+  struct input_t {
+    input_type_t type;
+    const char *spec;
+  };
+  vector<input_t> inputs;
+  float_sylph_t ubx_delay;
+  bool log_G;
+  calibration_t calibration;
+
+  Options()
+      : super_t(),
+      inputs(), ubx_delay(0), log_G(true), calibration() {
+    set_typical_calibration_specs(calibration);
+  }
+  ~Options(){}
+
+  void add_input(const input_type_t &type, const char *spec){
+    input_t input = {type, spec};
+    inputs.push_back(input);
+  }
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+    if(value = get_value(spec, "ubx", false)){
+      add_input(INPUT_UBX, value);
+      return true;
+    }
+    if(value = get_value(spec, "log", false)){
+      add_input(INPUT_LOG, value);
+      return true;
+    }
+    if(value = get_value(spec, "imu_csv", false)){
+      add_input(INPUT_IMU_CSV, value);
+      return true;
+    }
+    if(value = get_value(spec, "ubx_delay", false)){
+      ubx_delay = std::atof(value);
+      cerr << "ubx_delay: " << ubx_delay << endl;
+      return true;
+    }
+    if(value = get_value(spec, "log_G", true)){
+      log_G = is_true(value);
+      cerr << "log_G: " << (log_G ? "on" : "off") << endl;
+      return true;
+    }
+    if(value = get_value(spec, "calib_file", false)){
+      return load_calibration_file(calibration, value);
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+/**
+ * Source of pages, each of which generates a sequence of chunks.
+ * A chunk is a series of pages sharing a time stamp.
+ */
+struct source_t {
+  typedef CalendarTime<float_sylph_t>::Converter::roll_over_monitor_t monitor_t;
+  istream &in;
+  std::string chunk; ///< pages of the current chunk
+  float_sylph_t t; ///< time of the current chunk, which is continuous over week boundaries
+  monitor_t monitor;
+  bool t_valid;
+
+  source_t(istream &in_) : in(in_), chunk(), t(0), monitor(), t_valid(false) {}
+  virtual ~source_t(){}
+
+  /**
+   * Update time with time of week
+   */
+  void update_time(const float_sylph_t &itow){
+    if(!t_valid){
+      monitor.itow_previous = itow; // to prevent false detection of roll over
+      t_valid = true;
+    }
+    t = monitor(itow);
+  }
+
+  /**
+   * Read the next chunk
+   *
+   * @return (bool) false when the source is exhausted, otherwise true
+   */
+  virtual bool next() = 0;
+
+  static void append_page(std::string &buf, const char &type, const char *data){
+    buf += type;
+    buf.append(data, SYLPHIDE_PAGE_SIZE - 1);
+  }
+};
+
+/**
+ * u-blox stream, which is split into G pages
+ */
+struct ubx_source_t : public source_t {
+  typedef G_Packet_Observer<float_sylph_t> observer_t;
+  observer_t observer;
+  std::string packets; ///< packets of the current chunk
+
+  ubx_source_t(istream &in_)
+      : source_t(in_), observer(0x10000), packets() {}
+
+  /**
+   * Extract time stamp of the current packet
+   *
+   * @param itow time of week [s] (output)
+   * @return (bool) true when the packet has a time stamp
+   */
+  bool time_stamp(float_sylph_t &itow) const {
+    observer_t::packet_type_t type(observer.packet_type());
+    switch(type.mclass){
+      case 0x01: // NAV
+        switch(type.mid){
+          case 0x01: case 0x02: case 0x03: case 0x04: case 0x06: case 0x08:
+          case 0x11: case 0x12: case 0x20: case 0x21: case 0x22:
+          case 0x30: case 0x31: case 0x32:
+            itow = observer.fetch_ITOW();
+            return true;
+        }
+        break;
+      case 0x02: // RXM
+        switch(type.mid){
+          case 0x10: case 0x20: // RAW, SVSI
+            itow = observer.fetch_ITOW();
+            return true;
+          case 0x15: { // RAWX, whose time stamp is double
+            char buf[8];
+            observer.inspect(buf, sizeof(buf), 6);
+            itow = le_char8_2_num<double>(*buf);
+            return true;
+          }
+        }
+        break;
+    }
+    return false;
+  }
+
+  /**
+   * Make a valid packet available at the head of the observer.
+   * The packet is removed by observer.seek_next().
+   *
+   * @return (bool) false when the stream is exhausted, otherwise true
+   */
+  bool fill(){
+    char buf[0x1000];
+    while(true){
+      if(observer.ready()){
+        if(observer.validate()){return true;}
+        observer.seek_next(); // skip a byte of broken packet
+        continue;
+      }
+      observer.seek_next(); // skip bytes until the next header
+      in.read(buf, std::min<int>(observer.margin(), sizeof(buf)));
+      if(in.gcount() <= 0){return false;}
+      observer.write(buf, in.gcount());
+    }
+  }
+
+  bool next(){
+    bool stamped(false);
+    float_sylph_t itow_chunk(0);
+    while(fill()){
+      float_sylph_t itow;
+      if(time_stamp(itow)){
+        itow += options.ubx_delay;
+        if(!stamped){
+          stamped = true;
+          update_time(itow_chunk = itow);
+        }else if(itow != itow_chunk){
+          break; // the packet is left for the next chunk
+        }
+      }
+      unsigned int size(observer.current_packet_size());
+      std::size_t offset(packets.size());
+      packets.resize(offset + size);
+      observer.inspect(&packets[offset], size);
+      observer.seek_next();
+    }
+    if(packets.empty()){return false;}
+
+    // Split into G pages, whose last one is padded with zero
+    static const unsigned int payload(SYLPHIDE_PAGE_SIZE - 1);
+    packets.resize((packets.size() + payload - 1) / payload * payload, '\0');
+    chunk.clear();
+    for(std::size_t i(0); i < packets.size(); i += payload){
+      append_page(chunk, 'G', &packets[i]);
+    }
+    packets.clear();
+    return true;
+  }
+};
+
+/**
+ * NinjaScan log, whose pages are passed through
+ */
+struct log_source_t : public source_t {
+  A_Packet_Observer<float_sylph_t> observer_A;
+  Data24Bytes_Packet_Observer<float_sylph_t> observer_24; ///< common to F, M, P and N pages
+  unsigned long skipped_G;
+
+  log_source_t(istream &in_)
+      : source_t(in_),
+      observer_A(SYLPHIDE_PAGE_SIZE * 2), observer_24(SYLPHIDE_PAGE_SIZE * 2),
+      skipped_G(0) {}
+
+  template <class Observer>
+  static float_sylph_t fetch_ITOW(Observer &observer, const char *page){
+    observer.write(const_cast<char *>(page) + 1, SYLPHIDE_PAGE_SIZE - 1);
+    float_sylph_t res(observer.fetch_ITOW());
+    observer.seek_next();
+    return res;
+  }
+
+  bool next(){
+    char page[SYLPHIDE_PAGE_SIZE];
+    while(true){
+      in.read(page, sizeof(page));
+      if(in.gcount() < (streamsize)sizeof(page)){return false;}
+      switch(page[0]){
+        case 'A':
+          update_time(fetch_ITOW(observer_A, page));
+          break;
+        case 'F': case 'M': case 'P': case 'N':
+          update_time(fetch_ITOW(observer_24, page));
+          break;
+        case 'G':
+          if(!options.log_G){
+            ++skipped_G;
+            continue;
+          }
+          break;
+      }
+      chunk.assign(page, sizeof(page));
+      return true;
+    }
+  }
+};
+
+/**
+ * CSV of inertial sensors, whose lines are converted to A pages
+ */
+struct imu_csv_source_t : public source_t {
+  unsigned int index;
+  std::string line;
+
+  imu_csv_source_t(istream &in_) : source_t(in_), index(0), line() {}
+
+  bool next(){
+    while(std::getline(in, line)){
+      float_sylph_t values[7];
+      const char *p(line.c_str());
+      int i(0);
+      for(; i < 7; ++i){
+        while((*p == ',') || (*p == ' ') || (*p == '\t')){++p;}
+        char *p_end;
+        values[i] = std::strtod(p, &p_end);
+        if(p_end == p){break;}
+        p = p_end;
+      }
+      if(i < 7){continue;} // not numeric
+
+      float_sylph_t itow(std::fmod(values[0], (float_sylph_t)(60 * 60 * 24 * 7)));
+      if(itow < 0){itow += (60 * 60 * 24 * 7);}
+      update_time(itow);
+
+      int raw[9] = {0};
+      float_sylph_t accel[3], omega[3];
+      for(int j(0); j < 3; ++j){
+        accel[j] = values[1 + j];
+        omega[j] = values[4 + j] / 180 * M_PI;
+      }
+      options.calibration.accel2raw(accel, raw);
+      options.calibration.omega2raw(omega, raw);
+
+      char data[SYLPHIDE_PAGE_SIZE - 1] = {(char)(index++ & 0xFF)};
+      unsigned int itow_ms((unsigned int)std::floor(itow * 1000 + 0.5));
+      for(int j(0); j < 4; ++j){data[1 + j] = (char)((itow_ms >> (8 * j)) & 0xFF);}
+      for(int j(0); j < 8; ++j){ // 24 bits, big endian
+        int v(raw[j]);
+        if(v < 0){v = 0;}else if(v > 0xFFFFFF){v = 0xFFFFFF;}
+        data[5 + (3 * j)] = (char)((v >> 16) & 0xFF);
+        data[6 + (3 * j)] = (char)((v >> 8) & 0xFF);
+        data[7 + (3 * j)] = (char)(v & 0xFF);
+      }
+      chunk.clear();
+      append_page(chunk, 'A', data);
+      return true;
+    }
+    return false;
+  }
+};
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "NinjaScan log mixer" << endl;
+  cerr << "Usage: (exe) [options] [ubx_data [imu_csv]]" << endl;
+
+  int positional(0);
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    if((argv[i][0] == '-') && (argv[i][1] == '-')){
+      cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+      return -1;
+    }
+    switch(positional++){ // compatible with log_mixer.rb
+      case 0: options.add_input(Options::INPUT_UBX, argv[i]); break;
+      case 1: options.add_input(Options::INPUT_IMU_CSV, argv[i]); break;
+      default:
+        cerr << "(error!) Too many inputs!! : " << argv[i] << endl;
+        return -1;
+    }
+  }
+  if(options.inputs.empty()){
+    cerr << "(error!) No input." << endl;
+    return -1;
+  }
+
+  std::vector<source_t *> sources;
+  for(unsigned int i(0); i < options.inputs.size(); ++i){
+    const Options::input_t &input(options.inputs[i]);
+    switch(input.type){
+      case Options::INPUT_UBX:
+        cerr << "UBX: ";
+        sources.push_back(new ubx_source_t(options.spec2istream(input.spec)));
+        break;
+      case Options::INPUT_LOG:
+        cerr << "log: ";
+        sources.push_back(new log_source_t(options.spec2istream(input.spec)));
+        break;
+      case Options::INPUT_IMU_CSV:
+        cerr << "IMU CSV: ";
+        sources.push_back(new imu_csv_source_t(options.spec2istream(input.spec)));
+        break;
+    }
+  }
+
+  // Merge chunks; the number of sources is small, therefore linear search is used.
+  std::vector<source_t *> active;
+  for(unsigned int i(0); i < sources.size(); ++i){
+    if(sources[i]->next()){active.push_back(sources[i]);}
+  }
+  ostream &out(options.out());
+  unsigned long long bytes(0);
+  while(!active.empty()){
+    unsigned int selected(0);
+    for(unsigned int i(1); i < active.size(); ++i){
+      if(active[i]->t < active[selected]->t){selected = i;} // the earlier input wins a tie
+    }
+    source_t &src(*active[selected]);
+    out.write(src.chunk.data(), src.chunk.size());
+    bytes += src.chunk.size();
+    if(!src.next()){active.erase(active.begin() + selected);}
+  }
+  out.flush();
+
+  for(unsigned int i(0); i < sources.size(); ++i){
+    if(sources[i]->monitor.abnormal_jump_detected){
+      cerr << "(warning!) Time of input " << options.inputs[i].spec << " jumps." << endl;
+    }
+    delete sources[i];
+  }
+
+  cerr << "Mixed: " << bytes << " [bytes], "
+      << (bytes / SYLPHIDE_PAGE_SIZE) << " [pages]" << endl;
+
+  return 0;
+}
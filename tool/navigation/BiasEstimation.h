@@ -78,6 +78,17 @@ class INS_BiasEstimated : public BaseINS {
 
     virtual ~INS_BiasEstimated(){}
 
+    /**
+     * Save or restore states including biases for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      BaseINS::checkpoint(ar);
+      ar & m_bias_accel & m_bias_gyro;
+    }
+
     vec3_t &bias_accel(){return m_bias_accel;}
     vec3_t &bias_gyro(){return m_bias_gyro;}
 
@@ -264,6 +275,22 @@ class Filtered_INS_BiasEstimated : public BaseFINS {
     
     ~Filtered_INS_BiasEstimated(){}
 
+    /**
+     * Save or restore states for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      BaseFINS::checkpoint(ar);
+      ar & m_beta_accel & m_beta_gyro & m_deltaT_sum;
+#if BIAS_EST_MODE == 1
+      ar & previous_modified_bias_accel & previous_modified_bias_gyro;
+#elif BIAS_EST_MODE == 2
+      ar & previous_delteT_sum & drift_bias_accel & drift_bias_gyro;
+#endif
+    }
+
     vec3_t &beta_accel(){return m_beta_accel;}
     vec3_t &beta_gyro(){return m_beta_gyro;}
 
@@ -31,6 +31,7 @@
 #include "INS.h"
 #include "param/matrix.h"
 #include "algorithm/kalman.h"
+#include "util/profile.h"
 
 template <class FloatT>
 struct CorrectInfo {
@@ -425,6 +426,17 @@ class Filtered_INS2
     
     virtual ~Filtered_INS2(){}
 
+    /**
+     * Save or restore states and the filter for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      BaseINS::checkpoint(ar);
+      ar & m_filter;
+    }
+
   protected:
     /**
      * ԍXVɂČ㏈邽߂̃R[obN֐B
@@ -448,6 +460,7 @@ class Filtered_INS2
      * @param deltaT ԊԊu
      */
     void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
+      PROFILE_SCOPE("Filtered_INS2::update");
       getAB_res AB;
       getAB(accel, gyro, AB);
       mat_t A(AB.getA()), B(AB.getB());
@@ -457,7 +470,10 @@ class Filtered_INS2
       //std::cerr << "P:" << m_filter.getP() << std::endl;
       m_filter.predict(A, B, deltaT);
       before_update_INS(A, B, deltaT);
-      BaseINS::update(accel, gyro, deltaT);
+      {
+        PROFILE_SCOPE("INS::update");
+        BaseINS::update(accel, gyro, deltaT);
+      }
     }
   
   protected:
@@ -524,6 +540,7 @@ class Filtered_INS2
     void correct_primitive(const mat_t &H, const mat_t &z, const mat_t &R){
             
       // Cʂ̌vZ
+      PROFILE_SCOPE("Filtered_INS2::correct");
       mat_t K(m_filter.correct(H, R)); //J}QC
       mat_t x_hat(K * z);
       before_correct_INS(H, R, K, z, x_hat);
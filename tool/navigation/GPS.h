@@ -38,6 +38,7 @@
 
 #include <vector>
 #include <iterator>
+#include <algorithm>
 #include <map>
 #include <bitset>
 
@@ -176,6 +177,206 @@ class GPS_Signal {
           g2.next();
         }
     };
+
+    /**
+     * Precomputed C/A code table for software receiver.
+     * The codes of all PRNs are generated once by CA_Code, and are held
+     * in chip-expanded form (+1/-1) and in bit-packed form
+     * (LSB first in each word, 1 stands for +1 chip).
+     * Replica generation at arbitrary sampling rate uses a fixed-point code phase accumulator,
+     * and correlation of bit-packed sequences is performed by XOR and popcount.
+     * Their inner loops run over contiguous arrays without branches
+     * so that compilers can vectorize them.
+     */
+    class CA_Code_Table {
+      public:
+        typedef unsigned int word_t;
+        static const int LENGTH = 1023; ///< number of chips
+        static const int PRN_MAX = 37;
+        static const int WORD_BITS = sizeof(word_t) * CHAR_BIT;
+        static const int WORDS = (LENGTH + WORD_BITS - 1) / WORD_BITS; ///< number of words per code
+      protected:
+        signed char chips[PRN_MAX + 1][LENGTH];
+        word_t packed[PRN_MAX + 1][WORDS];
+        CA_Code_Table() {
+          for(int prn(1); prn <= PRN_MAX; ++prn){
+            CA_Code code(prn);
+            std::fill(packed[prn], packed[prn] + WORDS, 0);
+            for(int i(0); i < LENGTH; ++i, code.next()){
+              chips[prn][i] = (signed char)code.get_multi();
+              if(code.get()){packed[prn][i / WORD_BITS] |= ((word_t)1 << (i % WORD_BITS));}
+            }
+          }
+        }
+        static int index(const int &prn){
+          return ((prn >= 1) && (prn <= PRN_MAX)) ? prn : PRN_MAX; // PRN_MAX is the same as default of G2::get_G2
+        }
+      public:
+        static const CA_Code_Table &get_instance(){
+          static const CA_Code_Table table;
+          return table;
+        }
+        /**
+         * @return (const signed char *) +1/-1 chips of the specified PRN, whose length is LENGTH
+         */
+        const signed char *chips_of(const int &prn) const {return chips[index(prn)];}
+        /**
+         * @return (const word_t *) bit-packed chips of the specified PRN, whose length is WORDS
+         */
+        const word_t *packed_of(const int &prn) const {return packed[index(prn)];}
+
+        /**
+         * Generate code replica sampled at arbitrary rate
+         *
+         * @param prn satellite number
+         * @param buf output buffer, which is filled with +1/-1
+         * @param samples number of samples
+         * @param sampling_rate sampling rate [Hz]
+         * @param code_phase code phase of the first sample [chip]
+         * @param code_rate chipping rate [Hz], which can include Doppler
+         */
+        template <class T>
+        void replica(
+            const int &prn, T *buf, const int &samples,
+            const float_t &sampling_rate, const float_t &code_phase = 0,
+            const float_t &code_rate = CA_Code::FREQENCY) const {
+          accumulator_t acc(sampling_rate, code_phase, code_rate);
+          acc.fill(chips_of(prn), buf, samples);
+        }
+
+        /**
+         * Generate bit-packed code replica sampled at arbitrary rate
+         *
+         * @param prn satellite number
+         * @param buf output buffer, whose length must be (samples + WORD_BITS - 1) / WORD_BITS
+         * @see replica()
+         */
+        void replica_packed(
+            const int &prn, word_t *buf, const int &samples,
+            const float_t &sampling_rate, const float_t &code_phase = 0,
+            const float_t &code_rate = CA_Code::FREQENCY) const {
+          const signed char *src(chips_of(prn));
+          accumulator_t acc(sampling_rate, code_phase, code_rate);
+          signed char chunk[WORD_BITS];
+          for(int i(0); i < samples; i += WORD_BITS, ++buf){
+            int j_max((samples - i < WORD_BITS) ? (samples - i) : WORD_BITS);
+            acc.fill(src, chunk, j_max);
+            pack_sign(chunk, buf, j_max);
+          }
+        }
+
+        /**
+         * Convert samples to bit-packed signs; 1 for non-negative value
+         *
+         * @param src samples
+         * @param buf output buffer, whose length must be (samples + WORD_BITS - 1) / WORD_BITS
+         * @param samples number of samples
+         */
+        template <class T>
+        static void pack_sign(const T *src, word_t *buf, const int &samples){
+          // Bit weights are looked up instead of variable shifts, which SSE2 lacks.
+#define bit_weight(n) ((word_t)1 << n)
+          static const word_t weight[WORD_BITS] = {
+            bit_weight( 0), bit_weight( 1), bit_weight( 2), bit_weight( 3),
+            bit_weight( 4), bit_weight( 5), bit_weight( 6), bit_weight( 7),
+            bit_weight( 8), bit_weight( 9), bit_weight(10), bit_weight(11),
+            bit_weight(12), bit_weight(13), bit_weight(14), bit_weight(15),
+            bit_weight(16), bit_weight(17), bit_weight(18), bit_weight(19),
+            bit_weight(20), bit_weight(21), bit_weight(22), bit_weight(23),
+            bit_weight(24), bit_weight(25), bit_weight(26), bit_weight(27),
+            bit_weight(28), bit_weight(29), bit_weight(30), bit_weight(31)};
+#undef bit_weight
+          const int words(samples / WORD_BITS), rest(samples % WORD_BITS);
+          for(int i(0); i < words; ++i, src += WORD_BITS){
+            word_t w(0);
+            for(int j(0); j < WORD_BITS; ++j){ // fixed trip count for vectorization
+              w |= ((src[j] >= 0) ? weight[j] : 0);
+            }
+            buf[i] = w;
+          }
+          if(rest > 0){
+            word_t w(0);
+            for(int j(0); j < rest; ++j){
+              w |= ((src[j] >= 0) ? weight[j] : 0);
+            }
+            buf[words] = w;
+          }
+        }
+
+        /**
+         * Count bits by SWAR (SIMD within a register), which consists of
+         * only shifts, masks, and additions, and therefore is vectorized in a loop.
+         * If the popcount instruction is available, it is used instead.
+         */
+        static int popcount(word_t v){
+#if defined(__GNUC__) && defined(__POPCNT__)
+          return __builtin_popcount(v);
+#else
+          v = v - ((v >> 1) & 0x55555555u);
+          v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+          v = (v + (v >> 4)) & 0x0F0F0F0Fu;
+          v += (v >> 8);
+          v += (v >> 16);
+          return (int)(v & 0x3F);
+#endif
+        }
+
+        /**
+         * Correlate two bit-packed +1/-1 sequences
+         *
+         * @param a the first sequence
+         * @param b the second sequence
+         * @param bits number of effective bits
+         * @return (int) sum of products, i.e., (bits - 2 * number of different bits)
+         */
+        static int correlate(const word_t *a, const word_t *b, const int &bits){
+          const int words(bits / WORD_BITS), rest(bits % WORD_BITS);
+          int diff(0);
+          for(int i(0); i < words; ++i){
+            diff += popcount(a[i] ^ b[i]);
+          }
+          if(rest > 0){
+            diff += popcount((a[words] ^ b[words]) & (((word_t)1 << rest) - 1));
+          }
+          return bits - (diff * 2);
+        }
+
+      protected:
+        /**
+         * Code phase accumulator in fixed point, whose integer part is the chip index.
+         * Samples are generated run by run, and the chip index does not wrap in a run.
+         * Therefore, the index of each sample is calculated from the head of the run
+         * without loop-carried dependency.
+         */
+        struct accumulator_t {
+          typedef unsigned long long fixed_t; // 32 fractional bits
+          static const int FRAC_BITS = 32;
+          fixed_t phase, step;
+          accumulator_t(const float_t &sampling_rate, const float_t &code_phase, const float_t &code_rate){
+            float_t phase_f(std::fmod(code_phase, (float_t)LENGTH)), delta(code_rate / sampling_rate);
+            if(phase_f < 0){phase_f += LENGTH;}
+            phase = (fixed_t)(phase_f * ((fixed_t)1 << FRAC_BITS));
+            step = (fixed_t)(std::fmod(delta, (float_t)LENGTH) * ((fixed_t)1 << FRAC_BITS));
+          }
+          template <class T>
+          void fill(const signed char *src, T *buf, const int &samples){
+            static const fixed_t end((fixed_t)LENGTH << FRAC_BITS);
+            for(int i(0); i < samples; ){
+              int run(samples - i);
+              if(step > 0){
+                fixed_t run_max((end - phase + step - 1) / step); // samples before wrap
+                if(run_max < (fixed_t)run){run = (int)run_max;}
+              }
+              for(int j(0); j < run; ++j){
+                buf[i + j] = (T)src[(phase + step * j) >> FRAC_BITS];
+              }
+              i += run;
+              phase += step * run;
+              if(phase >= end){phase -= end;}
+            }
+          }
+        };
+    };
 };
 
 template <class FloatT>
@@ -733,6 +934,17 @@ static s ## bits ## _t name(const InputT *buf){ \
       uint_t DN;           ///< Last leap second update day (days)
       int_t delta_t_LSF;   ///< Updated leap seconds (s)
 
+      /**
+       * Save or restore parameters for checkpoint
+       *
+       * @param ar archive
+       */
+      template <class Archive>
+      void checkpoint(Archive &ar){
+        for(int i(0); i < 4; ++i){ar & alpha[i] & beta[i];}
+        ar & A1 & A0 & t_ot & WN_t & delta_t_LS & WN_LSF & DN & delta_t_LSF;
+      }
+
       struct raw_t {
         s8_t  alpha0;       ///< Ionospheric parameter (-30, s)
         s8_t  alpha1;       ///< Ionospheric parameter (-27, s/sc)
@@ -859,6 +1071,19 @@ static s ## bits ## _t name(const InputT *buf){ \
           float_t dot_Omega0;   ///< Rate of right ascension (rad/s)
           float_t dot_i0;       ///< Rate of inclination angle (rad/s)
 
+          /**
+           * Save or restore parameters for checkpoint
+           *
+           * @param ar archive
+           */
+          template <class Archive>
+          void checkpoint(Archive &ar){
+            ar & svid
+                & WN & URA & SV_health & iodc & t_GD & t_oc & a_f2 & a_f1 & a_f0
+                & iode & c_rs & delta_n & M0 & c_uc & e & c_us & sqrt_A & t_oe & fit_interval
+                & c_ic & Omega0 & c_is & i0 & c_rc & omega & dot_Omega0 & dot_i0;
+          }
+
           inline float_t period_from_time_of_clock(const gps_time_t &t) const {
             return -t.interval(WN, t_oc);
           }
@@ -892,14 +1117,20 @@ static s ## bits ## _t name(const InputT *buf){ \
            */
           bool maybe_better_one_avilable(const gps_time_t &t) const {
             float_t delta_t(period_from_first_valid_transmittion(t));
-            float_t transmittion_interval( // @see IDC 20.3.4.5 Reference Times, Table 20-XIII
-                (fit_interval > (4 * 60 * 60))
-                  ? fit_interval / 2 // fit_interval is more than 4 hour, fit_interval / 2
-                  : (1 * 60 * 60));  // fit_interval equals to 4 hour, some SVs transmits every one hour.
-            return !((delta_t >= 0) && (delta_t < transmittion_interval));
+            return !((delta_t >= 0) && (delta_t < transmittion_interval()));
+          }
+
+          /**
+           * @return (float_t) interval in which a new ephemeris is not expected to be transmitted
+           * @see IDC 20.3.4.5 Reference Times, Table 20-XIII
+           */
+          float_t transmittion_interval() const {
+            return (fit_interval > (4 * 60 * 60))
+                ? fit_interval / 2 // fit_interval is more than 4 hour, fit_interval / 2
+                : (1 * 60 * 60);  // fit_interval equals to 4 hour, some SVs transmits every one hour.
           }
           
-          static const float_t URA_limits[];
+          static const float_t URA_limits[16];
           static const int URA_MAX_INDEX;
 
           static float_t URA_meter(const int_t &index){
@@ -1288,7 +1519,8 @@ static s ## bits ## _t name(const InputT *buf){ \
               CONVERT(c_uc);
               CONVERT(e);
               CONVERT(c_us);
-              CONVERT(sqrt_A);
+              // sqrt_A / sf exceeds the range of s32_t
+              sqrt_A = (u32_t)((eph.sqrt_A + 0.5 * sf[SF_sqrt_A]) / sf[SF_sqrt_A]);
               CONVERT(t_oe);
 
               CONVERT(c_ic);
@@ -1522,11 +1754,74 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
           bool operator==(const PropertyT &prop){
             return PropertyT::is_equivalent(prop);
           }
+
+          template <class Archive>
+          void checkpoint(Archive &ar){
+            PropertyT::checkpoint(ar);
+            ar & priority & t_tag;
+          }
         };
         typedef std::vector<item_t> history_t;
-        history_t history; // listed in chronological and higher priority order
+        /**
+         * Items listed in chronological (ascending t_tag) and higher priority order.
+         * The first item is a dummy, which is never selected by search.
+         */
+        history_t history;
         typename history_t::size_type selected_index;
 
+        struct t_tag_less_t {
+          bool operator()(const int &t_tag, const item_t &item) const {
+            return t_tag < item.t_tag;
+          }
+        };
+
+        /**
+         * Find the first item whose time tag is greater than the specified one.
+         * The search begins from a hint in galloping manner, which means that
+         * its cost is O(1) for successive calls with neighboring targets,
+         * and O(log N) in the worst case.
+         *
+         * @param t_tag time tag
+         * @param hint index from which search begins
+         * @return index of the first item whose time tag is greater than t_tag.
+         * If no such item, history.size() is returned.
+         */
+        typename history_t::size_type upper_bound(
+            const int &t_tag,
+            typename history_t::size_type hint) const {
+          typedef typename history_t::size_type size_type;
+          const size_type n(history.size());
+          if(hint < 1){hint = 1;}
+          if(hint > n){hint = n;}
+          size_type lo, hi, step(1);
+          if((hint < n) && (history[hint].t_tag <= t_tag)){
+            // forward; history[lo].t_tag <= t_tag
+            for(lo = hint, hi = hint + 1; (hi < n) && (history[hi].t_tag <= t_tag); step <<= 1){
+              lo = hi;
+              hi = ((n - lo) > step) ? (lo + step) : n;
+            }
+            ++lo;
+          }else if((hint > 1) && (history[hint - 1].t_tag > t_tag)){
+            // backward; history[hi].t_tag > t_tag
+            for(hi = hint - 1, lo = hi - 1; (lo >= 1) && (history[lo].t_tag > t_tag); step <<= 1){
+              hi = lo;
+              lo = (hi > (step + 1)) ? (hi - step) : 0;
+            }
+            ++lo;
+            ++hi;
+          }else{
+            return hint;
+          }
+          return std::distance(history.begin(),
+              std::upper_bound(history.begin() + lo, history.begin() + hi, t_tag, t_tag_less_t()));
+        }
+
+        /**
+         * Number of distinct time tags on each side of a target,
+         * which are examined by select().
+         */
+        static const int select_window = 4;
+
         typename history_t::iterator selected_iterator() {
           typename history_t::iterator it(history.begin());
           std::advance(it, selected_index);
@@ -1693,6 +1988,7 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
             const gps_time_t &target_time,
             bool (PropertyT::*is_valid)(const gps_time_t &) const,
             float_t (PropertyT::*get_delta_t)(const gps_time_t &) const = NULL){
+          typedef typename history_t::size_type size_type;
           typename history_t::iterator it_selected(selected_iterator());
 
           bool changed(false);
@@ -1702,17 +1998,21 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
           float_t delta_t(get_delta_t
               ? ((*it_selected).*get_delta_t)(target_time)
               : (t_tag_target - t_tag));
+          if(delta_t < 0){delta_t *= -1;}
+          bool selected_is_valid(((*it_selected).*is_valid)(target_time));
 
-          typename history_t::iterator it, it_last;
-          if(delta_t >= 0){
-            // find newer
-            it = it_selected + 1;
-            it_last = history.end();
-          }else{
-            // find older (rare case, slow)
-            it = history.begin();
-            it_last = it_selected;
-            delta_t *= -1;
+          /* Items to be examined are limited to ones around the target,
+           * which are found by binary search (with the current selection as a hint),
+           * instead of linear scan over the whole history.
+           */
+          size_type idx_begin(upper_bound(t_tag_target, selected_index)), idx_end(idx_begin);
+          for(int i(0); (idx_begin > 1) && (i < select_window); ++i){
+            int t_tag_skip(history[--idx_begin].t_tag);
+            while((idx_begin > 1) && (history[idx_begin - 1].t_tag == t_tag_skip)){--idx_begin;}
+          }
+          for(int i(0); (idx_end < history.size()) && (i < select_window); ++i){
+            int t_tag_skip(history[idx_end++].t_tag);
+            while((idx_end < history.size()) && (history[idx_end].t_tag == t_tag_skip)){++idx_end;}
           }
 
           /* Selection priority:
@@ -1720,14 +2020,16 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
            * which means when an item has been selected,
            * the others having same time tag will be skipped.
            */
-          for( ; it != it_last; ++it){
+          for(typename history_t::iterator it(history.begin() + idx_begin), it_last(history.begin() + idx_end);
+              it != it_last; ++it){
             if(changed && (t_tag == it->t_tag)){continue;} // skip one having same time tag, because highest priority one is selected.
             if(!(((*it).*is_valid)(target_time))){continue;}
             float_t delta_t2(get_delta_t
                 ? ((*it).*get_delta_t)(target_time)
                 : (t_tag_target - it->t_tag));
             if(delta_t2 < 0){delta_t2 *= -1;}
-            if(delta_t > delta_t2){ // update
+            if((!selected_is_valid) || (delta_t > delta_t2)){ // update
+              selected_is_valid = true;
               changed = true;
               t_tag = it->t_tag;
               delta_t = delta_t2;
@@ -1751,12 +2053,12 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
           while(true){
             if(it1 == history.end()){
               while(it2 != another.history.end()){
-                list_new.push_back(*it2);
+                list_new.push_back(*it2++);
               }
               break;
             }else if(it2 == another.history.end()){
               while(it1 != history.end()){
-                list_new.push_back(*it1);
+                list_new.push_back(*it1++);
               }
               break;
             }
@@ -1793,6 +2095,21 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
         const PropertyT &current() const {
           return history[selected_index];
         }
+
+        /**
+         * Save or restore all items and the selection for checkpoint
+         *
+         * @param ar archive
+         */
+        template <class Archive>
+        void checkpoint(Archive &ar){
+          unsigned int index((unsigned int)selected_index);
+          ar & history & index;
+          if(Archive::loading){
+            if(history.empty()){history.push_back(item_t());} // the first dummy
+            selected_index = (index < history.size()) ? index : 0;
+          }
+        }
     };
 
     class Satellite : public SatelliteProperties {
@@ -1823,7 +2140,12 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
         }
 
         void merge(const Satellite &another, const bool &keep_original = true){
-          eph_history.merge(another, keep_original);
+          eph_history.merge(another.eph_history, keep_original);
+        }
+
+        template <class Archive>
+        void checkpoint(Archive &ar){
+          ar & eph_history;
         }
 
         const eph_t &ephemeris() const {
@@ -1847,6 +2169,22 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
               &eph_t::period_from_first_valid_transmittion) || is_valid;
         }
 
+        /**
+         * Get period in which select_ephemeris() retains the current ephemeris without search.
+         *
+         * @param since start of the period
+         * @param until end of the period (exclusive)
+         * @return (bool) true when the current ephemeris is valid, otherwise false,
+         * which means no period is available.
+         */
+        bool ephemeris_retained_period(gps_time_t &since, gps_time_t &until) const {
+          const eph_t &eph(ephemeris());
+          if(eph.fit_interval < 0){return false;}
+          since = gps_time_t(eph.WN, eph.t_oc) - (eph.fit_interval / 2);
+          until = since + std::min(eph.fit_interval, eph.transmittion_interval());
+          return true;
+        }
+
         float_t clock_error(const gps_time_t &t, const float_t &pseudo_range = 0) const{
           return ephemeris().clock_error(t, pseudo_range);
         }
@@ -1875,10 +2213,22 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
     Ionospheric_UTC_Parameters _iono_utc;
     bool _iono_initialized, _utc_initialized;
     satellites_t _satellites;
+
+    /**
+     * Cache for update_all_ephemeris() to exploit epoch-to-epoch locality.
+     * Within [since, until), ephemeris selection of satellites other than
+     * the listed ones (without valid ephemeris) is unchanged.
+     */
+    struct ephemeris_selection_cache_t {
+      bool valid;
+      gps_time_t since, until;
+      std::vector<int> prn_without_ephemeris;
+      ephemeris_selection_cache_t() : valid(false), since(), until(), prn_without_ephemeris() {}
+    } _eph_selection_cache;
   public:
     GPS_SpaceNode()
         : _iono_initialized(false), _utc_initialized(false),
-        _satellites() {
+        _satellites(), _eph_selection_cache() {
     }
     ~GPS_SpaceNode(){
       _satellites.clear();
@@ -1908,18 +2258,68 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
       return _satellites;
     }
     Satellite &satellite(const int &prn) {
+      _eph_selection_cache.valid = false; // because ephemeris may be registered
       return _satellites[prn];
     }
     bool has_satellite(const int &prn) const {
       return _satellites.find(prn) !=  _satellites.end();
     }
+    /**
+     * Select appropriate ephemeris of all satellites.
+     * When successive calls have neighboring target times, most of satellites are skipped
+     * as long as their selection is retained, and no ephemeris is newly registered.
+     *
+     * @param target_time time at measurement
+     */
     void update_all_ephemeris(const gps_time_t &target_time) {
+      ephemeris_selection_cache_t &cache(_eph_selection_cache);
+      if(cache.valid && (target_time >= cache.since) && (target_time < cache.until)){
+        for(std::vector<int>::const_iterator it(cache.prn_without_ephemeris.begin());
+            it != cache.prn_without_ephemeris.end();
+            ++it){
+          Satellite &sat(_satellites[*it]);
+          sat.select_ephemeris(target_time);
+          gps_time_t since, until;
+          if(sat.ephemeris_retained_period(since, until)
+              && (target_time >= since) && (target_time < until)){
+            cache.valid = false; // newly selected, thus the period should be recalculated.
+          }
+        }
+        return;
+      }
+      cache.valid = true;
+      cache.since = target_time;
+      cache.until = target_time + gps_time_t::seconds_week;
+      cache.prn_without_ephemeris.clear();
       for(typename satellites_t::iterator it(_satellites.begin());
           it != _satellites.end(); ++it){
         it->second.select_ephemeris(target_time);
+        gps_time_t since, until;
+        if(!(it->second.ephemeris_retained_period(since, until))
+            || (target_time < since) || (target_time >= until)){
+          cache.prn_without_ephemeris.push_back(it->first);
+          continue;
+        }
+        if(cache.since < since){cache.since = since;}
+        if(cache.until > until){cache.until = until;}
       }
     }
+    /**
+     * Save or restore ephemerides, ionospheric and UTC parameters, and the selection cache
+     * for checkpoint
+     *
+     * @param ar archive
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      ephemeris_selection_cache_t &cache(_eph_selection_cache);
+      ar & _iono_utc & _iono_initialized & _utc_initialized & _satellites
+          & cache.valid
+          & cache.since.week & cache.since.seconds & cache.until.week & cache.until.seconds
+          & cache.prn_without_ephemeris;
+    }
     void merge(const self_t &another, const bool &keep_original = true){
+      _eph_selection_cache.valid = false;
       for(typename satellites_t::const_iterator it(another._satellites.begin());
           it != another._satellites.end();
           ++it){
@@ -2163,7 +2563,7 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
         };
         static const int tbl_length(sizeof(tbl_hyd_avg) / sizeof(tbl_hyd_avg[0]));
         static const float_t delta(M_PI / 180 * 15);
-        float_t idx_f(latitude / delta);
+        float_t idx_f(std::abs(latitude) / delta); // tbl[i] corresponds to (i + 1) * delta
         int idx(idx_f);
 
         coef_t abc_avg, abc_amp, abc_wet;
@@ -2171,17 +2571,17 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
           abc_avg = tbl_hyd_avg[0];
           abc_amp = tbl_hyd_amp[0];
           abc_wet = tbl_wet[0];
-        }else if(idx >= (tbl_length - 1)){
+        }else if(idx >= tbl_length){
           abc_avg = tbl_hyd_avg[tbl_length - 1];
           abc_amp = tbl_hyd_amp[tbl_length - 1];
           abc_wet = tbl_wet[tbl_length - 1];
         }else{
-          // interpolation
-          float_t weight_b((idx_f - idx) / delta), weight_a(1. - weight_b);
+          // interpolation between tbl[idx - 1] and tbl[idx]
+          float_t weight_b(idx_f - idx), weight_a(1. - weight_b);
           for(int i(0); i < 3; ++i){
-            abc_avg = tbl_hyd_avg[i] * weight_a + tbl_hyd_avg[i + 1] * weight_b;
-            abc_amp = tbl_hyd_amp[i] * weight_a + tbl_hyd_amp[i + 1] * weight_b;
-            abc_wet =     tbl_wet[i] * weight_a +     tbl_wet[i + 1] * weight_b;;
+            abc_avg.coef[i] = tbl_hyd_avg[idx - 1].coef[i] * weight_a + tbl_hyd_avg[idx].coef[i] * weight_b;
+            abc_amp.coef[i] = tbl_hyd_amp[idx - 1].coef[i] * weight_a + tbl_hyd_amp[idx].coef[i] * weight_b;
+            abc_wet.coef[i] =     tbl_wet[idx - 1].coef[i] * weight_a +     tbl_wet[idx].coef[i] * weight_b;
           }
         }
 
@@ -2198,9 +2598,10 @@ if(std::abs(TARGET - eph.TARGET) > raw_t::sf[raw_t::SF_ ## TARGET]){break;}
           res.hydrostatic = marini1972(sin_elv, xi)
               + ((1. / sin_elv) - marini1972(sin_elv, abc_ht)) * height_km;
         }
-        res.wet = marini1972(sin_elv, abc_wet);
+        res.wet = marini1972(sin_elv, abc_wet.coef);
         return res;
       }
+      NiellMappingFunction() {}
       NiellMappingFunction(
           const enu_t &relative_pos,
           const llh_t &usrllh,
@@ -2328,7 +2729,7 @@ const typename GPS_SpaceNode<FloatT>::float_t GPS_SpaceNode<FloatT>::SatellitePr
 #undef GPS_SC2RAD
 
 template <class FloatT>
-const typename GPS_SpaceNode<FloatT>::float_t GPS_SpaceNode<FloatT>::SatelliteProperties::Ephemeris::URA_limits[] = {
+const typename GPS_SpaceNode<FloatT>::float_t GPS_SpaceNode<FloatT>::SatelliteProperties::Ephemeris::URA_limits[16] = {
   2.40,
   3.40,
   4.85,
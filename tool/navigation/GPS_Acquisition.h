@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __GPS_ACQUISITION_H__
+#define __GPS_ACQUISITION_H__
+
+/** @file
+ * @brief Parallel code phase search (acquisition) of GPS L1 C/A signal
+ *
+ * For each Doppler bin, the received samples are wiped off the carrier and
+ * transformed by FFT once, then circularly correlated with the code replicas
+ * of all PRNs, whose FFTs are precomputed, in frequency domain.
+ * Correlation power is accumulated non-coherently over successive blocks.
+ * Pairs of Doppler bin and PRN are evenly divided into contiguous chunks
+ * for the threads of ThreadPool, therefore even a search of a single Doppler bin
+ * is parallelized across PRNs. Each thread reuses its carrier-wiped spectra
+ * while the Doppler bin is unchanged.
+ *
+ * The acquisition decision is made by the ratio of the highest peak
+ * to the second highest one apart from the highest peak by more than one chip
+ * in the same Doppler bin, and C/N0 is estimated by the ratio of the peak
+ * to the mean of the correlation power except for the peak.
+ */
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <stdexcept>
+
+#include "GPS.h"
+#include "algorithm/fft.h"
+#include "util/thread_pool.h"
+
+template <class FloatT>
+struct GPS_Acquisition_Options {
+  FloatT sampling_rate; ///< [Hz]
+  FloatT intermediate_frequency; ///< [Hz], 0 for baseband
+  FloatT doppler_max; ///< search range [Hz], from -doppler_max to +doppler_max
+  FloatT doppler_step; ///< [Hz]
+  int coherent_ms; ///< coherent integration length [ms]
+  int non_coherent; ///< number of non-coherent accumulation
+  FloatT peak_ratio_threshold; ///< threshold of the first to second peak ratio
+  unsigned int threads; ///< number of threads
+  GPS_Acquisition_Options()
+      : sampling_rate(4.092E6), intermediate_frequency(0),
+      doppler_max(5000), doppler_step(500),
+      coherent_ms(1), non_coherent(1),
+      peak_ratio_threshold(2.5),
+      threads(1) {}
+};
+
+template <class FloatT>
+class GPS_Acquisition {
+  public:
+    typedef FloatT float_t;
+    typedef std::complex<float_t> complex_t;
+    typedef GPS_Acquisition_Options<float_t> options_t;
+    typedef typename GPS_Signal<float_t>::CA_Code ca_code_t;
+    typedef typename GPS_Signal<float_t>::CA_Code_Table ca_code_table_t;
+    typedef FFT<float_t> fft_t;
+
+    struct result_t {
+      int prn;
+      bool acquired;
+      float_t code_phase; ///< code phase of the first sample [chip]
+      int code_offset; ///< sample offset to the beginning of the next code period
+      float_t doppler; ///< [Hz]
+      float_t cn0; ///< [dB-Hz]
+      float_t peak_ratio; ///< the first to second peak ratio
+    };
+
+  protected:
+    options_t options;
+    int samples_per_block;
+    std::vector<int> prns;
+    fft_t fft;
+    std::vector<std::vector<complex_t> > code_ffts; ///< conjugated FFT of replica for each PRN
+    ThreadPool *pool;
+
+    struct peak_t {
+      float_t power, second, noise;
+      int index;
+    };
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param opt search options
+     * @param prn_list PRNs to be searched; if empty, PRN 1 to 32 are searched
+     */
+    GPS_Acquisition(const options_t &opt, const std::vector<int> &prn_list = std::vector<int>())
+        : options(opt),
+        samples_per_block((int)std::floor(opt.sampling_rate * 1E-3 * opt.coherent_ms + 0.5)),
+        prns(prn_list), fft(), code_ffts(), pool(NULL) {
+      if((options.coherent_ms < 1) || (samples_per_block < 1)){
+        throw std::invalid_argument("Invalid coherent integration length");
+      }
+      if(options.non_coherent < 1){options.non_coherent = 1;}
+      if(options.doppler_step <= 0){throw std::invalid_argument("Invalid Doppler step");}
+      if(prns.empty()){
+        for(int prn(1); prn <= 32; ++prn){prns.push_back(prn);}
+      }
+      fft = fft_t(samples_per_block);
+      const ca_code_table_t &table(ca_code_table_t::get_instance());
+      code_ffts.resize(prns.size());
+      for(unsigned int i(0); i < prns.size(); ++i){
+        std::vector<complex_t> &buf(code_ffts[i]);
+        buf.resize(samples_per_block);
+        table.replica(prns[i], &buf[0], samples_per_block, options.sampling_rate);
+        fft.forward(&buf[0]);
+        for(int j(0); j < samples_per_block; ++j){buf[j] = std::conj(buf[j]);}
+      }
+      pool = new ThreadPool((options.threads > 0) ? options.threads : 1);
+    }
+
+    ~GPS_Acquisition(){
+      delete pool;
+    }
+
+  private:
+    GPS_Acquisition(const GPS_Acquisition &);
+    GPS_Acquisition &operator=(const GPS_Acquisition &);
+
+  public:
+
+    /**
+     * @return (int) number of samples required by search()
+     */
+    int required_samples() const {
+      return samples_per_block * options.non_coherent;
+    }
+
+    /**
+     * @return (int) number of Doppler bins
+     */
+    int doppler_bins() const {
+      return (int)std::floor(options.doppler_max / options.doppler_step) * 2 + 1;
+    }
+
+    float_t doppler_of_bin(const int &bin) const {
+      return options.doppler_step * (bin - (doppler_bins() - 1) / 2);
+    }
+
+  protected:
+    /**
+     * Worker dedicated to a thread, which holds an FFT instance and buffers
+     */
+    struct worker_t {
+      const GPS_Acquisition &acq;
+      fft_t fft;
+      int bin; ///< Doppler bin of wiped, or -1 when wiped is not ready
+      std::vector<std::vector<complex_t> > wiped; ///< FFT of carrier-wiped blocks
+      std::vector<complex_t> corr;
+      std::vector<float_t> power;
+      worker_t(const GPS_Acquisition &acq_)
+          : acq(acq_), fft(acq_.fft), bin(-1),
+          wiped(acq_.options.non_coherent, std::vector<complex_t>(acq_.samples_per_block)),
+          corr(acq_.samples_per_block), power(acq_.samples_per_block) {}
+
+      /**
+       * Wipe off carrier of the received samples and transform them block by block
+       * @param samples received samples
+       * @param bin_ Doppler bin index
+       */
+      void wipe_off(const complex_t *samples, const int &bin_){
+        if(bin == bin_){return;}
+        const int n(acq.samples_per_block), blocks(acq.options.non_coherent);
+        const float_t omega(-2 * M_PI
+            * (acq.options.intermediate_frequency + acq.doppler_of_bin(bin_)) / acq.options.sampling_rate);
+        for(int k(0), i(0); k < blocks; ++k){
+          complex_t *dst(&wiped[k][0]);
+          for(int j(0); j < n; ++j, ++i){
+            dst[j] = samples[i] * std::polar(float_t(1), std::fmod(omega * i, float_t(2 * M_PI)));
+          }
+          fft.forward(dst);
+        }
+        bin = bin_;
+      }
+
+      /**
+       * Search a PRN in the Doppler bin of the wiped spectra
+       * @param p index of PRN in acq.prns
+       * @param peak result
+       */
+      void search(const unsigned int &p, peak_t &peak){
+        const int n(acq.samples_per_block), blocks(acq.options.non_coherent);
+        const int exclusion((int)std::ceil(acq.options.sampling_rate / ca_code_t::FREQENCY) + 1);
+        std::fill(power.begin(), power.end(), float_t(0));
+        const complex_t *code(&acq.code_ffts[p][0]);
+        for(int k(0); k < blocks; ++k){
+          const complex_t *src(&wiped[k][0]);
+          for(int j(0); j < n; ++j){corr[j] = src[j] * code[j];}
+          fft.inverse(&corr[0]);
+          for(int j(0); j < n; ++j){power[j] += std::norm(corr[j]);}
+        }
+
+        peak.power = 0;
+        peak.index = 0;
+        float_t sum(0);
+        for(int j(0); j < n; ++j){
+          sum += power[j];
+          if(power[j] > peak.power){
+            peak.power = power[j];
+            peak.index = j;
+          }
+        }
+        peak.second = 0;
+        float_t sum_excluded(0);
+        int excluded(0);
+        for(int j(0); j < n; ++j){
+          int dist(std::abs(j - peak.index));
+          if(dist > n / 2){dist = n - dist;}
+          if(dist <= exclusion){
+            sum_excluded += power[j];
+            ++excluded;
+          }else if(power[j] > peak.second){
+            peak.second = power[j];
+          }
+        }
+        peak.noise = (excluded < n) ? ((sum - sum_excluded) / (n - excluded)) : float_t(0);
+      }
+    };
+
+    /**
+     * Task for the thread pool; the i-th chunk of (Doppler bin, PRN) pairs,
+     * which are ordered as peaks, is processed by the i-th worker.
+     */
+    struct chunks_t {
+      std::vector<worker_t> &workers;
+      const complex_t *samples;
+      peak_t *peaks;
+      unsigned int prns, n, m; ///< numbers of PRNs, pairs, and chunks
+      void operator()(const unsigned int &i) const {
+        unsigned int i_begin((unsigned long long)n * i / m),
+            i_end((unsigned long long)n * (i + 1) / m);
+        worker_t &worker(workers[i]);
+        for(unsigned int k(i_begin); k < i_end; ++k){
+          worker.wipe_off(samples, (int)(k / prns));
+          worker.search(k % prns, peaks[k]);
+        }
+      }
+    };
+
+  public:
+    /**
+     * Search all PRNs over all Doppler bins
+     *
+     * This is not reentrant, because threads are shared among calls.
+     * @param samples received samples, whose length must be at least required_samples()
+     * @return (std::vector<result_t>) results in the order of PRNs
+     */
+    std::vector<result_t> search(const complex_t *samples) const {
+      const int bins(doppler_bins());
+      std::vector<peak_t> peaks(prns.size() * bins);
+
+      std::vector<worker_t> workers(pool->size(), worker_t(*this));
+      chunks_t chunks = {workers, samples, &peaks[0],
+          (unsigned int)prns.size(), (unsigned int)peaks.size(), (unsigned int)workers.size()};
+      if(chunks.m > chunks.n){chunks.m = chunks.n;}
+      pool->run(chunks, chunks.m);
+
+      std::vector<result_t> res;
+      const float_t chips_per_sample(ca_code_t::FREQENCY / options.sampling_rate);
+      const float_t t_coherent(1E-3 * options.coherent_ms);
+      for(unsigned int p(0); p < prns.size(); ++p){
+        int bin_max(0);
+        for(int bin(1); bin < bins; ++bin){
+          if(peaks[prns.size() * bin + p].power > peaks[prns.size() * bin_max + p].power){
+            bin_max = bin;
+          }
+        }
+        const peak_t &peak(peaks[prns.size() * bin_max + p]);
+        result_t r;
+        r.prn = prns[p];
+        r.doppler = doppler_of_bin(bin_max);
+        r.code_offset = peak.index;
+        r.code_phase = std::fmod(
+            ca_code_table_t::LENGTH * options.coherent_ms - chips_per_sample * peak.index,
+            float_t(ca_code_table_t::LENGTH));
+        r.peak_ratio = (peak.second > 0) ? (peak.power / peak.second) : float_t(0);
+        r.acquired = (r.peak_ratio >= options.peak_ratio_threshold);
+        float_t snr((peak.noise > 0) ? ((peak.power - peak.noise) / peak.noise) : float_t(0));
+        r.cn0 = (snr > 0) ? (10 * std::log10(snr / t_coherent)) : float_t(0);
+        res.push_back(r);
+      }
+      return res;
+    }
+};
+
+#endif /* __GPS_ACQUISITION_H__ */
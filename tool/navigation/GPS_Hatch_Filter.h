@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __GPS_HATCH_FILTER_H__
+#define __GPS_HATCH_FILTER_H__
+
+/** @file
+ * @brief Carrier phase (or Doppler) smoothing of pseudorange, i.e., Hatch filter
+ *
+ * Pseudorange in measurement is replaced with smoothed one
+ *   rho_s(k) = rho(k) / n + (n - 1) / n * (rho_s(k-1) + delta(k)),
+ * where delta(k) is range change obtained from time difference of carrier phase,
+ * or integration of Doppler when carrier phase is unavailable.
+ * The smoothing is restarted when a cycle slip is detected by
+ * (1) Doppler-based check, which compares carrier phase difference with integrated Doppler,
+ * (2) geometry-free check, which monitors the change of L1-L2 carrier phase combination,
+ * or (3) code-carrier divergence check.
+ * The state of each satellite is constant size, therefore a measurement is processed
+ * in the order of the number of satellites.
+ */
+
+#include <map>
+#include <vector>
+#include <cmath>
+
+#include "GPS.h"
+#include "GPS_Solver_Base.h"
+
+template <class FloatT>
+struct GPS_Hatch_Filter_Options {
+  int window; ///< maximum smoothing length in epochs; less than 2 means no smoothing
+  FloatT max_gap; ///< maximum time gap [s] to continue smoothing
+  FloatT doppler_threshold; ///< threshold [m] of difference between carrier phase difference and integrated Doppler
+  FloatT geometry_free_threshold; ///< threshold [m] of change of geometry-free combination
+  FloatT code_threshold; ///< threshold [m] of difference between raw and predicted pseudorange
+  bool scale_sigma; ///< if true, pseudorange sigma is scaled by 1/sqrt(smoothing length)
+  GPS_Hatch_Filter_Options()
+      : window(100), max_gap(5),
+      doppler_threshold(0.5), geometry_free_threshold(0.05), code_threshold(30),
+      scale_sigma(true) {}
+};
+
+template <class FloatT, class SolverT = GPS_Solver_Base<FloatT> >
+class GPS_Hatch_Filter {
+  public:
+    typedef SolverT solver_t;
+    typedef typename solver_t::float_t float_t;
+    typedef typename solver_t::prn_t prn_t;
+    typedef typename solver_t::gps_time_t gps_time_t;
+    typedef typename solver_t::measurement_t measurement_t;
+    typedef typename solver_t::measurement_item_set_t measurement_item_set_t;
+    typedef typename solver_t::space_node_t space_node_t;
+    typedef GPS_Hatch_Filter_Options<float_t> options_t;
+
+    options_t options;
+
+    struct signal_t {
+      const measurement_item_set_t *items;
+      float_t wave_length; ///< [m]
+    };
+
+  protected:
+    std::vector<signal_t> signals;
+
+    struct channel_t {
+      gps_time_t t; ///< time of the last update
+      float_t range; ///< smoothed pseudorange [m]
+      float_t carrier; ///< the last carrier phase [m]
+      float_t doppler; ///< the last Doppler [Hz]
+      int length; ///< current smoothing length, zero means not initialized
+      bool has_carrier, has_doppler;
+    };
+    struct satellite_state_t {
+      std::vector<channel_t> channels;
+      gps_time_t t_gf; ///< time of the last geometry-free combination
+      float_t gf; ///< the last geometry-free combination [m]
+      bool has_gf;
+    };
+    typedef std::map<prn_t, satellite_state_t> states_t;
+    states_t states;
+
+  public:
+    struct statistics_t {
+      unsigned int smoothed; ///< number of smoothed pseudoranges
+      unsigned int slips_doppler; ///< number of slips detected by Doppler-based check
+      unsigned int slips_geometry_free; ///< number of slips detected by geometry-free check
+      unsigned int slips_code; ///< number of restart due to code-carrier divergence
+    } statistics;
+
+    GPS_Hatch_Filter(const options_t &opt = options_t())
+        : options(opt), signals(), states() {
+      statistics_t s = {0};
+      statistics = s;
+      add_signal(solver_t::L1CA, space_node_t::L1_WaveLength());
+    }
+
+    /**
+     * Add signal to be smoothed
+     * @param items indices of measurement items of the signal
+     * @param wave_length wave length [m]
+     * The first signal is used as a reference of geometry-free combination.
+     */
+    GPS_Hatch_Filter &add_signal(const measurement_item_set_t &items, const float_t &wave_length){
+      signal_t signal = {&items, wave_length};
+      signals.push_back(signal);
+      states.clear();
+      return *this;
+    }
+
+    void reset(){
+      states.clear();
+    }
+
+  protected:
+    static const float_t *find_value(
+        const typename measurement_t::mapped_type &values, const int &key, float_t &buf) {
+      typename measurement_t::mapped_type::const_iterator it(values.find(key));
+      return (it != values.end()) ? &(buf = it->second) : NULL;
+    }
+
+    /**
+     * @return (bool) true when a slip is detected by geometry-free combination
+     */
+    bool check_geometry_free(
+        const gps_time_t &t,
+        const typename measurement_t::mapped_type &values,
+        satellite_state_t &state) const {
+      float_t phi_ref, phi;
+      bool has_gf(false);
+      float_t gf;
+      if((signals.size() >= 2)
+          && find_value(values, signals[0].items->carrier_phase.i, phi_ref)){
+        for(unsigned int i(1); i < signals.size(); ++i){
+          if(!find_value(values, signals[i].items->carrier_phase.i, phi)){continue;}
+          gf = phi_ref * signals[0].wave_length - phi * signals[i].wave_length;
+          has_gf = true;
+          break;
+        }
+      }
+      bool res(has_gf && state.has_gf
+          && (std::abs(t - state.t_gf) <= options.max_gap)
+          && (std::abs(gf - state.gf) > options.geometry_free_threshold));
+      if(state.has_gf = has_gf){
+        state.t_gf = t;
+        state.gf = gf;
+      }
+      return res;
+    }
+
+  public:
+    /**
+     * Smooth pseudoranges in measurement.
+     * Measurement must be supplied in time order.
+     *
+     * @param t time of measurement
+     * @param measurement measurement, whose pseudorange and its sigma are overwritten.
+     */
+    void update(const gps_time_t &t, measurement_t &measurement){
+      if(options.window < 2){return;}
+      for(typename measurement_t::iterator it(measurement.begin()), it_end(measurement.end());
+          it != it_end; ++it){
+        satellite_state_t &state(states[it->first]);
+        if(state.channels.size() != signals.size()){
+          channel_t ch = {gps_time_t(), 0, 0, 0, 0, false, false};
+          state.channels.assign(signals.size(), ch);
+          state.has_gf = false;
+        }
+
+        bool slip_gf(check_geometry_free(t, it->second, state));
+        if(slip_gf){statistics.slips_geometry_free++;}
+
+        for(unsigned int i(0); i < signals.size(); ++i){
+          const measurement_item_set_t &items(*signals[i].items);
+          const float_t &lambda(signals[i].wave_length);
+          channel_t &ch(state.channels[i]);
+
+          float_t range, carrier, doppler;
+          if(!find_value(it->second, items.pseudorange.i, range)){
+            ch.length = 0;
+            continue;
+          }
+          bool has_carrier(find_value(it->second, items.carrier_phase.i, carrier));
+          bool has_doppler(find_value(it->second, items.doppler.i, doppler));
+          if(has_carrier){carrier *= lambda;}
+
+          float_t delta_t(t - ch.t);
+          bool continued((ch.length > 0) && (delta_t > 0) && (delta_t <= options.max_gap));
+          bool has_delta(false);
+          float_t delta;
+          if(continued){
+            if(has_doppler && ch.has_doppler){ // range change by Doppler (positive for approaching)
+              delta = -lambda * (doppler + ch.doppler) / 2 * delta_t;
+              has_delta = true;
+            }
+            if(has_carrier && ch.has_carrier){
+              float_t delta_carrier(carrier - ch.carrier);
+              if(slip_gf){
+                has_delta = false;
+              }else if(has_delta && (std::abs(delta_carrier - delta) > options.doppler_threshold)){
+                statistics.slips_doppler++;
+                has_delta = false;
+              }else{
+                delta = delta_carrier;
+                has_delta = true;
+              }
+            }
+          }
+          if(has_delta && (std::abs(range - (ch.range + delta)) > options.code_threshold)){
+            statistics.slips_code++;
+            has_delta = false;
+          }
+
+          if(has_delta){
+            if(ch.length < options.window){ch.length++;}
+            ch.range = range / ch.length + (ch.range + delta) * (ch.length - 1) / ch.length;
+            statistics.smoothed++;
+          }else{
+            ch.length = 1;
+            ch.range = range;
+          }
+          ch.t = t;
+          if(ch.has_carrier = has_carrier){ch.carrier = carrier;}
+          if(ch.has_doppler = has_doppler){ch.doppler = doppler;}
+
+          it->second[items.pseudorange.i] = ch.range;
+          typename measurement_t::mapped_type::iterator it_sigma(
+              it->second.find(items.pseudorange.i_sigma));
+          if(options.scale_sigma && (it_sigma != it->second.end())){
+            it_sigma->second /= std::sqrt(float_t(ch.length));
+          }
+        }
+      }
+    }
+};
+
+#endif /* __GPS_HATCH_FILTER_H__ */
@@ -41,13 +41,22 @@
 #include <utility>
 #include <vector>
 #include <exception>
+#include <iostream>
 
 #include <cmath>
+#include <map>
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+#define GPS_SOLVER_DELAY_CACHE_LOCK
+#include <mutex>
+#endif
 
 #include "GPS.h"
 #include "GPS_Solver_Base.h"
 #include "NTCM.h"
 
+#include "util/profile.h"
+
 template <class FloatT>
 struct GPS_Solver_GeneralOptions {
   FloatT elevation_mask;
@@ -71,8 +80,30 @@ struct GPS_Solver_GeneralOptions {
 
   FloatT f_10_7;
 
+  /**
+   * Receiver autonomous integrity monitoring (RAIM) and
+   * fault detection and exclusion (FDE)
+   */
+  typedef typename GPS_Solver_Base<FloatT>::raim_options_t raim_t;
+  raim_t raim;
+
+  /**
+   * Reuse of ionospheric and tropospheric delays per satellite.
+   * Delays are recalculated only when elevation, azimuth, user position, or time
+   * changes beyond the thresholds since the last calculation.
+   */
+  struct delay_cache_t {
+    bool enabled;
+    FloatT angle_threshold; ///< elevation and azimuth [rad]
+    FloatT position_threshold; ///< user position [m]
+    FloatT time_threshold; ///< time [s]
+    delay_cache_t()
+        : enabled(true),
+        angle_threshold(1E-4), position_threshold(10), time_threshold(30) {}
+  } delay_cache;
+
   GPS_Solver_GeneralOptions()
-      : elevation_mask(0), f_10_7(-1) {
+      : elevation_mask(0), f_10_7(-1), raim(), delay_cache() {
     for(int i(0); i < sizeof(ionospheric_models) / sizeof(ionospheric_models[0]); ++i){
       ionospheric_models[i] = IONOSPHERIC_SKIP;
     }
@@ -170,6 +201,84 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
     const space_node_t &_space_node;
     options_t _options;
 
+    struct delay_cache_item_t {
+      float_t elevation, azimuth;
+      xyz_t usr_pos;
+      gps_time_t t;
+      float_t iono, tropo;
+      int flag; ///< cached items, combination of range_error_t::MASK_IONOSPHERIC and MASK_TROPOSPHERIC
+    };
+    /**
+     * Delays for each satellite, which are reused among iterations and epochs.
+     * Items are copied in and out under a lock (with C++11),
+     * therefore an instance shared among threads is safe, although its cached values
+     * then depend on the order of calls; a solver per thread is still preferable.
+     * All items are discarded when the Klobuchar parameters of the space node are changed.
+     */
+    class delay_cache_t {
+      protected:
+        typedef std::map<const satellite_t *, delay_cache_item_t> items_t;
+        items_t items;
+        float_t klobuchar[8]; ///< alpha and beta with which the items were calculated
+#if defined(GPS_SOLVER_DELAY_CACHE_LOCK)
+        mutable std::mutex mutex;
+#define GPS_SOLVER_DELAY_CACHE_GUARD std::lock_guard<std::mutex> lock(mutex)
+#else
+#define GPS_SOLVER_DELAY_CACHE_GUARD
+#endif
+        void reset_klobuchar(){
+          for(int i(0); i < 8; ++i){klobuchar[i] = 0;}
+        }
+      public:
+        delay_cache_t() : items() {reset_klobuchar();}
+        delay_cache_t(const delay_cache_t &another) : items() {
+          GPS_SOLVER_DELAY_CACHE_GUARD;
+          items = another.items;
+          for(int i(0); i < 8; ++i){klobuchar[i] = another.klobuchar[i];}
+        }
+        void clear(){
+          GPS_SOLVER_DELAY_CACHE_GUARD;
+          items.clear();
+          reset_klobuchar();
+        }
+        /**
+         * @param sat satellite
+         * @param iono Klobuchar parameters in use
+         * @param item where a cached item is copied to
+         * @return (bool) true when found
+         */
+        bool get(const satellite_t *sat,
+            const typename space_node_t::Ionospheric_UTC_Parameters &iono,
+            delay_cache_item_t &item){
+          GPS_SOLVER_DELAY_CACHE_GUARD;
+          bool changed(false);
+          for(int i(0); i < 4; ++i){
+            if((klobuchar[i] != iono.alpha[i]) || (klobuchar[i + 4] != iono.beta[i])){
+              changed = true;
+              break;
+            }
+          }
+          if(changed){
+            items.clear();
+            for(int i(0); i < 4; ++i){
+              klobuchar[i] = iono.alpha[i];
+              klobuchar[i + 4] = iono.beta[i];
+            }
+            return false;
+          }
+          typename items_t::const_iterator it(items.find(sat));
+          if(it == items.end()){return false;}
+          item = it->second;
+          return true;
+        }
+        void set(const satellite_t *sat, const delay_cache_item_t &item){
+          GPS_SOLVER_DELAY_CACHE_GUARD;
+          items[sat] = item;
+        }
+#undef GPS_SOLVER_DELAY_CACHE_GUARD
+    };
+    mutable delay_cache_t _delay_cache;
+
   public:
     const space_node_t &space_node() const {return _space_node;}
 
@@ -209,17 +318,31 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
       return _options;
     }
 
+    const typename base_t::raim_options_t &raim_options() const {
+      return _options.raim;
+    }
+
     options_t available_options(options_t opt_wish) const {
       filter_ionospheric_models(opt_wish);
       return opt_wish;
     }
 
     const options_t &update_options(const options_t &opt_wish){
-      return _options = available_options(opt_wish);
+      options_t opt(available_options(opt_wish));
+      bool delay_model_changed(opt.f_10_7 != _options.f_10_7);
+      for(int i(0); i < sizeof(opt.ionospheric_models) / sizeof(opt.ionospheric_models[0]); ++i){
+        if(opt.ionospheric_models[i] != _options.ionospheric_models[i]){
+          delay_model_changed = true;
+          break;
+        }
+      }
+      if(delay_model_changed || (!opt.delay_cache.enabled)){_delay_cache.clear();}
+      return _options = opt;
     }
 
     GPS_SinglePositioning(const space_node_t &sn, const options_t &opt_wish = options_t())
-        : base_t(), _space_node(sn), _options(available_options(opt_wish)) {}
+        : base_t(), _space_node(sn), _options(available_options(opt_wish)),
+        _delay_cache() {}
 
     ~GPS_SinglePositioning(){}
 
@@ -231,6 +354,39 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
       float_t &weight;
     };
 
+    /**
+     * Calculate ionospheric correction with the most preferable available model
+     *
+     * @param relative_pos satellite position relative to user
+     * @param usr_llh user position in LLH
+     * @param t time
+     * @return (float_t) correction to be added to residual, zero when no model is applicable.
+     */
+    float_t ionospheric_correction(
+        const enu_t &relative_pos, const llh_t &usr_llh, const gps_time_t &t) const {
+      // Ionospheric model selection, the fall back is no correction
+      for(int i(0); i < sizeof(_options.ionospheric_models) / sizeof(_options.ionospheric_models[0]); ++i){
+        switch(_options.ionospheric_models[i]){
+          case options_t::IONOSPHERIC_KLOBUCHAR:
+            return _space_node.iono_correction(relative_pos, usr_llh, t);
+          case options_t::IONOSPHERIC_NTCM_GL: {
+            // TODO f_10_7 setup, optimization (mag_model etc.)
+            typename space_node_t::pierce_point_res_t pp(_space_node.pierce_point(relative_pos, usr_llh));
+            return -space_node_t::tec2delay(
+                _space_node.slant_factor(relative_pos)
+                * NTCM_GL_Generic<float_t>::tec_vert(
+                    pp.latitude, pp.longitude,
+                    t.year(), _options.f_10_7));
+          }
+          case options_t::IONOSPHERIC_NONE:
+            return 0;
+          default:
+            continue;
+        }
+      }
+      return 0;
+    }
+
     /**
      * Get corrected range in accordance with current status
      *
@@ -270,49 +426,62 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
       residual.los_neg_z = -(sat_pos.z() - usr_pos.xyz.z()) / geometric_range;
 
       enu_t relative_pos(enu_t::relative(sat_pos, usr_pos.xyz));
+      float_t elv(relative_pos.elevation());
+
+      delay_cache_item_t cache;
+      cache.flag = 0;
+      bool cached(_options.delay_cache.enabled
+          && (error.unknown_flag
+            & (range_error_t::MASK_IONOSPHERIC | range_error_t::MASK_TROPOSPHERIC)));
+      if(cached){
+        float_t azm(relative_pos.azimuth());
+        if(!(_delay_cache.get(&sat, _space_node.iono_utc(), cache)
+            && (std::abs(elv - cache.elevation) < _options.delay_cache.angle_threshold)
+            && (std::abs(azm - cache.azimuth) < _options.delay_cache.angle_threshold)
+            && (std::abs(time_arrival - cache.t) < _options.delay_cache.time_threshold)
+            && (cache.usr_pos.dist(usr_pos.xyz) < _options.delay_cache.position_threshold))){
+          cache.flag = 0; // not found or expired
+          cache.elevation = elv;
+          cache.azimuth = azm;
+          cache.usr_pos = usr_pos.xyz;
+          cache.t = time_arrival;
+        }
+      }
+      const int cache_flag_orig(cache.flag);
 
+      // Ionospheric
       if(error.unknown_flag & range_error_t::MASK_IONOSPHERIC){
-        // Ionospheric model selection, the fall back is no correction
-        bool iono_model_hit(false);
-        for(int i(0); i < sizeof(_options.ionospheric_models) / sizeof(_options.ionospheric_models[0]); ++i){
-          switch(_options.ionospheric_models[i]){
-            case options_t::IONOSPHERIC_KLOBUCHAR:
-              residual.residual += _space_node.iono_correction(relative_pos, usr_pos.llh, time_arrival);
-              break;
-            case options_t::IONOSPHERIC_NTCM_GL: {
-              // TODO f_10_7 setup, optimization (mag_model etc.)
-              typename space_node_t::pierce_point_res_t pp(_space_node.pierce_point(relative_pos, usr_pos.llh));
-              residual.residual -= space_node_t::tec2delay(
-                  _space_node.slant_factor(relative_pos)
-                  * NTCM_GL_Generic<float_t>::tec_vert(
-                      pp.latitude, pp.longitude,
-                      time_arrival.year(), _options.f_10_7));
-              break;
-            }
-            case options_t::IONOSPHERIC_NONE:
-              break;
-            default:
-              continue;
-          }
-          iono_model_hit = true;
-          break;
+        if(!(cache.flag & range_error_t::MASK_IONOSPHERIC)){
+          cache.iono = ionospheric_correction(relative_pos, usr_pos.llh, time_arrival);
+          cache.flag |= range_error_t::MASK_IONOSPHERIC;
         }
+        residual.residual += cache.iono;
       }else{
         residual.residual += error.value[range_error_t::IONOSPHERIC];
       }
 
       // Tropospheric
-      residual.residual += (error.unknown_flag & range_error_t::MASK_TROPOSPHERIC)
-          ? _space_node.tropo_correction(relative_pos, usr_pos.llh)
-          : error.value[range_error_t::TROPOSPHERIC];
+      if(error.unknown_flag & range_error_t::MASK_TROPOSPHERIC){
+        if(!(cache.flag & range_error_t::MASK_TROPOSPHERIC)){
+          cache.tropo = _space_node.tropo_correction(relative_pos, usr_pos.llh);
+          cache.flag |= range_error_t::MASK_TROPOSPHERIC;
+        }
+        residual.residual += cache.tropo;
+      }else{
+        residual.residual += error.value[range_error_t::TROPOSPHERIC];
+      }
+
+      if(cached && (cache.flag != cache_flag_orig)){_delay_cache.set(&sat, cache);}
 
       // Setup weight
-      if(std::abs(residual.residual) > 30.0){
-        // If residual is too big, gently exclude it by decreasing its weight.
+      if((std::abs(residual.residual) > 30.0)
+          && ((!_options.raim.enabled) || (elv < _options.elevation_mask))){
+        /* If residual is too big, gently exclude it by decreasing its weight.
+         * When RAIM is enabled, a satellite above the elevation mask retains its weight
+         * so that such a fault is detected by the test instead of being hidden.
+         */
         residual.weight = 1E-8;
       }else{
-
-        float_t elv(relative_pos.elevation());
         if(elv < _options.elevation_mask){
           residual.weight = 0; // exclude it when elevation is less than threshold
         }else{
@@ -440,6 +609,7 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
         const float_t &receiver_error_init,
         const bool &good_init = true,
         const bool &with_velocity = true) const {
+      PROFILE_SCOPE("GPS_SinglePositioning::solve_user_pvt");
 
       user_pvt_t res;
       res.receiver_time = receiver_time;
@@ -501,7 +671,7 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
           residual_t residual = {
             geomat.delta_r(j, 0),
             geomat.G(j, 0), geomat.G(j, 1), geomat.G(j, 2),
-            geomat.W(j, j)
+            geomat.W(j, 0)
           };
 
           const satellite_t *sat(it->first.second);
@@ -589,6 +759,23 @@ class GPS_SinglePositioning : public GPS_Solver_Base<FloatT> {
         return res;
       }
 
+      if(_options.raim.enabled){
+        std::vector<bool> excluded;
+        if(this->raim_fde(res, time_arrival, geomat, 4, excluded) > 0){
+          typename sat_range_t::iterator it_dst(sat_range_corrected.begin());
+          for(unsigned int i(0); i < excluded.size(); ++i){
+            const prn_t &prn(sat_range_corrected[i].first.first);
+            if(excluded[i]){
+              res.raim.excluded_satellite_mask.set(prn);
+              res.used_satellite_mask.reset(prn);
+              continue;
+            }
+            *(it_dst++) = sat_range_corrected[i];
+          }
+          sat_range_corrected.erase(it_dst, sat_range_corrected.end());
+        }
+      }
+
       try{
         res.update_DOP(geomat.partial(res.used_satellites).C());
       }catch(std::exception &e){
@@ -38,6 +38,9 @@
 #include <vector>
 #include <map>
 #include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
 
 #include <cmath>
 #include <cstring>
@@ -46,6 +49,7 @@
 
 #include "param/matrix.h"
 #include "GPS.h"
+#include "util/profile.h"
 
 template <class FloatT>
 struct GPS_Solver_Base {
@@ -68,6 +72,14 @@ struct GPS_Solver_Base {
     llh_t llh;
   };
 
+  /**
+   * Maximum number of system groups, each of which has its own receiver clock error.
+   * Clock errors of groups except for the reference one are estimated
+   * as inter-system biases (ISB) with respect to the reference.
+   */
+  static const int SYSTEM_GROUPS_MAX = 4;
+  static const int UNKNOWNS_MAX = 3 + SYSTEM_GROUPS_MAX; ///< position, clock error, and ISBs
+
   typedef std::vector<std::pair<prn_t, float_t> > prn_obs_t;
 
   static prn_obs_t difference(
@@ -224,6 +236,37 @@ struct GPS_Solver_Base {
     return *this;
   }
 
+  /**
+   * Classify a satellite into a system group having its own receiver clock error
+   * @param prn satellite number
+   * @return (int) group index ranging from 0 to (SYSTEM_GROUPS_MAX - 1),
+   * where 0 is the reference. Negative value means the satellite is not usable.
+   */
+  virtual int system_group(const prn_t &prn) const {
+    return 0;
+  }
+
+  /**
+   * Receiver autonomous integrity monitoring (RAIM) and
+   * fault detection and exclusion (FDE)
+   */
+  struct raim_options_t {
+    bool enabled;
+    float_t range_sigma; ///< standard deviation of range error whose weight is one [m]
+    float_t fa_quantile; ///< standard normal quantile of false alarm probability, 4.265 for 1E-5
+    int max_exclusions; ///< maximum number of satellites to be excluded per epoch
+    raim_options_t() : enabled(false), range_sigma(5), fa_quantile(4.265), max_exclusions(1) {}
+  };
+
+  /**
+   * RAIM/FDE options, this is provision for GNSS extension
+   * @return disabled options, however, it will be overridden by a subclass
+   */
+  virtual const raim_options_t &raim_options() const {
+    static const raim_options_t disabled;
+    return disabled;
+  }
+
   struct relative_property_t {
     float_t weight; ///< How useful this information is. only positive value activates the other values.
     float_t range_corrected; ///< corrected range just including delay, and excluding receiver/satellite error
@@ -352,15 +395,38 @@ struct GPS_Solver_Base {
     enu_t user_velocity_enu;
     float_t receiver_error_rate;
     float_t gdop, pdop, hdop, vdop, tdop;
+    /**
+     * Receiver clock error of each system group subtracted by receiver_error [m],
+     * which is zero for the reference group (the lowest group used in the solution).
+     */
+    float_t inter_system_bias[SYSTEM_GROUPS_MAX];
+    unsigned int system_groups; ///< bit pattern of system groups used in the solution
     unsigned int used_satellites;
     typedef bit_array_t<0x400> satellite_mask_t;
     satellite_mask_t used_satellite_mask; ///< bit pattern(use=1, otherwise=0), PRN 1(LSB) to 32 for GPS
+    struct raim_t {
+      enum {
+        RAIM_UNAVAILABLE = 0, ///< not performed, or redundancy is insufficient
+        RAIM_PASSED, ///< no fault is detected
+        RAIM_EXCLUDED, ///< fault(s) is detected and excluded successfully
+        RAIM_FAILED, ///< fault is detected, but it can not be excluded
+      } state;
+      float_t test_statistic; ///< WSSR normalized by variance of unit weight range error
+      float_t threshold; ///< chi-square threshold of test_statistic
+      float_t hpl, vpl; ///< horizontal and vertical protection levels [m]
+      satellite_mask_t excluded_satellite_mask;
+    } raim;
 
     user_pvt_t()
         : error_code(ERROR_UNSOLVED),
           receiver_time(),
           user_position(), receiver_error(0),
-          user_velocity_enu(), receiver_error_rate(0) {}
+          user_velocity_enu(), receiver_error_rate(0),
+          system_groups(0) {
+      for(int i(0); i < SYSTEM_GROUPS_MAX; ++i){inter_system_bias[i] = 0;}
+      raim.state = raim_t::RAIM_UNAVAILABLE;
+      raim.excluded_satellite_mask.clear();
+    }
 
     bool position_solved() const {
       switch(error_code){
@@ -378,7 +444,7 @@ struct GPS_Solver_Base {
 
     void update_DOP(const matrix_t &C){
       // Calculate DOP
-      gdop = std::sqrt(C.trace());
+      gdop = std::sqrt(C.partial(4, 4, 0, 0).trace()); // ISBs are excluded
       pdop = std::sqrt(C.partial(3, 3, 0, 0).trace());
       hdop = std::sqrt(C.partial(2, 2, 0, 0).trace());
       vdop = std::sqrt(C(2, 2));
@@ -387,25 +453,195 @@ struct GPS_Solver_Base {
   };
 
 protected:
+  /**
+   * Normal equation of linearized range (or rate) equation having four or more unknowns,
+   * i.e., three dimensional position (or velocity), receiver clock error (or its rate),
+   * and optional inter-system biases.
+   * G^{T} W G and G^{T} W delta_r are accumulated row by row without dense weight matrix,
+   * then the former is decomposed by Cholesky method as L L^{T}.
+   */
+  struct normal_equation_t {
+    int unknowns; ///< number of unknowns, which is equal to the number of columns of G
+    float_t L[UNKNOWNS_MAX][UNKNOWNS_MAX]; ///< lower triangle of G^{T} W G, which will be replaced with Cholesky factor
+    float_t b[UNKNOWNS_MAX]; ///< G^{T} W delta_r
+    float_t dr_W_dr; ///< delta_r^{T} W delta_r
+    bool decomposed;
+
+    normal_equation_t(const int &unknowns_ = 4)
+        : unknowns(unknowns_), dr_W_dr(0), decomposed(false) {
+      for(int i(0); i < unknowns; ++i){
+        for(int j(0); j <= i; ++j){L[i][j] = 0;}
+        b[i] = 0;
+      }
+    }
+
+    /**
+     * Accumulate a row of design matrix
+     * @param G_i i-th row of design matrix
+     * @param w weight of i-th row
+     * @param dr i-th residual
+     */
+    void add(const float_t *G_i, const float_t &w, const float_t &dr){
+      for(int i(0); i < unknowns; ++i){
+        float_t wG(w * G_i[i]);
+        for(int j(0); j <= i; ++j){L[i][j] += wG * G_i[j];}
+        b[i] += wG * dr;
+      }
+      dr_W_dr += w * dr * dr;
+    }
+
+    /**
+     * Remove a row from already decomposed normal equation by rank-one downdate,
+     * which is equivalent to (but much cheaper than) re-accumulation without the row.
+     * @param G_i row of design matrix to be removed
+     * @param w weight of the row
+     * @param dr residual of the row
+     * @throw std::runtime_error when the remaining rows are not enough to be solved
+     */
+    void downdate(const float_t *G_i, const float_t &w, const float_t &dr){
+      decompose();
+      float_t v[UNKNOWNS_MAX], sqrt_w(std::sqrt(w));
+      for(int i(0); i < unknowns; ++i){
+        v[i] = sqrt_w * G_i[i];
+        b[i] -= w * G_i[i] * dr;
+      }
+      dr_W_dr -= w * dr * dr;
+      for(int k(0); k < unknowns; ++k){
+        float_t r2(L[k][k] * L[k][k] - v[k] * v[k]);
+        if(!(r2 > 0)){throw std::runtime_error("not positive definite");}
+        float_t r(std::sqrt(r2)), c(r / L[k][k]), s(v[k] / L[k][k]);
+        L[k][k] = r;
+        for(int i(k + 1); i < unknowns; ++i){
+          L[i][k] = (L[i][k] - s * v[i]) / c;
+          v[i] = c * v[i] - s * L[i][k];
+        }
+      }
+    }
+
+    /**
+     * Perform Cholesky decomposition
+     * @throw std::runtime_error when G^{T} W G is not positive definite
+     */
+    normal_equation_t &decompose(){
+      if(decomposed){return *this;}
+      for(int j(0); j < unknowns; ++j){
+        float_t d(L[j][j]);
+        for(int k(0); k < j; ++k){d -= L[j][k] * L[j][k];}
+        if(!(d > 0)){throw std::runtime_error("not positive definite");}
+        L[j][j] = std::sqrt(d);
+        for(int i(j + 1); i < unknowns; ++i){
+          float_t v(L[i][j]);
+          for(int k(0); k < j; ++k){v -= L[i][k] * L[j][k];}
+          L[i][j] = v / L[j][j];
+        }
+      }
+      decomposed = true;
+      return *this;
+    }
+
+    /**
+     * Resolve x of (L L^{T}) x = y by forward and backward substitution
+     * @param x input as y, and output as x, whose length is unknowns
+     */
+    void solve(float_t *x) const {
+      for(int i(0); i < unknowns; ++i){ // L z = y
+        for(int k(0); k < i; ++k){x[i] -= L[i][k] * x[k];}
+        x[i] /= L[i][i];
+      }
+      for(int i(unknowns - 1); i >= 0; --i){ // L^{T} x = z
+        for(int k(i + 1); k < unknowns; ++k){x[i] -= L[k][i] * x[k];}
+        x[i] /= L[i][i];
+      }
+    }
+
+    /**
+     * @param x least square solution, whose length is unknowns
+     */
+    void solution(float_t *x) {
+      decompose();
+      for(int i(0); i < unknowns; ++i){x[i] = b[i];}
+      solve(x);
+    }
+
+    /**
+     * @param x least square solution
+     * @return (float_t) weighted sum of squared residuals (WSSR) after fitting
+     */
+    float_t wssr(const float_t *x) const {
+      float_t res(dr_W_dr);
+      for(int i(0); i < unknowns; ++i){res -= b[i] * x[i];}
+      return res;
+    }
+
+    /**
+     * @return (matrix_t) least square solution (unknowns x 1)
+     */
+    matrix_t solution() {
+      float_t x[UNKNOWNS_MAX];
+      solution(x);
+      matrix_t res(unknowns, 1);
+      for(int i(0); i < unknowns; ++i){res(i, 0) = x[i];}
+      return res;
+    }
+
+    /**
+     * @return (matrix_t) (G^{T} W G)^{-1} (unknowns x unknowns)
+     */
+    matrix_t C() {
+      decompose();
+      matrix_t res(unknowns, unknowns);
+      for(int j(0); j < unknowns; ++j){
+        float_t x[UNKNOWNS_MAX] = {0};
+        x[j] = 1;
+        solve(x);
+        for(int i(0); i < unknowns; ++i){res(i, j) = x[i];}
+      }
+      return res;
+    }
+  };
+
   template <class MatrixT>
   struct linear_solver_t {
     MatrixT G; ///< Design matrix
-    MatrixT W; ///< Weight (diagonal) matrix
+    MatrixT W; ///< Weight vector, which holds diagonal elements of weight matrix
     MatrixT delta_r; ///< Residual vector
     linear_solver_t(const MatrixT &G_, const MatrixT &W_, const MatrixT &delta_r_)
         : G(G_), W(W_), delta_r(delta_r_) {}
+    /**
+     * Form normal equation by accumulation
+     * @param weighted if false, all weights are regarded as one.
+     */
+    normal_equation_t normal_equation(const bool &weighted = true) const {
+      const unsigned int unknowns(G.columns());
+      normal_equation_t res(unknowns);
+      float_t G_i[UNKNOWNS_MAX];
+      for(unsigned int i(0), i_end(G.rows()); i < i_end; ++i){
+        for(unsigned int j(0); j < unknowns; ++j){G_i[j] = G(i, j);}
+        res.add(G_i, (weighted ? W(i, 0) : float_t(1)), delta_r(i, 0));
+      }
+      return res;
+    }
+    /**
+     * Unweighted (G^{T} G)^{-1} for DOP calculation.
+     * Because DOP reflects geometry only, this is decomposed separately from
+     * the weighted normal equation used for the least square solution.
+     */
     matrix_t C() const {
-      return (G.transpose() * G).inverse();
+      return normal_equation(false).C();
     }
     matrix_t least_square() const {
-      matrix_t Gt_W(G.transpose() * W);
-      return (Gt_W * G).inverse() * Gt_W * delta_r;
+      return normal_equation().solution();
     }
     typedef linear_solver_t<typename MatrixT::partial_offsetless_t> partial_t;
-    partial_t partial(unsigned int size) const {
+    /**
+     * @param size number of rows
+     * @param unknowns number of columns of design matrix; zero means all columns
+     */
+    partial_t partial(unsigned int size, unsigned int unknowns = 0) const {
       if(size >= G.rows()){size = G.rows();}
+      if((unknowns == 0) || (unknowns >= G.columns())){unknowns = G.columns();}
       return partial_t(
-          G.partial(size, 4), W.partial(size, size), delta_r.partial(size, 1));
+          G.partial(size, unknowns), W.partial(size, 1), delta_r.partial(size, 1));
     }
     typedef linear_solver_t<typename MatrixT::circular_t> exclude_t;
     exclude_t exclude(const unsigned int &row) const {
@@ -413,31 +649,206 @@ protected:
       if(size >= 1){size--;}
       // generate matrices having circular view
       return exclude_t(
-          G.circular(offset, 0, size, 4),
-          W.circular(offset, offset, size, size),
+          G.circular(offset, 0, size, G.columns()),
+          W.circular(offset, 0, size, 1),
           delta_r.circular(offset, 0, size, 1));
     }
     template <class MatrixT2>
     void copy_G_W_row(const linear_solver_t<MatrixT2> &src,
         const unsigned int &i_src, const unsigned int &i_dst){
-      for(unsigned int j(0); j < 4; ++j){
+      for(unsigned int j(0), j_end(G.columns()); j < j_end; ++j){
         G(i_dst, j) = src.G(i_src, j);
       }
-      W(i_dst, i_dst) = src.W(i_src, i_src);
+      W(i_dst, 0) = src.W(i_src, 0);
     }
   };
 
   struct geometric_matrices_t : public linear_solver_t<matrix_t> {
     typedef linear_solver_t<matrix_t> super_t;
-    geometric_matrices_t(const unsigned int &capacity)
+    geometric_matrices_t(const unsigned int &capacity, const unsigned int &unknowns = 4)
         : super_t(
-          matrix_t(capacity, 4), matrix_t(capacity, capacity), matrix_t(capacity, 1)) {
+          matrix_t(capacity, unknowns), matrix_t(capacity, 1), matrix_t(capacity, 1)) {
       for(unsigned int i(0); i < capacity; ++i){
         super_t::G(i, 3) = 1;
       }
     }
   };
 
+  /**
+   * Approximate chi-square threshold by Wilson-Hilferty transformation
+   *
+   * @param dof degree of freedom
+   * @param z standard normal quantile corresponding to false alarm probability
+   * @return (float_t) threshold
+   */
+  static float_t chi2_threshold(const unsigned int &dof, const float_t &z) {
+    float_t a(float_t(2) / (9 * dof)), b(1 - a + z * std::sqrt(a));
+    return b * b * b * dof;
+  }
+
+  /**
+   * Perform RAIM/FDE with converged least square solution.
+   * Chi-square test is applied to weighted sum of squared residuals (WSSR).
+   * When a fault is detected, WSSR of each leave-one-out subset is calculated
+   * by rank-one downdate of Cholesky factor of normal matrix instead of full re-solve,
+   * and then the satellite whose removal minimizes WSSR is excluded.
+   * A satellite which is the only one of its system group is never excluded,
+   * because its inter-system bias becomes unobservable.
+   * Protection levels are calculated with the slopes of the remaining satellites.
+   *
+   * @param res solution, whose position, receiver clock error, and inter-system biases
+   * will be corrected when exclusion is performed
+   * @param time_arrival time of arrival, which will be corrected as well as res
+   * @param geomat design matrix, weight, and residual of the solution,
+   * whose rows of excluded satellites will be removed
+   * @param unknowns number of columns of geomat used in the solution including ISB columns,
+   * which follow the reference clock column in ascending order of system group
+   * @param excluded output, whose i-th element becomes true when i-th row
+   * (before removal) of geomat is excluded
+   * @return (unsigned int) number of excluded satellites
+   */
+  unsigned int raim_fde(
+      user_pvt_t &res, gps_time_t &time_arrival,
+      geometric_matrices_t &geomat, const unsigned int &unknowns,
+      std::vector<bool> &excluded) const {
+
+    const raim_options_t &opt(raim_options());
+    res.raim.state = user_pvt_t::raim_t::RAIM_UNAVAILABLE;
+    res.raim.excluded_satellite_mask.clear();
+
+    const unsigned int n(res.used_satellites);
+    excluded.assign(n, false);
+    if(n <= unknowns){return 0;}
+
+    normal_equation_t ne(geomat.partial(n, unknowns).normal_equation());
+    float_t x_full[UNKNOWNS_MAX], x[UNKNOWNS_MAX];
+    try{
+      ne.solution(x_full);
+    }catch(std::exception &e){
+      return 0;
+    }
+    std::memcpy(x, x_full, sizeof(x));
+
+    const float_t sigma2(std::pow(opt.range_sigma, 2));
+    unsigned int dof(n - unknowns), exclusions(0);
+    res.raim.test_statistic = ne.wssr(x) / sigma2;
+    res.raim.threshold = chi2_threshold(dof, opt.fa_quantile);
+    res.raim.state = user_pvt_t::raim_t::RAIM_PASSED;
+
+    while(res.raim.test_statistic > res.raim.threshold){
+      if((exclusions >= (unsigned int)opt.max_exclusions) || (dof <= 1)){
+        res.raim.state = user_pvt_t::raim_t::RAIM_FAILED;
+        break;
+      }
+      int i_min(-1);
+      float_t T_min(0);
+      normal_equation_t ne_min;
+      for(unsigned int i(0); i < n; ++i){
+        if(excluded[i]){continue;}
+        normal_equation_t ne_i(ne);
+        float_t G_i[UNKNOWNS_MAX], x_i[UNKNOWNS_MAX];
+        for(unsigned int j(0); j < unknowns; ++j){G_i[j] = geomat.G(i, j);}
+        try{
+          ne_i.downdate(G_i, geomat.W(i, 0), geomat.delta_r(i, 0));
+          ne_i.solution(x_i);
+        }catch(std::exception &e){
+          continue; // unobservable without this satellite
+        }
+        float_t T_i(ne_i.wssr(x_i) / sigma2);
+        if((i_min >= 0) && (T_i >= T_min)){continue;}
+        i_min = (int)i;
+        T_min = T_i;
+        ne_min = ne_i;
+        std::memcpy(x, x_i, sizeof(x));
+      }
+      if(i_min < 0){
+        res.raim.state = user_pvt_t::raim_t::RAIM_FAILED;
+        break;
+      }
+      ne = ne_min;
+      excluded[i_min] = true;
+      ++exclusions;
+      res.raim.test_statistic = T_min;
+      res.raim.threshold = chi2_threshold(--dof, opt.fa_quantile);
+      res.raim.state = user_pvt_t::raim_t::RAIM_EXCLUDED;
+    }
+
+    if(exclusions > 0){
+      // Correct solution; x_full has already been applied to the solution.
+      res.user_position.xyz += xyz_t(x[0] - x_full[0], x[1] - x_full[1], x[2] - x_full[2]);
+      res.user_position.llh = res.user_position.xyz.llh();
+      const float_t delta_receiver_error(x[3] - x_full[3]);
+      res.receiver_error += delta_receiver_error;
+      time_arrival -= (delta_receiver_error / space_node_t::light_speed);
+      for(unsigned int k(0), column(3); k < SYSTEM_GROUPS_MAX; ++k){
+        if(!(res.system_groups & (1u << k))){continue;}
+        if(column > 3){ // the first group is the reference
+          res.inter_system_bias[k] += x[column] - x_full[column];
+        }
+        ++column;
+      }
+
+      // Remove excluded rows
+      unsigned int j(0);
+      for(unsigned int i(0); i < n; ++i){
+        if(excluded[i]){continue;}
+        if(i != j){
+          geomat.copy_G_W_row(geomat, i, j);
+          geomat.delta_r(j, 0) = geomat.delta_r(i, 0);
+        }
+        ++j;
+      }
+      res.used_satellites = j;
+    }
+
+    // Protection levels
+    res.raim.hpl = res.raim.vpl = 0;
+    for(unsigned int i(0); i < res.used_satellites; ++i){
+      const float_t &w(geomat.W(i, 0));
+      float_t G_i[UNKNOWNS_MAX], C_G_i[UNKNOWNS_MAX];
+      for(unsigned int j(0); j < unknowns; ++j){C_G_i[j] = G_i[j] = geomat.G(i, j);}
+      ne.solve(C_G_i);
+      // sensitivity of test statistic to the bias on i-th range
+      float_t G_C_G(0);
+      for(unsigned int j(0); j < unknowns; ++j){G_C_G += G_i[j] * C_G_i[j];}
+      float_t s(w * (1 - w * G_C_G));
+      // sensitivity of position error to the bias on i-th range
+      enu_t slope(enu_t::relative_rel(
+          xyz_t(w * C_G_i[0], w * C_G_i[1], w * C_G_i[2]), res.user_position.llh));
+      if(!(s > 1E-12 * w)){ // not monitored
+        if(std::abs(slope.east()) + std::abs(slope.north()) + std::abs(slope.up()) < 1E-6){
+          continue; // the only satellite of a system group, whose bias is absorbed in its ISB
+        }
+        res.raim.hpl = res.raim.vpl = std::numeric_limits<float_t>::infinity();
+        break;
+      }
+      s = std::sqrt(s);
+      float_t slope_h(std::sqrt(std::pow(slope.east(), 2) + std::pow(slope.north(), 2)) / s),
+          slope_v(std::abs(slope.up()) / s);
+      if(slope_h > res.raim.hpl){res.raim.hpl = slope_h;}
+      if(slope_v > res.raim.vpl){res.raim.vpl = slope_v;}
+    }
+    const float_t k(opt.range_sigma * std::sqrt(res.raim.threshold));
+    res.raim.hpl *= k;
+    res.raim.vpl *= k;
+
+    return exclusions;
+  }
+
+  /**
+   * Satellite entry of an epoch associated with its solver and system group
+   */
+  struct epoch_satellite_t {
+    prn_t prn;
+    const typename measurement_t::mapped_type *values;
+    const GPS_Solver_Base<FloatT> *solver;
+    int group;
+    bool operator<(const epoch_satellite_t &another) const {
+      return group < another.group;
+    }
+  };
+  typedef std::vector<epoch_satellite_t> epoch_satellites_t;
+
 public:
   /**
    * Calculate User position/velocity with hint
@@ -460,10 +871,27 @@ public:
       const bool &with_velocity = true) const {
 
     // Reference implementation (to be hidden by optimized one in sub class)
+    PROFILE_SCOPE("GPS_Solver_Base::solve_user_pvt");
 
     user_pvt_t res;
     res.receiver_time = receiver_time;
 
+    /* Unified satellite table of the epoch, which is sorted by system group.
+     * Solver selection and group classification are performed only once per epoch,
+     * and the rows of the same group become contiguous in the design matrix.
+     */
+    epoch_satellites_t sats;
+    sats.reserve(measurement.size());
+    for(typename measurement_t::const_iterator it(measurement.begin());
+        it != measurement.end();
+        ++it){
+      int group(system_group(it->first));
+      if((group < 0) || (group >= SYSTEM_GROUPS_MAX)){continue;}
+      epoch_satellite_t sat = {it->first, &(it->second), &select(it->first), group};
+      sats.push_back(sat);
+    }
+    std::stable_sort(sats.begin(), sats.end());
+
     // 1. Position calculation
 
     res.user_position = user_position_init;
@@ -472,10 +900,14 @@ public:
     gps_time_t time_arrival(
         receiver_time - (res.receiver_error / space_node_t::light_speed));
 
-    geometric_matrices_t geomat(measurement.size());
-    typedef std::vector<std::pair<prn_t, float_t> > sat_range_t;
+    geometric_matrices_t geomat(sats.size(), UNKNOWNS_MAX);
+    typedef std::vector<std::pair<const epoch_satellite_t *, float_t> > sat_range_t;
     sat_range_t sat_rate_rel;
-    sat_rate_rel.reserve(measurement.size());
+    sat_rate_rel.reserve(sats.size());
+
+    float_t (&isb)[SYSTEM_GROUPS_MAX](res.inter_system_bias);
+    int group_ref(-1);
+    unsigned int unknowns(4);
 
     // If initialization is not appropriate, more iteration will be performed.
     bool converged(false);
@@ -484,47 +916,67 @@ public:
       sat_rate_rel.clear();
       unsigned int j(0);
       res.used_satellite_mask.clear();
+      res.system_groups = 0;
+      group_ref = -1;
+      unknowns = 3;
+      int column_of_group[SYSTEM_GROUPS_MAX];
 
       const bool coarse_estimation(i <= 0);
-      for(typename measurement_t::const_iterator it(measurement.begin());
-          it != measurement.end();
-          ++it){
+      for(typename epoch_satellites_t::const_iterator it(sats.begin()); it != sats.end(); ){
+
+        const int group(it->group);
+        const float_t receiver_error_group(res.receiver_error + isb[group]);
+        const unsigned int j_group(j);
+
+        for(; (it != sats.end()) && (it->group == group); ++it){
+          static const xyz_t zero(0, 0, 0);
+          relative_property_t prop(it->solver->relative_property(
+              it->prn, *(it->values),
+              receiver_error_group, time_arrival,
+              res.user_position, zero));
+
+          if(prop.weight <= 0){
+            continue; // intentionally excluded satellite
+          }else{
+            res.used_satellite_mask.set(it->prn);
+          }
 
-        static const xyz_t zero(0, 0, 0);
-        relative_property_t prop(select(it->first).relative_property(
-            it->first, it->second,
-            res.receiver_error, time_arrival,
-            res.user_position, zero));
+          if(coarse_estimation){
+            prop.weight = 1;
+          }else{
+            sat_rate_rel.push_back(std::make_pair(&(*it), prop.rate_relative_neg));
+          }
 
-        if(prop.weight <= 0){
-          continue; // intentionally excluded satellite
-        }else{
-          res.used_satellite_mask.set(it->first);
-        }
+          geomat.delta_r(j, 0) = prop.range_residual;
+          geomat.G(j, 0) = prop.los_neg[0];
+          geomat.G(j, 1) = prop.los_neg[1];
+          geomat.G(j, 2) = prop.los_neg[2];
+          geomat.W(j, 0) = prop.weight;
 
-        if(coarse_estimation){
-          prop.weight = 1;
-        }else{
-          sat_rate_rel.push_back(std::make_pair(it->first, prop.rate_relative_neg));
+          ++j;
         }
 
-        geomat.delta_r(j, 0) = prop.range_residual;
-        geomat.G(j, 0) = prop.los_neg[0];
-        geomat.G(j, 1) = prop.los_neg[1];
-        geomat.G(j, 2) = prop.los_neg[2];
-        geomat.W(j, j) = prop.weight;
+        if(j == j_group){continue;} // no satellite of the group is available
 
-        ++j;
+        // The first available group becomes the reference, and the others have ISB columns.
+        res.system_groups |= (1u << group);
+        if(group_ref < 0){group_ref = group;}
+        column_of_group[group] = unknowns++;
+        for(unsigned int k(j_group); k < j; ++k){
+          geomat.G(k, 3) = 1;
+          for(int k2(4); k2 < UNKNOWNS_MAX; ++k2){geomat.G(k, k2) = 0;}
+          if(group != group_ref){geomat.G(k, column_of_group[group]) = 1;}
+        }
       }
 
-      if((res.used_satellites = j) < 4){
+      if((res.used_satellites = j) < (unknowns > 4 ? unknowns : 4)){
         res.error_code = user_pvt_t::ERROR_INSUFFICIENT_SATELLITES;
         return res;
       }
 
       try{
         // Least square
-        matrix_t delta_x(geomat.partial(res.used_satellites).least_square());
+        matrix_t delta_x(geomat.partial(res.used_satellites, unknowns).least_square());
 
         xyz_t delta_user_position(delta_x.partial(3, 1, 0, 0));
         res.user_position.xyz += delta_user_position;
@@ -534,6 +986,11 @@ public:
         res.receiver_error += delta_receiver_error;
         time_arrival -= (delta_receiver_error / space_node_t::light_speed);
 
+        for(int k(0); k < SYSTEM_GROUPS_MAX; ++k){
+          if((k == group_ref) || !(res.system_groups & (1u << k))){continue;}
+          isb[k] += delta_x(column_of_group[k], 0);
+        }
+
         if((!coarse_estimation) && (delta_user_position.dist() <= 1E-6)){
           converged = true;
           break;
@@ -549,8 +1006,32 @@ public:
       return res;
     }
 
+    if(raim_options().enabled){
+      std::vector<bool> excluded;
+      if(raim_fde(res, time_arrival, geomat, unknowns, excluded) > 0){
+        typename sat_range_t::iterator it_dst(sat_rate_rel.begin());
+        for(unsigned int k(0); k < excluded.size(); ++k){
+          const prn_t &prn(sat_rate_rel[k].first->prn);
+          if(excluded[k]){
+            res.raim.excluded_satellite_mask.set(prn);
+            res.used_satellite_mask.reset(prn);
+            continue;
+          }
+          *(it_dst++) = sat_rate_rel[k];
+        }
+        sat_rate_rel.erase(it_dst, sat_rate_rel.end());
+      }
+    }
+
+    if(isb[group_ref] != 0){ // receiver_error is aligned to the reference group
+      res.receiver_error += isb[group_ref];
+      for(int k(SYSTEM_GROUPS_MAX - 1); k >= 0; --k){ // descending; isb[group_ref] is cleared last
+        isb[k] = (res.system_groups & (1u << k)) ? (isb[k] - isb[group_ref]) : 0;
+      }
+    }
+
     try{
-      res.update_DOP(geomat.partial(res.used_satellites).C());
+      res.update_DOP(geomat.partial(res.used_satellites, unknowns).C());
     }catch(std::exception &e){
       res.error_code = user_pvt_t::ERROR_DOP;
       return res;
@@ -563,7 +1044,8 @@ public:
 
     /* 2. Calculate velocity
      * Check consistency between range and rate for velocity calculation,
-     * then, assign design and weight matrices
+     * then, assign design and weight matrices.
+     * Receiver clock error rate is common to all the system groups.
      */
     geometric_matrices_t geomat2(res.used_satellites);
     int i_range(0), i_rate(0);
@@ -573,9 +1055,7 @@ public:
         ++it, ++i_range){
 
       float_t rate;
-      if(!select(it->first).rate(
-          measurement.find(it->first)->second, // const version of measurement[PRN]
-          rate)){continue;}
+      if(!(it->first->solver->rate(*(it->first->values), rate))){continue;}
 
       // Copy design matrix and set rate
       geomat2.copy_G_W_row(geomat, i_range, i_rate);
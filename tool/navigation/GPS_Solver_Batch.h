@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __GPS_SOLVER_BATCH_H__
+#define __GPS_SOLVER_BATCH_H__
+
+/** @file
+ * @brief Batch PVT calculation over recorded observation (RINEX OBS)
+ *
+ * Epochs are solved independently of each other, therefore a batch of epochs
+ * is divided into contiguous chunks, each of which is handled by a worker
+ * having its own copy of space node (ephemeris selection is a mutable state)
+ * and solver. A worker reuses its latest solution as an initial guess,
+ * and the results are returned in the order of input.
+ * Workers and their threads are kept over batches, and discarded by reset().
+ */
+
+#include <vector>
+#include <exception>
+
+#if defined(GPS_SOLVER_BATCH_WITHOUT_THREAD) && !defined(THREAD_POOL_WITHOUT_THREAD)
+#define THREAD_POOL_WITHOUT_THREAD
+#endif
+#include "util/thread_pool.h"
+
+#include "GPS.h"
+#include "GPS_Solver.h"
+#include "GPS_Hatch_Filter.h"
+#include "RINEX.h"
+
+template <class FloatT, class SolverT = GPS_SinglePositioning<FloatT> >
+struct GPS_Solver_Batch {
+  typedef SolverT solver_t;
+  typedef typename solver_t::space_node_t space_node_t;
+  typedef typename solver_t::options_t options_t;
+  typedef typename solver_t::gps_time_t gps_time_t;
+  typedef typename solver_t::measurement_t measurement_t;
+  typedef typename solver_t::user_pvt_t user_pvt_t;
+  typedef RINEX_OBS_Reader<FloatT> reader_t;
+  typedef typename reader_t::ObservedItem observed_item_t;
+  typedef GPS_Hatch_Filter<FloatT, solver_t> smoother_t;
+
+  struct epoch_t {
+    gps_time_t t;
+    measurement_t measurement;
+  };
+
+  /**
+   * Correspondence between RINEX observation type and measurement item.
+   * The first available type is adopted for each item;
+   * for example, P1 is used as L1 pseudorange only when C1 is not observed.
+   */
+  struct observation_rule_t {
+    const char *label; ///< RINEX observation type such as "C1"
+    int item; ///< index of measurement_items_t
+    int index; ///< resolved column index in the observation file, or -1
+  };
+  std::vector<observation_rule_t> rules;
+
+  const space_node_t &space_node;
+  options_t options;
+  unsigned int threads; ///< number of workers
+  unsigned int batch_size; ///< number of epochs processed at once
+  FloatT warm_start_limit; ///< maximum time gap [s] for which a previous solution is used as initial guess
+  smoother_t *smoother; ///< optional pseudorange smoother, which is sequentially applied while reading
+
+  GPS_Solver_Batch(const space_node_t &sn, const options_t &opt = options_t())
+      : rules(), space_node(sn), options(opt),
+      threads(1), batch_size(0x1000), warm_start_limit(60), smoother(NULL),
+      workers(), pool(NULL) {
+    typedef typename solver_t::measurement_items_t items_t;
+    add_rule("C1", items_t::L1_PSEUDORANGE);
+    add_rule("P1", items_t::L1_PSEUDORANGE);
+    add_rule("L1", items_t::L1_CARRIER_PHASE);
+    add_rule("D1", items_t::L1_DOPPLER);
+  }
+
+  GPS_Solver_Batch &add_rule(const char *label, const int &item){
+    observation_rule_t rule = {label, item, -1};
+    rules.push_back(rule);
+    return *this;
+  }
+
+  /**
+   * Resolve column indices of observation types
+   * @param reader reader of RINEX observation file
+   * @return (int) number of observation types used
+   */
+  int resolve(const reader_t &reader){
+    int res(0);
+    for(typename std::vector<observation_rule_t>::iterator it(rules.begin());
+        it != rules.end(); ++it){
+      if((it->index = reader.observed_index(it->label)) >= 0){++res;}
+    }
+    return res;
+  }
+
+  /**
+   * Convert RINEX observation into measurement for solver.
+   * Only GPS satellites are extracted, and zero (blank) values are skipped.
+   * @param src observation of an epoch
+   * @param dst converted epoch
+   */
+  void convert(const observed_item_t &src, epoch_t &dst) const {
+    dst.t = src.t_epoc;
+    dst.measurement.clear();
+    for(typename observed_item_t::sat_data_t::const_iterator
+          it(src.sat_data.begin()), it_end(src.sat_data.end());
+        it != it_end; ++it){
+      if((it->first < 1) || (it->first > 32)){continue;}
+      typename measurement_t::mapped_type *values(NULL);
+      for(typename std::vector<observation_rule_t>::const_iterator
+            it2(rules.begin()), it2_end(rules.end());
+          it2 != it2_end; ++it2){
+        if((it2->index < 0) || (it2->index >= (int)it->second.size())){continue;}
+        const FloatT &v(it->second[it2->index].observed);
+        if(v == 0){continue;}
+        if(!values){values = &(dst.measurement[it->first]);}
+        values->insert(std::make_pair(it2->item, v)); // keep the preceding rule
+      }
+    }
+  }
+
+  struct worker_t {
+    space_node_t space_node;
+    solver_t solver;
+    user_pvt_t latest;
+    const FloatT &warm_start_limit;
+    unsigned int warm_starts; ///< number of epochs solved with the previous solution as initial guess
+    worker_t(const GPS_Solver_Batch &batch)
+        : space_node(batch.space_node),
+        solver(space_node),
+        latest(),
+        warm_start_limit(batch.warm_start_limit),
+        warm_starts(0) {
+      solver.update_options(batch.options);
+    }
+    void operator()(const epoch_t *epoch, const epoch_t *epoch_end, user_pvt_t *res){
+      for(; epoch != epoch_end; ++epoch, ++res){
+        space_node.update_all_ephemeris(epoch->t);
+        bool warm(latest.position_solved()
+            && (std::abs(epoch->t - latest.receiver_time) <= warm_start_limit));
+        if(warm){++warm_starts;}
+        try{
+          *res = solver.solve_user_pvt(
+              epoch->measurement, epoch->t,
+              warm ? latest.user_position : typename solver_t::pos_t(),
+              warm ? latest.receiver_error : FloatT(0),
+              warm);
+        }catch(std::exception &e){
+          *res = user_pvt_t();
+          res->receiver_time = epoch->t;
+        }
+        if(res->position_solved()){latest = *res;}
+      }
+    }
+  };
+
+  protected:
+    std::vector<worker_t *> workers;
+    ThreadPool *pool;
+
+    /**
+     * Task for the thread pool; the i-th chunk is processed by the i-th worker.
+     */
+    struct chunks_t {
+      std::vector<worker_t *> &workers;
+      const epoch_t *src;
+      user_pvt_t *dst;
+      unsigned int n, m; ///< numbers of epochs and chunks
+      void operator()(const unsigned int &i) const {
+        unsigned int i_begin((unsigned long long)n * i / m),
+            i_end((unsigned long long)n * (i + 1) / m);
+        (*workers[i])(&src[i_begin], &src[i_end], &dst[i_begin]);
+      }
+    };
+
+  private:
+    GPS_Solver_Batch(const GPS_Solver_Batch &);
+    GPS_Solver_Batch &operator=(const GPS_Solver_Batch &);
+
+  public:
+  ~GPS_Solver_Batch(){
+    reset();
+  }
+
+  /**
+   * Discard workers and threads. They are created again at the next solve()
+   * with the current space node, options and number of threads.
+   * This should be called when they are changed after the first solve().
+   */
+  void reset(){
+    for(unsigned int i(0); i < workers.size(); ++i){delete workers[i];}
+    workers.clear();
+    delete pool;
+    pool = NULL;
+  }
+
+  /**
+   * @return (unsigned int) total number of warm starts since the last reset()
+   */
+  unsigned int warm_starts() const {
+    unsigned int res(0);
+    for(unsigned int i(0); i < workers.size(); ++i){res += workers[i]->warm_starts;}
+    return res;
+  }
+
+  /**
+   * Solve epochs; epochs are evenly divided into contiguous chunks for workers.
+   * @param epochs epochs to be solved, which are assumed to be in time order
+   * @param res results, whose order is identical to that of epochs
+   */
+  void solve(const std::vector<epoch_t> &epochs, std::vector<user_pvt_t> &res){
+    if(workers.empty()){
+      unsigned int workers_num(threads);
+      if(workers_num < 1){workers_num = 1;}
+      pool = new ThreadPool(workers_num);
+      if(workers_num > pool->size()){workers_num = pool->size();}
+      for(unsigned int i(0); i < workers_num; ++i){
+        workers.push_back(new worker_t(*this));
+      }
+    }
+    res.resize(epochs.size());
+    if(epochs.empty()){return;}
+    chunks_t chunks = {workers, &epochs[0], &res[0], (unsigned int)epochs.size(), (unsigned int)workers.size()};
+    if(chunks.m > chunks.n){chunks.m = chunks.n;}
+    pool->run(chunks, chunks.m);
+  }
+
+  /**
+   * Solve all epochs in observation file
+   * @param reader reader of RINEX observation file
+   * @param functor called with (const epoch_t &, const user_pvt_t &) for each epoch in order
+   * @return (int) number of processed epochs
+   */
+  template <class Functor>
+  int run(reader_t &reader, Functor &functor){
+    resolve(reader);
+
+    int processed(0);
+    std::vector<epoch_t> epochs;
+    std::vector<user_pvt_t> res;
+    while(reader.has_next()){
+      epochs.clear();
+      while(reader.has_next() && (epochs.size() < batch_size)){
+        observed_item_t item(reader.next());
+        if(item.event_flag >= 2){continue;} // not observation
+        epochs.push_back(epoch_t());
+        convert(item, epochs.back());
+        if(smoother){smoother->update(epochs.back().t, epochs.back().measurement);}
+      }
+      solve(epochs, res);
+      for(unsigned int i(0); i < epochs.size(); ++i){
+        functor(epochs[i], res[i]);
+      }
+      processed += epochs.size();
+    }
+    return processed;
+  }
+
+  /**
+   * Hardware concurrency hint
+   * @return (unsigned int) number of available cores, or 1 when unknown
+   */
+  static unsigned int concurrency(){
+    return ThreadPool::concurrency();
+  }
+};
+
+#endif /* __GPS_SOLVER_BATCH_H__ */
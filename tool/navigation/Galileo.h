@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __GALILEO_H__
+#define __GALILEO_H__
+
+/** @file
+ * @brief Galileo space segment, mainly for its broadcasted ephemeris
+ *
+ * Galileo ephemeris has the same Keplerian parameters as GPS LNAV ephemeris,
+ * and its orbit differs only in the gravitational constant of the Earth.
+ * Because the difference is equivalent to an offset of mean motion,
+ * a Galileo ephemeris is converted to the GPS form with the adjusted mean motion difference,
+ * and then processed by the same routines as GPS.
+ * The remaining difference in the relativistic clock correction is
+ * less than 1E-14 seconds, which is negligible.
+ *
+ * @see Galileo OS SIS ICD Issue 1.3, 5.1 Navigation algorithms
+ */
+
+#include <cmath>
+
+#include "GPS.h"
+
+template <class FloatT = double>
+class Galileo_SpaceNode : public GPS_SpaceNode<FloatT> {
+  public:
+    typedef Galileo_SpaceNode<FloatT> self_t;
+    typedef GPS_SpaceNode<FloatT> super_t;
+    typedef FloatT float_t;
+    typedef typename super_t::gps_time_t gps_time_t;
+    typedef typename super_t::Satellite::Ephemeris gps_ephemeris_t;
+
+    static const float_t mu_Earth; ///< Earth gravitational constant [m^3/s^2]
+    static const float_t Omega_Earth; ///< Earth rotation rate [rad/s], identical to GPS
+    static const float_t E1_Frequency; ///< identical to GPS L1
+    static const float_t E5a_Frequency;
+    static const float_t E5b_Frequency;
+
+    struct SatelliteProperties {
+      /**
+       * Ephemeris of I/NAV or F/NAV message.
+       * Week number is continuous and aligned with GPS week as RINEX 3.
+       */
+      struct Ephemeris {
+        unsigned int svid;    ///< Satellite number (1-36)
+        unsigned int WN;      ///< Week number aligned with GPS week
+        int iodnav;           ///< Issue of data (navigation)
+        float_t SISA;         ///< Signal in space accuracy [m]; negative means no accuracy prediction
+        unsigned int health;  ///< Signal health and data validity status; zero means healthy
+        unsigned int data_source; ///< bit 0: I/NAV E1-B, bit 1: F/NAV E5a-I, bit 2: I/NAV E5b-I
+
+        float_t BGD_E1E5a;    ///< Broadcast group delay E1-E5a (s)
+        float_t BGD_E1E5b;    ///< Broadcast group delay E1-E5b (s)
+        float_t t_oc;         ///< Clock data reference time
+        float_t a_f0;         ///< Clock correction parameter (s)
+        float_t a_f1;         ///< Clock correction parameter (s/s)
+        float_t a_f2;         ///< Clock correction parameter (s/s^2)
+
+        float_t t_oe;         ///< Reference time ephemeris (s)
+        float_t sqrt_A;       ///< Square root of semi-major axis (sqrt(m))
+        float_t e;            ///< Eccentricity
+        float_t M0;           ///< Mean anomaly (rad)
+        float_t delta_n;      ///< Mean motion difference (rad/s)
+        float_t omega;        ///< Argument of perigee (rad)
+        float_t Omega0;       ///< Longitude of ascending node (rad)
+        float_t dot_Omega0;   ///< Rate of right ascension (rad/s)
+        float_t i0;           ///< Inclination angle (rad)
+        float_t dot_i0;       ///< Rate of inclination angle (rad/s)
+        float_t c_uc;         ///< Cosine correction, latitude (rad)
+        float_t c_us;         ///< Sine correction, latitude (rad)
+        float_t c_rc;         ///< Cosine correction, orbit (m)
+        float_t c_rs;         ///< Sine correction, orbit (m)
+        float_t c_ic;         ///< Cosine correction, inclination (rad)
+        float_t c_is;         ///< Sine correction, inclination (rad)
+
+        /**
+         * Convert to ephemeris of GPS form.
+         * Group delay is selected for E1 single frequency user in accordance with data source,
+         * and the validity period is 4 hours centered at t_oc (OS SIS ICD 5.1.9.1).
+         *
+         * @param svid_new satellite number of the converted one, which is used as key
+         * of the space node. If zero, the original satellite number is used.
+         */
+        gps_ephemeris_t to_GPS(const unsigned int &svid_new = 0) const {
+          gps_ephemeris_t res = gps_ephemeris_t();
+          res.svid = (svid_new > 0) ? svid_new : svid;
+          res.WN = WN;
+          res.URA = (SISA < 0)
+              ? gps_ephemeris_t::URA_MAX_INDEX
+              : gps_ephemeris_t::URA_index(SISA);
+          res.SV_health = (health != 0) ? 1 : 0;
+          res.iodc = res.iode = iodnav;
+          res.t_GD = (data_source & 0x02) ? BGD_E1E5a : BGD_E1E5b; // F/NAV or I/NAV
+          res.t_oc = t_oc;
+          res.a_f0 = a_f0;
+          res.a_f1 = a_f1;
+          res.a_f2 = a_f2;
+
+          res.t_oe = t_oe;
+          res.sqrt_A = sqrt_A;
+          res.e = e;
+          res.M0 = M0;
+          // n0 is calculated with the GPS constant, and the difference is compensated.
+          res.delta_n = delta_n
+              + (std::sqrt(mu_Earth) - std::sqrt(WGS84::mu_Earth)) / std::pow(sqrt_A, 3);
+          res.omega = omega;
+          res.Omega0 = Omega0;
+          res.dot_Omega0 = dot_Omega0;
+          res.i0 = i0;
+          res.dot_i0 = dot_i0;
+          res.c_uc = c_uc;
+          res.c_us = c_us;
+          res.c_rc = c_rc;
+          res.c_rs = c_rs;
+          res.c_ic = c_ic;
+          res.c_is = c_is;
+          res.fit_interval = 4 * 60 * 60;
+          return res;
+        }
+      };
+    };
+    typedef typename SatelliteProperties::Ephemeris ephemeris_t;
+
+    /**
+     * Register Galileo ephemeris
+     *
+     * @param eph ephemeris
+     * @param key satellite number used as key of the space node, which is normally
+     * a unique serial among multiple constellations. If zero, svid is used.
+     */
+    void register_ephemeris(const ephemeris_t &eph, const int &key = 0){
+      const int key_new(key > 0 ? key : (int)eph.svid);
+      super_t::satellite(key_new).register_ephemeris(eph.to_GPS(key_new));
+    }
+};
+
+template <class FloatT>
+const typename Galileo_SpaceNode<FloatT>::float_t Galileo_SpaceNode<FloatT>::mu_Earth = 3.986004418E14;
+
+template <class FloatT>
+const typename Galileo_SpaceNode<FloatT>::float_t Galileo_SpaceNode<FloatT>::Omega_Earth = 7.2921151467E-5;
+
+template <class FloatT>
+const typename Galileo_SpaceNode<FloatT>::float_t Galileo_SpaceNode<FloatT>::E1_Frequency = 1575.42E6;
+
+template <class FloatT>
+const typename Galileo_SpaceNode<FloatT>::float_t Galileo_SpaceNode<FloatT>::E5a_Frequency = 1176.45E6;
+
+template <class FloatT>
+const typename Galileo_SpaceNode<FloatT>::float_t Galileo_SpaceNode<FloatT>::E5b_Frequency = 1207.14E6;
+
+#endif /* __GALILEO_H__ */
@@ -354,6 +354,20 @@ class INS {
      */
     virtual ~INS(){}
     
+    /**
+     * Save or restore states, including derived ones, for checkpoint
+     * 
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     * @see util/checkpoint.h
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      ar & v_2e_4n & v_N & v_E
+          & q_e2n & h & phi & lambda & alpha
+          & q_n2b
+          & omega_e2i_4e & omega_e2i_4n & omega_n2e_4n;
+    }
+    
     /**
      * ԗʂ֒ڃANZXB
      * CfbNXw肵ČĂяo܂B
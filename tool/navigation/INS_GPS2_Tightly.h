@@ -21,6 +21,8 @@
 
 #include <cmath>
 #include <iostream>
+#include <map>
+#include <vector>
 
 #include "INS.h"
 #include "Filtered_INS2.h"
@@ -28,19 +30,31 @@
 #include "GPS_Solver_Base.h"
 #include "coordinate.h"
 
-template <typename BaseINS, unsigned int Clocks>
+template <typename BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
 class INS_ClockErrorEstimated;
 
-template <class BaseINS, unsigned int Clocks>
-struct INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks> > {
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+struct INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> > {
   static const unsigned CLOCKS_SUPPORTED = Clocks;
+  static const unsigned INTER_SYSTEM_BIASES = InterSystemBiases;
   static const unsigned STATE_VALUES_WITHOUT_CLOCK_ERROR = INS_Property<BaseINS>::STATE_VALUES;
-  static const unsigned STATE_VALUES_CLOCK_ERROR = 2 * CLOCKS_SUPPORTED;
+  static const unsigned STATE_VALUES_CLOCK_ERROR = 2 * CLOCKS_SUPPORTED + INTER_SYSTEM_BIASES;
   static const unsigned STATE_VALUES = STATE_VALUES_WITHOUT_CLOCK_ERROR + STATE_VALUES_CLOCK_ERROR;
 };
 
+/**
+ * @brief INS with receiver clock error
+ *
+ * Receiver clock errors and their rates are appended to the state.
+ * In addition, inter-system biases (ISB), each of which is a constant offset of
+ * a GNSS system group other than the reference one, can be appended.
+ * They are placed after clock errors, and shared among all clocks.
+ *
+ * @param Clocks number of receiver clocks
+ * @param InterSystemBiases number of ISBs, which is (number of system groups - 1)
+ */
 template <
-    typename BaseINS = INS<>, unsigned int Clocks = 1>
+    typename BaseINS = INS<>, unsigned int Clocks = 1, unsigned int InterSystemBiases = 0>
 class INS_ClockErrorEstimated : public BaseINS {
   public:
 #if defined(__GNUC__) && (__GNUC__ < 5)
@@ -52,19 +66,18 @@ class INS_ClockErrorEstimated : public BaseINS {
 #endif
 
   public:
-    static const unsigned CLOCKS_SUPPORTED
-        = INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::CLOCKS_SUPPORTED;
-    static const unsigned STATE_VALUES_WITHOUT_CLOCK_ERROR
-        = INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::STATE_VALUES_WITHOUT_CLOCK_ERROR;
-    static const unsigned STATE_VALUES_CLOCK_ERROR
-        = INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::STATE_VALUES_CLOCK_ERROR;
-    static const unsigned STATE_VALUES
-        = INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::STATE_VALUES; ///< Number of state values
+    typedef INS_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> > property_t;
+    static const unsigned CLOCKS_SUPPORTED = property_t::CLOCKS_SUPPORTED;
+    static const unsigned INTER_SYSTEM_BIASES = property_t::INTER_SYSTEM_BIASES;
+    static const unsigned STATE_VALUES_WITHOUT_CLOCK_ERROR = property_t::STATE_VALUES_WITHOUT_CLOCK_ERROR;
+    static const unsigned STATE_VALUES_CLOCK_ERROR = property_t::STATE_VALUES_CLOCK_ERROR;
+    static const unsigned STATE_VALUES = property_t::STATE_VALUES; ///< Number of state values
     virtual unsigned state_values() const {return STATE_VALUES;}
 
   protected:
     float_t m_clock_error[CLOCKS_SUPPORTED];  ///< receiver clock error [m]
     float_t m_clock_error_rate[CLOCKS_SUPPORTED];  ///< receiver clock error rate [m/s]
+    float_t m_inter_system_bias[InterSystemBiases > 0 ? InterSystemBiases : 1]; ///< ISB [m]
 
   public:
     INS_ClockErrorEstimated()
@@ -73,6 +86,9 @@ class INS_ClockErrorEstimated : public BaseINS {
         m_clock_error[i] = 0;
         m_clock_error_rate[i] = 0;
       }
+      for(unsigned int i(0); i < INTER_SYSTEM_BIASES; ++i){
+        m_inter_system_bias[i] = 0;
+      }
     }
 
     INS_ClockErrorEstimated(const INS_ClockErrorEstimated &orig, const bool &deepcopy = false)
@@ -81,20 +97,46 @@ class INS_ClockErrorEstimated : public BaseINS {
         m_clock_error[i] = orig.m_clock_error[i];
         m_clock_error_rate[i] = orig.m_clock_error_rate[i];
       }
+      for(unsigned int i(0); i < INTER_SYSTEM_BIASES; ++i){
+        m_inter_system_bias[i] = orig.m_inter_system_bias[i];
+      }
     }
 
     virtual ~INS_ClockErrorEstimated(){}
 
+    /**
+     * Save or restore states including clock errors for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      BaseINS::checkpoint(ar);
+      for(unsigned int i(0); i < CLOCKS_SUPPORTED; ++i){
+        ar & m_clock_error[i] & m_clock_error_rate[i];
+      }
+      for(unsigned int i(0); i < INTER_SYSTEM_BIASES; ++i){
+        ar & m_inter_system_bias[i];
+      }
+    }
+
     float_t &clock_error(const unsigned int &index = 0){return m_clock_error[index];}
     float_t &clock_error_rate(const unsigned int &index = 0){return m_clock_error_rate[index];}
+    /**
+     * @param index ISB index, which corresponds to system group (index + 1)
+     */
+    float_t &inter_system_bias(const unsigned int &index = 0){return m_inter_system_bias[index];}
 
     using BaseINS::operator[];
 
     const float_t &operator[](const unsigned &index) const {
       int index_offset(index - STATE_VALUES_WITHOUT_CLOCK_ERROR);
-      if((index_offset >= 0) && (index_offset < STATE_VALUES_CLOCK_ERROR)){
+      if((index_offset >= 0) && (index_offset < (int)(CLOCKS_SUPPORTED * 2))){
         int index_clock(index_offset >> 1);
         return (index_offset % 2 == 0) ? m_clock_error[index_clock] : m_clock_error_rate[index_clock];
+      }else if((index_offset >= (int)(CLOCKS_SUPPORTED * 2))
+          && (index_offset < (int)STATE_VALUES_CLOCK_ERROR)){
+        return m_inter_system_bias[index_offset - CLOCKS_SUPPORTED * 2];
       }
       return BaseINS::operator[](index);
     }
@@ -105,12 +147,12 @@ class INS_ClockErrorEstimated : public BaseINS {
       for(unsigned int i(0); i < CLOCKS_SUPPORTED; ++i){
         m_clock_error[i] += m_clock_error_rate[i] * deltaT;
       }
-      BaseINS::update(accel, gyro, deltaT);
+      BaseINS::update(accel, gyro, deltaT); // ISBs are constant
     }
 };
 
-template <class BaseINS, unsigned int Clocks>
-class Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+class Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >
     : public Filtered_INS2_Property<BaseINS> {
   public:
     static const unsigned P_SIZE_WITHOUT_CLOCK_ERROR
@@ -125,12 +167,12 @@ class Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >
         ;
     static const unsigned P_SIZE_CLOCK_ERROR
 #if defined(_MSC_VER)
-        = INS_ClockErrorEstimated<BaseINS, Clocks>::STATE_VALUES_CLOCK_ERROR
+        = INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases>::STATE_VALUES_CLOCK_ERROR
 #endif
         ;
     static const unsigned Q_SIZE_CLOCK_ERROR
 #if defined(_MSC_VER)
-        = INS_ClockErrorEstimated<BaseINS, Clocks>::STATE_VALUES_CLOCK_ERROR
+        = INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases>::STATE_VALUES_CLOCK_ERROR
 #endif
         ;
     static const unsigned P_SIZE
@@ -146,28 +188,28 @@ class Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >
 };
 
 #if !defined(_MSC_VER)
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::P_SIZE_WITHOUT_CLOCK_ERROR
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::P_SIZE_WITHOUT_CLOCK_ERROR
     = Filtered_INS2_Property<BaseINS>::P_SIZE;
 
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::Q_SIZE_WITHOUT_CLOCK_ERROR
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::Q_SIZE_WITHOUT_CLOCK_ERROR
     = Filtered_INS2_Property<BaseINS>::Q_SIZE;
 
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::P_SIZE_CLOCK_ERROR
-    = INS_ClockErrorEstimated<BaseINS>::STATE_VALUES_CLOCK_ERROR;
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::P_SIZE_CLOCK_ERROR
+    = INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases>::STATE_VALUES_CLOCK_ERROR;
 
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::Q_SIZE_CLOCK_ERROR
-    = INS_ClockErrorEstimated<BaseINS>::STATE_VALUES_CLOCK_ERROR;
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::Q_SIZE_CLOCK_ERROR
+    = INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases>::STATE_VALUES_CLOCK_ERROR;
 
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::P_SIZE
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::P_SIZE
     = P_SIZE_WITHOUT_CLOCK_ERROR + P_SIZE_CLOCK_ERROR;
 
-template <class BaseINS, unsigned int Clocks>
-const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks> >::Q_SIZE
+template <class BaseINS, unsigned int Clocks, unsigned int InterSystemBiases>
+const unsigned Filtered_INS2_Property<INS_ClockErrorEstimated<BaseINS, Clocks, InterSystemBiases> >::Q_SIZE
     = Q_SIZE_WITHOUT_CLOCK_ERROR + Q_SIZE_CLOCK_ERROR;
 #endif
 
@@ -191,6 +233,7 @@ class Filtered_INS_ClockErrorEstimated : public BaseFINS {
 
   public:
     using BaseFINS::ins_t::CLOCKS_SUPPORTED;
+    using BaseFINS::ins_t::INTER_SYSTEM_BIASES;
     using BaseFINS::ins_t::STATE_VALUES_WITHOUT_CLOCK_ERROR;
     using BaseFINS::ins_t::STATE_VALUES_CLOCK_ERROR;
     using BaseFINS::property_t::P_SIZE_WITHOUT_CLOCK_ERROR;
@@ -216,6 +259,17 @@ class Filtered_INS_ClockErrorEstimated : public BaseFINS {
 
     ~Filtered_INS_ClockErrorEstimated(){}
 
+    /**
+     * Save or restore states for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      BaseFINS::checkpoint(ar);
+      ar & m_beta_clock_error & m_beta_clock_error_rate;
+    }
+
     float_t &beta_clock_error(){return m_beta_clock_error;}
     float_t &beta_clock_error_rate(){return m_beta_clock_error_rate;}
 
@@ -241,6 +295,8 @@ class Filtered_INS_ClockErrorEstimated : public BaseFINS {
         }
       }
 
+      /* A matrix of ISB, which is placed after clock errors, is zero (random walk) */
+
       { // B matrix modification
         for(unsigned i(P_SIZE_WITHOUT_CLOCK_ERROR), j(Q_SIZE_WITHOUT_CLOCK_ERROR), k(0);
              k < Q_SIZE_CLOCK_ERROR;
@@ -249,6 +305,7 @@ class Filtered_INS_ClockErrorEstimated : public BaseFINS {
           /* Matrix layout (B)
            * [1] : row(j*2)   => clock(j) error
            * [1] : row(j*2+1) => clock(j) error rate
+           * [1] : row(CLOCKS_SUPPORTED*2+k) => ISB(k)
            */
           res.B[i][j] += 1;
         }
@@ -383,6 +440,18 @@ struct GPS_RawData {
   }
 };
 
+template <class FloatT>
+struct INS_GPS2_Tightly_TDCP_Property {
+  bool enabled; ///< true when time-differenced carrier phase (TDCP) is used
+  FloatT sigma; ///< standard deviation [m] of TDCP
+  FloatT max_interval; ///< maximum interval [s] between epochs to be differenced
+  FloatT doppler_threshold; ///< threshold [m] between TDCP and integrated Doppler, exceeding it means cycle slip
+  FloatT residual_threshold; ///< threshold [m] of TDCP residual, exceeding it means exclusion
+  INS_GPS2_Tightly_TDCP_Property()
+      : enabled(false), sigma(0.05), max_interval(2),
+      doppler_threshold(0.5), residual_threshold(5) {}
+};
+
 /**
  * @brief Tightly coupled INS/GPS
  *
@@ -409,14 +478,37 @@ class INS_GPS2_Tightly : public BaseFINS {
     using typename super_t::quat_t;
     using typename super_t::mat_t;
 #endif
+    typedef INS_GPS2_Tightly_TDCP_Property<float_t> tdcp_property_t;
+  protected:
+    tdcp_property_t tdcp_property;
+
   public:
-    INS_GPS2_Tightly() : super_t() {}
+    INS_GPS2_Tightly()
+        : super_t(), tdcp_property(),
+        carrier_phases(), clone() {}
 
     INS_GPS2_Tightly(const INS_GPS2_Tightly &orig, const bool &deepcopy = false)
-        : super_t(orig, deepcopy) {
+        : super_t(orig, deepcopy), tdcp_property(orig.tdcp_property),
+        carrier_phases(orig.carrier_phases), clone() {
+      if(clone.valid = orig.clone.valid){
+        clone.P = deepcopy ? orig.clone.P.copy() : orig.clone.P;
+        clone.C = deepcopy ? orig.clone.C.copy() : orig.clone.C;
+      }
     }
 
     ~INS_GPS2_Tightly(){}
+
+    /**
+     * Save or restore states including carrier phases and the cloned state for TDCP for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      super_t::checkpoint(ar);
+      ar & carrier_phases & clone.valid;
+      if(clone.valid){ar & clone.P & clone.C;}
+    }
     
     typedef INS_GPS2_Tightly<super_t> self_t;
 
@@ -425,9 +517,16 @@ class INS_GPS2_Tightly : public BaseFINS {
     typedef typename solver_t::space_node_t space_node_t;
 
     using super_t::CLOCKS_SUPPORTED;
+    using super_t::INTER_SYSTEM_BIASES;
     using super_t::P_SIZE;
     using super_t::property_t::P_SIZE_WITHOUT_CLOCK_ERROR;
 
+    void setup_tdcp(const tdcp_property_t &property){
+      tdcp_property = property;
+      carrier_phases.clear();
+      clone.valid = false;
+    }
+
   protected:
     struct receiver_state_t {
       typename raw_data_t::gps_time_t t;
@@ -436,6 +535,41 @@ class INS_GPS2_Tightly : public BaseFINS {
       typename solver_t::pos_t pos;
       typename solver_t::xyz_t vel;
     };
+
+    /**
+     * Carrier phase of a satellite, which is differenced between epochs for TDCP.
+     * Its residual is (carrier phase - predicted range) in meter.
+     * When committed, the residual and the observation matrix row are evaluated
+     * with the state after measurement update, which is the cloned state.
+     */
+    struct carrier_phase_t {
+      typename raw_data_t::gps_time_t t;
+      float_t carrier; ///< carrier phase [m]
+      float_t residual; ///< carrier phase [m] - predicted range [m]
+      float_t doppler; ///< [Hz]
+      bool has_doppler;
+      float_t H[P_SIZE]; ///< observation matrix row of range, i.e., correlation to state
+      template <class Archive>
+      void checkpoint(Archive &ar){
+        ar & t.week & t.seconds & carrier & residual & doppler & has_doppler;
+        for(unsigned int i(0); i < P_SIZE; ++i){ar & H[i];}
+      }
+    };
+    typedef std::map<typename solver_t::prn_t, carrier_phase_t> carrier_phases_t;
+    carrier_phases_t carrier_phases; ///< committed carrier phases of the previous epoch
+
+    /**
+     * Error state cloned when carrier phases are committed.
+     * TDCP depends on both the current and the cloned states, which are correlated.
+     * Therefore, the cross covariance between them is propagated
+     * with time and measurement updates until the next commit.
+     */
+    struct {
+      bool valid; ///< false means no clone
+      mat_t P; ///< covariance of the cloned state
+      mat_t C; ///< cross covariance between the current and the cloned states
+    } clone;
+
     receiver_state_t receiver_state(
         const typename raw_data_t::gps_time_t &t,
         const unsigned int &clock_index,
@@ -458,28 +592,22 @@ class INS_GPS2_Tightly : public BaseFINS {
     /**
      * Assign items of z, H and R of Kalman filter matrices based on range and rate residuals
      *
-     * @param solver residual calculator
-     * @param prn GNSS satellite number used as target
+     * @param solver_selected residual calculator selected for the satellite
      * @param measurement Measurement per satellite containg pseudorange and range rate
      * @param x receiver state represented by current position and clock properties
+     * @param prop relative property of the satellite
      * @param z (output) pointer to be stored with residual
      * @param H (output) pointer to be stored with correlation of state
      * @param R_diag (output) pointer to be stored with estimated residual variance
      * @return (int) number of used rows
      */
     int assign_z_H_R(
-        const solver_t &solver,
-        const typename solver_t::prn_t &prn,
+        const solver_t &solver_selected,
         const typename solver_t::measurement_t::mapped_type &measurement,
         const receiver_state_t &x,
+        typename solver_t::relative_property_t prop,
         float_t z[], float_t H[][P_SIZE], float_t R_diag[]) const {
 
-      const solver_t &solver_selected(solver.select(prn));
-      typename solver_t::relative_property_t prop(
-          solver_selected.relative_property(prn, measurement, x.clock_error, x.t, x.pos, x.vel));
-
-      if(prop.weight <= 0){return 0;} // Intentional exclusion
-
       z[0] = prop.range_residual;
 
       float_t rate;
@@ -582,6 +710,163 @@ class INS_GPS2_Tightly : public BaseFINS {
       return 2;
     }
 
+    /**
+     * Calculate carrier phase of a satellite with the current state,
+     * which is used for time-differenced carrier phase (TDCP), a delta-range between epochs.
+     * Its residual is (carrier phase - predicted range), and the predicted range is
+     * extracted from the range residual. Delays except for known ionospheric one are cancelled by differencing.
+     *
+     * @param solver_selected residual calculator selected for the satellite
+     * @param measurement Measurement per satellite containg carrier phase
+     * @param x receiver state represented by current position and clock properties
+     * @param prop relative property of the satellite, which is shared with range and rate
+     * @param H_range observation matrix row of range
+     * @param res (output) carrier phase
+     * @return (bool) true when carrier phase is available
+     */
+    bool get_carrier_phase(
+        const solver_t &solver_selected,
+        const typename solver_t::measurement_t::mapped_type &measurement,
+        const receiver_state_t &x,
+        const typename solver_t::relative_property_t &prop,
+        const float_t H_range[],
+        carrier_phase_t &res) const {
+
+      static const float_t lambda(space_node_t::L1_WaveLength());
+      if(!solver_t::find_value(measurement,
+          solver_t::measurement_items_t::L1_CARRIER_PHASE, res.carrier)){
+        return false;
+      }
+      float_t range;
+      typename solver_t::range_error_t range_error;
+      if(!solver_selected.range(measurement, range, &range_error)){return false;}
+
+      res.t = x.t;
+      res.carrier *= lambda;
+      res.residual = res.carrier - range + prop.range_residual;
+      if(!(range_error.unknown_flag & solver_t::range_error_t::MASK_IONOSPHERIC)){
+        res.residual -= range_error.value[solver_t::range_error_t::IONOSPHERIC];
+      }
+      res.has_doppler = solver_t::find_value(measurement,
+          solver_t::measurement_items_t::L1_DOPPLER, res.doppler);
+      if(!res.has_doppler){res.doppler = 0;}
+      for(unsigned int j(0); j < P_SIZE; ++j){res.H[j] = H_range[j];}
+      return true;
+    }
+
+    /**
+     * Assign items of z, H and R of Kalman filter matrices based on range and rate residuals,
+     * and optionally calculate carrier phase for TDCP. Relative property of the satellite
+     * is calculated once and shared among them.
+     *
+     * @param solver residual calculator
+     * @param prn GNSS satellite number used as target
+     * @param measurement Measurement per satellite containg pseudorange and range rate
+     * @param x receiver state represented by current position and clock properties
+     * @param z (output) pointer to be stored with residual
+     * @param H (output) pointer to be stored with correlation of state
+     * @param R_diag (output) pointer to be stored with estimated residual variance
+     * @param carrier_phases_out (output) if not NULL, carrier phase of the satellite is stored
+     * @return (int) number of used rows
+     */
+    int assign_z_H_R(
+        const solver_t &solver,
+        const typename solver_t::prn_t &prn,
+        const typename solver_t::measurement_t::mapped_type &measurement,
+        const receiver_state_t &x,
+        float_t z[], float_t H[][P_SIZE], float_t R_diag[],
+        carrier_phases_t *carrier_phases_out = NULL) const {
+
+      /* System group other than the reference (0) has its own ISB,
+       * and a satellite in a group whose ISB is not estimated is not used.
+       */
+      const int group(solver.system_group(prn));
+      if((group < 0) || (group > (int)INTER_SYSTEM_BIASES)){return 0;}
+      const float_t isb((group > 0) ? super_t::m_inter_system_bias[group - 1] : 0);
+
+      const solver_t &solver_selected(solver.select(prn));
+      typename solver_t::relative_property_t prop(
+          solver_selected.relative_property(prn, measurement, x.clock_error + isb, x.t, x.pos, x.vel));
+
+      if(prop.weight <= 0){return 0;} // Intentional exclusion
+
+      int rows(assign_z_H_R(solver_selected, measurement, x, prop, z, H, R_diag));
+      if(group > 0){
+        H[0][P_SIZE_WITHOUT_CLOCK_ERROR + (CLOCKS_SUPPORTED * 2) + (group - 1)] = -1; // same as clock error
+      }
+      if(carrier_phases_out){
+        carrier_phase_t item;
+        if(get_carrier_phase(solver_selected, measurement, x, prop, H[0], item)){
+          (*carrier_phases_out)[prn] = item;
+        }
+      }
+      return rows;
+    }
+
+    /**
+     * Commit carrier phases of the current epoch to be differenced at the next epoch.
+     * They are evaluated with the state after measurement update,
+     * and the state is cloned at the same time.
+     *
+     * @param gps GPS measurement of the current epoch
+     */
+    void commit_carrier_phases(const raw_data_t &gps){
+      carrier_phases.clear();
+      if(tdcp_property.enabled && (gps.clock_index < CLOCKS_SUPPORTED) && gps.solver){
+        receiver_state_t x(receiver_state(gps.gpstime, gps.clock_index));
+        float_t z[2], H[2][P_SIZE], R_diag[2];
+        for(typename solver_t::measurement_t::const_iterator it(gps.measurement.begin());
+            it != gps.measurement.end(); ++it){
+          assign_z_H_R(*gps.solver, it->first, it->second, x, z, H, R_diag, &carrier_phases);
+        }
+      }
+      if(clone.valid = !carrier_phases.empty()){
+        clone.P = super_t::getFilter().getP().copy();
+        clone.C = clone.P.copy();
+      }
+    }
+
+    /**
+     * Call-back function for time update, which propagates cross covariance of the cloned state
+     * as C = Phi * C, where Phi = I + A * deltaT.
+     *
+     * @param A matrix A
+     * @param B matrix B
+     * @param deltaT interval time
+     */
+    void before_update_INS(
+        const mat_t &A, const mat_t &B,
+        const float_t &deltaT){
+      if(clone.valid){
+        clone.C = clone.C + A * (clone.C * deltaT);
+      }
+      super_t::before_update_INS(A, B, deltaT);
+    }
+
+    /**
+     * Call-back function for measurement update, which updates cross covariance of the cloned state
+     * as C = (I - K H) C. (I - K H) is calculated as (I - P^{+} H^{T} R^{-1} H),
+     * which does not depend on implementation of filter such as the sequential gain of UD filter.
+     *
+     * @param H matrix H
+     * @param R matrix R
+     * @param K matrix K (Kalman gain)
+     * @param v =(z - H x)
+     * @param x_hat values to be corrected
+     */
+    void before_correct_INS(
+        const mat_t &H,
+        const mat_t &R,
+        const mat_t &K,
+        const mat_t &v,
+        mat_t &x_hat){
+      if(clone.valid){
+        const mat_t &P(super_t::getFilter().getP());
+        clone.C = clone.C - P * H.transpose() * R.inverse() * (H * clone.C);
+      }
+      super_t::before_correct_INS(H, R, K, v, x_hat);
+    }
+
   public:
     using super_t::correct_info;
 
@@ -651,6 +936,94 @@ class INS_GPS2_Tightly : public BaseFINS {
       return correct_info(gps, clock_error_shift);
     }
 
+    /**
+     * Calculate information required for measurement update with
+     * time-differenced carrier phase (TDCP), which is a delta-range between epochs.
+     * The residual is the carrier phase residual of the current epoch subtracted by
+     * the committed one of the previous epoch, then it depends on both the current state x
+     * and the cloned state x_c as z = H_x x - H_c x_c + n.
+     * Because of the correlation, x_c is regressed on x as x_c = M x + w,
+     * where M = C^{T} P^{-1} and the covariance of w is D = P_c - M C.
+     * The equivalent observation is z = (H_x - H_c M) x + (n - H_c w)
+     * with R = sigma^2 I + H_c D H_c^{T}, which is exact for the augmented state.
+     * The rows are finally whitened with UD decomposition of R
+     * because a filter may use only the diagonal of R.
+     * A satellite whose carrier phase in the previous epoch is missing, or
+     * which is suspected of cycle slip by Doppler or large residual, is excluded.
+     *
+     * @param gps GPS measurement of the current epoch
+     * @return (CorrectInfo) information for measurement update
+     */
+    CorrectInfo<float_t> correct_info_tdcp(const raw_data_t &gps) const {
+      if((!tdcp_property.enabled) || carrier_phases.empty() || (!clone.valid)
+          || (gps.clock_index >= CLOCKS_SUPPORTED) || (!gps.solver)){
+        return CorrectInfo<float_t>::no_info();
+      }
+
+      receiver_state_t x(receiver_state(gps.gpstime, gps.clock_index));
+      carrier_phases_t current;
+      {
+        float_t z[2], H[2][P_SIZE], R_diag[2];
+        for(typename solver_t::measurement_t::const_iterator it(gps.measurement.begin());
+            it != gps.measurement.end(); ++it){
+          assign_z_H_R(*gps.solver, it->first, it->second, x, z, H, R_diag, &current);
+        }
+      }
+
+      static const float_t lambda(space_node_t::L1_WaveLength());
+      std::vector<std::pair<const carrier_phase_t *, const carrier_phase_t *> > pairs;
+      for(typename carrier_phases_t::const_iterator it(current.begin());
+          it != current.end(); ++it){
+        typename carrier_phases_t::const_iterator it_previous(carrier_phases.find(it->first));
+        if(it_previous == carrier_phases.end()){continue;}
+        const carrier_phase_t &now(it->second), &previous(it_previous->second);
+
+        const float_t delta_t(now.t - previous.t);
+        if((delta_t <= 0) || (delta_t > tdcp_property.max_interval)){continue;}
+
+        if(now.has_doppler && previous.has_doppler){ // cycle slip check
+          float_t delta_doppler(-lambda * (now.doppler + previous.doppler) / 2 * delta_t);
+          if(std::abs(now.carrier - previous.carrier - delta_doppler)
+              > tdcp_property.doppler_threshold){
+            continue;
+          }
+        }
+
+        if(std::abs(now.residual - previous.residual) > tdcp_property.residual_threshold){continue;}
+
+        pairs.push_back(std::make_pair(&now, &previous));
+      }
+
+      const unsigned int rows(pairs.size());
+      if(rows < 1){return CorrectInfo<float_t>::no_info();}
+
+      mat_t z(rows, 1), H_x(rows, P_SIZE), H_c(rows, P_SIZE);
+      for(unsigned int i(0); i < rows; ++i){
+        z(i, 0) = pairs[i].first->residual - pairs[i].second->residual;
+        for(unsigned int j(0); j < P_SIZE; ++j){
+          H_x(i, j) = pairs[i].first->H[j];
+          H_c(i, j) = pairs[i].second->H[j];
+        }
+      }
+
+      const mat_t &P(const_cast<self_t *>(this)->getFilter().getP());
+      mat_t M(clone.C.transpose() * P.inverse());
+      mat_t H(H_x - H_c * M);
+      mat_t R(H_c * (clone.P - M * clone.C) * H_c.transpose());
+      for(unsigned int i(0); i < rows; ++i){
+        R(i, i) += std::pow(tdcp_property.sigma, 2);
+      }
+
+      mat_t UD(R.decomposeUD(false));
+      mat_t U_inv(UD.partial(rows, rows).inverse());
+      mat_t R_white(rows, rows);
+      for(unsigned int i(0); i < rows; ++i){
+        R_white(i, i) = UD(i, rows + i);
+      }
+
+      return CorrectInfo<float_t>(U_inv * H, U_inv * z, R_white);
+    }
+
   protected:
     float_t range_residual_mean_ms(
         const unsigned int &clock_index,
@@ -718,6 +1091,23 @@ class INS_GPS2_Tightly : public BaseFINS {
   public:
     using super_t::correct;
 
+  protected:
+    /**
+     * Measurement update with TDCP following range and rate,
+     * and then commit carrier phases of the current epoch.
+     *
+     * @param gps GPS measurement
+     */
+    void correct_tdcp(const raw_data_t &gps){
+      if(tdcp_property.enabled){
+        CorrectInfo<float_t> info(correct_info_tdcp(gps));
+        clone.valid = false; // The cloned state will be renewed by the following commit.
+        if(info.z.rows() > 0){super_t::correct_primitive(info);}
+      }
+      commit_carrier_phases(gps);
+    }
+
+  public:
     /**
      * Measurement update with GPS raw measurement
      *
@@ -725,6 +1115,7 @@ class INS_GPS2_Tightly : public BaseFINS {
      */
     void correct(const raw_data_t &gps){
       correct_with_clock_jump_check(gps, CorrectInfoGenerator());
+      correct_tdcp(gps);
     }
 
     /**
@@ -738,13 +1129,31 @@ class INS_GPS2_Tightly : public BaseFINS {
         const vec3_t &lever_arm_b,
         const vec3_t &omega_b2i_4b){
       correct_with_clock_jump_check(gps, CorrectInfoGenerator(&lever_arm_b, &omega_b2i_4b));
+      correct_tdcp(gps);
+    }
+
+    /**
+     * Measurement update of yaw angle, which also updates cross covariance of the cloned state
+     * as C = (I - K H) C = P^{+} P^{-1} C, because its call-back function is not invoked.
+     *
+     * @param delta_psi difference from the current yaw angle [rad]
+     * @param sigma2_delta_psi variance of delta_psi [rad^2]
+     */
+    void correct_yaw(const float_t &delta_psi, const float_t &sigma2_delta_psi){
+      if(!clone.valid){
+        super_t::correct_yaw(delta_psi, sigma2_delta_psi);
+        return;
+      }
+      mat_t P_inv_C(super_t::getFilter().getP().inverse() * clone.C);
+      super_t::correct_yaw(delta_psi, sigma2_delta_psi);
+      clone.C = super_t::getFilter().getP() * P_inv_C;
     }
 
     // { // PVT (loosely) interface
     CorrectInfo<float_t> correct_info_pvt(
         const typename raw_data_t::pvt_t &,
         const float_t &,
-        void *,
+        const void *,
         const vec3_t * = NULL, const vec3_t * = NULL) const {
       return CorrectInfo<float_t>::no_info();
     }
@@ -763,26 +1172,46 @@ class INS_GPS2_Tightly : public BaseFINS {
           ? super_t::correct_info((GPS_Solution<float_t>)pvt, *lever_arm_b, *omega_b2i_4b)
           : super_t::correct_info((GPS_Solution<float_t>)pvt));
 
-      // expand H, z, R rows to include clock and clock rate residual
-      unsigned int rows_orig(info_loosely.z.rows()), rows_new(rows_orig + 2);
+      /* Inter-system biases of the solution, which is screened by RAIM/FDE of the grouped solver,
+       * are also used when both of the reference group (0) and the corresponding group are used.
+       */
+      unsigned int isb_rows(0);
+      int isb_groups[INTER_SYSTEM_BIASES > 0 ? INTER_SYSTEM_BIASES : 1];
+      for(int group(1); group <= (int)INTER_SYSTEM_BIASES; ++group){
+        if(group >= raw_data_t::solver_t::SYSTEM_GROUPS_MAX){break;}
+        if((pvt.system_groups & 0x1) && (pvt.system_groups & (1u << group))){
+          isb_groups[isb_rows++] = group;
+        }
+      }
+
+      // expand H, z, R rows to include clock and clock rate residual, and ISBs
+      unsigned int rows_orig(info_loosely.z.rows()), rows_new(rows_orig + 2 + isb_rows);
       mat_t H(rows_new, info_loosely.H.columns()), z(rows_new, 1), R(rows_new, rows_new);
       H.pivotMerge(0, 0, info_loosely.H);
       z.pivotMerge(0, 0, info_loosely.z);
       R.pivotMerge(0, 0, info_loosely.R);
 
       // fill clock (H = -1 because of correspondence of tightly)
-      H(rows_new - 2, P_SIZE_WITHOUT_CLOCK_ERROR + (pvt.clock_index * 2)) = -1;
-      z(rows_new - 2, 0)
+      H(rows_orig, P_SIZE_WITHOUT_CLOCK_ERROR + (pvt.clock_index * 2)) = -1;
+      z(rows_orig, 0)
           = pvt.receiver_error
             - (super_t::m_clock_error[pvt.clock_index] + clock_error_shift);
-      R(rows_new - 2, rows_new - 2) = 1E1; // TODO
+      R(rows_orig, rows_orig) = 1E1; // TODO
 
       // fill clock rate (H = -1 because of correspondence of tightly)
-      H(rows_new - 1, P_SIZE_WITHOUT_CLOCK_ERROR + (pvt.clock_index * 2) + 1) = -1;
-      z(rows_new - 1, 0)
+      H(rows_orig + 1, P_SIZE_WITHOUT_CLOCK_ERROR + (pvt.clock_index * 2) + 1) = -1;
+      z(rows_orig + 1, 0)
           = pvt.receiver_error_rate
             - super_t::m_clock_error_rate[pvt.clock_index];
-      R(rows_new - 1, rows_new - 1) = 1E-1; // TODO
+      R(rows_orig + 1, rows_orig + 1) = 1E-1; // TODO
+
+      // fill ISB (H = -1 as well as clock)
+      for(unsigned int i(0), row(rows_orig + 2); i < isb_rows; ++i, ++row){
+        const int &group(isb_groups[i]);
+        H(row, P_SIZE_WITHOUT_CLOCK_ERROR + (CLOCKS_SUPPORTED * 2) + (group - 1)) = -1;
+        z(row, 0) = pvt.inter_system_bias[group] - super_t::m_inter_system_bias[group - 1];
+        R(row, row) = 1E1; // TODO
+      }
 
       return CorrectInfo<float_t>(H, z, R);
     }
@@ -38,11 +38,12 @@
 #include <cstring>
 
 #include "param/matrix.h"
+#include "util/delta_trace.h"
 #include "Filtered_INS2.h"
 
 template <class FloatT>
 struct INS_GPS_Debug_Property {
-  enum debug_target_t {DEBUG_NONE, DEBUG_KF_P, DEBUG_KF_FULL, DEBUG_PURE_INERTIAL} debug_target;
+  enum debug_target_t {DEBUG_NONE, DEBUG_KF_P, DEBUG_KF_FULL, DEBUG_KF_P_TRACE, DEBUG_PURE_INERTIAL} debug_target;
   INS_GPS_Debug_Property() : debug_target(DEBUG_NONE) {}
 
   bool check_debug_property_spec(const char *spec){
@@ -50,6 +51,8 @@ struct INS_GPS_Debug_Property {
       debug_target = DEBUG_KF_P;
     }else if(std::strcmp(spec, "KF_FULL") == 0){
       debug_target = DEBUG_KF_FULL;
+    }else if(std::strcmp(spec, "KF_P_trace") == 0){
+      debug_target = DEBUG_KF_P_TRACE;
     }else if(std::strcmp(spec, "pure_inertial") == 0){
       debug_target = DEBUG_PURE_INERTIAL;
     }else{
@@ -66,6 +69,7 @@ struct INS_GPS_Debug_Property {
         case DEBUG_NONE: break;
         case DEBUG_KF_P: out << "KF_P"; break;
         case DEBUG_KF_FULL: out << "KF_FULL"; break;
+        case DEBUG_KF_P_TRACE: out << "KF_P_trace"; break;
         case DEBUG_PURE_INERTIAL: out << "pure_inertial"; break;
       }
       return out;
@@ -97,6 +101,13 @@ class INS_GPS_Debug : public INS_GPS, protected INS_GPS_Debug_Property<typename
     }
 
     virtual void inspect(std::ostream &out) const {}
+    /**
+     * Write binary debug information
+     *
+     * @param out output stream, which should be opened in binary mode
+     * @param t time stamp
+     */
+    virtual void trace(std::ostream &out, const typename INS_GPS::float_t &t) const {}
 };
 
 template <class INS_GPS>
@@ -123,16 +134,24 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
             K(deepcopy ? orig.K.copy() : orig.K),
             v(deepcopy ? orig.v.copy() : orig.v) {}
     } snapshot;
+    /**
+     * Encoder of trace(), which is opened at the first call.
+     * Because each record is encoded as difference from the previous one,
+     * its state is carried over by copy, which continues the trace.
+     */
+    mutable DeltaTrace::Writer trace_writer;
   public:
     INS_GPS_Debug_Covariance()
-        : super_t(), last_action(ACTION_LAST_NOP) {}
+        : super_t(), last_action(ACTION_LAST_NOP), trace_writer() {}
     INS_GPS_Debug_Covariance(
         const INS_GPS_Debug_Covariance &orig,
         const bool &deepcopy = false)
-        : super_t(orig, deepcopy), last_action(orig.last_action), snapshot(orig.snapshot, deepcopy) {}
+        : super_t(orig, deepcopy), last_action(orig.last_action), snapshot(orig.snapshot, deepcopy),
+        trace_writer(orig.trace_writer) {}
     INS_GPS_Debug_Covariance<INS_GPS> &operator=(const INS_GPS_Debug_Covariance<INS_GPS> &another){
-      INS_GPS_Debug_Covariance<INS_GPS>::operator=(another);
+      super_t::operator=(another);
       last_action = another.last_action;
+      trace_writer = another.trace_writer;
       snapshot.A = another.snapshot.A;
       snapshot.B = another.snapshot.B;
       snapshot.H = another.snapshot.H;
@@ -181,14 +200,30 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
           break;
       }
     }
+    /**
+     * Write the upper triangle of P in DeltaTrace format.
+     * A filter writes its trace to a single stream; the stream of the first call is used.
+     */
+    void trace(std::ostream &out, const float_t &t) const {
+      if(super_t::debug_target != super_t::DEBUG_KF_P_TRACE){return;}
+      typedef INS_GPS_Debug_Covariance<INS_GPS> self_t;
+      const mat_t &P(const_cast<self_t *>(this)->getFilter().getP());
+      if(!trace_writer.is_open()){
+        trace_writer = DeltaTrace::Writer(
+            out, DeltaTrace::header_t(DeltaTrace::LAYOUT_UPPER_TRIANGLE, P.rows()));
+      }
+      trace_writer.write_matrix((double)t, P);
+    }
 
   protected:
     void before_update_INS(
         const mat_t &A, const mat_t &B,
         const float_t &elapsedT){
       last_action = ACTION_LAST_UPDATE;
-      snapshot.A = A;
-      snapshot.B = B;
+      if(super_t::debug_target == super_t::DEBUG_KF_FULL){ // snapshot is used only by inspect()
+        snapshot.A = A;
+        snapshot.B = B;
+      }
       super_t::before_update_INS(A, B, elapsedT);
     }
 
@@ -199,10 +234,12 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
         const mat_t &v,
         mat_t &x_hat){
       last_action = ACTION_LAST_CORRECT;
-      snapshot.H = H;
-      snapshot.R = R;
-      snapshot.K = K;
-      snapshot.v = v;
+      if(super_t::debug_target == super_t::DEBUG_KF_FULL){
+        snapshot.H = H;
+        snapshot.R = R;
+        snapshot.K = K;
+        snapshot.v = v;
+      }
       super_t::before_correct_INS(H, R, K, v, x_hat);
     }
 };
@@ -121,13 +121,13 @@ struct INS_GPS_Factory_Options {
   };
 
   // tightly coupled
-  template <class T, unsigned int Clocks>
+  template <class T, unsigned int Clocks, unsigned int InterSystemBiases = 0>
   struct tightly_t : option_t<T> {
     static const int priority = Priority_Tightly;
 
     template <class T_Change>
     struct change_t {
-      typedef tightly_t<T_Change, Clocks> res_t;
+      typedef tightly_t<T_Change, Clocks, InterSystemBiases> res_t;
     };
 
     template <class T_Add>
@@ -136,17 +136,17 @@ struct INS_GPS_Factory_Options {
       struct check_copy_t {
         template <bool new_is_under, class U = void>
         struct check_order_t { // new_opt<old_opt>
-          typedef typename T_Rebuild::template change_t<tightly_t<T, Clocks> >::res_t res_t;
+          typedef typename T_Rebuild::template change_t<tightly_t<T, Clocks, InterSystemBiases> >::res_t res_t;
         };
         template <class U>
         struct check_order_t<true, U> { // old_opt_top<new_opt>
-          typedef tightly_t<T_Rebuild, Clocks> res_t;
+          typedef tightly_t<T_Rebuild, Clocks, InterSystemBiases> res_t;
         };
         typedef typename check_order_t<(priority > T_Rebuild::priority)>::res_t res_t;
       };
-      template <class T_Rebuild_Base, unsigned int Clocks_New>
-      struct check_copy_t<tightly_t<T_Rebuild_Base, Clocks_New> > {
-        typedef tightly_t<T_Rebuild_Base, Clocks_New> res_t;
+      template <class T_Rebuild_Base, unsigned int Clocks_New, unsigned int InterSystemBiases_New>
+      struct check_copy_t<tightly_t<T_Rebuild_Base, Clocks_New, InterSystemBiases_New> > {
+        typedef tightly_t<T_Rebuild_Base, Clocks_New, InterSystemBiases_New> res_t;
       };
       typedef typename check_copy_t<
           typename option_t<T>::template add_t<T_Add>::res_t>::res_t res_t;
@@ -254,9 +254,9 @@ struct INS_GPS_Factory {
           typename INS_GPS_Factory_Options::template egm_t<void, EGM> >::res_t> {};
 
   // tightly coupled
-  template <class T, unsigned int Clocks>
-  struct option_t<typename INS_GPS_Factory_Options::tightly_t<T, Clocks> > : option_t<T> {
-    typedef INS_ClockErrorEstimated<typename option_t<T>::ins_t, Clocks> ins_t;
+  template <class T, unsigned int Clocks, unsigned int InterSystemBiases>
+  struct option_t<typename INS_GPS_Factory_Options::tightly_t<T, Clocks, InterSystemBiases> > : option_t<T> {
+    typedef INS_ClockErrorEstimated<typename option_t<T>::ins_t, Clocks, InterSystemBiases> ins_t;
     template <class INS_Type>
     struct filtered_ins_t {
       typedef Filtered_INS_ClockErrorEstimated<
@@ -285,11 +285,11 @@ struct INS_GPS_Factory {
           >::res_t > res_t;
     };
   };
-  template <unsigned int Clocks = 1>
+  template <unsigned int Clocks = 1, unsigned int InterSystemBiases = 0>
   struct tightly : public INS_GPS_Factory<PureINS,
       typename INS_GPS_Factory_Options::template option_t<Options>
         ::template add_t<
-          typename INS_GPS_Factory_Options::template tightly_t<void, Clocks> >::res_t> {};
+          typename INS_GPS_Factory_Options::template tightly_t<void, Clocks, InterSystemBiases> >::res_t> {};
 
   // bias estimation
   template <class T>
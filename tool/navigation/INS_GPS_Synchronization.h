@@ -81,6 +81,29 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
     }
     const snapshots_t &get_snapshots() const {return snapshots;}
 
+    /**
+     * Save or restore states including snapshots for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      INS_GPS::checkpoint(ar);
+      unsigned int n(snapshots.size());
+      ar & n;
+      if(Archive::loading){
+        // Properties are taken over from the current state, and then states are overwritten.
+        snapshots.clear();
+        for(unsigned int i(0); i < n; ++i){
+          snapshots.push_back(snapshot_content_t(*this, mat_t(), mat_t(), 0));
+        }
+      }
+      for(typename snapshots_t::iterator it(snapshots.begin()); it != snapshots.end(); ++it){
+        it->ins_gps.checkpoint(ar);
+        ar & it->Phi & it->GQGt & it->elapsedT_from_last_correct;
+      }
+    }
+
   protected:
     /**
      * Call-back function for time update
@@ -92,6 +115,7 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
     void before_update_INS(
         const mat_t &A, const mat_t &B,
         const float_t &elapsedT){
+      INS_GPS::before_update_INS(A, B, elapsedT);
       mat_t Phi(A * elapsedT);
       for(unsigned i(0); i < A.rows(); i++){Phi(i, i) += 1;}
       mat_t Gamma(B * elapsedT);
@@ -122,6 +146,7 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
         const mat_t &K,
         const mat_t &v,
         mat_t &x_hat){
+      INS_GPS::before_correct_INS(H, R, K, v, x_hat);
       if(!snapshots.empty()){
 
         // This routine is invoked by measurement update function called correct().
@@ -212,6 +237,28 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
       prop_t::operator=(property);
     }
 
+    /**
+     * Save or restore states including snapshots for checkpoint
+     *
+     * @param ar archive such as Checkpoint::Writer or Checkpoint::Reader
+     */
+    template <class Archive>
+    void checkpoint(Archive &ar){
+      INS_GPS::checkpoint(ar);
+      unsigned int n(snapshots.size());
+      ar & n;
+      if(Archive::loading){
+        snapshots.clear();
+        for(unsigned int i(0); i < n; ++i){
+          snapshots.push_back(snapshot_content_t(*this, mat_t(), mat_t(), mat_t(), 0));
+        }
+      }
+      for(typename snapshots_t::iterator it(snapshots.begin()); it != snapshots.end(); ++it){
+        it->ins_gps.checkpoint(ar);
+        ar & it->A & it->Phi_inv & it->GQGt & it->elapsedT_from_last_update;
+      }
+    }
+
   protected:
     /**
      * Call-back function for time update
@@ -223,6 +270,7 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     void before_update_INS(
         const mat_t &A, const mat_t &B,
         const float_t &elapsedT){
+      INS_GPS::before_update_INS(A, B, elapsedT);
       mat_t Phi(A * elapsedT);
       for(unsigned i(0); i < A.rows(); i++){Phi(i, i) += 1;}
       mat_t Gamma(B * elapsedT);
@@ -92,7 +92,7 @@ class MagneticFieldGeneric {
     }
     
     static void make_model(
-        model_t &model_new, const model_t *models[], const unsigned int &models_size){
+        model_t &model_new, const model_t *const models[], const unsigned int &models_size){
       if(models_size < 1){
         return;
       }else if(models_size == 1){
@@ -120,7 +120,7 @@ class MagneticFieldGeneric {
     }
     static model_t make_model(
         const FloatT &year,
-        const model_t *models[], const unsigned int &models_size,
+        const model_t *const models[], const unsigned int &models_size,
         const int &dof = 0){
       model_t res;
       res.year = year;
@@ -325,11 +325,7 @@ struct MagneticFieldGeneric2 : public MagneticFieldGeneric<FloatT> {
     return MagneticFieldGeneric<FloatT>::make_model(
         year,
         Binder<FloatT>::models,
-#if defined(__GNUC__)
-        sizeof(Binder<FloatT>::models) / sizeof(Binder<FloatT>::models[0]),
-#else
         Binder<FloatT>::models_num,
-#endif
         dof);
   }
   static typename MagneticFieldGeneric<FloatT>::latlng_t geomagnetic_latlng(
@@ -380,7 +376,7 @@ struct IGRF11Preset {
 template <class FloatT>
 struct IGRF11Generic : public MagneticFieldGeneric2<FloatT, IGRF11Generic>, public IGRF11Preset<FloatT> {
   typedef IGRF11Preset<FloatT> preset_t;
-  static const typename MagneticFieldGeneric<FloatT>::model_t *models[];
+  static const typename MagneticFieldGeneric<FloatT>::model_t *const models[23];
   static const int models_num;
 };
 
@@ -765,7 +761,7 @@ const typename MagneticFieldGeneric<FloatT>::model_t IGRF11Preset<FloatT>::IGRF4
     };
 
 template <class FloatT>
-const typename MagneticFieldGeneric<FloatT>::model_t *IGRF11Generic<FloatT>::models[] = {
+const typename MagneticFieldGeneric<FloatT>::model_t *const IGRF11Generic<FloatT>::models[23] = {
   &preset_t::IGRF00,
   &preset_t::IGRF05,
   &preset_t::IGRF10,
@@ -803,7 +799,7 @@ struct IGRF12Preset : public IGRF11Preset<FloatT> {
 template <class FloatT>
 struct IGRF12Generic : public MagneticFieldGeneric2<FloatT, IGRF12Generic>, public IGRF12Preset<FloatT> {
   typedef IGRF12Preset<FloatT> preset_t;
-  static const typename MagneticFieldGeneric<FloatT>::model_t *models[];
+  static const typename MagneticFieldGeneric<FloatT>::model_t *const models[24];
   static const int models_num;
 };
 
@@ -849,7 +845,7 @@ const typename MagneticFieldGeneric<FloatT>::model_t IGRF12Preset<FloatT>::IGRF2
     };
 
 template <class FloatT>
-const typename MagneticFieldGeneric<FloatT>::model_t *IGRF12Generic<FloatT>::models[] = {
+const typename MagneticFieldGeneric<FloatT>::model_t *const IGRF12Generic<FloatT>::models[24] = {
   &preset_t::IGRF00,
   &preset_t::IGRF05,
   &preset_t::IGRF10,
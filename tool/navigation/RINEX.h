@@ -50,6 +50,7 @@
 #include <algorithm>
 
 #include "GPS.h"
+#include "Galileo.h"
 
 template <class U = void>
 class RINEX_Reader {
@@ -107,10 +108,14 @@ struct RINEX_NAV {
   typedef GPS_SpaceNode<FloatT> space_node_t;
   typedef typename space_node_t::Ionospheric_UTC_Parameters iono_utc_t;
   typedef typename space_node_t::Satellite::Ephemeris ephemeris_t;
+  typedef Galileo_SpaceNode<FloatT> galileo_space_node_t;
+  typedef typename galileo_space_node_t::ephemeris_t galileo_ephemeris_t;
   struct SatelliteInfo {
-    unsigned int svid;
+    char system; ///< 'G' (GPS), 'J' (QZSS), or 'E' (Galileo)
+    unsigned int svid; ///< PRN for GPS and QZSS (193-), satellite number for Galileo
     FloatT t_ot;  ///< Transmitting time [s]
-    ephemeris_t ephemeris;
+    ephemeris_t ephemeris; ///< for GPS and QZSS
+    galileo_ephemeris_t ephemeris_galileo; ///< for Galileo
   };
 };
 
@@ -124,13 +129,18 @@ class RINEX_NAV_Reader : public RINEX_Reader<> {
     typedef typename content_t::space_node_t space_node_t;
     typedef typename content_t::ephemeris_t ephemeris_t;
     typedef typename content_t::SatelliteInfo SatelliteInfo;
+    typedef typename content_t::galileo_space_node_t galileo_space_node_t;
+    typedef typename content_t::galileo_ephemeris_t galileo_ephemeris_t;
   
   protected:
     SatelliteInfo info;
+    int version; ///< 100 times of RINEX version, for example, 211 and 304
     static std::string &modify_header(std::string &label, std::string &content){
       if((label.find("ION ALPHA") == 0)
           || (label.find("ION BETA") == 0)
-          || (label.find("DELTA-UTC: A0,A1,T,W") == 0)){
+          || (label.find("DELTA-UTC: A0,A1,T,W") == 0)
+          || (label.find("IONOSPHERIC CORR") == 0)
+          || (label.find("TIME SYSTEM CORR") == 0)){
         for(int pos(0);
             (pos = content.find("D", pos)) != std::string::npos;
             ){
@@ -141,8 +151,17 @@ class RINEX_NAV_Reader : public RINEX_Reader<> {
     }
     
     void seek_next() {
+      if(version >= 300){
+        seek_next_v3();
+      }else{
+        seek_next_v2();
+      }
+    }
+
+    void seek_next_v2() {
       char buf[256];
       
+      info.system = 'G';
       FloatT ura_meter;
       for(int i = 0; (i < 8) && (super_t::src.good()); i++){
         if(super_t::src.getline(buf, sizeof(buf)).fail()){return;}
@@ -249,9 +268,164 @@ case line_num: { \
       
       super_t::_has_next = true;
     }
+
+    /**
+     * Read a record of RINEX 3 navigation message.
+     * GPS, QZSS, and Galileo records are extracted, and the others are skipped.
+     */
+    void seek_next_v3() {
+      char buf[256];
+      while(super_t::src.good()){
+        if(super_t::src.getline(buf, sizeof(buf)).fail()){return;}
+        std::string lines[8];
+        lines[0] = buf;
+        if(lines[0].size() < 23){continue;}
+
+        info.system = lines[0][0];
+        int lines_following(7);
+        switch(info.system){
+          case 'R': case 'S': lines_following = 3; break; // GLONASS, SBAS
+        }
+        for(int i(1); i <= lines_following; ++i){
+          if(super_t::src.getline(buf, sizeof(buf)).fail()){return;}
+          lines[i] = buf;
+        }
+        switch(info.system){
+          case 'G': case 'J': case 'E': break;
+          default: continue; // unsupported system
+        }
+        for(int i(0); i <= lines_following; ++i){
+          for(int pos(0);
+              (pos = lines[i].find("D", pos)) != std::string::npos;
+              ){
+            lines[i].replace(pos, 1, "E");
+          }
+        }
+
+#define GET_SS(line_num, offset, length) \
+std::stringstream(lines[line_num].size() > offset ? lines[line_num].substr(offset, length) : "0")
+#define GET_FIELD(line_num, index, v) \
+{FloatT v_; if(GET_SS(line_num, ((line_num) == 0 ? 23 : 4) + 19 * (index), 19) >> v_){v = v_;}else{v = 0;}}
+
+        GET_SS(0, 1, 2) >> info.svid;
+        struct tm t;
+        GET_SS(0, 4, 4) >> t.tm_year;
+        t.tm_year -= 1900;
+        GET_SS(0, 9, 2) >> t.tm_mon;
+        --(t.tm_mon);
+        GET_SS(0, 12, 2) >> t.tm_mday;
+        GET_SS(0, 15, 2) >> t.tm_hour;
+        GET_SS(0, 18, 2) >> t.tm_min;
+        t.tm_sec = 0;
+        int sec(0);
+        GET_SS(0, 21, 2) >> sec;
+        GPS_Time<FloatT> t_oc(t); // Galileo system time is regarded as GPS time
+        t_oc += sec;
+
+        FloatT dummy, health, iod, ura_meter, fit_interval, week;
+
+        if(info.system == 'E'){
+          galileo_ephemeris_t &eph(info.ephemeris_galileo);
+          eph = galileo_ephemeris_t();
+          eph.svid = info.svid;
+          eph.t_oc = t_oc.seconds;
+          GET_FIELD(0, 0, eph.a_f0);
+          GET_FIELD(0, 1, eph.a_f1);
+          GET_FIELD(0, 2, eph.a_f2);
+          GET_FIELD(1, 0, iod);         eph.iodnav = (int)iod;
+          GET_FIELD(1, 1, eph.c_rs);
+          GET_FIELD(1, 2, eph.delta_n);
+          GET_FIELD(1, 3, eph.M0);
+          GET_FIELD(2, 0, eph.c_uc);
+          GET_FIELD(2, 1, eph.e);
+          GET_FIELD(2, 2, eph.c_us);
+          GET_FIELD(2, 3, eph.sqrt_A);
+          GET_FIELD(3, 0, eph.t_oe);
+          GET_FIELD(3, 1, eph.c_ic);
+          GET_FIELD(3, 2, eph.Omega0);
+          GET_FIELD(3, 3, eph.c_is);
+          GET_FIELD(4, 0, eph.i0);
+          GET_FIELD(4, 1, eph.c_rc);
+          GET_FIELD(4, 2, eph.omega);
+          GET_FIELD(4, 3, eph.dot_Omega0);
+          GET_FIELD(5, 0, eph.dot_i0);
+          GET_FIELD(5, 1, dummy);       eph.data_source = (unsigned int)dummy;
+          GET_FIELD(5, 2, week);        eph.WN = (unsigned int)week; // GAL week aligned with GPS week
+          GET_FIELD(6, 0, eph.SISA);
+          GET_FIELD(6, 1, health);      eph.health = (unsigned int)health;
+          GET_FIELD(6, 2, eph.BGD_E1E5a);
+          GET_FIELD(6, 3, eph.BGD_E1E5b);
+          GET_FIELD(7, 0, info.t_ot);
+          if(eph.WN != (unsigned int)t_oc.week){ // t_oc in previous or next week
+            eph.t_oc += (t_oc.week - (int)eph.WN) * GPS_Time<FloatT>::seconds_week;
+          }
+        }else{ // GPS, QZSS
+          ephemeris_t &eph(info.ephemeris);
+          eph = ephemeris_t();
+          if(info.system == 'J'){info.svid += 192;} // PRN
+          eph.svid = info.svid;
+          eph.WN = t_oc.week;
+          eph.t_oc = t_oc.seconds;
+          GET_FIELD(0, 0, eph.a_f0);
+          GET_FIELD(0, 1, eph.a_f1);
+          GET_FIELD(0, 2, eph.a_f2);
+          GET_FIELD(1, 0, iod);         eph.iode = (int)iod;
+          GET_FIELD(1, 1, eph.c_rs);
+          GET_FIELD(1, 2, eph.delta_n);
+          GET_FIELD(1, 3, eph.M0);
+          GET_FIELD(2, 0, eph.c_uc);
+          GET_FIELD(2, 1, eph.e);
+          GET_FIELD(2, 2, eph.c_us);
+          GET_FIELD(2, 3, eph.sqrt_A);
+          GET_FIELD(3, 0, eph.t_oe);
+          GET_FIELD(3, 1, eph.c_ic);
+          GET_FIELD(3, 2, eph.Omega0);
+          GET_FIELD(3, 3, eph.c_is);
+          GET_FIELD(4, 0, eph.i0);
+          GET_FIELD(4, 1, eph.c_rc);
+          GET_FIELD(4, 2, eph.omega);
+          GET_FIELD(4, 3, eph.dot_Omega0);
+          GET_FIELD(5, 0, eph.dot_i0);
+          GET_FIELD(5, 2, week);
+          GET_FIELD(6, 0, ura_meter);
+          GET_FIELD(6, 1, health);      eph.SV_health = (unsigned int)health;
+          GET_FIELD(6, 2, eph.t_GD);
+          GET_FIELD(6, 3, iod);         eph.iodc = (int)iod;
+          GET_FIELD(7, 0, info.t_ot);
+          GET_FIELD(7, 1, fit_interval);
+
+          if((unsigned int)week != eph.WN){ // t_oc in previous or next week
+            eph.t_oc += ((int)eph.WN - (int)week) * GPS_Time<FloatT>::seconds_week;
+            eph.WN = (unsigned int)week;
+          }
+          eph.URA = ephemeris_t::URA_index(ura_meter);
+          if(info.system == 'J'){
+            // QZSS has fit interval flag, 0: 2 hours, 1: more than 2 hours (IS-QZSS-PNT)
+            fit_interval = (fit_interval > 0) ? 4 : 2;
+          }else if(fit_interval < 4){
+            fit_interval = 4; // At least 4 hour validity
+          }
+          eph.fit_interval = fit_interval * (60 * 60); // hours => seconds;
+        }
+#undef GET_FIELD
+#undef GET_SS
+
+        super_t::_has_next = true;
+        return;
+      }
+    }
+
+    static int version_of(const typename super_t::header_t &header){
+      typename super_t::header_t::const_iterator it(header.find("RINEX VERSION / TYPE"));
+      if(it == header.end()){return 0;}
+      FloatT v(0);
+      std::stringstream(it->second.substr(0, 9)) >> v;
+      return (int)(v * 100 + 0.5);
+    }
   
   public:
-    RINEX_NAV_Reader(std::istream &in) : super_t(in, self_t::modify_header) {
+    RINEX_NAV_Reader(std::istream &in)
+        : super_t(in, self_t::modify_header), version(version_of(super_t::_header)) {
       seek_next();
     }
     ~RINEX_NAV_Reader(){}
@@ -295,6 +469,37 @@ case line_num: { \
         sstr >> iono_utc.WN_t;
       }
 
+      if(version >= 300){
+        if((it = _header.find("IONOSPHERIC CORR")) != _header.end()){
+          for(std::string::size_type i(0); i + 4 <= it->second.size(); i += 60){
+            std::string type(it->second.substr(i, 4));
+            FloatT *dst(NULL);
+            if(type == "GPSA"){
+              dst = iono_utc.alpha;
+              alpha = true;
+            }else if(type == "GPSB"){
+              dst = iono_utc.beta;
+              beta = true;
+            }else{
+              continue;
+            }
+            std::stringstream sstr(it->second.substr(i + 5, 48));
+            for(int j(0); j < 4; ++j){sstr >> dst[j];}
+          }
+        }
+        if((it = _header.find("TIME SYSTEM CORR")) != _header.end()){
+          for(std::string::size_type i(0); i + 4 <= it->second.size(); i += 60){
+            if(it->second.substr(i, 4) != "GPUT"){continue;}
+            std::stringstream sstr(it->second.substr(i + 5, 50));
+            sstr >> iono_utc.A0;
+            sstr >> iono_utc.A1;
+            sstr >> iono_utc.t_ot;
+            sstr >> iono_utc.WN_t;
+            utc = true;
+          }
+        }
+      }
+
       if(leap = ((it = _header.find("LEAP SECONDS")) != _header.end())){
         std::stringstream sstr(it->second);
         sstr >> iono_utc.delta_t_LS;
@@ -309,9 +514,53 @@ case line_num: { \
       RINEX_NAV_Reader reader(in);
       reader.extract_iono_utc(space_node); // read optional parameters
       res++;
-      for(; reader.has_next(); ++res){
+      for(; reader.has_next(); ){
         SatelliteInfo info(reader.next());
+        if(info.system != 'G'){continue;}
         space_node.satellite(info.svid).register_ephemeris(info.ephemeris);
+        ++res;
+      }
+      return res;
+    }
+
+    /**
+     * Read all ephemerides of multiple constellations.
+     * Ephemerides of a constellation whose space node is NULL are skipped.
+     *
+     * @param in input stream
+     * @param gps space node for GPS, which also receives ionospheric and UTC parameters
+     * @param qzss space node for QZSS, whose key is PRN (193-)
+     * @param galileo space node for Galileo
+     * @param galileo_key_offset offset added to the satellite number of Galileo
+     * to generate a key of the space node
+     * @return (int) number of registered ephemerides, or negative value when format is invalid
+     */
+    static int read_all(std::istream &in,
+        space_node_t *gps, space_node_t *qzss = NULL,
+        galileo_space_node_t *galileo = NULL, const int &galileo_key_offset = 0){
+      int res(-1);
+      RINEX_NAV_Reader reader(in);
+      if(gps){reader.extract_iono_utc(*gps);}
+      res++;
+      for(; reader.has_next(); ){
+        SatelliteInfo info(reader.next());
+        switch(info.system){
+          case 'G':
+            if(!gps){continue;}
+            gps->satellite(info.svid).register_ephemeris(info.ephemeris);
+            break;
+          case 'J':
+            if(!qzss){continue;}
+            qzss->satellite(info.svid).register_ephemeris(info.ephemeris);
+            break;
+          case 'E':
+            if(!galileo){continue;}
+            galileo->register_ephemeris(info.ephemeris_galileo, galileo_key_offset + info.svid);
+            break;
+          default:
+            continue;
+        }
+        ++res;
       }
       return res;
     }
@@ -392,8 +641,11 @@ class RINEX_OBS_Reader : public RINEX_Reader<> {
           data >> v; // b
           item.t_epoc += v;
           
-          // Receiver clock error
-          std::stringstream(data_line.substr(68)) >> item.receiver_clock_error;
+          // Receiver clock error (optional)
+          item.receiver_clock_error = 0;
+          if(data_line.size() > 68){
+            std::stringstream(data_line.substr(68)) >> item.receiver_clock_error;
+          }
           
           int prn;
           for(int i(0); num_of_followed_data > 0; i++, num_of_followed_data--){
@@ -432,10 +684,14 @@ class RINEX_OBS_Reader : public RINEX_Reader<> {
               data_line = std::string(buf);
             }
             typename ObservedItem::data_t data;
-            std::string s(data_line.substr(offset_index * 16, 16));
+            data.observed = 0;
+            data.lli = data.ss = 0;
+            // trailing blank fields may be omitted
+            std::string s((data_line.size() > offset_index * 16)
+                ? data_line.substr(offset_index * 16, 16)
+                : std::string());
             std::stringstream ss(s);
             ss >> data.observed;
-            data.lli = data.ss = 0;
             if(s.size() >= 15){unsigned i(s[14] - '0'); if(i < 10){data.lli = i;}}
             if(s.size() >= 16){unsigned i(s[15] - '0'); if(i < 10){data.ss = i;}}
             //std::cerr << data.observed << ", " << data.lli << "," << data.ss << std::endl;
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2013, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @file
+ * @brief Explicit instantiation definitions of libninjascan_nav
+ * @see ninjascan_nav.h
+ *
+ * With NINJASCAN_NAV_NO_FLYWEIGHT, libninjascan_nav_no_flyweight is built instead,
+ * @see ninjascan_nav_no_flyweight.h
+ */
+
+#if defined(NINJASCAN_NAV_NO_FLYWEIGHT)
+#include "navigation/ninjascan_nav_no_flyweight.h"
+#endif
+
+#include "param/matrix.h"
+#include "algorithm/kalman.h"
+#include "navigation/GPS.h"
+#include "navigation/GPS_Solver.h"
+#include "navigation/EGM.h"
+#include "navigation/MagneticField.h"
+#include "navigation/INS_GPS_Factory.h"
+
+#define NINJASCAN_NAV_INSTANTIATE
+#include "navigation/ninjascan_nav.h"
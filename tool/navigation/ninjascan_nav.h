@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2013, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @file
+ * @brief Explicit instantiations of the commonly used specializations
+ *
+ * The navigation headers are header-only; each program instantiates
+ * the whole stack of templates it uses. The specializations listed here are instead
+ * compiled once into a library (libninjascan_nav, see navigation/ninjascan_nav.cpp),
+ * including their static coefficient tables, such as EGM2008 and IGRF.
+ *
+ * Usage: include this file after the navigation headers, then define
+ * NINJASCAN_NAV_LIBRARY and link the library.
+ * Without the macro, this file does nothing, and the headers work as before.
+ * Only the specializations of the already included headers are declared,
+ * by checking their include guards.
+ * Because this uses extern template, it requires C++11 or later;
+ * in C++98, everything is instantiated in each translation unit.
+ *
+ * The INS products depend on the layout of Vector3<double> and Quaternion<double>.
+ * A program using them without flyweight, such as INS_GPS.cpp, includes
+ * navigation/ninjascan_nav_no_flyweight.h and links libninjascan_nav_no_flyweight,
+ * whose INS products have the same layouts.
+ * A program specializing Vector3Data_TypeMapper<double> or QuaternionData_TypeMapper<double>
+ * in another way must define NINJASCAN_NAV_WITHOUT_INS before including this file
+ * in order not to mix the layouts.
+ */
+
+#ifndef __NINJASCAN_NAV_H__
+#define __NINJASCAN_NAV_H__
+
+#if defined(NINJASCAN_NAV_INSTANTIATE)
+#define NINJASCAN_NAV_TEMPLATE template
+#elif defined(NINJASCAN_NAV_LIBRARY) && (__cplusplus >= 201103L)
+#define NINJASCAN_NAV_TEMPLATE extern template
+#endif
+
+#if defined(NINJASCAN_NAV_TEMPLATE)
+
+#if defined(__MATRIX_H)
+NINJASCAN_NAV_TEMPLATE class Array2D_Dense<double>;
+NINJASCAN_NAV_TEMPLATE class Matrix_Frozen<double, Array2D_Dense<double> >;
+NINJASCAN_NAV_TEMPLATE class Matrix<double>;
+NINJASCAN_NAV_TEMPLATE class Array2D_Dense<float>;
+NINJASCAN_NAV_TEMPLATE class Matrix_Frozen<float, Array2D_Dense<float> >;
+NINJASCAN_NAV_TEMPLATE class Matrix<float>;
+#endif
+
+#if defined(__GPS_H__)
+NINJASCAN_NAV_TEMPLATE struct GPS_Time<double>;
+NINJASCAN_NAV_TEMPLATE class GPS_SpaceNode<double>;
+#endif
+
+#if defined(__GPS_SOLVER_H__)
+NINJASCAN_NAV_TEMPLATE class GPS_SinglePositioning<double>;
+#endif
+
+#if defined(__EGM_H__)
+NINJASCAN_NAV_TEMPLATE struct EGM_Generic<double>;
+NINJASCAN_NAV_TEMPLATE struct EGM2008_70_Generic<double>;
+#endif
+
+#if defined(__MAGNETIC_FIELD_H__)
+NINJASCAN_NAV_TEMPLATE class MagneticFieldGeneric<double>;
+NINJASCAN_NAV_TEMPLATE struct IGRF11Preset<double>;
+NINJASCAN_NAV_TEMPLATE struct IGRF12Preset<double>;
+NINJASCAN_NAV_TEMPLATE struct IGRF12Generic<double>;
+#endif
+
+#if defined(__INS_GPS_FACTORY_H__) && !defined(NINJASCAN_NAV_WITHOUT_INS)
+// INS_GPS_Factory<>::product, and products with ::egm<> and/or ::bias<>
+NINJASCAN_NAV_TEMPLATE class INS<double>;
+NINJASCAN_NAV_TEMPLATE class INS<float>;
+NINJASCAN_NAV_TEMPLATE class Filtered_INS2<INS<double> >;
+NINJASCAN_NAV_TEMPLATE class INS_GPS2<Filtered_INS2<INS<double> > >;
+NINJASCAN_NAV_TEMPLATE class INS_EGM<INS<double> >;
+NINJASCAN_NAV_TEMPLATE class Filtered_INS2<INS_EGM<INS<double> > >;
+NINJASCAN_NAV_TEMPLATE class INS_GPS2<Filtered_INS2<INS_EGM<INS<double> > > >;
+NINJASCAN_NAV_TEMPLATE class INS_BiasEstimated<INS<double> >;
+NINJASCAN_NAV_TEMPLATE class Filtered_INS2<INS_BiasEstimated<INS<double> > >;
+NINJASCAN_NAV_TEMPLATE class Filtered_INS_BiasEstimated<Filtered_INS2<INS_BiasEstimated<INS<double> > > >;
+NINJASCAN_NAV_TEMPLATE class INS_GPS2<Filtered_INS_BiasEstimated<Filtered_INS2<INS_BiasEstimated<INS<double> > > > >;
+NINJASCAN_NAV_TEMPLATE class INS_GPS_BiasEstimated<INS_GPS2<
+    Filtered_INS_BiasEstimated<Filtered_INS2<INS_BiasEstimated<INS<double> > > > > >;
+#endif
+
+#undef NINJASCAN_NAV_TEMPLATE
+#endif
+
+#endif /* __NINJASCAN_NAV_H__ */
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2013, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @file
+ * @brief Layout of Vector3<double> and Quaternion<double> without flyweight
+ *
+ * A program preferring the layouts without flyweight, such as INS_GPS.cpp, includes this file
+ * before any navigation header, and links libninjascan_nav_no_flyweight
+ * instead of libninjascan_nav. The library is built from navigation/ninjascan_nav.cpp
+ * with NINJASCAN_NAV_NO_FLYWEIGHT defined, therefore the INS products in ninjascan_nav.h
+ * are instantiated with the same layouts as the program.
+ */
+
+#ifndef __NINJASCAN_NAV_NO_FLYWEIGHT_H__
+#define __NINJASCAN_NAV_NO_FLYWEIGHT_H__
+
+#if !defined(NINJASCAN_NAV_NO_FLYWEIGHT)
+#define NINJASCAN_NAV_NO_FLYWEIGHT
+#endif
+
+#include "param/vector3.h"
+#include "param/quaternion.h"
+
+template <>
+struct Vector3Data_TypeMapper<double> {
+  typedef Vector3Data_NoFlyWeight<double> res_t;
+};
+template <>
+struct QuaternionData_TypeMapper<double> {
+  typedef QuaternionData_NoFlyWeight<double> res_t;
+};
+
+#endif /* __NINJASCAN_NAV_NO_FLYWEIGHT_H__ */
@@ -295,8 +295,8 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      * @param array another one
      */
     Array2D_Dense(const self_t &array)
-        : super_t(array.m_rows, array.m_columns){
-      if(values = array.values){(*(ref = array.ref))++;}
+        : super_t(array.m_rows, array.m_columns), values(array.values), ref(NULL) {
+      if(values){(*(ref = array.ref))++;}
     }
     /**
      * Constructor based on another type array, which performs deep copy.
@@ -0,0 +1,311 @@
+/**
+ * @file SWIG interface file for GPS related classes
+ *
+ * Ruby usage example:
+ *   require 'GPS'
+ *   sn = GPS::SpaceNode::new
+ *   sn.read("brdc.nav")
+ *   solver = GPS::SinglePositioning::new(sn)
+ *   res = solver.solve_rinex("rover.obs").unpack("d*")
+ *   res.each_slice(GPS::SinglePositioning::OUTPUT_COLUMNS){|row| ...}
+ */
+
+%module GPS
+
+%include std_string.i
+%include "include/buffer.i"
+
+%{
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+
+#include "navigation/GPS.h"
+#include "navigation/GPS_Solver.h"
+#include "navigation/GPS_Solver_Batch.h"
+#include "navigation/RINEX.h"
+%}
+
+%rename(RINEX_OBS_Reader) RINEX_OBS_Table;
+
+/*
+ * SinglePositioning refers to SpaceNode given to its constructor,
+ * therefore the SpaceNode object of the script is kept alive while the solver is.
+ */
+#if defined(SWIGRUBY)
+%trackobjects SpaceNode;
+%markfunc SinglePositioning "mark_SinglePositioning";
+#endif
+
+%inline %{
+/**
+ * Space segment, which holds ephemerides
+ */
+class SpaceNode {
+  public:
+#ifndef SWIG
+    typedef GPS_SpaceNode<double> space_node_t;
+    space_node_t space_node;
+#endif
+    SpaceNode() : space_node() {}
+
+    /**
+     * Read ephemerides from RINEX navigation file
+     *
+     * @param fname file name
+     * @return (int) number of read ephemerides
+     */
+    int read(const char *fname){
+      std::ifstream in(fname);
+      if(!in){throw std::runtime_error(std::string("Failed to open ") + fname);}
+      return RINEX_NAV_Reader<double>::read_all(in, space_node);
+    }
+    bool has_satellite(const int &prn) const {
+      return space_node.has_satellite(prn);
+    }
+    void update_all_ephemeris(const int &week, const double &seconds){
+      space_node.update_all_ephemeris(space_node_t::gps_time_t(week, seconds));
+    }
+
+    /**
+     * Calculate satellite positions and clock errors at multiple times
+     *
+     * @param prn satellite number
+     * @param buffer pairs of (GPS week, time of week [s])
+     * @return (packed_t) rows of (x, y, z [m], clock error [s]) in ECEF,
+     * which are NaN when no valid ephemeris is available.
+     */
+    packed_t positions(const int &prn, const double *buffer, size_t length){
+      if(length % 2 != 0){throw std::invalid_argument("length of buffer must be even");}
+      packed_t res;
+      res.values.reserve(length * 2);
+      if(!space_node.has_satellite(prn)){
+        res.values.resize(length * 2, std::numeric_limits<double>::quiet_NaN());
+        return res;
+      }
+      space_node_t::Satellite &sat(space_node.satellite(prn));
+      for(size_t i(0); i < length; i += 2){
+        space_node_t::gps_time_t t((int)buffer[i], buffer[i + 1]);
+        if(sat.select_ephemeris(t)){
+          space_node_t::xyz_t pos(sat.position(t));
+          res.push(pos.x());
+          res.push(pos.y());
+          res.push(pos.z());
+          res.push(sat.clock_error(t));
+        }else{
+          res.values.resize(res.values.size() + 4, std::numeric_limits<double>::quiet_NaN());
+        }
+      }
+      return res;
+    }
+};
+
+/**
+ * Single positioning solver processing multiple epochs at once
+ */
+class SinglePositioning {
+  public:
+#ifndef SWIG
+    typedef GPS_Solver_Batch<double> batch_t;
+    typedef batch_t::solver_t solver_t;
+    typedef batch_t::user_pvt_t user_pvt_t;
+    typedef solver_t::measurement_items_t items_t;
+    SpaceNode &space_node;
+    batch_t::options_t options;
+#endif
+    unsigned int threads; ///< number of workers, 0 means the number of cores
+    unsigned int batch_size; ///< number of epochs processed at once
+
+    /**
+     * Number of columns in a result row; (GPS week, time of week [s], error code,
+     * x, y, z [m], receiver clock error [m], latitude, longitude [deg], height [m],
+     * velocity east, north, up [m/s], receiver clock error rate [m/s],
+     * GDOP, PDOP, HDOP, VDOP, TDOP, number of used satellites)
+     */
+    static const unsigned int OUTPUT_COLUMNS = 20;
+    /**
+     * Number of columns in a measurement row; (GPS week, time of week [s], PRN,
+     * L1 pseudorange [m], L1 Doppler [Hz]), where a missing value is zero or NaN.
+     */
+    static const unsigned int INPUT_COLUMNS = 5;
+
+    /**
+     * @param sn space node, which is referred to (not copied) during the lifetime of the solver,
+     * therefore ephemerides read afterward are also used.
+     */
+    SinglePositioning(SpaceNode &sn)
+        : space_node(sn), options(), threads(0), batch_size(0x1000) {}
+
+    void set_elevation_mask_deg(const double &deg){
+      options.elevation_mask = deg / 180 * M_PI;
+    }
+    double get_elevation_mask_deg() const {
+      return options.elevation_mask / M_PI * 180;
+    }
+
+#ifndef SWIG
+    static void append(packed_t &res, const user_pvt_t &pvt){
+      res.push(pvt.receiver_time.week);
+      res.push(pvt.receiver_time.seconds);
+      res.push(pvt.error_code);
+      res.push(pvt.user_position.xyz.x());
+      res.push(pvt.user_position.xyz.y());
+      res.push(pvt.user_position.xyz.z());
+      res.push(pvt.receiver_error);
+      res.push(pvt.user_position.llh.latitude() / M_PI * 180);
+      res.push(pvt.user_position.llh.longitude() / M_PI * 180);
+      res.push(pvt.user_position.llh.height());
+      res.push(pvt.user_velocity_enu.east());
+      res.push(pvt.user_velocity_enu.north());
+      res.push(pvt.user_velocity_enu.up());
+      res.push(pvt.receiver_error_rate);
+      res.push(pvt.gdop);
+      res.push(pvt.pdop);
+      res.push(pvt.hdop);
+      res.push(pvt.vdop);
+      res.push(pvt.tdop);
+      res.push(pvt.used_satellites);
+    }
+
+    struct collector_t {
+      packed_t &res;
+      void operator()(const batch_t::epoch_t &epoch, const user_pvt_t &pvt){
+        append(res, pvt);
+      }
+    };
+
+    unsigned int workers() const {
+      return (threads > 0) ? threads : batch_t::concurrency();
+    }
+#endif
+
+    /**
+     * Solve epochs given as a measurement table
+     *
+     * @param buffer rows of INPUT_COLUMNS values, where rows of the same epoch are contiguous
+     * @return (packed_t) rows of OUTPUT_COLUMNS values for each epoch
+     */
+    packed_t solve(const double *buffer, size_t length){
+      if(length % INPUT_COLUMNS != 0){
+        throw std::invalid_argument("length of buffer must be a multiple of INPUT_COLUMNS");
+      }
+      batch_t batch(space_node.space_node, options);
+      std::vector<batch_t::epoch_t> epochs;
+      for(const double *row(buffer), *row_end(buffer + length);
+          row != row_end; row += INPUT_COLUMNS){
+        solver_t::gps_time_t t((int)row[0], row[1]);
+        if(epochs.empty() || (epochs.back().t != t)){
+          epochs.push_back(batch_t::epoch_t());
+          epochs.back().t = t;
+        }
+        int prn((int)row[2]);
+        if(row[3] != 0 && row[3] == row[3]){
+          epochs.back().measurement[prn].insert(std::make_pair((int)items_t::L1_PSEUDORANGE, row[3]));
+        }
+        if(row[4] != 0 && row[4] == row[4]){
+          epochs.back().measurement[prn].insert(std::make_pair((int)items_t::L1_DOPPLER, row[4]));
+        }
+      }
+      std::vector<user_pvt_t> pvt;
+      batch.threads = workers();
+      batch.solve(epochs, pvt);
+      packed_t res;
+      res.values.reserve(pvt.size() * OUTPUT_COLUMNS);
+      for(unsigned int i(0); i < pvt.size(); ++i){append(res, pvt[i]);}
+      return res;
+    }
+
+    /**
+     * Solve all epochs in a RINEX observation file
+     *
+     * @param fname file name
+     * @return (packed_t) rows of OUTPUT_COLUMNS values for each epoch
+     */
+    packed_t solve_rinex(const char *fname){
+      std::ifstream in(fname);
+      if(!in){throw std::runtime_error(std::string("Failed to open ") + fname);}
+      RINEX_OBS_Reader<double> reader(in);
+      batch_t batch(space_node.space_node, options);
+      batch.threads = workers();
+      batch.batch_size = batch_size;
+      packed_t res;
+      collector_t collector = {res};
+      batch.run(reader, collector);
+      return res;
+    }
+};
+
+/**
+ * RINEX observation file reader, which converts observations into a table
+ */
+class RINEX_OBS_Table {
+  public:
+#ifndef SWIG
+    typedef RINEX_OBS_Reader<double> reader_t;
+    std::ifstream in;
+    reader_t reader;
+#endif
+    RINEX_OBS_Table(const char *fname) : in(fname), reader(in) {
+      if(!in){throw std::runtime_error(std::string("Failed to open ") + fname);}
+    }
+    bool has_next() const {return reader.has_next();}
+    int observed_index(const char *label) const {return reader.observed_index(label);}
+
+    /**
+     * Read multiple epochs
+     *
+     * @param labels comma separated observation types such as "C1,L1,D1"
+     * @param max_epochs maximum number of epochs to be read, 0 means all
+     * @return (packed_t) rows of (GPS week, time of week [s], satellite number,
+     * values of the observation types), where a missing value is NaN.
+     * The satellite number follows RINEX_OBS_Reader; e.g., 1-32 for GPS, +100 for SBAS.
+     */
+    packed_t read(const char *labels, const unsigned int &max_epochs = 0){
+      std::vector<int> indices;
+      {
+        std::stringstream ss(labels);
+        std::string label;
+        while(std::getline(ss, label, ',')){indices.push_back(reader.observed_index(label));}
+      }
+      packed_t res;
+      for(unsigned int epochs(0);
+          reader.has_next() && ((max_epochs == 0) || (epochs < max_epochs)); ){
+        reader_t::ObservedItem item(reader.next());
+        if(item.event_flag >= 2){continue;}
+        ++epochs;
+        for(reader_t::ObservedItem::sat_data_t::const_iterator it(item.sat_data.begin());
+            it != item.sat_data.end(); ++it){
+          res.push(item.t_epoc.week);
+          res.push(item.t_epoc.seconds);
+          res.push(it->first);
+          for(unsigned int i(0); i < indices.size(); ++i){
+            double v((indices[i] >= 0) && (indices[i] < (int)it->second.size())
+                ? it->second[indices[i]].observed : 0);
+            res.push((v != 0) ? v : std::numeric_limits<double>::quiet_NaN());
+          }
+        }
+      }
+      return res;
+    }
+};
+%}
+
+#if defined(SWIGRUBY)
+%{
+static void mark_SinglePositioning(void *ptr){
+  VALUE space_node(SWIG_RubyInstanceFor(&((SinglePositioning *)ptr)->space_node));
+  if(!NIL_P(space_node)){rb_gc_mark(space_node);}
+}
+%}
+#elif defined(SWIGPYTHON)
+%pythoncode %{
+def _SinglePositioning_init(self, sn, _init=SinglePositioning.__init__):
+    _init(self, sn)
+    self._space_node = sn # reference to keep sn alive
+SinglePositioning.__init__ = _SinglePositioning_init
+%}
+#endif
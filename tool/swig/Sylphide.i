@@ -0,0 +1,263 @@
+/**
+ * @file SWIG interface file for decoder of NinjaScan log pages
+ *
+ * Ruby usage example:
+ *   require 'Sylphide'
+ *   dec = Sylphide::PageDecoder::new
+ *   open("log.dat", "rb"){|io|
+ *     while (chunk = io.read(0x10000))
+ *       dec.decode(chunk)
+ *     end
+ *   }
+ *   a = dec.fetch('A').unpack("d*").each_slice(Sylphide::PageDecoder::columns('A')).to_a
+ */
+
+%module Sylphide
+
+%include "include/buffer.i"
+
+%{
+#include <string>
+
+#include "SylphideProcessor.h"
+%}
+
+%inline %{
+/**
+ * Decoder of 32 bytes pages, each of which begins with its type character.
+ * Decoded values are accumulated for each type until they are fetched.
+ */
+class PageDecoder {
+  public:
+#ifndef SWIG
+    typedef SylphideProcessor<double> proc_t;
+    proc_t::A_Observer_t a;
+    proc_t::M_Observer_t m;
+    proc_t::P_Observer_t p;
+    proc_t::N_Observer_t n;
+    proc_t::F_Observer_t f;
+    proc_t::S_Observer_t s;
+    proc_t::I_Observer_t i;
+    proc_t::G_Observer_t g;
+    bool g_seek_next;
+    packed_t a_values, m_values, p_values, n_values,
+        f_values, s_values, i_values, g_values;
+    std::string remainder;
+    unsigned long _skipped;
+
+    template <class Observer>
+    static void feed(Observer &observer, const char *page){
+      observer.write(const_cast<char *>(page) + 1, SYLPHIDE_PAGE_SIZE - 1);
+    }
+    void fetch_solution(){
+      if(!g.validate()){return;}
+      if(!g.packet_type().equals(0x01, 0x06)){return;} // NAV-SOL only
+      proc_t::G_Observer_t::solution_t solution(g.fetch_solution());
+      const double values[] = {
+        g.fetch_ITOW(), (double)solution.week,
+        (double)solution.fix_type, (double)solution.status_flags,
+        1E-2 * solution.position_ecef_cm[0],
+        1E-2 * solution.position_ecef_cm[1],
+        1E-2 * solution.position_ecef_cm[2],
+        1E-2 * solution.position_ecef_acc_cm,
+        1E-2 * solution.velocity_ecef_cm_s[0],
+        1E-2 * solution.velocity_ecef_cm_s[1],
+        1E-2 * solution.velocity_ecef_cm_s[2],
+        1E-2 * solution.velocity_ecef_acc_cm_s,
+        (double)solution.satellites_used,
+      };
+      g_values.values.insert(g_values.values.end(),
+          values, values + (sizeof(values) / sizeof(values[0])));
+    }
+    void decode_page(const char *page){
+      switch(page[0]){
+        case 'A': {
+          feed(a, page);
+          proc_t::A_Observer_t::values_t values(a.fetch_values());
+          a_values.push(a.fetch_ITOW());
+          for(int i(0); i < 8; ++i){a_values.push(values.values[i]);}
+          a_values.push(values.temperature);
+          a.seek_next();
+          break;
+        }
+        case 'M': {
+          feed(m, page);
+          proc_t::M_Observer_t::values_t values(m.fetch_values());
+          m_values.push(m.fetch_ITOW());
+          for(int i(0); i < 4; ++i){m_values.push(values.x[i]);}
+          for(int i(0); i < 4; ++i){m_values.push(values.y[i]);}
+          for(int i(0); i < 4; ++i){m_values.push(values.z[i]);}
+          m.seek_next();
+          break;
+        }
+        case 'P': {
+          feed(p, page);
+          proc_t::P_Observer_t::values_t values(p.fetch_values());
+          p_values.push(p.fetch_ITOW());
+          for(int i(0); i < 4; ++i){p_values.push(values.air_speed[i]);}
+          for(int i(0); i < 4; ++i){p_values.push(values.air_alpha[i]);}
+          for(int i(0); i < 4; ++i){p_values.push(values.air_beta[i]);}
+          p.seek_next();
+          break;
+        }
+        case 'N': {
+          feed(n, page);
+          proc_t::N_Observer_t::navdata_t nav(n.fetch_navdata());
+          const double values[] = {
+            nav.itow,
+            nav.latitude, nav.longitude, nav.altitude,
+            nav.v_north, nav.v_east, nav.v_down,
+            nav.heading, nav.pitch, nav.roll,
+          };
+          n_values.values.insert(n_values.values.end(),
+              values, values + (sizeof(values) / sizeof(values[0])));
+          n.seek_next();
+          break;
+        }
+        case 'F': {
+          feed(f, page);
+          proc_t::F_Observer_t::values_t values(f.fetch_values());
+          f_values.push(f.fetch_ITOW());
+          for(int i(0); i < 8; ++i){f_values.push(values.servo_in[i]);}
+          for(int i(0); i < 8; ++i){f_values.push(values.servo_out[i]);}
+          f.seek_next();
+          break;
+        }
+        case 'S': {
+          feed(s, page);
+          proc_t::S_Observer_t::values_t values(s.fetch_values());
+          const double row[] = {
+            s.fetch_ITOW(),
+            (double)values.segments, (double)values.flush_watermark,
+            (double)values.accepted, (double)values.refused, (double)values.lost,
+            (double)values.high_water, (double)values.pages, (double)values.max_flush_ms,
+          };
+          s_values.values.insert(s_values.values.end(),
+              row, row + (sizeof(row) / sizeof(row[0])));
+          s.seek_next();
+          break;
+        }
+        case 'I': {
+          feed(i, page);
+          proc_t::I_Observer_t::values_t values(i.fetch_values());
+          double itow(i.fetch_ITOW());
+          for(unsigned int j(0); j < values.samples; ++j){ // one row per sample
+            i_values.push(itow + values.time_offset(j));
+            for(int k(0); k < 6; ++k){i_values.push(values.values[j][k]);}
+            i_values.push(values.temperature);
+          }
+          i.seek_next();
+          break;
+        }
+        case 'G': {
+          // u-blox packets lie across pages, the same as AbstractSylphideProcessor::process_raw
+          feed(g, page);
+          if(!g_seek_next){
+            if(g.ready()){fetch_solution();}
+            g_seek_next = g.seek_next();
+          }
+          while(g_seek_next && g.ready()){
+            fetch_solution();
+            g_seek_next = g.seek_next();
+          }
+          break;
+        }
+        default:
+          ++_skipped;
+      }
+    }
+    packed_t *target(const char *type){
+      switch(type[0]){
+        case 'A': return &a_values;
+        case 'M': return &m_values;
+        case 'P': return &p_values;
+        case 'N': return &n_values;
+        case 'F': return &f_values;
+        case 'S': return &s_values;
+        case 'I': return &i_values;
+        case 'G': return &g_values;
+      }
+      throw std::invalid_argument(std::string("Unsupported page type: ") + type);
+    }
+#endif
+
+    PageDecoder()
+        : a(SYLPHIDE_PAGE_SIZE * 2), m(SYLPHIDE_PAGE_SIZE * 2),
+        p(SYLPHIDE_PAGE_SIZE * 2), n(SYLPHIDE_PAGE_SIZE * 2),
+        f(SYLPHIDE_PAGE_SIZE * 2), s(SYLPHIDE_PAGE_SIZE * 2),
+        i(SYLPHIDE_PAGE_SIZE * 2), g(SYLPHIDE_PAGE_SIZE * 32), g_seek_next(false),
+        a_values(), m_values(), p_values(), n_values(),
+        f_values(), s_values(), i_values(), g_values(),
+        remainder(), _skipped(0) {}
+
+    /**
+     * Decode pages. A trailing incomplete page is kept and joined to the next input.
+     *
+     * @param bytes log data
+     * @return (unsigned long) number of decoded pages including unsupported ones
+     */
+    unsigned long decode(const char *bytes, size_t length){
+      unsigned long res(0);
+      if(!remainder.empty()){
+        size_t fill(SYLPHIDE_PAGE_SIZE - remainder.size());
+        if(fill > length){fill = length;}
+        remainder.append(bytes, fill);
+        bytes += fill;
+        length -= fill;
+        if(remainder.size() < SYLPHIDE_PAGE_SIZE){return res;}
+        decode_page(remainder.data());
+        remainder.clear();
+        ++res;
+      }
+      for(; length >= SYLPHIDE_PAGE_SIZE;
+          bytes += SYLPHIDE_PAGE_SIZE, length -= SYLPHIDE_PAGE_SIZE, ++res){
+        decode_page(bytes);
+      }
+      remainder.assign(bytes, length);
+      return res;
+    }
+
+    /**
+     * Number of columns of decoded values
+     *
+     * @param type page type
+     * @return (unsigned int) 'A': (time [s], 8 raw values, temperature);
+     * 'M': (time [s], x[4], y[4], z[4]); 'P': (time [s], speed[4], alpha[4], beta[4]);
+     * 'N': (time [s], latitude, longitude [deg], altitude [m],
+     * velocity north, east, down [m/s], heading, pitch, roll [deg]);
+     * 'F': (time [s], servo_in[8], servo_out[8]);
+     * 'S': (time [s], segments, flush watermark, accepted, refused, lost,
+     * high water, pages, max flush time [ms]);
+     * 'I': (time of the sample [s], accelerometer XYZ, gyro XYZ, temperature) in the raw format of 'A';
+     * 'G': (time [s], GPS week, fix type, status flags, x, y, z [m], position accuracy [m],
+     * vx, vy, vz [m/s], velocity accuracy [m/s], number of used satellites) from u-blox NAV-SOL
+     */
+    static unsigned int columns(const char *type){
+      switch(type[0]){
+        case 'A': case 'N': return 10;
+        case 'M': case 'P': case 'G': return 13;
+        case 'F': return 17;
+        case 'S': return 9;
+        case 'I': return 8;
+      }
+      throw std::invalid_argument(std::string("Unsupported page type: ") + type);
+    }
+
+    /**
+     * Take decoded values out
+     *
+     * @param type page type; 'A', 'M', 'P', 'N', 'F', 'S', 'I', or 'G'
+     * @return (packed_t) rows of values, whose number of columns is columns(type)
+     */
+    packed_t fetch(const char *type){
+      packed_t res;
+      res.values.swap(target(type)->values);
+      return res;
+    }
+
+    /**
+     * @return (unsigned long) number of pages whose type is not supported
+     */
+    unsigned long skipped() const {return _skipped;}
+};
+%}
@@ -0,0 +1,132 @@
+/**
+ * @file SWIG interface file for matrix
+ *
+ * Ruby usage example:
+ *   require 'SylphideMath'
+ *   m = SylphideMath::Matrix::new(3, 3, [1, 0, 0, 0, 2, 0, 0, 0, 3].pack("d*"))
+ *   vectors = m.inverse.map(xyz_array.pack("d*")).unpack("d*")
+ */
+
+%module SylphideMath
+
+%include "include/buffer.i"
+
+%{
+#include "param/matrix.h"
+
+typedef Matrix<double> Matrix_d;
+%}
+
+%rename(Matrix) Matrix_d;
+#if defined(SWIGRUBY)
+%rename("[]") Matrix_d::get;
+%rename("[]=") Matrix_d::set;
+%rename("+") Matrix_d::__add__;
+%rename("-") Matrix_d::__sub__;
+%rename("*") Matrix_d::__mul__;
+#endif
+
+/*
+ * Only a part of Matrix<double> is declared, because its expression templates
+ * are not suitable to be parsed by SWIG; results of operations are evaluated in C++.
+ */
+class Matrix_d {
+  public:
+    Matrix_d(const unsigned int &rows, const unsigned int &columns);
+    ~Matrix_d();
+    unsigned int rows() const;
+    unsigned int columns() const;
+};
+
+%extend Matrix_d {
+  /**
+   * Constructor with values
+   *
+   * @param buffer row-major values, whose length is rows * columns
+   */
+  Matrix_d(const unsigned int &rows, const unsigned int &columns,
+      const double *buffer, size_t length){
+    if(length != (size_t)rows * columns){
+      throw std::invalid_argument("length of buffer must be rows * columns");
+    }
+    return new Matrix_d(rows, columns, buffer);
+  }
+
+  double get(const unsigned int &row, const unsigned int &column) const {
+    if((row >= $self->rows()) || (column >= $self->columns())){
+      throw std::out_of_range("index out of range");
+    }
+    return (*$self)(row, column);
+  }
+  void set(const unsigned int &row, const unsigned int &column, const double &value){
+    if((row >= $self->rows()) || (column >= $self->columns())){
+      throw std::out_of_range("index out of range");
+    }
+    (*$self)(row, column) = value;
+  }
+
+  /**
+   * @return (packed_t) row-major values
+   */
+  packed_t to_buffer() const {
+    packed_t res;
+    res.values.reserve($self->rows() * $self->columns());
+    for(unsigned int i(0); i < $self->rows(); ++i){
+      for(unsigned int j(0); j < $self->columns(); ++j){
+        res.push((*$self)(i, j));
+      }
+    }
+    return res;
+  }
+
+  Matrix_d copy() const {return $self->copy();}
+  Matrix_d transpose() const {return $self->transpose().copy();}
+  Matrix_d inverse() const {return $self->inverse();}
+  Matrix_d __add__(const Matrix_d &another) const {
+    if(($self->rows() != another.rows()) || ($self->columns() != another.columns())){
+      throw std::invalid_argument("incompatible size");
+    }
+    return *$self + another;
+  }
+  Matrix_d __sub__(const Matrix_d &another) const {
+    if(($self->rows() != another.rows()) || ($self->columns() != another.columns())){
+      throw std::invalid_argument("incompatible size");
+    }
+    return *$self - another;
+  }
+  Matrix_d __mul__(const Matrix_d &another) const {
+    if($self->columns() != another.rows()){
+      throw std::invalid_argument("incompatible size");
+    }
+    return *$self * another;
+  }
+  Matrix_d __mul__(const double &scalar) const {
+    return *$self * scalar;
+  }
+
+  /**
+   * Multiply multiple column vectors at once, which is equivalent to
+   * (this * [v_0, v_1, ...]) in column-major order without temporary matrices.
+   *
+   * @param buffer vectors, each of which has columns() values
+   * @return (packed_t) vectors, each of which has rows() values
+   */
+  packed_t map(const double *buffer, size_t length) const {
+    const unsigned int rows($self->rows()), columns($self->columns());
+    if((columns == 0) || (length % columns != 0)){
+      throw std::invalid_argument("length of buffer must be a multiple of columns");
+    }
+    packed_t res;
+    res.values.resize(length / columns * rows);
+    double *dst(res.values.empty() ? NULL : &res.values[0]);
+    for(const double *src(buffer), *src_end(buffer + length);
+        src != src_end; src += columns, dst += rows){
+      for(unsigned int i(0); i < rows; ++i){
+        double v(0);
+        for(unsigned int j(0); j < columns; ++j){v += (*$self)(i, j) * src[j];}
+        dst[i] = v;
+      }
+    }
+    return res;
+  }
+};
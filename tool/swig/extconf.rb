@@ -0,0 +1,11 @@
+# Template of extconf.rb for SWIG extensions;
+# "create_makefile(<package>)" is appended to its copy by makefile.
+
+require 'mkmf'
+
+# This file is copied to build_SWIG/<package>/, therefore the tool directory is three levels up.
+TOOL_DIR = File::expand_path(File::join(File::dirname(__FILE__), '..', '..', '..'))
+$INCFLAGS << " -I#{TOOL_DIR}"
+$CXXFLAGS << " -O2 -Wno-unused-variable -Wno-unused-function"
+have_library('stdc++')
+have_library('pthread')
@@ -0,0 +1,149 @@
+/**
+ * @file SWIG typemaps for contiguous numeric arrays
+ *
+ * Batch entry points exchange arrays of double in the native byte order
+ * instead of calling per element.
+ *
+ * Input (const double *buffer, size_t length) accepts
+ *   Ruby: String (e.g. [...].pack("d*"), NArray#to_s),
+ *     an object having to_binary (e.g. Numo::DFloat), or Array of Numeric.
+ *   Python: an object supporting the buffer protocol (e.g. bytes, array.array('d'),
+ *     numpy.ndarray of float64), or sequence of float.
+ * Binary data is used in place when it is aligned for double, otherwise copied,
+ * because its address depends on the script (e.g. a substring such as str[1..-1]).
+ *
+ * Output packed_t is returned as
+ *   Ruby: String, which can be converted with unpack("d*"),
+ *     NArray.to_na(str, NArray::DFLOAT) or Numo::DFloat.from_binary(str).
+ *   Python: bytes, which can be converted with numpy.frombuffer(b) or array.array('d', b).
+ */
+
+%include exception.i
+
+%{
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Array of double to be returned to scripts; rows are contiguous
+ * when it represents a table, whose number of columns is documented by each method.
+ */
+struct packed_t {
+  std::vector<double> values;
+  packed_t() : values() {}
+  void push(const double &v){values.push_back(v);}
+};
+
+/**
+ * Obtain an aligned array of double from binary data
+ *
+ * @param data binary data, whose length is a multiple of sizeof(double)
+ * @param length number of double
+ * @param temp storage used only when data is not aligned
+ * @return data itself, or its copy in temp
+ */
+static const double *aligned_doubles(
+    const void *data, const std::size_t &length, std::vector<double> &temp){
+  if(((std::size_t)data % sizeof(double)) == 0){return (const double *)data;}
+  temp.resize(length);
+  if(length > 0){std::memcpy(&temp[0], data, sizeof(double) * length);}
+  return temp.empty() ? NULL : &temp[0];
+}
+%}
+
+#if defined(SWIGRUBY)
+
+%typemap(in) (const double *buffer, size_t length) (std::vector<double> temp) {
+  VALUE obj($input);
+  if((TYPE(obj) != T_STRING) && (TYPE(obj) != T_ARRAY)
+      && rb_respond_to(obj, rb_intern("to_binary"))){
+    obj = rb_funcall(obj, rb_intern("to_binary"), 0);
+  }
+  if(TYPE(obj) == T_STRING){
+    if(RSTRING_LEN(obj) % sizeof(double) != 0){
+      SWIG_exception(SWIG_ValueError, "length of buffer is not a multiple of sizeof(double)");
+    }
+    $2 = RSTRING_LEN(obj) / sizeof(double);
+    $1 = aligned_doubles(RSTRING_PTR(obj), $2, temp);
+  }else if(TYPE(obj) == T_ARRAY){
+    temp.resize(RARRAY_LEN(obj));
+    for(std::size_t i(0); i < temp.size(); ++i){
+      temp[i] = NUM2DBL(rb_ary_entry(obj, i));
+    }
+    $1 = temp.empty() ? NULL : &temp[0];
+    $2 = temp.size();
+  }else{
+    SWIG_exception(SWIG_TypeError, "String or Array is expected");
+  }
+}
+%typemap(typecheck, precedence=SWIG_TYPECHECK_DOUBLE_ARRAY) (const double *buffer, size_t length) {
+  $1 = (TYPE($input) == T_STRING) || (TYPE($input) == T_ARRAY)
+      || rb_respond_to($input, rb_intern("to_binary"));
+}
+
+%typemap(out) packed_t {
+  const std::vector<double> &values((&$1)->values);
+  $result = rb_str_new(
+      values.empty() ? NULL : (const char *)&values[0],
+      sizeof(double) * values.size());
+}
+
+#elif defined(SWIGPYTHON)
+
+%typemap(arginit) (const double *buffer, size_t length) {
+  view$argnum.obj = NULL;
+}
+%typemap(in) (const double *buffer, size_t length) (Py_buffer view, std::vector<double> temp) {
+  if(PyObject_CheckBuffer($input)){
+    if(PyObject_GetBuffer($input, &view, PyBUF_C_CONTIGUOUS) != 0){SWIG_fail;}
+    if(view.len % sizeof(double) != 0){
+      SWIG_exception_fail(SWIG_ValueError, "length of buffer is not a multiple of sizeof(double)");
+    }
+    $2 = view.len / sizeof(double);
+    $1 = aligned_doubles(view.buf, $2, temp);
+  }else if(PySequence_Check($input)){
+    temp.resize(PySequence_Size($input));
+    for(std::size_t i(0); i < temp.size(); ++i){
+      PyObject *item(PySequence_GetItem($input, i));
+      temp[i] = PyFloat_AsDouble(item);
+      Py_XDECREF(item);
+      if(PyErr_Occurred()){SWIG_fail;}
+    }
+    $1 = temp.empty() ? NULL : &temp[0];
+    $2 = temp.size();
+  }else{
+    SWIG_exception_fail(SWIG_TypeError, "buffer or sequence is expected");
+  }
+}
+%typemap(freearg) (const double *buffer, size_t length) {
+  if(view$argnum.obj){PyBuffer_Release(&view$argnum);}
+}
+%typemap(typecheck, precedence=SWIG_TYPECHECK_DOUBLE_ARRAY) (const double *buffer, size_t length) {
+  $1 = PyObject_CheckBuffer($input) || PySequence_Check($input);
+}
+
+%typemap(out) packed_t {
+  const std::vector<double> &values((&$1)->values);
+  $result = PyBytes_FromStringAndSize(
+      values.empty() ? NULL : (const char *)&values[0],
+      sizeof(double) * values.size());
+}
+
+#endif
+
+// raw bytes, such as log pages, are passed with the built-in (char *STRING, size_t LENGTH) typemap
+%apply (char *STRING, size_t LENGTH) {(const char *bytes, size_t length)};
+
+%exception {
+  try{
+    $action
+  }catch(const std::invalid_argument &e){
+    SWIG_exception(SWIG_ValueError, e.what());
+  }catch(const std::out_of_range &e){
+    SWIG_exception(SWIG_IndexError, e.what());
+  }catch(const std::exception &e){
+    SWIG_exception(SWIG_RuntimeError, e.what());
+  }
+}
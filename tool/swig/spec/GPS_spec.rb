@@ -0,0 +1,71 @@
+# Round-trip specs of GPS extension with synthetic RINEX files in data/,
+# whose observations are generated for a static receiver having 1234.5 [m] clock error.
+
+require 'GPS'
+
+describe GPS do
+  let(:nav){File::join(File::dirname(__FILE__), 'data', 'synthetic.nav')}
+  let(:obs){File::join(File::dirname(__FILE__), 'data', 'synthetic.obs')}
+  let(:receiver){[-3947515.0671, 3431522.4952, 3637924.2670]}
+  let(:space_node){
+    sn = GPS::SpaceNode::new
+    expect(sn.read(nav)).to eq(32)
+    sn
+  }
+  let(:columns){GPS::SinglePositioning::OUTPUT_COLUMNS}
+
+  def check_solutions(rows)
+    expect(rows.size).to eq(5)
+    rows.each_with_index{|row, i|
+      expect(row[0..1]).to eq([2000, 7800 + 30 * i])
+      expect((1..6).include?(row[2].to_i)).to be(false) # position is solved
+      expect(Math::sqrt(row[3..5].zip(receiver).collect{|a, b| (a - b) ** 2}.inject(:+))).to be < 1E-1
+      expect(row[6]).to be_within(1E-1).of(1234.5)
+    }
+  end
+
+  it 'calculates satellite positions at multiple times' do
+    times = [[2000, 7200], [2000, 7800], [2100, 0]] # the last one is out of fit interval
+    pos = space_node.positions(1, times.flatten).unpack("d*").each_slice(4).to_a
+    expect(pos.size).to eq(3)
+    pos[0..1].each{|x, y, z, clk|
+      expect(Math::sqrt(x ** 2 + y ** 2 + z ** 2)).to be_within(1E6).of(5153.6 ** 2)
+    }
+    expect(pos[2].all?{|v| v.nan?}).to be(true)
+    expect(space_node.positions(33, times.flatten).unpack("d*").all?{|v| v.nan?}).to be(true)
+  end
+
+  it 'accepts binary data regardless of its alignment' do
+    times = [2000, 7800, 2000, 7830].pack("d*")
+    expected = space_node.positions(2, times)
+    (1..7).each{|offset|
+      shifted = ("\0" * offset + times)[offset..-1] # substring may share the buffer with an offset
+      expect(space_node.positions(2, shifted)).to eq(expected)
+    }
+    expect{space_node.positions(2, times[0..-2])}.to raise_error(ArgumentError)
+  end
+
+  it 'solves a RINEX observation file' do
+    solver = GPS::SinglePositioning::new(space_node)
+    check_solutions(solver.solve_rinex(obs).unpack("d*").each_slice(columns).to_a)
+  end
+
+  it 'solves observations read by RINEX_OBS_Reader as the RINEX file' do
+    solver = GPS::SinglePositioning::new(space_node)
+    table = GPS::RINEX_OBS_Reader::new(obs).read("C1").unpack("d*").each_slice(4).collect{|row|
+      row + [0] # without Doppler
+    }
+    expect(table.size).to eq(40)
+    res = solver.solve(table.flatten).unpack("d*").each_slice(columns).to_a
+    check_solutions(res)
+    expect(res.flatten.pack("d*")).to eq(solver.solve_rinex(obs))
+  end
+
+  it 'keeps SpaceNode alive while SinglePositioning refers to it' do
+    solver = GPS::SinglePositioning::new(GPS::SpaceNode::new.tap{|sn| sn.read(nav)})
+    GC.start
+    GPS::SpaceNode::new # reuse freed memory if any
+    GC.start
+    check_solutions(solver.solve_rinex(obs).unpack("d*").each_slice(columns).to_a)
+  end
+end
@@ -0,0 +1,36 @@
+# Round-trip specs of SylphideMath extension
+
+require 'SylphideMath'
+
+describe SylphideMath::Matrix do
+  let(:values){[4, 1, 2, 1, 3, 0, 2, 0, 5]}
+  let(:mat){SylphideMath::Matrix::new(3, 3, values.pack("d*"))}
+
+  it 'is constructed from String, Array, and unaligned String' do
+    expect(mat.to_buffer.unpack("d*")).to eq(values)
+    expect(SylphideMath::Matrix::new(3, 3, values).to_buffer).to eq(mat.to_buffer)
+    packed = values.pack("d*")
+    (1..7).each{|offset|
+      shifted = ("\0" * offset + packed)[offset..-1]
+      expect(SylphideMath::Matrix::new(3, 3, shifted).to_buffer).to eq(mat.to_buffer)
+    }
+    expect{SylphideMath::Matrix::new(3, 3, values[0..-2])}.to raise_error(ArgumentError)
+  end
+
+  it 'accesses elements' do
+    expect(mat[1, 0]).to eq(1)
+    mat[1, 0] = 7
+    expect(mat[1, 0]).to eq(7)
+    expect{mat[3, 0]}.to raise_error(IndexError)
+  end
+
+  it 'maps vectors at once' do
+    vectors = [[1, 0, 0], [0, 1, 0], [1, 2, 3]]
+    res = mat.map(vectors.flatten.pack("d*")).unpack("d*").each_slice(3).to_a
+    vectors.zip(res).each{|v, r|
+      expect(r).to eq((0...3).collect{|i| (0...3).collect{|j| values[i * 3 + j] * v[j]}.inject(:+)})
+    }
+    identity = (mat * mat.inverse).to_buffer.unpack("d*")
+    identity.each_with_index{|v, i| expect(v).to be_within(1E-12).of((i % 4 == 0) ? 1 : 0)}
+  end
+end
@@ -0,0 +1,104 @@
+# Round-trip specs of Sylphide extension; pages are packed here, then decoded by the extension.
+
+require 'Sylphide'
+
+describe Sylphide::PageDecoder do
+  def page(type, payload) # a page is 32 bytes beginning with its type
+    (type + payload).b.ljust(32, "\0".b)[0, 32]
+  end
+
+  # Data24Bytes layout: 2 bytes of header, 1 sequence byte, ITOW [ms] in LE, then 24 bytes of data
+  def page24(type, header, itow_ms, data)
+    page(type, (header + [0, itow_ms].pack("CV") + data).b)
+  end
+
+  def ubx(klass, id, payload)
+    body = [klass, id, payload.size].pack("CCv") + payload
+    ck_a, ck_b = body.bytes.inject([0, 0]){|(a, b), c| a = (a + c) & 0xFF; [a, (b + a) & 0xFF]}
+    [0xB5, 0x62].pack("C*") + body + [ck_a, ck_b].pack("C*")
+  end
+
+  let(:decoder){Sylphide::PageDecoder::new}
+  let(:a_values){[0x123456, 0x800000, 0x7FFFFF, 0, 1, 2, 3, 0xFFFFFF]}
+  let(:a_page){
+    page('A', [0, 12_345].pack("CV") \
+        + a_values.collect{|v| [v].pack("N")[1, 3]}.join \
+        + [0x1234].pack("v"))
+  }
+  let(:s_values){[10, 4, 1000, 2, 1, 7, 12, 35]}
+  let(:s_page){
+    page24('S', s_values[0, 2].pack("C2"), 20_000,
+        s_values[2, 3].pack("V3") + s_values[5, 2].pack("C2") + [s_values[7]].pack("v"))
+  }
+  let(:i_samples){[[1, 2, 3, 4, 5, 6], [0x8000, 0xFFFF, 0, 0x1234, 0x5678, 0x9ABC]]}
+  let(:i_page){ # 2 samples of 10 ms interval
+    page24('I', [(2 << 6) | (10 - 1), 0x56].pack("C2"), 30_010, i_samples.flatten.pack("n*"))
+  }
+  let(:solution){ # NAV-SOL
+    {:itow => 40_000, :week => 2000, :fix => 3, :flags => 0x0D,
+      :pos => [-394751507, 343152250, 363792427], :p_acc => 250,
+      :vel => [-12, 34, -56], :s_acc => 20, :sv => 9}
+  }
+  let(:nav_sol){
+    s = solution
+    ubx(0x01, 0x06, [s[:itow], 0, s[:week], s[:fix], s[:flags]].pack("Vl<vCC") \
+        + (s[:pos] + [s[:p_acc]] + s[:vel] + [s[:s_acc]]).pack("l<3Vl<3V") \
+        + [0, 0, s[:sv], 0].pack("vCCV"))
+  }
+  def g_pages(packets) # u-blox stream is divided into 31 bytes
+    packets.scan(/.{1,31}/m).collect{|chunk| page('G', chunk)}.join
+  end
+
+  it 'decodes A pages' do
+    expect(decoder.decode(a_page * 2)).to eq(2)
+    rows = decoder.fetch('A').unpack("d*").each_slice(Sylphide::PageDecoder::columns('A')).to_a
+    expect(rows.size).to eq(2)
+    rows.each{|row| expect(row).to eq([12.345] + a_values + [0x1234])}
+    expect(decoder.fetch('A')).to eq("") # already fetched
+  end
+
+  it 'decodes S pages' do
+    decoder.decode(s_page)
+    expect(decoder.fetch('S').unpack("d*")).to eq([20.0] + s_values)
+  end
+
+  it 'decodes I pages into samples' do
+    decoder.decode(i_page)
+    rows = decoder.fetch('I').unpack("d*").each_slice(Sylphide::PageDecoder::columns('I')).to_a
+    expect(rows.size).to eq(2)
+    [30.0, 30.01].zip(rows, i_samples).each{|t, row, sample|
+      expect(row[0]).to be_within(1E-9).of(t)
+      expect(row[1..6]).to eq(sample)
+      expect(row[7]).to eq(0x5680)
+    }
+  end
+
+  it 'decodes u-blox NAV-SOL lying across G pages' do
+    data = g_pages(ubx(0x01, 0x02, "\0".b * 28) + nav_sol) + s_page # NAV-POSLLH is not extracted
+    data.bytes.each_slice(7){|chunk| decoder.decode(chunk.pack("C*"))} # arbitrary split
+    rows = decoder.fetch('G').unpack("d*").each_slice(Sylphide::PageDecoder::columns('G')).to_a
+    expect(rows.size).to eq(1)
+    s = solution
+    expected = [s[:itow] * 1E-3, s[:week], s[:fix], s[:flags]] \
+        + s[:pos].collect{|v| v * 1E-2} + [s[:p_acc] * 1E-2] \
+        + s[:vel].collect{|v| v * 1E-2} + [s[:s_acc] * 1E-2, s[:sv]]
+    rows[0].zip(expected).each{|a, b| expect(a).to be_within(1E-6).of(b)}
+    expect(decoder.fetch('S').unpack("d*").size).to eq(Sylphide::PageDecoder::columns('S'))
+    expect(decoder.skipped).to eq(0)
+  end
+
+  it 'skips a G packet having a wrong checksum' do
+    packet = nav_sol.dup
+    packet[20] = (packet[20].ord ^ 0xFF).chr
+    decoder.decode(g_pages(packet + nav_sol))
+    expect(decoder.fetch('G').unpack("d*").size).to eq(Sylphide::PageDecoder::columns('G'))
+    decoder.decode(g_pages(packet))
+    expect(decoder.fetch('G')).to eq("")
+  end
+
+  it 'counts unsupported pages' do
+    decoder.decode(page('Z', "") + a_page)
+    expect(decoder.skipped).to eq(1)
+    expect{decoder.fetch('Z')}.to raise_error(ArgumentError)
+  end
+end
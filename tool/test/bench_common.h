@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+/** @file
+ * @brief Minimal harness for micro benchmarks
+ *
+ * Each benchmark program (bench_*.cpp) measures functors with Benchmark::run(),
+ * and writes a JSON document to the standard output, whose form is
+ * {"suite": name, "results": [{"name": ..., "size": ..., "iterations": ..., "ns_per_op": ...}, ...]}.
+ * Progress is printed to the standard error.
+ *
+ * The number of iterations is doubled until the elapsed time exceeds a threshold,
+ * then the measurement is repeated and the fastest one is reported,
+ * which is more reproducible than the average under the noise of other processes.
+ *
+ * Options of the programs are
+ *   --min_time=<seconds> minimum time of a measurement (default 0.1)
+ *   --repeat=<N> number of measurements (default 3)
+ *   --filter=<string> runs only cases whose name contains the string
+ */
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#if __cplusplus >= 201103L
+#include <chrono>
+#else
+#include <ctime>
+#endif
+
+/**
+ * Sink to prevent a result from being eliminated by optimization
+ */
+template <class T>
+void bench_sink(const T &v){
+  static volatile char sink;
+  sink = *(const volatile char *)&v;
+}
+
+class Benchmark {
+  protected:
+    std::string suite;
+    std::ostream &out;
+    double min_time;
+    int repeat;
+    std::string filter;
+    int results;
+
+    static double now(){
+#if __cplusplus >= 201103L
+      return std::chrono::duration<double>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+      return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+    }
+
+    template <class Functor>
+    static double measure(Functor &f, const unsigned long &iterations){
+      double t0(now());
+      for(unsigned long i(0); i < iterations; ++i){f();}
+      return now() - t0;
+    }
+
+  public:
+    /**
+     * Constructor, which interprets options and begins JSON output
+     *
+     * @param suite_name name of the suite
+     * @param argc number of arguments of main()
+     * @param argv arguments of main()
+     * @param out_ output stream of JSON
+     */
+    Benchmark(const char *suite_name, int argc, char *argv[], std::ostream &out_ = std::cout)
+        : suite(suite_name), out(out_), min_time(0.1), repeat(3), filter(), results(0) {
+      for(int i(1); i < argc; ++i){
+        if(std::strncmp(argv[i], "--min_time=", 11) == 0){
+          min_time = std::atof(argv[i] + 11);
+        }else if(std::strncmp(argv[i], "--repeat=", 9) == 0){
+          repeat = std::atoi(argv[i] + 9);
+          if(repeat < 1){repeat = 1;}
+        }else if(std::strncmp(argv[i], "--filter=", 9) == 0){
+          filter = argv[i] + 9;
+        }else{
+          std::cerr << "(warning!) Unknown option: " << argv[i] << std::endl;
+        }
+      }
+      out << "{\"suite\": \"" << suite << "\", \"results\": [";
+    }
+
+    ~Benchmark(){
+      out << (results > 0 ? "\n" : "") << "]}" << std::endl;
+    }
+
+    /**
+     * Measure a functor
+     *
+     * @param name name of the case
+     * @param f functor, whose operator() performs one operation
+     * @param size problem size, which is omitted in output if negative
+     * @return (double) nanoseconds per operation; negative if skipped by filter
+     */
+    template <class Functor>
+    double run(const std::string &name, Functor &f, const int &size = -1){
+      if((!filter.empty()) && (name.find(filter) == std::string::npos)){return -1;}
+
+      unsigned long iterations(1);
+      while(true){ // calibration, which also works as warm-up
+        if(measure(f, iterations) >= min_time){break;}
+        iterations *= 2;
+      }
+      double best(measure(f, iterations));
+      for(int i(1); i < repeat; ++i){
+        double t(measure(f, iterations));
+        if(t < best){best = t;}
+      }
+      double ns_per_op(best * 1E9 / iterations);
+
+      out << (results++ > 0 ? "," : "") << "\n  {\"name\": \"" << name << "\"";
+      if(size >= 0){out << ", \"size\": " << size;}
+      out << ", \"iterations\": " << iterations
+          << ", \"ns_per_op\": " << ns_per_op << "}";
+      out.flush();
+
+      std::cerr << suite << '/' << name;
+      if(size >= 0){std::cerr << '[' << size << ']';}
+      std::cerr << ": " << ns_per_op << " [ns/op]" << std::endl;
+
+      return ns_per_op;
+    }
+};
+
+#endif /* __BENCH_COMMON_H__ */
@@ -0,0 +1,107 @@
+/**
+ * @file Micro benchmarks of Kalman filters at state sizes of INS/GPS
+ *
+ */
+
+#include <string>
+
+#include "param/matrix.h"
+#include "algorithm/kalman.h"
+#include "navigation/INS.h"
+#include "navigation/BiasEstimation.h"
+#include "navigation/INS_GPS2_Tightly.h"
+
+#include "bench_common.h"
+
+typedef double content_t;
+typedef Matrix<content_t> matrix_t;
+
+static matrix_t random_matrix(const unsigned int &rows, const unsigned int &columns){
+  matrix_t res(rows, columns);
+  unsigned int seed(rows * 97 + columns);
+  for(unsigned int i(0); i < rows; ++i){
+    for(unsigned int j(0); j < columns; ++j){
+      seed = seed * 1103515245u + 12345u;
+      res(i, j) = (double)((seed >> 16) & 0x7FFF) / 0x7FFF - 0.5;
+    }
+  }
+  return res;
+}
+
+/**
+ * Filter with fixed system matrices.
+ * P is reset in every operation so that the condition of the problem does not change.
+ */
+template <class FilterT>
+struct filter_bench_t {
+  FilterT filter;
+  matrix_t P, A, B, H, R;
+  filter_bench_t(const unsigned int &P_size, const unsigned int &Q_size, const unsigned int &z_size)
+      : filter(matrix_t::getI(P_size), matrix_t::getI(Q_size) * 1E-2),
+      P(matrix_t::getI(P_size)),
+      A(random_matrix(P_size, P_size)), B(random_matrix(P_size, Q_size)),
+      H(random_matrix(z_size, P_size)), R(matrix_t::getI(z_size)) {}
+  struct predict_t {
+    filter_bench_t &self;
+    predict_t(filter_bench_t &self_) : self(self_) {}
+    void operator()(){
+      self.filter.setP(self.P);
+      self.filter.predict(self.A, self.B, 1E-2);
+    }
+  };
+  struct correct_t {
+    filter_bench_t &self;
+    correct_t(filter_bench_t &self_) : self(self_) {}
+    void operator()(){
+      self.filter.setP(self.P);
+      matrix_t K(self.filter.correct(self.H, self.R));
+      bench_sink(K(0, 0));
+    }
+  };
+  struct reset_t {
+    filter_bench_t &self;
+    reset_t(filter_bench_t &self_) : self(self_) {}
+    void operator()(){
+      self.filter.setP(self.P);
+    }
+  };
+};
+
+/**
+ * Run predict and correct, which include the cost of resetting P.
+ * The cost is also measured separately as "reset".
+ * Observations of correct are position and velocity (6) for loosely coupled,
+ * and range and rate of 8 satellites (16) for tightly coupled.
+ */
+template <class FilterT>
+void run(Benchmark &bench, const std::string &name,
+    const unsigned int &P_size, const unsigned int &Q_size){
+  typedef filter_bench_t<FilterT> b_t;
+  b_t b_loosely(P_size, Q_size, 6), b_tightly(P_size, Q_size, 16);
+  typename b_t::reset_t reset(b_loosely);
+  bench.run(name + "/reset", reset, P_size);
+  typename b_t::predict_t predict(b_loosely);
+  bench.run(name + "/predict", predict, P_size);
+  typename b_t::correct_t correct_loosely(b_loosely);
+  bench.run(name + "/correct_loosely", correct_loosely, P_size);
+  typename b_t::correct_t correct_tightly(b_tightly);
+  bench.run(name + "/correct_tightly", correct_tightly, P_size);
+}
+
+template <class INS_T>
+void run(Benchmark &bench, const std::string &name){
+  typedef Filtered_INS2_Property<INS_T> prop_t;
+  run<KalmanFilter<content_t> >(bench, "KF/" + name, prop_t::P_SIZE, prop_t::Q_SIZE);
+  run<KalmanFilterUD<content_t> >(bench, "UD/" + name, prop_t::P_SIZE, prop_t::Q_SIZE);
+}
+
+int main(int argc, char *argv[]){
+  Benchmark bench("filter", argc, argv);
+  typedef INS<content_t> ins_t;
+  typedef INS_BiasEstimated<ins_t> ins_bias_t;
+  run<ins_t>(bench, "INS");
+  run<ins_bias_t>(bench, "INS_bias");
+  run<INS_ClockErrorEstimated<ins_bias_t> >(bench, "INS_bias_clock");
+  run<INS_ClockErrorEstimated<ins_bias_t, 1, 1> >(bench, "INS_bias_clock_ISB");
+  return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file Micro benchmarks of matrix operations
+ *
+ */
+
+#include <vector>
+
+#include "param/matrix.h"
+
+#include "bench_common.h"
+
+typedef double content_t;
+typedef Matrix<content_t> matrix_t;
+
+/**
+ * Make a symmetric positive definite matrix, which is typical for covariance,
+ * and suitable for all of inverse, LU and UD decomposition.
+ */
+static matrix_t spd_matrix(const unsigned int &size){
+  matrix_t A(size, size);
+  unsigned int seed(size);
+  for(unsigned int i(0); i < size; ++i){
+    for(unsigned int j(0); j < size; ++j){
+      seed = seed * 1103515245u + 12345u;
+      A(i, j) = (double)((seed >> 16) & 0x7FFF) / 0x7FFF - 0.5;
+    }
+  }
+  matrix_t res(A * A.transpose());
+  for(unsigned int i(0); i < size; ++i){res(i, i) += size;}
+  return res;
+}
+
+struct mul_t {
+  matrix_t A, B;
+  mul_t(const unsigned int &size) : A(spd_matrix(size)), B(spd_matrix(size)) {}
+  void operator()(){
+    matrix_t C(A * B);
+    bench_sink(C(0, 0));
+  }
+};
+
+struct inverse_t {
+  matrix_t A;
+  inverse_t(const unsigned int &size) : A(spd_matrix(size)) {}
+  void operator()(){
+    matrix_t C(A.inverse());
+    bench_sink(C(0, 0));
+  }
+};
+
+struct LU_t {
+  matrix_t A;
+  LU_t(const unsigned int &size) : A(spd_matrix(size)) {}
+  void operator()(){
+    matrix_t LU(A.decomposeLU(false));
+    bench_sink(LU(0, 0));
+  }
+};
+
+struct UD_t {
+  matrix_t A;
+  UD_t(const unsigned int &size) : A(spd_matrix(size)) {}
+  void operator()(){
+    matrix_t UD(A.decomposeUD(false));
+    bench_sink(UD(0, 0));
+  }
+};
+
+int main(int argc, char *argv[]){
+  Benchmark bench("matrix", argc, argv);
+  static const unsigned int sizes[] = {3, 4, 8, 16, 32, 64};
+  for(unsigned int i(0); i < sizeof(sizes) / sizeof(sizes[0]); ++i){
+    mul_t mul(sizes[i]);
+    bench.run("mul", mul, sizes[i]);
+    inverse_t inverse(sizes[i]);
+    bench.run("inverse", inverse, sizes[i]);
+    LU_t LU(sizes[i]);
+    bench.run("decomposeLU", LU, sizes[i]);
+    UD_t UD(sizes[i]);
+    bench.run("decomposeUD", UD, sizes[i]);
+  }
+  return 0;
+}
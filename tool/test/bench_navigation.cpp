@@ -0,0 +1,364 @@
+/**
+ * @file Micro benchmarks of navigation routines and log decoding
+ *
+ */
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "navigation/INS.h"
+#include "navigation/INS_EGM.h"
+#include "navigation/EGM.h"
+#include "navigation/GPS.h"
+#include "navigation/GPS_Solver.h"
+#include "navigation/GPS_Solver_Batch.h"
+#include "navigation/INS_GPS2_Tightly.h"
+#include "SylphideProcessor.h"
+
+#include "bench_common.h"
+
+typedef double content_t;
+
+template <class INS_T>
+struct ins_update_t {
+  INS_T ins;
+  typename INS_T::vec3_t accel, gyro;
+  ins_update_t() : ins(), accel(0.1, 0, -9.8), gyro(0, 0, 1E-3) {
+    ins.initPosition(35. / 180 * M_PI, 139. / 180 * M_PI, 100);
+    ins.initVelocity(10, 0, 0);
+    ins.initAttitude(0, 0, 0);
+  }
+  void operator()(){
+    ins.update(accel, gyro, 1E-2);
+    bench_sink(ins[0]);
+  }
+};
+
+struct egm_gravity_t {
+  content_t r, phi, lambda;
+  egm_gravity_t() : r(6378137. + 100), phi(35. / 180 * M_PI), lambda(139. / 180 * M_PI) {}
+  void operator()(){
+    EGM2008_70::gravity_res_t g(EGM2008_70::gravity(r, phi, lambda));
+    bench_sink(g.r);
+  }
+};
+
+struct egm_gravity_cached_t : public egm_gravity_t {
+  EGM2008_70::cache_t cache;
+  egm_gravity_cached_t() : egm_gravity_t(), cache() {
+    cache.update(WGS84::R_e / r, phi, lambda);
+  }
+  void operator()(){
+    EGM2008_70::gravity_res_t g(EGM2008_70::gravity(cache, r, phi, lambda));
+    bench_sink(g.r);
+  }
+};
+
+typedef GPS_SpaceNode<content_t> space_node_t;
+typedef GPS_SinglePositioning<content_t> solver_t;
+
+/**
+ * GPS constellation of 6 planes and 4 satellites for each plane,
+ * and pseudo ranges observed by a static receiver
+ */
+struct constellation_t {
+  space_node_t space_node;
+  space_node_t::gps_time_t t;
+  space_node_t::xyz_t usr;
+  solver_t::measurement_t measurement;
+  constellation_t()
+      : space_node(), t(2000, 7200 + 600),
+      usr(space_node_t::llh_t(35. / 180 * M_PI, 139. / 180 * M_PI, 100).xyz()),
+      measurement() {
+    for(int prn(1); prn <= 24; ++prn){
+      space_node_t::Satellite::eph_t eph = space_node_t::Satellite::eph_t();
+      eph.svid = prn;
+      eph.WN = t.week;
+      eph.t_oc = eph.t_oe = 7200;
+      eph.fit_interval = 4 * 60 * 60;
+      eph.sqrt_A = 5153.6;
+      eph.e = 0.01;
+      eph.i0 = 55. / 180 * M_PI;
+      eph.Omega0 = M_PI / 3 * ((prn - 1) / 4);
+      eph.M0 = M_PI / 2 * ((prn - 1) % 4) + M_PI / 12 * ((prn - 1) / 4);
+      eph.dot_Omega0 = -8E-9;
+      space_node.satellite(prn).register_ephemeris(eph);
+    }
+    space_node.update_all_ephemeris(t);
+    for(int prn(1); prn <= 24; ++prn){
+      space_node_t::xyz_t sat(space_node.satellite(prn).position(t, 2E7));
+      if(space_node_t::enu_t::relative(sat, usr).elevation() < (10. / 180 * M_PI)){continue;}
+      measurement[prn][solver_t::measurement_items_t::L1_PSEUDORANGE] = sat.dist(usr) + 1E3;
+      measurement[prn][solver_t::measurement_items_t::L1_RANGE_RATE] = 0;
+    }
+  }
+};
+
+struct satellite_position_t {
+  constellation_t &c;
+  satellite_position_t(constellation_t &c_) : c(c_) {}
+  void operator()(){
+    space_node_t::xyz_t pos(c.space_node.satellite(1).position(c.t, 2E7));
+    bench_sink(pos.x());
+  }
+};
+
+struct solve_user_pvt_t {
+  const constellation_t &c;
+  solver_t solver;
+  solve_user_pvt_t(const constellation_t &c_, const bool &delay_cache = true)
+      : c(c_), solver(c.space_node) {
+    solver_t::options_t opt;
+    opt.insert_ionospheric_model(solver_t::options_t::IONOSPHERIC_NONE);
+    opt.delay_cache.enabled = delay_cache;
+    solver.update_options(opt);
+  }
+  void operator()(){
+    solver_t::user_pvt_t pvt( // without hint, which is declared in the base class
+        static_cast<const solver_t::base_t &>(solver).solve_user_pvt(c.measurement, c.t));
+    bench_sink(pvt.receiver_error);
+  }
+};
+
+/**
+ * Batch of epochs having the same observation, whose throughput is
+ * (size / time per operation) epochs per second.
+ */
+struct solve_batch_t {
+  typedef GPS_Solver_Batch<content_t> batch_t;
+  batch_t batch;
+  std::vector<batch_t::epoch_t> epochs;
+  std::vector<batch_t::user_pvt_t> res;
+  solve_batch_t(const constellation_t &c, const unsigned int &threads, const unsigned int &size = 0x400)
+      : batch(c.space_node), epochs(size), res() {
+    batch.options.insert_ionospheric_model(batch_t::options_t::IONOSPHERIC_NONE);
+    batch.threads = threads;
+    for(unsigned int i(0); i < size; ++i){
+      epochs[i].t = c.t;
+      epochs[i].measurement = c.measurement;
+    }
+  }
+  void operator()(){
+    batch.solve(epochs, res);
+    bench_sink(res.back().receiver_error);
+  }
+};
+
+/**
+ * Epoch of tightly coupled INS/GPS, which consists of 10 time updates and a measurement update
+ * with range, rate, and optionally TDCP of the same satellites.
+ * The filter, whose carrier phases of the previous epoch has been committed, is restored at each operation.
+ */
+struct tightly_epoch_t {
+  typedef INS_GPS2_Tightly<> ins_gps_t;
+  solver_t solver;
+  ins_gps_t ins_gps_orig;
+  GPS_RawData<content_t> gps;
+  GPS_RawData<content_t> observe(constellation_t &c, const space_node_t::gps_time_t &t){
+    GPS_RawData<content_t> res;
+    res.solver = &solver;
+    res.gpstime = t;
+    for(solver_t::measurement_t::const_iterator it(c.measurement.begin());
+        it != c.measurement.end(); ++it){
+      content_t pr(c.space_node.satellite(it->first).position(t, 2E7).dist(c.usr) + 1E3);
+      res.measurement[it->first][solver_t::measurement_items_t::L1_PSEUDORANGE] = pr;
+      res.measurement[it->first][solver_t::measurement_items_t::L1_RANGE_RATE] = 0;
+      res.measurement[it->first][solver_t::measurement_items_t::L1_CARRIER_PHASE]
+          = pr / space_node_t::L1_WaveLength();
+    }
+    return res;
+  }
+  tightly_epoch_t(constellation_t &c, const bool &tdcp)
+      : solver(c.space_node), ins_gps_orig(), gps() {
+    solver_t::options_t opt;
+    opt.insert_ionospheric_model(solver_t::options_t::IONOSPHERIC_NONE);
+    solver.update_options(opt);
+    space_node_t::llh_t llh(c.usr.llh());
+    ins_gps_orig.initPosition(llh.latitude(), llh.longitude(), llh.height());
+    ins_gps_orig.initVelocity(0, 0, 0);
+    ins_gps_orig.initAttitude(0, 0, 0);
+    ins_gps_orig.clock_error() = 1E3;
+    ins_gps_t::tdcp_property_t prop;
+    prop.enabled = tdcp;
+    prop.residual_threshold = 1E3;
+    ins_gps_orig.setup_tdcp(prop);
+    ins_gps_orig.correct(observe(c, c.t));
+    gps = observe(c, c.t + 1);
+    if(tdcp && (ins_gps_orig.correct_info_tdcp(gps).z.rows() == 0)){
+      std::cerr << "(warning!) no TDCP rows" << std::endl;
+    }
+  }
+  void operator()(){
+    ins_gps_t ins_gps(ins_gps_orig, true);
+    ins_gps_t::vec3_t accel(-ins_gps.gravity_total()), gyro(0, 0, 0);
+    for(int i(0); i < 10; ++i){
+      ins_gps.update(accel, gyro, 1E-1);
+    }
+    ins_gps.correct(gps);
+    bench_sink(ins_gps.clock_error());
+  }
+};
+
+typedef GPS_Signal<content_t>::CA_Code_Table ca_code_table_t;
+
+/**
+ * C/A code replica of 1 ms at 4.092 MHz (4 samples per chip), and its correlation
+ */
+struct ca_code_t {
+  const ca_code_table_t &table;
+  static const int samples = 4092;
+  std::vector<signed char> replica;
+  std::vector<ca_code_table_t::word_t> a, b;
+  ca_code_t()
+      : table(ca_code_table_t::get_instance()), replica(samples),
+      a((samples + ca_code_table_t::WORD_BITS - 1) / ca_code_table_t::WORD_BITS), b(a.size()) {
+    table.replica_packed(1, &a[0], samples, 4.092E6);
+    table.replica_packed(2, &b[0], samples, 4.092E6, 100.25);
+  }
+  struct replica_t {
+    ca_code_t &self;
+    void operator()(){
+      self.table.replica(3, &self.replica[0], samples, 4.092E6, 10.5, 1.023E6 + 1);
+      bench_sink(self.replica[samples - 1]);
+    }
+  };
+  struct replica_packed_t {
+    ca_code_t &self;
+    void operator()(){
+      self.table.replica_packed(3, &self.a[0], samples, 4.092E6, 10.5, 1.023E6 + 1);
+      bench_sink(self.a[0]);
+    }
+  };
+  struct pack_sign_t {
+    ca_code_t &self;
+    void operator()(){
+      ca_code_table_t::pack_sign(&self.replica[0], &self.b[0], samples);
+      bench_sink(self.b[0]);
+    }
+  };
+  struct correlate_t {
+    ca_code_t &self;
+    void operator()(){
+      bench_sink(ca_code_table_t::correlate(&self.a[0], &self.b[0], samples));
+    }
+  };
+};
+
+typedef SylphideProcessor<content_t> processor_t;
+
+/**
+ * Decode of A, G and M pages, which is the major part of log.dat.
+ * G pages contain UBX NAV-POSLLH stream.
+ */
+struct sylphide_decode_t {
+  processor_t processor;
+  std::vector<char> pages;
+  static void handler_A(const processor_t::A_Observer_t &observer){
+    processor_t::A_Observer_t::values_t values(observer.fetch_values());
+    bench_sink(values.values[0]);
+  }
+  static void handler_G(const processor_t::G_Observer_t &observer){
+    if(!observer.validate()){return;}
+    processor_t::G_Observer_t::position_t pos(observer.fetch_position());
+    bench_sink(pos.latitude);
+  }
+  static void handler_M(const processor_t::M_Observer_t &observer){
+    processor_t::M_Observer_t::values_t values(observer.fetch_values());
+    bench_sink(values.x[0]);
+  }
+  sylphide_decode_t() : processor(), pages() {
+    processor.set_a_handler(handler_A);
+    processor.set_g_handler(handler_G);
+    processor.set_m_handler(handler_M);
+
+    std::vector<unsigned char> ubx;
+    for(int i(0); i < 31; ++i){ // 31 NAV-POSLLH packets fill 36 G pages
+      unsigned char packet[8 + 28] = {0xB5, 0x62, 0x01, 0x02, 28, 0};
+      for(int j(0); j < 28; ++j){packet[6 + j] = (unsigned char)(i + j);}
+      unsigned char ck_a(0), ck_b(0);
+      for(int j(2); j < 6 + 28; ++j){ck_a += packet[j]; ck_b += ck_a;}
+      packet[6 + 28] = ck_a;
+      packet[6 + 28 + 1] = ck_b;
+      ubx.insert(ubx.end(), packet, packet + sizeof(packet));
+    }
+    for(unsigned int i(0), j(0); j < ubx.size(); ++i){
+      for(int k(0); k < 8; ++k){ // A page is the most frequent
+        char page[SYLPHIDE_PAGE_SIZE] = {'A', (char)i};
+        for(int l(5); l < SYLPHIDE_PAGE_SIZE; ++l){page[l] = (char)(i + k + l);}
+        pages.insert(pages.end(), page, page + sizeof(page));
+      }
+      {
+        char page[SYLPHIDE_PAGE_SIZE] = {'G'};
+        for(int l(1); l < SYLPHIDE_PAGE_SIZE; ++l, ++j){page[l] = (char)ubx[j];}
+        pages.insert(pages.end(), page, page + sizeof(page));
+      }
+      {
+        char page[SYLPHIDE_PAGE_SIZE] = {'M', 0, 0, 0, 0, (char)i};
+        pages.insert(pages.end(), page, page + sizeof(page));
+      }
+    }
+  }
+  unsigned int size() const {return pages.size() / SYLPHIDE_PAGE_SIZE;}
+  void operator()(){
+    for(unsigned int i(0); i < pages.size(); i += SYLPHIDE_PAGE_SIZE){
+      processor.process(&pages[i], SYLPHIDE_PAGE_SIZE);
+    }
+  }
+};
+
+int main(int argc, char *argv[]){
+  Benchmark bench("navigation", argc, argv);
+  {
+    ins_update_t<INS<content_t> > ins;
+    bench.run("INS/update", ins);
+    ins_update_t<INS_EGM<INS<content_t> > > ins_egm;
+    bench.run("INS_EGM/update", ins_egm);
+  }
+  {
+    egm_gravity_t egm;
+    bench.run("EGM2008_70/gravity", egm);
+    egm_gravity_cached_t egm_cached;
+    bench.run("EGM2008_70/gravity_cached", egm_cached);
+  }
+  {
+    constellation_t c;
+    satellite_position_t sat_pos(c);
+    bench.run("GPS/Satellite/position", sat_pos);
+    solve_user_pvt_t pvt(c);
+    { // check solution
+      solver_t::user_pvt_t res(
+          static_cast<const solver_t::base_t &>(pvt.solver).solve_user_pvt(c.measurement, c.t));
+      if(!res.position_solved()){
+        std::cerr << "(warning!) solve_user_pvt failed: " << res.error_code << std::endl;
+      }
+    }
+    bench.run("GPS/solve_user_pvt", pvt, c.measurement.size());
+    solve_user_pvt_t pvt_no_cache(c, false);
+    bench.run("GPS/solve_user_pvt_without_delay_cache", pvt_no_cache, c.measurement.size());
+    solve_batch_t batch_single(c, 1);
+    bench.run("GPS/Solver_Batch/single_thread", batch_single, batch_single.epochs.size());
+    solve_batch_t batch_multi(c, solve_batch_t::batch_t::concurrency());
+    bench.run("GPS/Solver_Batch/multi_thread", batch_multi, batch_multi.epochs.size());
+    tightly_epoch_t tightly(c, false);
+    bench.run("INS_GPS2_Tightly/epoch", tightly, c.measurement.size());
+    tightly_epoch_t tightly_tdcp(c, true);
+    bench.run("INS_GPS2_Tightly/epoch_with_TDCP", tightly_tdcp, c.measurement.size());
+  }
+  {
+    ca_code_t ca_code;
+    ca_code_t::replica_t replica = {ca_code};
+    bench.run("GPS/CA_Code_Table/replica", replica, ca_code.samples);
+    ca_code_t::replica_packed_t replica_packed = {ca_code};
+    bench.run("GPS/CA_Code_Table/replica_packed", replica_packed, ca_code.samples);
+    ca_code_t::pack_sign_t pack_sign = {ca_code};
+    bench.run("GPS/CA_Code_Table/pack_sign", pack_sign, ca_code.samples);
+    ca_code_t::correlate_t correlate = {ca_code};
+    bench.run("GPS/CA_Code_Table/correlate", correlate, ca_code.samples);
+  }
+  {
+    sylphide_decode_t decode;
+    bench.run("Sylphide/decode", decode, decode.size()); // size is the number of pages
+  }
+  return 0;
+}
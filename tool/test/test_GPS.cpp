@@ -3,10 +3,19 @@
 #include <iostream>
 #include <bitset>
 #include <string>
+#include <sstream>
 #include <algorithm>
 
 #include "navigation/GPS.h"
 #include "navigation/GPS_Solver_Base.h"
+#include "navigation/GPS_Solver.h"
+#include "navigation/GPS_Solver_Batch.h"
+#include "navigation/GPS_Hatch_Filter.h"
+#include "navigation/GPS_Acquisition.h"
+#include "navigation/Galileo.h"
+#include "navigation/ninjascan_nav.h"
+
+#include "util/checkpoint.h"
 
 #include <boost/random.hpp>
 #include <boost/random/random_device.hpp>
@@ -312,4 +321,1026 @@ BOOST_FIXTURE_TEST_CASE(bit_array, Fixture){
   }
 }
 
+
+BOOST_AUTO_TEST_CASE(llh_xyz){
+  typedef space_node_t::xyz_t xyz_t;
+  typedef space_node_t::llh_t llh_t;
+  static const double lng_deg[] = {-170, -90, 0, 45, 139};
+  for(unsigned int i(0); i < sizeof(lng_deg) / sizeof(lng_deg[0]); ++i){
+    llh_t llh(35. / 180 * M_PI, lng_deg[i] / 180 * M_PI, 100);
+    xyz_t xyz(llh.xyz());
+    BOOST_CHECK_CLOSE(std::atan2(xyz.y(), xyz.x()), llh.longitude(), 1E-8);
+    llh_t llh2(xyz.llh());
+    BOOST_CHECK_SMALL(llh2.latitude() - llh.latitude(), 1E-9);
+    BOOST_CHECK_SMALL(llh2.longitude() - llh.longitude(), 1E-9);
+    BOOST_CHECK_SMALL(llh2.height() - llh.height(), 1E-3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(niell_mapping){
+  typedef space_node_t::NiellMappingFunction nmf_t;
+  static const double deg(M_PI / 180);
+  { // zenith
+    nmf_t res(nmf_t::get(2020.5, 35 * deg, 90 * deg, 0));
+    BOOST_CHECK_CLOSE(res.hydrostatic, 1, 1E-8);
+    BOOST_CHECK_CLOSE(res.wet, 1, 1E-8);
+  }
+  { // on a grid latitude, coefficients are taken from the table without interpolation
+    static const double coef_wet_45[] = {5.8118019e-4, 1.4572752e-3, 4.3908931e-2};
+    nmf_t res(nmf_t::get(2020.5, 45 * deg, 10 * deg, 0));
+    BOOST_CHECK_CLOSE(res.wet, nmf_t::marini1972(std::sin(10 * deg), coef_wet_45), 1E-8);
+    BOOST_CHECK(res.wet < 1. / std::sin(10 * deg));
+  }
+  for(double lat_deg(15); lat_deg < 90; lat_deg += 15){ // continuity and symmetry
+    nmf_t a(nmf_t::get(2020.5, (lat_deg - 1E-6) * deg, 5 * deg, 0.1)),
+        b(nmf_t::get(2020.5, (lat_deg + 1E-6) * deg, 5 * deg, 0.1)),
+        c(nmf_t::get(2020.5, -lat_deg * deg, 5 * deg, 0.1));
+    BOOST_CHECK_CLOSE(a.hydrostatic, b.hydrostatic, 1E-4);
+    BOOST_CHECK_CLOSE(a.wet, b.wet, 1E-4);
+    BOOST_CHECK_CLOSE(a.wet, c.wet, 1E-4);
+    BOOST_CHECK(a.wet > 9 && a.wet < 1. / std::sin(5 * deg));
+  }
+}
+
+struct solver_test_t : public solver_base_t {
+  using solver_base_t::matrix_t;
+  using solver_base_t::normal_equation_t;
+  using solver_base_t::geometric_matrices_t;
+};
+
+BOOST_FIXTURE_TEST_CASE(weighted_least_square, Fixture){
+  typedef solver_test_t::matrix_t matrix_t;
+  boost::random::uniform_real_distribution<> los_dist(-1, 1), w_dist(1E-3, 1), dr_dist(-100, 100);
+  for(int loop(0); loop < 0x100; loop++){
+    unsigned int n(5 + (loop % 8));
+    solver_test_t::geometric_matrices_t geomat(n + 2);
+    matrix_t W_dense(n, n);
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < 3; ++j){
+        geomat.G(i, j) = los_dist(gen);
+      }
+      W_dense(i, i) = geomat.W(i, 0) = w_dist(gen);
+      geomat.delta_r(i, 0) = dr_dist(gen);
+    }
+    matrix_t G(geomat.G.partial(n, 4).copy()), dr(geomat.delta_r.partial(n, 1).copy());
+
+    { // weighted least square
+      matrix_t Gt_W(G.transpose() * W_dense);
+      matrix_t x_ref((Gt_W * G).inverse() * Gt_W * dr);
+      matrix_t x(geomat.partial(n).least_square());
+      for(unsigned int i(0); i < 4; ++i){
+        BOOST_CHECK_SMALL(x(i, 0) - x_ref(i, 0), 1E-8 * (1 + std::abs(x_ref(i, 0))));
+      }
+    }
+    { // DOP related matrix
+      matrix_t C_ref((G.transpose() * G).inverse());
+      matrix_t C(geomat.partial(n).C());
+      for(unsigned int i(0); i < 4; ++i){
+        for(unsigned int j(0); j < 4; ++j){
+          BOOST_CHECK_SMALL(C(i, j) - C_ref(i, j), 1E-8 * (1 + std::abs(C_ref(i, j))));
+        }
+      }
+    }
+    { // leave-one-out
+      unsigned int k(loop % n);
+      matrix_t G2(n - 1, 4), W2(n - 1, n - 1), dr2(n - 1, 1);
+      for(unsigned int i(0), i2(0); i < n; ++i){
+        if(i == k){continue;}
+        for(unsigned int j(0); j < 4; ++j){G2(i2, j) = G(i, j);}
+        W2(i2, i2) = W_dense(i, i);
+        dr2(i2, 0) = dr(i, 0);
+        ++i2;
+      }
+      matrix_t Gt_W(G2.transpose() * W2);
+      matrix_t x_ref((Gt_W * G2).inverse() * Gt_W * dr2);
+      matrix_t x(geomat.partial(n).exclude(k).least_square());
+      for(unsigned int i(0); i < 4; ++i){
+        BOOST_CHECK_SMALL(x(i, 0) - x_ref(i, 0), 1E-8 * (1 + std::abs(x_ref(i, 0))));
+      }
+
+      // rank-one downdate
+      solver_test_t::normal_equation_t ne(geomat.partial(n).normal_equation());
+      ne.decompose();
+      double G_k[4] = {G(k, 0), G(k, 1), G(k, 2), G(k, 3)}, x2[4];
+      ne.downdate(G_k, W_dense(k, k), dr(k, 0));
+      ne.solution(x2);
+      for(unsigned int i(0); i < 4; ++i){
+        BOOST_CHECK_SMALL(x2[i] - x_ref(i, 0), 1E-8 * (1 + std::abs(x_ref(i, 0))));
+      }
+      matrix_t r(dr2 - G2 * x_ref);
+      double wssr_ref(0);
+      for(unsigned int i(0); i < n - 1; ++i){
+        wssr_ref += W2(i, i) * r(i, 0) * r(i, 0);
+      }
+      BOOST_CHECK_SMALL(ne.wssr(x2) - wssr_ref, 1E-6 * (1 + wssr_ref));
+    }
+  }
+}
+
+typedef GPS_SinglePositioning<double> single_positioning_t;
+
+/**
+ * Static receiver observing GPS constellation of 8 planes and 4 satellites for each plane.
+ * Pseudo ranges are made consistent with the range model of the solver,
+ * then, satellites having even PRN are biased by isb to emulate the other system group.
+ */
+struct constellation_t {
+  space_node_t space_node;
+  space_node_t::gps_time_t t;
+  space_node_t::xyz_t usr;
+  double clock_error, isb;
+  single_positioning_t solver;
+  solver_base_t::measurement_t measurement;
+  std::vector<int> prn_list; ///< in descending order of elevation
+  constellation_t(const double &isb_ = 0)
+      : space_node(), t(2000, 7200 + 600),
+      usr(space_node_t::llh_t(35. / 180 * M_PI, 139. / 180 * M_PI, 100).xyz()),
+      clock_error(1234.5), isb(isb_),
+      solver(space_node), measurement(), prn_list() {
+    typedef single_positioning_t::options_t opt_t;
+    opt_t opt;
+    opt.insert_ionospheric_model(opt_t::IONOSPHERIC_NONE);
+    opt.delay_cache.enabled = false;
+    opt.raim.enabled = true;
+    solver.update_options(opt);
+
+    std::vector<std::pair<double, int> > elv_prn;
+    for(int prn(1); prn <= 32; ++prn){
+      space_node_t::Satellite::eph_t eph = space_node_t::Satellite::eph_t();
+      eph.svid = prn;
+      eph.WN = t.week;
+      eph.t_oc = eph.t_oe = 7200;
+      eph.fit_interval = 4 * 60 * 60;
+      eph.sqrt_A = 5153.6;
+      eph.e = 0.01;
+      eph.i0 = 55. / 180 * M_PI;
+      eph.Omega0 = M_PI / 4 * ((prn - 1) / 4);
+      eph.M0 = M_PI / 2 * ((prn - 1) % 4) + M_PI / 16 * ((prn - 1) / 4);
+      eph.dot_Omega0 = -8E-9;
+      space_node.satellite(prn).register_ephemeris(eph);
+    }
+    measurement = observe(t, &elv_prn);
+    std::sort(elv_prn.begin(), elv_prn.end());
+    for(unsigned int i(0); i < elv_prn.size(); ++i){
+      prn_list.push_back(elv_prn[i].second);
+    }
+  }
+  /**
+   * Generate pseudoranges of satellites above 10 degrees, which are consistent with the solver.
+   * @param t_obs observation time in receiver time
+   * @param elv_prn if not NULL, pairs of negative elevation and PRN are appended
+   */
+  solver_base_t::measurement_t observe(
+      const space_node_t::gps_time_t &t_obs,
+      std::vector<std::pair<double, int> > *elv_prn = NULL){
+    solver_base_t::measurement_t res;
+    space_node.update_all_ephemeris(t_obs);
+    const solver_base_t::pos_t usr_pos = {usr, usr.llh()};
+    const space_node_t::gps_time_t t_arrival(t_obs - clock_error / space_node_t::light_speed);
+    for(int prn(1); prn <= 32; ++prn){
+      space_node_t::xyz_t sat(space_node.satellite(prn).position(t_obs, 2E7));
+      double elv(space_node_t::enu_t::relative(sat, usr).elevation());
+      if(elv < (10. / 180 * M_PI)){continue;}
+      if(elv_prn){elv_prn->push_back(std::make_pair(-elv, prn));}
+      double &pr(res[prn][solver_base_t::measurement_items_t::L1_PSEUDORANGE]);
+      for(pr = sat.dist(usr) + clock_error; ; ){
+        double residual(solver.relative_property(
+            prn, res[prn], clock_error, t_arrival, usr_pos,
+            space_node_t::xyz_t(0, 0, 0)).range_residual);
+        pr -= residual;
+        if(std::abs(residual) < 1E-6){break;}
+      }
+      if(system_group(prn) > 0){pr += isb;}
+    }
+    return res;
+  }
+  static int system_group(const int &prn){
+    return (prn % 2 == 0) ? 1 : 0;
+  }
+  double &pseudorange(const int &prn){
+    return measurement[prn][solver_base_t::measurement_items_t::L1_PSEUDORANGE];
+  }
+};
+
+/**
+ * Solver having the same structure as GNSS_Receiver::solver_t,
+ * which groups satellites by PRN and delegates them to a single positioning solver.
+ */
+struct grouped_solver_t : public solver_base_t {
+  const constellation_t &c;
+  grouped_solver_t(const constellation_t &c_) : solver_base_t(), c(c_) {}
+  const solver_base_t &select(const prn_t &prn) const {
+    return c.solver;
+  }
+  int system_group(const prn_t &prn) const {
+    return constellation_t::system_group(prn);
+  }
+  const raim_options_t &raim_options() const {
+    return c.solver.raim_options();
+  }
+};
+
+BOOST_AUTO_TEST_CASE(raim_fde){
+  typedef solver_base_t::user_pvt_t pvt_t;
+  typedef pvt_t::raim_t raim_t;
+
+  for(int grouped(0); grouped < 2; ++grouped){
+    BOOST_TEST_MESSAGE((grouped ? "multi-constellation solver" : "single positioning"));
+    constellation_t c(grouped ? -25 : 0);
+    grouped_solver_t solver_grouped(c);
+    const solver_base_t &solver(grouped
+        ? static_cast<const solver_base_t &>(solver_grouped)
+        : static_cast<const solver_base_t &>(c.solver));
+    BOOST_REQUIRE(c.prn_list.size() >= 8);
+
+    struct {
+      const solver_base_t &solver;
+      const constellation_t &c;
+      pvt_t operator()() const {
+        return solver.solve_user_pvt(c.measurement, c.t, space_node_t::xyz_t(), 0, false, false);
+      }
+    } solve = {solver, c};
+
+    { // fault free
+      pvt_t pvt(solve());
+      BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+      BOOST_CHECK_EQUAL(pvt.raim.state, raim_t::RAIM_PASSED);
+      BOOST_CHECK_EQUAL(pvt.used_satellites, c.prn_list.size());
+      BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(c.usr), 1E-3);
+      BOOST_CHECK_SMALL(pvt.raim.test_statistic, 1E-6);
+      BOOST_CHECK(pvt.raim.hpl > 0);
+      BOOST_CHECK(pvt.raim.hpl < 1E3);
+      BOOST_CHECK(pvt.raim.vpl > 0);
+      BOOST_CHECK(pvt.raim.vpl < 1E3);
+      if(grouped){
+        BOOST_CHECK_SMALL(pvt.inter_system_bias[1] - c.isb, 1E-3);
+      }
+    }
+
+    // single fault on each of high elevation satellites is detected and excluded.
+    for(unsigned int i(0); i < 3; ++i){
+      const int prn(c.prn_list[i]);
+      BOOST_TEST_MESSAGE(format("bias on PRN %d") % prn);
+      c.pseudorange(prn) += 100;
+      pvt_t pvt(solve());
+      c.pseudorange(prn) -= 100;
+      BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+      BOOST_CHECK_EQUAL(pvt.raim.state, raim_t::RAIM_EXCLUDED);
+      BOOST_CHECK(pvt.raim.excluded_satellite_mask[prn]);
+      BOOST_CHECK(!pvt.used_satellite_mask[prn]);
+      BOOST_CHECK_EQUAL(pvt.used_satellites, c.prn_list.size() - 1);
+      BOOST_CHECK(pvt.raim.test_statistic < pvt.raim.threshold);
+      // linearized correction after exclusion remains a small error.
+      BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(c.usr), 0.2);
+      BOOST_CHECK_SMALL(pvt.receiver_error - c.clock_error, 0.2);
+      if(grouped){
+        BOOST_CHECK_SMALL(pvt.inter_system_bias[1] - c.isb, 0.2);
+      }
+    }
+
+    { // double faults are not excluded by default
+      c.pseudorange(c.prn_list[0]) += 400;
+      c.pseudorange(c.prn_list[1]) -= 300;
+      pvt_t pvt(solve());
+      c.pseudorange(c.prn_list[0]) -= 400;
+      c.pseudorange(c.prn_list[1]) += 300;
+      BOOST_REQUIRE(pvt.position_solved());
+      BOOST_CHECK_EQUAL(pvt.raim.state, raim_t::RAIM_FAILED);
+    }
+  }
+
+  { // Without RAIM, large residual is still down-weighted as before.
+    constellation_t c;
+    single_positioning_t::options_t opt(c.solver.available_options());
+    opt.raim.enabled = false;
+    c.solver.update_options(opt);
+    c.pseudorange(c.prn_list[0]) += 100;
+    pvt_t pvt(static_cast<const solver_base_t &>(c.solver).solve_user_pvt(
+        c.measurement, c.t, space_node_t::xyz_t(), 0, false, false));
+    BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_CHECK_EQUAL(pvt.raim.state, raim_t::RAIM_UNAVAILABLE);
+    BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(c.usr), 1E-2);
+  }
+}
+
+struct batch_collector_t {
+  typedef GPS_Solver_Batch<double> batch_t;
+  std::vector<batch_t::gps_time_t> t;
+  std::vector<batch_t::user_pvt_t> pvt;
+  void operator()(const batch_t::epoch_t &epoch, const batch_t::user_pvt_t &pvt_){
+    t.push_back(epoch.t);
+    pvt.push_back(pvt_);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(solver_batch){
+  typedef batch_collector_t::batch_t batch_t;
+  constellation_t c;
+
+  // 300 epochs of 1 [s] interval with a gap of 100 [s] after the 200th epoch,
+  // which are written in RINEX OBS format
+  std::vector<batch_t::gps_time_t> t_list;
+  std::stringstream ss;
+  {
+    RINEX_OBS_Writer<double> writer(ss);
+    const char *types[] = {"C1"};
+    writer.types_of_obs(types, 1);
+    ss << writer.header();
+    for(int i(0); i < 300; ++i){
+      batch_t::gps_time_t t_obs(c.t + (i + ((i < 200) ? 0 : 100)));
+      t_list.push_back(t_obs);
+      solver_base_t::measurement_t m(c.observe(t_obs));
+      RINEX_OBS_Writer<double>::content_t::ObservedItem item;
+      item.t_epoc = t_obs;
+      item.event_flag = 0;
+      item.receiver_clock_error = 0;
+      for(solver_base_t::measurement_t::const_iterator it(m.begin()); it != m.end(); ++it){
+        RINEX_OBS_Writer<double>::content_t::ObservedItem::data_t v = {
+            it->second.find(solver_base_t::measurement_items_t::L1_PSEUDORANGE)->second, 0, 0};
+        item.sat_data[it->first].push_back(v);
+      }
+      writer << item;
+    }
+  }
+  const std::string rinex(ss.str());
+
+  batch_t::options_t opt;
+  opt.insert_ionospheric_model(batch_t::options_t::IONOSPHERIC_NONE);
+  opt.delay_cache.enabled = false; // cached delay depends on the initial guess
+
+  batch_collector_t res_ref;
+  { // single thread
+    std::stringstream in(rinex);
+    RINEX_OBS_Reader<double> reader(in);
+    batch_t batch(c.space_node, opt);
+    batch.batch_size = 64;
+    BOOST_REQUIRE_EQUAL(batch.run(reader, res_ref), (int)t_list.size());
+    BOOST_CHECK_EQUAL(batch.warm_starts(), t_list.size() - 2); // the first one and after the gap
+  }
+  BOOST_REQUIRE_EQUAL(res_ref.t.size(), t_list.size());
+  for(unsigned int i(0); i < t_list.size(); ++i){ // in the order of input
+    BOOST_REQUIRE_SMALL(res_ref.t[i] - t_list[i], 1E-6);
+    BOOST_REQUIRE(res_ref.pvt[i].position_solved());
+    BOOST_CHECK_SMALL(res_ref.pvt[i].receiver_time - t_list[i], 1E-6);
+    BOOST_CHECK_SMALL(res_ref.pvt[i].user_position.xyz.dist(c.usr), 1E-2);
+    BOOST_CHECK_SMALL(res_ref.pvt[i].receiver_error - c.clock_error, 1E-2);
+  }
+
+  for(int loop(0); loop < 2; ++loop){
+    bool cold(loop > 0);
+    BOOST_TEST_MESSAGE((cold ? "multi-thread, cold start" : "multi-thread, warm start"));
+    std::stringstream in(rinex);
+    RINEX_OBS_Reader<double> reader(in);
+    batch_t batch(c.space_node, opt);
+    batch.threads = 4;
+    batch.batch_size = 64;
+    if(cold){batch.warm_start_limit = -1;}
+    batch_collector_t res;
+    BOOST_REQUIRE_EQUAL(batch.run(reader, res), (int)t_list.size());
+    if(cold){
+      BOOST_CHECK_EQUAL(batch.warm_starts(), 0);
+    }else{ // the first epoch of each chunk may be cold started
+      BOOST_CHECK_LE(batch.warm_starts(), t_list.size() - 2);
+      BOOST_CHECK_GE(batch.warm_starts(), t_list.size() - 4 * 5 - 1);
+    }
+    BOOST_REQUIRE_EQUAL(res.t.size(), t_list.size());
+    for(unsigned int i(0); i < t_list.size(); ++i){
+      BOOST_REQUIRE_SMALL(res.t[i] - t_list[i], 1E-6);
+      BOOST_REQUIRE(res.pvt[i].position_solved());
+      BOOST_CHECK_SMALL(res.pvt[i].user_position.xyz.dist(res_ref.pvt[i].user_position.xyz), 1E-4);
+      BOOST_CHECK_SMALL(res.pvt[i].receiver_error - res_ref.pvt[i].receiver_error, 1E-4);
+    }
+  }
+
+  { // workers and threads are reused over solve() calls
+    batch_t batch(c.space_node, opt);
+    batch.threads = 2;
+    std::vector<batch_t::epoch_t> epochs(2);
+    std::vector<batch_t::user_pvt_t> res;
+    for(int i(0); i < 3; ++i){
+      for(int j(0); j < 2; ++j){
+        epochs[j].t = t_list[i * 2 + j];
+        epochs[j].measurement = c.observe(epochs[j].t);
+      }
+      batch.solve(epochs, res);
+      BOOST_REQUIRE_EQUAL(res.size(), epochs.size());
+      for(int j(0); j < 2; ++j){
+        BOOST_CHECK_SMALL(res[j].user_position.xyz.dist(c.usr), 1E-4);
+      }
+    }
+    BOOST_CHECK_EQUAL(batch.warm_starts(), 4); // each worker warm starts except its first epoch
+  }
+}
+
+struct shared_solve_t {
+  const constellation_t &c;
+  const single_positioning_t &solver;
+  std::vector<solver_base_t::measurement_t> measurement;
+  std::vector<space_node_t::gps_time_t> t;
+  std::vector<solver_base_t::user_pvt_t> res;
+  shared_solve_t(const constellation_t &c_, const single_positioning_t &solver_)
+      : c(c_), solver(solver_), measurement(), t(), res() {}
+  void operator()(const unsigned int &i){
+    res[i] = static_cast<const solver_base_t &>(solver).solve_user_pvt(
+        measurement[i], t[i], c.usr, c.clock_error, true, false);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(delay_cache){
+  typedef single_positioning_t::options_t opt_t;
+  typedef solver_base_t::user_pvt_t pvt_t;
+  constellation_t c;
+  space_node_t::Ionospheric_UTC_Parameters iono = space_node_t::Ionospheric_UTC_Parameters();
+  { // typical values
+    const double alpha[] = {1.0245E-08, 2.2352E-08, -5.9605E-08, -1.1921E-07};
+    const double beta[] = {8.8064E+04, 1.3107E+05, -1.3107E+05, -3.9322E+05};
+    for(int i(0); i < 4; ++i){iono.alpha[i] = alpha[i]; iono.beta[i] = beta[i];}
+  }
+  c.space_node.update_iono_utc(iono);
+
+  opt_t opt; // Klobuchar
+  opt.delay_cache.position_threshold = 1E3; // loose enough to reuse delays between calls
+  single_positioning_t solver(c.space_node, opt);
+  opt.delay_cache.enabled = false;
+  single_positioning_t solver_ref(c.space_node, opt);
+
+  for(int loop(0); loop < 2; ++loop){
+    if(loop > 0){ // Change of Klobuchar parameters must invalidate cached delays
+      for(int i(0); i < 4; ++i){iono.alpha[i] *= 2;}
+      c.space_node.update_iono_utc(iono);
+    }
+    pvt_t pvt(static_cast<const solver_base_t &>(solver).solve_user_pvt(
+        c.measurement, c.t, c.usr, c.clock_error, true, false));
+    pvt_t pvt_ref(static_cast<const solver_base_t &>(solver_ref).solve_user_pvt(
+        c.measurement, c.t, c.usr, c.clock_error, true, false));
+    BOOST_REQUIRE(pvt.position_solved());
+    BOOST_REQUIRE(pvt_ref.position_solved());
+    BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(pvt_ref.user_position.xyz), 5E-2);
+    BOOST_CHECK_SMALL(pvt.receiver_error - pvt_ref.receiver_error, 5E-2);
+  }
+
+  { // A solver shared among threads
+    shared_solve_t shared(c, solver), ref(c, solver_ref);
+    for(int i(0); i < 64; ++i){
+      space_node_t::gps_time_t t(c.t + i);
+      shared.t.push_back(t);
+      shared.measurement.push_back(c.observe(t));
+    }
+    shared.res.resize(shared.t.size());
+    ref.t = shared.t;
+    ref.measurement = shared.measurement;
+    ref.res.resize(ref.t.size());
+    ThreadPool pool(4);
+    pool.run(shared, shared.t.size());
+    pool.run(ref, ref.t.size());
+    for(unsigned int i(0); i < shared.res.size(); ++i){
+      BOOST_REQUIRE(shared.res[i].position_solved());
+      BOOST_CHECK_SMALL(shared.res[i].user_position.xyz.dist(ref.res[i].user_position.xyz), 5E-2);
+    }
+  }
+}
+
+struct eph_collector_t {
+  typedef space_node_t::Satellite::eph_t eph_t;
+  std::vector<eph_t> list;
+  void operator()(const eph_t &eph){list.push_back(eph);}
+};
+
+BOOST_FIXTURE_TEST_CASE(ephemeris_select, Fixture){
+  typedef space_node_t::Satellite::eph_t eph_t;
+  typedef space_node_t::gps_time_t gps_time_t;
+  boost::random::uniform_int_distribution<> idx_dist(0, 0x7FFF);
+
+  space_node_t sn, sn_ref;
+  { // Register ephemerides for one week in random order with duplication
+    std::vector<eph_t> list;
+    for(int prn(1); prn <= 4; ++prn){
+      for(int i(0); i < 84; ++i){
+        if((prn == 4) && (i >= 20) && (i < 30)){continue;} // gap
+        eph_t eph = eph_t();
+        eph.svid = prn;
+        eph.WN = 2000;
+        eph.t_oc = eph.t_oe = 60 * 60 * 2 * i + ((prn == 3) ? 16 : 0);
+        eph.fit_interval = (i % 7 == 3) ? (60 * 60 * 6) : (60 * 60 * 4);
+        eph.iode = eph.iodc = i;
+        list.push_back(eph);
+        if(i % 5 == 0){ // different content having same time tag
+          eph.iode = eph.iodc = i + 0x100;
+          list.push_back(eph);
+        }
+      }
+    }
+    for(int i(list.size() - 1); i > 0; --i){
+      std::swap(list[i], list[idx_dist(gen) % (i + 1)]);
+    }
+    for(std::vector<eph_t>::const_iterator it(list.begin()); it != list.end(); ++it){
+      sn.satellite(it->svid).register_ephemeris(*it, (it->iode >= 0x100) ? 2 : 1);
+      sn_ref.satellite(it->svid).register_ephemeris(*it, (it->iode >= 0x100) ? 2 : 1);
+    }
+  }
+
+  for(int loop(0); loop < 0x800; ++loop){
+    gps_time_t t(2000, 0);
+    t += ((loop < 0x400)
+        ? (60.0 * 7 * loop) // forward
+        : (60.0 * 60 * 24 * 7 * idx_dist(gen) / 0x7FFF)); // random
+
+    sn.update_all_ephemeris(t);
+    for(space_node_t::satellites_t::const_iterator it(sn.satellites().begin());
+        it != sn.satellites().end(); ++it){
+      space_node_t::Satellite &sat_ref(sn_ref.satellite(it->first));
+      bool valid(sat_ref.select_ephemeris(t));
+      const eph_t &eph(it->second.ephemeris()), &eph_ref(sat_ref.ephemeris());
+      BOOST_REQUIRE_EQUAL(eph.is_valid(t), valid);
+      BOOST_REQUIRE_EQUAL(eph.t_oc, eph_ref.t_oc);
+      BOOST_REQUIRE_EQUAL(eph.iode, eph_ref.iode);
+
+      // Compare to exhaustive search
+      eph_collector_t collector;
+      it->second.each_ephemeris(collector);
+      double delta_t_min(-1);
+      for(std::vector<eph_t>::const_iterator it2(collector.list.begin());
+          it2 != collector.list.end(); ++it2){
+        if(!it2->is_valid(t)){continue;}
+        double delta_t(it2->period_from_first_valid_transmittion(t));
+        if((delta_t_min < 0) || (delta_t < delta_t_min)){delta_t_min = delta_t;}
+      }
+      BOOST_REQUIRE_EQUAL(valid, (delta_t_min >= 0));
+      if(valid && eph.maybe_better_one_avilable(t)){
+        BOOST_REQUIRE_EQUAL(eph.period_from_first_valid_transmittion(t), delta_t_min);
+      }
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(ephemeris_checkpoint, Fixture){
+  typedef space_node_t::Satellite::eph_t eph_t;
+  typedef space_node_t::gps_time_t gps_time_t;
+  boost::random::uniform_int_distribution<> idx_dist(0, 0x7FFF);
+
+  // Ephemerides of one day in order of transmission, some of which are duplicated
+  std::vector<eph_t> list;
+  for(int i(0); i < 12; ++i){
+    for(int prn(1); prn <= 8; ++prn){
+      eph_t eph = eph_t();
+      eph.svid = prn;
+      eph.WN = 2000;
+      eph.t_oc = eph.t_oe = 60 * 60 * 2 * i;
+      eph.fit_interval = 60 * 60 * 4;
+      eph.iode = eph.iodc = i;
+      eph.sqrt_A = 5153.6;
+      eph.e = 0.01;
+      eph.i0 = 55. / 180 * M_PI;
+      eph.Omega0 = M_PI / 4 * (prn - 1);
+      eph.M0 = M_PI / 8 * (prn - 1) + 1E-2 * idx_dist(gen) / 0x7FFF;
+      list.push_back(eph);
+      if(idx_dist(gen) % 3 == 0){list.push_back(eph);}
+    }
+  }
+  space_node_t::Ionospheric_UTC_Parameters iono_utc = space_node_t::Ionospheric_UTC_Parameters();
+  iono_utc.alpha[0] = 1E-8;
+  iono_utc.beta[3] = -1E5;
+  iono_utc.WN_t = 2000;
+  iono_utc.delta_t_LS = 18;
+
+  // Register the ephemerides, and select them every 7 minutes
+  struct run_t {
+    space_node_t &sn;
+    const std::vector<eph_t> &list;
+    std::vector<eph_t>::size_type i_eph;
+    run_t(space_node_t &sn_, const std::vector<eph_t> &list_, const int &i_eph_ = 0)
+        : sn(sn_), list(list_), i_eph(i_eph_) {}
+    void operator()(const int &step){
+      gps_time_t t(2000, 60.0 * 7 * step);
+      for(; i_eph < list.size(); ++i_eph){
+        if(gps_time_t(list[i_eph].WN, list[i_eph].t_oe - 60 * 60) > t){break;}
+        sn.satellite(list[i_eph].svid).register_ephemeris(list[i_eph]);
+      }
+      sn.update_all_ephemeris(t);
+    }
+  };
+  static const int steps(24 * 60 / 7), steps_before(steps / 2);
+
+  space_node_t sn;
+  sn.update_iono_utc(iono_utc, true, false);
+  run_t run(sn, list);
+  for(int step(0); step < steps_before; ++step){run(step);}
+
+  std::stringstream ss;
+  {
+    Checkpoint::Writer ar(ss, "GPS_SpaceNode");
+    ar & sn;
+    BOOST_REQUIRE(ar.flush());
+  }
+  space_node_t sn_resumed;
+  {
+    Checkpoint::Reader ar(ss, "GPS_SpaceNode");
+    ar & sn_resumed;
+  }
+  BOOST_CHECK(sn_resumed.is_valid_iono());
+  BOOST_CHECK(!sn_resumed.is_valid_utc());
+  BOOST_CHECK_EQUAL(sn_resumed.iono_utc().alpha[0], iono_utc.alpha[0]);
+  BOOST_CHECK_EQUAL(sn_resumed.iono_utc().beta[3], iono_utc.beta[3]);
+  BOOST_CHECK_EQUAL(sn_resumed.iono_utc().delta_t_LS, iono_utc.delta_t_LS);
+
+  // Resumed one must be identical to the one without interruption.
+  run_t run_resumed(sn_resumed, list, run.i_eph);
+  for(int step(steps_before); step < steps; ++step){
+    run(step);
+    run_resumed(step);
+    gps_time_t t(2000, 60.0 * 7 * step);
+    BOOST_REQUIRE_EQUAL(sn.satellites().size(), sn_resumed.satellites().size());
+    for(space_node_t::satellites_t::const_iterator
+          it(sn.satellites().begin()), it2(sn_resumed.satellites().begin());
+        it != sn.satellites().end(); ++it, ++it2){
+      BOOST_REQUIRE_EQUAL(it->first, it2->first);
+      const eph_t &eph(it->second.ephemeris()), &eph2(it2->second.ephemeris());
+      BOOST_REQUIRE_EQUAL(eph.t_oe, eph2.t_oe);
+      BOOST_REQUIRE_EQUAL(eph.iode, eph2.iode);
+      BOOST_REQUIRE_EQUAL(eph.M0, eph2.M0);
+      if(!eph.is_valid(t)){continue;}
+      BOOST_REQUIRE_EQUAL(it->second.position(t).dist(it2->second.position(t)), 0);
+    }
+  }
+  { // including priorities and caches
+    std::stringstream ss1, ss2;
+    {
+      Checkpoint::Writer ar1(ss1, ""), ar2(ss2, "");
+      ar1 & sn;
+      ar2 & sn_resumed;
+    }
+    BOOST_CHECK(ss1.str() == ss2.str());
+  }
+
+  { // Truncated one is rejected
+    std::string truncated(ss.str());
+    truncated.resize(truncated.size() / 2);
+    std::stringstream ss2(truncated);
+    Checkpoint::Reader ar(ss2, "GPS_SpaceNode");
+    space_node_t sn2;
+    BOOST_CHECK_THROW(ar & sn2, std::runtime_error);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ephemeris_raw_encode){
+  typedef space_node_t::Satellite::eph_t eph_t;
+  eph_t eph = eph_t();
+  eph.sqrt_A = 5153.6; // exceeds 2^31 in raw unit
+  eph.e = 0.01;
+  eph_t::raw_t raw;
+  raw = eph;
+  eph_t eph2((eph_t)raw);
+  BOOST_CHECK_SMALL(eph2.sqrt_A - eph.sqrt_A, std::pow(2., -19));
+  BOOST_CHECK_SMALL(eph2.e - eph.e, std::pow(2., -33));
+}
+
+BOOST_AUTO_TEST_CASE(hatch_filter){
+  typedef GPS_Hatch_Filter<double> smoother_t;
+  typedef solver_base_t::measurement_items_t items_t;
+  smoother_t smoother;
+  const double lambda(space_node_t::L1_WaveLength());
+
+  boost::random::mt19937 gen;
+  boost::random::normal_distribution<> noise(0, 1);
+
+  double sum_raw(0), sum_smoothed(0);
+  int n(0);
+  for(int k(0); k < 600; ++k){
+    double t(100000 + k);
+    double range(2E7 + 500 * k + 0.1 * k * k), rate(500 + 0.2 * k);
+    double carrier(range / lambda + 12345);
+    if(k >= 300){carrier += 3;} // cycle slip
+
+    solver_base_t::measurement_t msr;
+    double raw(range + noise(gen));
+    msr[1][items_t::L1_PSEUDORANGE] = raw;
+    msr[1][items_t::L1_PSEUDORANGE_SIGMA] = 1;
+    msr[1][items_t::L1_CARRIER_PHASE] = carrier;
+    msr[1][items_t::L1_DOPPLER] = -rate / lambda;
+    smoother.update(solver_base_t::gps_time_t(2000, t), msr);
+
+    double smoothed(msr[1][items_t::L1_PSEUDORANGE]);
+    if(k == 300){ // restarted
+      BOOST_REQUIRE_EQUAL(smoothed, raw);
+      BOOST_REQUIRE_EQUAL(msr[1][items_t::L1_PSEUDORANGE_SIGMA], 1);
+    }
+    if((k >= 200 && k < 300) || (k >= 500)){
+      sum_raw += std::pow(raw - range, 2);
+      sum_smoothed += std::pow(smoothed - range, 2);
+      ++n;
+    }
+  }
+  BOOST_CHECK_EQUAL(smoother.statistics.slips_doppler, 1);
+  BOOST_CHECK_EQUAL(smoother.statistics.slips_code, 0);
+  BOOST_CHECK(std::sqrt(sum_smoothed / n) < std::sqrt(sum_raw / n) * 0.3);
+}
+
+BOOST_AUTO_TEST_CASE(ca_code_table){
+  typedef GPS_Signal<double> signal_t;
+  typedef signal_t::CA_Code_Table table_t;
+  const table_t &table(table_t::get_instance());
+  const int len(table_t::LENGTH);
+
+  for(int prn(1); prn <= table_t::PRN_MAX; ++prn){ // consistency with generator
+    signal_t::CA_Code code(prn);
+    const signed char *chips(table.chips_of(prn));
+    const table_t::word_t *packed(table.packed_of(prn));
+    for(int i(0); i < len; ++i, code.next()){
+      BOOST_REQUIRE_EQUAL(chips[i], code.get_multi());
+      BOOST_REQUIRE_EQUAL(((packed[i / table_t::WORD_BITS] >> (i % table_t::WORD_BITS)) & 1) == 1, code.get());
+    }
+  }
+  { // The first 10 chips of PRN 1 are 1440 in octal
+    int head(0);
+    for(int i(0); i < 10; ++i){head = (head << 1) | (table.chips_of(1)[i] > 0 ? 1 : 0);}
+    BOOST_REQUIRE_EQUAL(head, 01440);
+  }
+
+  { // replica at 2 samples per chip with half chip offset
+    vector<int> buf(len * 2);
+    table.replica(3, &buf[0], (int)buf.size(), signal_t::CA_Code::FREQENCY * 2, 0.5);
+    for(int i(0); i < (int)buf.size(); ++i){
+      BOOST_REQUIRE_EQUAL(buf[i], table.chips_of(3)[((i + 1) / 2) % len]);
+    }
+  }
+
+  { // replica with Doppler shifted code rate, which wraps several times in a buffer
+    const double fs(4.092E6), rate(signal_t::CA_Code::FREQENCY + 1.5), phase(1000.25);
+    vector<int> buf(len * 10 + 7);
+    table.replica(5, &buf[0], (int)buf.size(), fs, phase, rate);
+    for(int i(0); i < (int)buf.size(); ++i){
+      BOOST_REQUIRE_EQUAL(buf[i],
+          table.chips_of(5)[(int)std::fmod(phase + rate / fs * i + 1E-9, (double)len)]);
+    }
+  }
+
+  { // auto and cross correlation by XOR/popcount, and comparison with product sum
+    const double fs(4.092E6);
+    const int n(4092), words((n + table_t::WORD_BITS - 1) / table_t::WORD_BITS);
+    vector<table_t::word_t> a(words), b(words), s(words);
+    vector<double> a_f(n), b_f(n);
+    for(int prn(1); prn <= 32; ++prn){
+      table.replica_packed(prn, &a[0], n, fs);
+      table.replica(prn, &a_f[0], n, fs);
+      table_t::pack_sign(&a_f[0], &s[0], n);
+      BOOST_REQUIRE(std::equal(a.begin(), a.end(), s.begin()));
+      BOOST_REQUIRE_EQUAL(table_t::correlate(&a[0], &a[0], n), n);
+      for(int prn2(prn + 1); prn2 <= 32; prn2 += 7){
+        for(double phase(0); phase < len; phase += 101.25){
+          table.replica_packed(prn2, &b[0], n, fs, phase);
+          table.replica(prn2, &b_f[0], n, fs, phase);
+          double sum(0);
+          for(int i(0); i < n; ++i){sum += a_f[i] * b_f[i];}
+          int corr(table_t::correlate(&a[0], &b[0], n));
+          BOOST_REQUIRE_EQUAL(corr, (int)sum);
+          BOOST_CHECK(std::abs(corr) <= 65 * 4);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(acquisition){
+  typedef GPS_Acquisition<double> acq_t;
+  typedef acq_t::complex_t complex_t;
+
+  for(unsigned int n(1); n <= 24; ++n){ // FFT, both radix-2 and Bluestein, compared with DFT
+    acq_t::fft_t fft(n);
+    vector<complex_t> x(n), y;
+    for(unsigned int i(0); i < n; ++i){x[i] = complex_t(std::cos(i * 1.3), std::sin(i * i * 0.7));}
+    y = x;
+    fft.forward(&y[0]);
+    for(unsigned int k(0); k < n; ++k){
+      complex_t sum(0);
+      for(unsigned int i(0); i < n; ++i){sum += x[i] * std::polar(1.0, -2 * M_PI * i * k / n);}
+      BOOST_REQUIRE_SMALL(std::abs(y[k] - sum), 1E-9 * n);
+    }
+    fft.inverse(&y[0]);
+    for(unsigned int i(0); i < n; ++i){BOOST_REQUIRE_SMALL(std::abs(y[i] / double(n) - x[i]), 1E-12 * n);}
+  }
+
+  acq_t::options_t opt;
+  opt.sampling_rate = 2.048E6;
+  opt.non_coherent = 4;
+  opt.threads = 2;
+  vector<int> prns;
+  prns.push_back(3); prns.push_back(7); prns.push_back(19);
+  acq_t acq(opt, prns);
+
+  const double doppler(-1600), code_phase(600.5), cn0(45); // PRN 7
+  int n(acq.required_samples());
+  vector<complex_t> samples(n);
+  {
+    vector<double> code(n);
+    GPS_Signal<double>::CA_Code_Table::get_instance().replica(
+        7, &code[0], n, opt.sampling_rate, code_phase);
+    boost::random::mt19937 gen(1);
+    boost::random::normal_distribution<> dist(0, std::sqrt(0.5)); // complex noise of unit power
+    double amp(std::sqrt(std::pow(10, cn0 / 10) / opt.sampling_rate));
+    for(int i(0); i < n; ++i){
+      samples[i] = std::polar(amp * code[i], 2 * M_PI * doppler * i / opt.sampling_rate)
+          + complex_t(dist(gen), dist(gen));
+    }
+  }
+
+  vector<acq_t::result_t> res(acq.search(&samples[0]));
+  BOOST_REQUIRE_EQUAL(res.size(), prns.size());
+  for(unsigned int i(0); i < res.size(); ++i){
+    BOOST_TEST_MESSAGE(format("PRN %d: %d, %f [chip], %f [Hz], %f [dB-Hz], %f")
+        % res[i].prn % res[i].acquired % res[i].code_phase
+        % res[i].doppler % res[i].cn0 % res[i].peak_ratio);
+    BOOST_CHECK_EQUAL(res[i].prn, prns[i]);
+    if(res[i].prn != 7){
+      BOOST_CHECK(!res[i].acquired);
+      continue;
+    }
+    BOOST_CHECK(res[i].acquired);
+    BOOST_CHECK_SMALL(res[i].doppler - doppler, opt.doppler_step / 2);
+    BOOST_CHECK_SMALL(res[i].code_phase - code_phase, 0.5);
+    BOOST_CHECK_SMALL(res[i].cn0 - cn0, 2.0);
+  }
+
+  // Results are independent of the number of threads, even for a single Doppler bin,
+  // whose PRNs are distributed to threads.
+  for(double doppler_max(0); doppler_max <= 2000; doppler_max += 2000){
+    vector<int> prns_all;
+    for(int prn(1); prn <= 32; ++prn){prns_all.push_back(prn);}
+    acq_t::options_t opt2(opt);
+    opt2.doppler_max = doppler_max;
+    opt2.threads = 1;
+    acq_t acq1(opt2, prns_all);
+    opt2.threads = 5;
+    acq_t acq5(opt2, prns_all);
+    vector<acq_t::result_t> res1(acq1.search(&samples[0])), res5(acq5.search(&samples[0]));
+    BOOST_REQUIRE_EQUAL(res1.size(), res5.size());
+    for(unsigned int i(0); i < res1.size(); ++i){
+      BOOST_CHECK_EQUAL(res1[i].prn, res5[i].prn);
+      BOOST_CHECK_EQUAL(res1[i].acquired, res5[i].acquired);
+      BOOST_CHECK_EQUAL(res1[i].code_offset, res5[i].code_offset);
+      BOOST_CHECK_EQUAL(res1[i].doppler, res5[i].doppler);
+      BOOST_CHECK_EQUAL(res1[i].peak_ratio, res5[i].peak_ratio);
+    }
+    BOOST_CHECK_EQUAL(res5[6].acquired, doppler_max > 0); // PRN 7 at -1600 Hz
+  }
+}
+
+struct multi_constellation_solver_t : public solver_base_t {
+  typedef solver_base_t::float_t float_t;
+  std::map<prn_t, xyz_t> sat_pos;
+  /**
+   * Galileo satellites, whose PRNs are 0x200 or more, have their own clock group.
+   */
+  int system_group(const prn_t &prn) const {
+    return (prn >= 0x200) ? 1 : 0;
+  }
+  relative_property_t relative_property(
+      const prn_t &prn,
+      const measurement_t::mapped_type &measurement,
+      const float_t &receiver_error,
+      const gps_time_t &time_arrival,
+      const pos_t &usr_pos,
+      const xyz_t &usr_vel) const {
+    relative_property_t res = {0};
+    float_t pr;
+    if(!range(measurement, pr)){return res;}
+    const xyz_t &sat(sat_pos.find(prn)->second);
+    float_t r(usr_pos.xyz.dist(sat));
+    res.weight = 1;
+    res.range_corrected = pr;
+    res.range_residual = pr - r - receiver_error;
+    res.los_neg[0] = -(sat.x() - usr_pos.xyz.x()) / r;
+    res.los_neg[1] = -(sat.y() - usr_pos.xyz.y()) / r;
+    res.los_neg[2] = -(sat.z() - usr_pos.xyz.z()) / r;
+    return res;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(multi_constellation){
+  typedef multi_constellation_solver_t::xyz_t xyz_t;
+  typedef multi_constellation_solver_t::llh_t llh_t;
+  typedef multi_constellation_solver_t::enu_t enu_t;
+  typedef multi_constellation_solver_t::user_pvt_t pvt_t;
+  typedef solver_base_t::measurement_items_t items_t;
+
+  const xyz_t usr(llh_t(35. / 180 * M_PI, 139. / 180 * M_PI, 100).xyz());
+  const double clock_error(1234.5), isb(-25.);
+
+  multi_constellation_solver_t solver;
+  solver_base_t::measurement_t msr_all;
+  static const double azel[][2] = { // [deg]
+    {0, 85}, {60, 30}, {150, 45}, {240, 20}, {320, 60}, // GPS
+    {20, 40}, {110, 15}, {200, 70}, {290, 35}, // Galileo
+  };
+  for(unsigned int i(0); i < sizeof(azel) / sizeof(azel[0]); ++i){
+    int prn((i < 5) ? (i + 1) : (0x200 + i));
+    double az(azel[i][0] / 180 * M_PI), el(azel[i][1] / 180 * M_PI), r(2.2E7);
+    xyz_t sat(enu_t(
+        r * std::cos(el) * std::sin(az), r * std::cos(el) * std::cos(az), r * std::sin(el))
+        .absolute(usr));
+    solver.sat_pos[prn] = sat;
+    msr_all[prn][items_t::L1_PSEUDORANGE]
+        = sat.dist(usr) + clock_error + ((prn >= 0x200) ? isb : 0);
+  }
+
+  { // GPS and Galileo
+    pvt_t pvt(solver.solve_user_pvt(
+        msr_all, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false));
+    BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_CHECK_EQUAL(pvt.used_satellites, msr_all.size());
+    BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(usr), 1E-3);
+    BOOST_CHECK_SMALL(pvt.receiver_error - clock_error, 1E-3);
+    BOOST_CHECK_SMALL(pvt.inter_system_bias[1] - isb, 1E-3);
+    BOOST_CHECK(pvt.gdop > 0);
+  }
+  { // warm start from the solution reproduces it
+    pvt_t pvt_cold(solver.solve_user_pvt(
+        msr_all, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false));
+    pvt_t pvt_warm(solver.solve_user_pvt(
+        msr_all, solver_base_t::gps_time_t(2000, 0),
+        pvt_cold.user_position, pvt_cold.receiver_error, true, false));
+    BOOST_REQUIRE_EQUAL(pvt_warm.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_CHECK_SMALL(pvt_warm.user_position.xyz.dist(pvt_cold.user_position.xyz), 1E-6);
+    BOOST_CHECK_SMALL(pvt_warm.receiver_error - pvt_cold.receiver_error, 1E-6);
+    BOOST_CHECK_SMALL(pvt_warm.inter_system_bias[1] - pvt_cold.inter_system_bias[1], 1E-6);
+  }
+  { // Without ISB, the solution is identical to the single group one, and ISB column costs DOP.
+    struct single_group_solver_t : public multi_constellation_solver_t {
+      int system_group(const prn_t &) const {return 0;}
+    } solver_single;
+    solver_single.sat_pos = solver.sat_pos;
+    solver_base_t::measurement_t msr(msr_all);
+    for(solver_base_t::measurement_t::iterator it(msr.begin()); it != msr.end(); ++it){
+      if(it->first >= 0x200){it->second[items_t::L1_PSEUDORANGE] -= isb;}
+    }
+    pvt_t pvt(solver.solve_user_pvt(
+        msr, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false)),
+        pvt_single(solver_single.solve_user_pvt(
+          msr, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false));
+    BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_REQUIRE_EQUAL(pvt_single.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_CHECK_EQUAL(pvt.system_groups, 0x3u);
+    BOOST_CHECK_EQUAL(pvt_single.system_groups, 0x1u);
+    BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(pvt_single.user_position.xyz), 1E-3);
+    BOOST_CHECK_SMALL(pvt.receiver_error - pvt_single.receiver_error, 1E-3);
+    BOOST_CHECK_SMALL(pvt.inter_system_bias[1], 1E-3);
+    BOOST_CHECK(pvt.gdop > pvt_single.gdop);
+    BOOST_CHECK(pvt.pdop >= pvt_single.pdop);
+  }
+  { // Galileo only, then the clock error is aligned to Galileo
+    solver_base_t::measurement_t msr(msr_all);
+    for(int prn(1); prn <= 5; ++prn){msr.erase(prn);}
+    pvt_t pvt(solver.solve_user_pvt(
+        msr, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false));
+    BOOST_REQUIRE_EQUAL(pvt.error_code, pvt_t::ERROR_VELOCITY_SKIPPED);
+    BOOST_CHECK_SMALL(pvt.user_position.xyz.dist(usr), 1E-3);
+    BOOST_CHECK_SMALL(pvt.receiver_error - (clock_error + isb), 1E-3);
+    BOOST_CHECK_EQUAL(pvt.inter_system_bias[1], 0);
+  }
+  { // 4 satellites are insufficient when both GPS and Galileo are used
+    solver_base_t::measurement_t msr(msr_all);
+    for(int i(6); i < 9; ++i){msr.erase(0x200 + i);}
+    msr.erase(1);
+    msr.erase(2);
+    pvt_t pvt(solver.solve_user_pvt(
+        msr, solver_base_t::gps_time_t(2000, 0), xyz_t(), 0, false, false));
+    BOOST_CHECK_EQUAL(pvt.error_code, pvt_t::ERROR_INSUFFICIENT_SATELLITES);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(galileo_ephemeris){
+  typedef Galileo_SpaceNode<double> galileo_t;
+  galileo_t::ephemeris_t eph = galileo_t::ephemeris_t();
+  eph.svid = 11;
+  eph.WN = 2100;
+  eph.iodnav = 77;
+  eph.SISA = 3.12;
+  eph.data_source = 0x05; // I/NAV
+  eph.BGD_E1E5a = 1E-9;
+  eph.BGD_E1E5b = 2E-9;
+  eph.t_oc = eph.t_oe = 36000;
+  eph.sqrt_A = 5440.6;
+  eph.e = 1E-4;
+  eph.delta_n = 3E-9;
+  eph.i0 = 56. / 180 * M_PI;
+
+  galileo_t::gps_ephemeris_t eph_gps(eph.to_GPS(0x200 + eph.svid));
+  BOOST_CHECK_EQUAL(eph_gps.svid, 0x200 + eph.svid);
+  BOOST_CHECK_EQUAL(eph_gps.iode, eph.iodnav);
+  BOOST_CHECK_EQUAL(eph_gps.t_GD, eph.BGD_E1E5b);
+  BOOST_CHECK_EQUAL(eph.to_GPS().svid, eph.svid);
+  { // mean motion is preserved
+    double a3(std::pow(eph.sqrt_A, 6));
+    BOOST_CHECK_SMALL(
+        (std::sqrt(galileo_t::mu_Earth / a3) + eph.delta_n)
+          - (std::sqrt(WGS84::mu_Earth / a3) + eph_gps.delta_n),
+        1E-18);
+  }
+  eph.data_source = 0x02; // F/NAV
+  BOOST_CHECK_EQUAL(eph.to_GPS().t_GD, eph.BGD_E1E5a);
+
+  galileo_t sn;
+  sn.register_ephemeris(eph, 0x200 + eph.svid);
+  BOOST_CHECK(sn.has_satellite(0x200 + eph.svid));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
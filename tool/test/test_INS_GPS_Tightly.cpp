@@ -0,0 +1,531 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "navigation/GPS.h"
+#include "navigation/GPS_Solver.h"
+#include "navigation/INS_GPS2_Tightly.h"
+#include "navigation/INS_GPS_Factory.h"
+#include "navigation/INS_GPS_Debug.h"
+#include "navigation/ninjascan_nav.h"
+
+#include <boost/random.hpp>
+
+#include <boost/format.hpp>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+using namespace std;
+using boost::format;
+
+typedef GPS_SpaceNode<double> space_node_t;
+typedef GPS_Solver_Base<double> solver_base_t;
+typedef GPS_SinglePositioning<double> single_positioning_t;
+
+/**
+ * Static receiver observing 32 satellites, whose measurements are
+ * pseudorange, carrier phase, and Doppler with optional noise.
+ * Pseudorange is made consistent with the solver, and carrier phase is
+ * the noise-free pseudorange with a constant ambiguity.
+ * When groups is 2, satellites whose PRNs are even belong to
+ * the second system group, and their pseudoranges have the inter-system bias.
+ */
+struct scenario_t {
+  space_node_t space_node;
+  struct solver_t : public single_positioning_t {
+    int groups;
+    solver_t(const space_node_t &sn) : single_positioning_t(sn), groups(1) {}
+    int system_group(const prn_t &prn) const {
+      return ((groups > 1) && (prn % 2 == 0)) ? 1 : 0;
+    }
+  } solver;
+  space_node_t::gps_time_t t0;
+  space_node_t::xyz_t usr;
+  double clock_error, clock_error_rate; ///< receiver clock at t0 [m], [m/s]
+  double isb; ///< inter-system bias of the second system group [m]
+  double sigma_range, sigma_carrier, sigma_doppler; ///< noise [m], [m], [Hz]
+  boost::random::mt19937 gen;
+  boost::random::normal_distribution<> noise;
+  scenario_t()
+      : space_node(), solver(space_node), t0(2000, 7200 + 600),
+      usr(space_node_t::llh_t(35. / 180 * M_PI, 139. / 180 * M_PI, 100).xyz()),
+      clock_error(1234.5), clock_error_rate(0.5), isb(-25),
+      sigma_range(0), sigma_carrier(0), sigma_doppler(0),
+      gen(0), noise() {
+    typedef single_positioning_t::options_t opt_t;
+    opt_t opt;
+    opt.insert_ionospheric_model(opt_t::IONOSPHERIC_NONE);
+    opt.delay_cache.enabled = false;
+    solver.update_options(opt);
+
+    for(int prn(1); prn <= 32; ++prn){
+      space_node_t::Satellite::eph_t eph = space_node_t::Satellite::eph_t();
+      eph.svid = prn;
+      eph.WN = t0.week;
+      eph.t_oc = eph.t_oe = 7200;
+      eph.fit_interval = 4 * 60 * 60;
+      eph.sqrt_A = 5153.6;
+      eph.e = 0.01;
+      eph.i0 = 55. / 180 * M_PI;
+      eph.Omega0 = M_PI / 4 * ((prn - 1) / 4);
+      eph.M0 = M_PI / 2 * ((prn - 1) % 4) + M_PI / 16 * ((prn - 1) / 4);
+      eph.dot_Omega0 = -8E-9;
+      space_node.satellite(prn).register_ephemeris(eph);
+    }
+    space_node.update_all_ephemeris(t0);
+  }
+  double clock(const space_node_t::gps_time_t &t_obs) const {
+    return clock_error + clock_error_rate * (t_obs - t0);
+  }
+  /**
+   * @return (double) noise-free pseudorange, or negative value when the satellite is invisible
+   */
+  double pseudorange(const int &prn, const space_node_t::gps_time_t &t_obs){
+    space_node_t::xyz_t sat(space_node.satellite(prn).position(t_obs, 2E7));
+    if(space_node_t::enu_t::relative(sat, usr).elevation() < (10. / 180 * M_PI)){return -1;}
+    const solver_base_t::pos_t usr_pos = {usr, usr.llh()};
+    const double b(clock(t_obs) + (solver.system_group(prn) > 0 ? isb : 0));
+    const space_node_t::gps_time_t t_arrival(t_obs - b / space_node_t::light_speed);
+    solver_base_t::measurement_t::mapped_type values;
+    double &pr(values[solver_base_t::measurement_items_t::L1_PSEUDORANGE]);
+    for(pr = sat.dist(usr) + b; ; ){
+      double residual(solver.relative_property(
+          prn, values, b, t_arrival, usr_pos, space_node_t::xyz_t(0, 0, 0)).range_residual);
+      pr -= residual;
+      if(std::abs(residual) < 1E-6){break;}
+    }
+    return pr;
+  }
+  GPS_RawData<double> observe(const space_node_t::gps_time_t &t_obs){
+    typedef solver_base_t::measurement_items_t items_t;
+    static const double lambda(space_node_t::L1_WaveLength()), dt(0.05);
+    GPS_RawData<double> res;
+    res.solver = &solver;
+    res.gpstime = t_obs;
+    for(int prn(1); prn <= 32; ++prn){
+      double pr(pseudorange(prn, t_obs));
+      if(pr < 0){continue;}
+      solver_base_t::measurement_t::mapped_type &values(res.measurement[prn]);
+      values[items_t::L1_PSEUDORANGE] = pr + noise(gen) * sigma_range;
+      values[items_t::L1_PSEUDORANGE_SIGMA] = (sigma_range > 0) ? sigma_range : 1;
+      values[items_t::L1_CARRIER_PHASE]
+          = (pr + 12.345 * prn + noise(gen) * sigma_carrier) / lambda;
+      values[items_t::L1_DOPPLER]
+          = -(pseudorange(prn, t_obs + dt) - pseudorange(prn, t_obs - dt)) / (dt * 2) / lambda
+            + noise(gen) * sigma_doppler;
+      values[items_t::L1_DOPPLER_SIGMA] = (sigma_doppler > 0) ? sigma_doppler : 0.1;
+    }
+    return res;
+  }
+};
+
+/**
+ * Tightly coupled INS/GPS exposing internal states related to TDCP
+ */
+struct ins_gps_t : public INS_GPS2_Tightly<> {
+  typedef INS_GPS2_Tightly<> super_t;
+  typedef super_t::carrier_phases_t carrier_phases_t;
+  using super_t::carrier_phases;
+  using super_t::clone;
+  using super_t::receiver_state;
+  using super_t::assign_z_H_R;
+  ins_gps_t(const scenario_t &scenario, const bool &tdcp = true) : super_t() {
+    space_node_t::llh_t llh(scenario.usr.llh());
+    initPosition(llh.latitude(), llh.longitude(), llh.height());
+    initVelocity(0, 0, 0);
+    initAttitude(0, 0, 0);
+    clock_error() = scenario.clock_error;
+    clock_error_rate() = scenario.clock_error_rate;
+    {
+      mat_t P(getFilter().getP());
+      P(0, 0) = P(1, 1) = P(2, 2) = 1E-2;
+      P(3, 3) = P(4, 4) = P(5, 5) = 1E-12;
+      P(6, 6) = 1E+1;
+      P(7, 7) = P(8, 8) = P(9, 9) = 1E-6;
+      P(10, 10) = 1E2;
+      P(11, 11) = 1E0;
+      getFilter().setP(P);
+    }
+    {
+      mat_t Q(getFilter().getQ());
+      Q(0, 0) = Q(1, 1) = Q(2, 2) = 1E-2;
+      Q(3, 3) = Q(4, 4) = Q(5, 5) = 1E-8;
+      Q(6, 6) = 1E-6;
+      Q(7, 7) = 1E-2;
+      Q(8, 8) = 1E-2;
+      getFilter().setQ(Q);
+    }
+    tdcp_property_t prop;
+    prop.enabled = tdcp;
+    prop.sigma = 1E-2;
+    setup_tdcp(prop);
+  }
+  /**
+   * Static IMU output, which cancels gravity and measures the Earth's rotation
+   */
+  void update_static(const double &deltaT, const vec3_t &accel_noise = vec3_t()){
+    vec3_t accel(-gravity_total() + accel_noise);
+    vec3_t gyro(omega_e2i_4n);
+    update(accel, gyro, deltaT);
+  }
+  void correct_range_rate(const raw_data_t &gps){
+    correct_with_clock_jump_check(gps, CorrectInfoGenerator());
+  }
+  /**
+   * Carrier phases of the current epoch evaluated with the current state,
+   * which are the same as ones in correct_info_tdcp().
+   */
+  carrier_phases_t current_carrier_phases(const raw_data_t &gps) const {
+    carrier_phases_t res;
+    receiver_state_t x(receiver_state(gps.gpstime, gps.clock_index));
+    double z[2], H[2][P_SIZE], R_diag[2];
+    for(solver_t::measurement_t::const_iterator it(gps.measurement.begin());
+        it != gps.measurement.end(); ++it){
+      assign_z_H_R(*gps.solver, it->first, it->second, x, z, H, R_diag, &res);
+    }
+    return res;
+  }
+};
+
+static void add_carrier_cycles(GPS_RawData<double> &gps, const int &prn, const double &cycles){
+  gps.measurement[prn][solver_base_t::measurement_items_t::L1_CARRIER_PHASE] += cycles;
+}
+
+BOOST_AUTO_TEST_SUITE(INS_GPS_Tightly)
+
+BOOST_AUTO_TEST_CASE(tdcp_rows){
+  scenario_t scenario;
+  ins_gps_t ins_gps(scenario);
+
+  space_node_t::gps_time_t t(scenario.t0);
+  GPS_RawData<double> gps(scenario.observe(t));
+  const unsigned int sats(gps.measurement.size());
+  BOOST_REQUIRE(sats >= 6);
+  std::vector<int> prns;
+  for(solver_base_t::measurement_t::const_iterator it(gps.measurement.begin());
+      it != gps.measurement.end(); ++it){
+    prns.push_back(it->first);
+  }
+
+  // no previous epoch
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), 0);
+  BOOST_CHECK(!ins_gps.clone.valid);
+  ins_gps.correct(gps);
+  BOOST_CHECK_EQUAL(ins_gps.carrier_phases.size(), sats);
+  BOOST_CHECK(ins_gps.clone.valid);
+
+  // the next epoch uses all satellites, and the carrier phase of prns[0] is missing
+  for(int i(0); i < 10; ++i){ins_gps.update_static(0.1);}
+  t += 1;
+  gps = scenario.observe(t);
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats);
+  gps.measurement[prns[0]].erase(solver_base_t::measurement_items_t::L1_CARRIER_PHASE);
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats - 1);
+  ins_gps.correct(gps);
+  BOOST_CHECK_EQUAL(ins_gps.carrier_phases.size(), sats - 1);
+
+  // prns[0] is excluded due to missing previous epoch, and then cycle slip is introduced.
+  for(int i(0); i < 10; ++i){ins_gps.update_static(0.1);}
+  t += 1;
+  gps = scenario.observe(t);
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats - 1);
+  add_carrier_cycles(gps, prns[1], 10); // about 1.9 m, which is detected by Doppler
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats - 2);
+  gps.measurement[prns[1]].erase(solver_base_t::measurement_items_t::L1_DOPPLER);
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats - 1); // undetectable
+  add_carrier_cycles(gps, prns[1], 20); // about 5.7 m, which exceeds the residual threshold
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(gps).z.rows(), sats - 2);
+
+  // exceeding maximum interval
+  for(int i(0); i < 30; ++i){ins_gps.update_static(0.1);}
+  BOOST_CHECK_EQUAL(ins_gps.correct_info_tdcp(scenario.observe(t + 3)).z.rows(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(tdcp_augmented_covariance){
+  typedef ins_gps_t::mat_t mat_t;
+  scenario_t scenario;
+  ins_gps_t ins_gps(scenario);
+
+  space_node_t::gps_time_t t(scenario.t0);
+  ins_gps.correct(scenario.observe(t));
+  for(int i(0); i < 10; ++i){ins_gps.update_static(0.1);}
+  t += 1;
+  GPS_RawData<double> gps(scenario.observe(t));
+  ins_gps.correct_range_rate(gps);
+
+  // Reference is the Kalman filter of the augmented state [x; x_c], whose covariance is [[P, C]; [C^T, P_c]].
+  mat_t P(ins_gps.getFilter().getP().copy()), C(ins_gps.clone.C.copy()), P_c(ins_gps.clone.P.copy());
+  ins_gps_t::carrier_phases_t current(ins_gps.current_carrier_phases(gps));
+  const unsigned int rows(current.size());
+  BOOST_REQUIRE_EQUAL(rows, ins_gps.carrier_phases.size());
+  mat_t H_x(rows, P.columns()), H_c(rows, P.columns());
+  {
+    unsigned int i(0);
+    for(ins_gps_t::carrier_phases_t::const_iterator it(current.begin());
+        it != current.end(); ++it, ++i){
+      for(unsigned int j(0); j < P.columns(); ++j){
+        H_x(i, j) = it->second.H[j];
+        H_c(i, j) = ins_gps.carrier_phases[it->first].H[j];
+      }
+    }
+  }
+  mat_t R(mat_t::getI(rows) * std::pow(1E-2, 2));
+  mat_t S(H_x * P * H_x.transpose() - H_x * C * H_c.transpose()
+      - H_c * C.transpose() * H_x.transpose() + H_c * P_c * H_c.transpose() + R);
+  mat_t K((P * H_x.transpose() - C * H_c.transpose()) * S.inverse());
+  mat_t P_ref(P - K * S * K.transpose());
+
+  CorrectInfo<double> info(ins_gps.correct_info_tdcp(gps));
+  BOOST_REQUIRE_EQUAL(info.z.rows(), rows);
+  for(unsigned int i(0); i < rows; ++i){
+    for(unsigned int j(0); j < rows; ++j){
+      if(i != j){BOOST_CHECK_EQUAL(info.R(i, j), 0);} // whitened
+    }
+  }
+  ins_gps.correct_primitive(info);
+  mat_t P_post(ins_gps.getFilter().getP());
+  for(unsigned int i(0); i < P.rows(); ++i){
+    for(unsigned int j(0); j < P.columns(); ++j){
+      BOOST_CHECK_SMALL(P_post(i, j) - P_ref(i, j),
+          std::sqrt(P(i, i) * P(j, j)) * 1E-6 + 1E-15);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(tdcp_accuracy){
+  struct result_t {
+    double velocity_rms; ///< [m/s]
+    double normalized; ///< mean of squared velocity error normalized by estimated variance
+  };
+  struct {
+    result_t operator()(const bool &tdcp) const {
+      scenario_t scenario;
+      scenario.sigma_range = 3;
+      scenario.sigma_carrier = 5E-3;
+      scenario.sigma_doppler = 0.5; // about 0.1 m/s
+      ins_gps_t ins_gps(scenario, tdcp);
+      boost::random::mt19937 gen(1);
+      boost::random::normal_distribution<> noise;
+
+      space_node_t::gps_time_t t(scenario.t0);
+      result_t res = {0, 0};
+      int samples(0);
+      for(int epoch(0); epoch < 120; ++epoch, t += 1){
+        if(epoch > 0){
+          for(int i(0); i < 10; ++i){
+            ins_gps.update_static(0.1, ins_gps_t::vec3_t(noise(gen), noise(gen), noise(gen)) * 1E-1);
+          }
+        }
+        ins_gps.correct(scenario.observe(t));
+        if(epoch < 60){continue;}
+        ins_gps_t::mat_t P(ins_gps.getFilter().getP());
+        const double v[] = {ins_gps.v_north(), ins_gps.v_east(), ins_gps.v_down()};
+        for(int i(0); i < 3; ++i){
+          res.velocity_rms += std::pow(v[i], 2);
+          res.normalized += std::pow(v[i], 2) / P(i, i);
+        }
+        ++samples;
+      }
+      res.velocity_rms = std::sqrt(res.velocity_rms / samples / 3);
+      res.normalized /= (samples * 3);
+      return res;
+    }
+  } run;
+
+  result_t without_tdcp(run(false)), with_tdcp(run(true));
+  BOOST_TEST_MESSAGE(format("velocity RMS without TDCP: %f [m/s], normalized: %f")
+      % without_tdcp.velocity_rms % without_tdcp.normalized);
+  BOOST_TEST_MESSAGE(format("velocity RMS with TDCP: %f [m/s], normalized: %f")
+      % with_tdcp.velocity_rms % with_tdcp.normalized);
+  BOOST_CHECK(with_tdcp.velocity_rms < without_tdcp.velocity_rms * 0.8);
+  BOOST_CHECK(with_tdcp.normalized < 3); // not overconfident
+}
+
+/**
+ * Tightly coupled INS/GPS with an inter-system bias (ISB) state, which is generated
+ * by the factory as INS_GPS does, and therefore accepts PVT as well as raw measurement.
+ */
+struct ins_gps_isb_t : public INS_GPS_Factory<>::tightly<1, 1>::product {
+  typedef INS_GPS_Factory<>::tightly<1, 1>::product super_t;
+  ins_gps_isb_t(const scenario_t &scenario) : super_t() {
+    space_node_t::llh_t llh(scenario.usr.llh());
+    initPosition(llh.latitude(), llh.longitude(), llh.height());
+    initVelocity(0, 0, 0);
+    initAttitude(0, 0, 0);
+    clock_error() = scenario.clock_error;
+    clock_error_rate() = scenario.clock_error_rate;
+    {
+      mat_t P(getFilter().getP());
+      P(0, 0) = P(1, 1) = P(2, 2) = 1E-2;
+      P(3, 3) = P(4, 4) = P(5, 5) = 1E-12;
+      P(6, 6) = 1E+1;
+      P(7, 7) = P(8, 8) = P(9, 9) = 1E-6;
+      P(10, 10) = 1E2;
+      P(11, 11) = 1E0;
+      P(12, 12) = 1E4; // ISB
+      getFilter().setP(P);
+    }
+    {
+      mat_t Q(getFilter().getQ());
+      Q(0, 0) = Q(1, 1) = Q(2, 2) = 1E-2;
+      Q(3, 3) = Q(4, 4) = Q(5, 5) = 1E-8;
+      Q(6, 6) = 1E-6;
+      Q(7, 7) = 1E-2;
+      Q(8, 8) = 1E-2;
+      Q(9, 9) = 1E-6; // ISB
+      getFilter().setQ(Q);
+    }
+  }
+  void update_static(const double &deltaT){
+    update(-gravity_total(), omega_e2i_4n, deltaT);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(isb_states){
+  // ISB states are added only on request.
+  const unsigned int isb_default(INS_GPS_Factory<>::tightly<>::product::INTER_SYSTEM_BIASES),
+      isb_requested(INS_GPS_Factory<>::tightly<1, 1>::product::INTER_SYSTEM_BIASES),
+      p_size_default(ins_gps_t::P_SIZE), p_size_isb(ins_gps_isb_t::P_SIZE);
+  BOOST_CHECK_EQUAL(isb_default, 0u);
+  BOOST_CHECK_EQUAL(isb_requested, 1u);
+  BOOST_CHECK_EQUAL(p_size_isb, p_size_default + 1);
+
+  // Without ISB state, satellites of the second group are not used.
+  scenario_t scenario;
+  scenario.solver.groups = 2;
+  GPS_RawData<double> gps(scenario.observe(scenario.t0));
+  unsigned int sats_group0(0);
+  for(solver_base_t::measurement_t::const_iterator it(gps.measurement.begin());
+      it != gps.measurement.end(); ++it){
+    if(scenario.solver.system_group(it->first) == 0){++sats_group0;}
+  }
+  BOOST_REQUIRE(sats_group0 >= 3);
+  BOOST_REQUIRE(gps.measurement.size() - sats_group0 >= 3);
+  ins_gps_t ins_gps(scenario, false);
+  ins_gps_isb_t ins_gps_isb(scenario);
+  BOOST_CHECK_EQUAL(ins_gps.correct_info(gps).z.rows(), sats_group0 * 2); // range and rate
+  CorrectInfo<double> info(ins_gps_isb.correct_info(gps));
+  BOOST_CHECK_EQUAL(info.z.rows(), gps.measurement.size() * 2);
+  for(unsigned int i(0); i < info.z.rows(); ++i){ // ISB column is filled for range rows of the second group
+    BOOST_CHECK(info.H(i, ins_gps_isb_t::P_SIZE - 1) == 0 || info.H(i, ins_gps_isb_t::P_SIZE - 1) == -1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(isb_estimation){
+  scenario_t scenario;
+  scenario.solver.groups = 2;
+  scenario.sigma_range = 1;
+  scenario.sigma_doppler = 0.1;
+  ins_gps_isb_t ins_gps(scenario);
+  BOOST_CHECK_EQUAL(ins_gps.inter_system_bias(), 0);
+
+  space_node_t::gps_time_t t(scenario.t0);
+  GPS_RawData<double> gps(scenario.observe(t));
+  { // clock error and ISB are initialized with the grouped snapshot solution as INS_GPS does
+    const solver_base_t::pos_t pos_init = {space_node_t::xyz_t(), space_node_t::llh_t()};
+    solver_base_t::user_pvt_t pvt(scenario.solver.solver_base_t::solve_user_pvt(
+        gps.measurement, t, pos_init, 0, false)); // reference implementation supporting groups
+    BOOST_REQUIRE(pvt.position_solved());
+    BOOST_REQUIRE_EQUAL(pvt.system_groups, 0x3u);
+    ins_gps.clock_error() = pvt.receiver_error;
+    ins_gps.inter_system_bias() = pvt.inter_system_bias[1];
+    BOOST_TEST_MESSAGE(format("ISB initialized: %f") % ins_gps.inter_system_bias());
+  }
+  for(int epoch(0); epoch < 30; ++epoch, t += 1){
+    if(epoch > 0){
+      for(int i(0); i < 10; ++i){ins_gps.update_static(0.1);}
+      gps = scenario.observe(t);
+    }
+    ins_gps.correct(gps);
+  }
+  const double sigma_isb(std::sqrt(ins_gps.getFilter().getP()(ins_gps_isb_t::P_SIZE - 1, ins_gps_isb_t::P_SIZE - 1)));
+  BOOST_TEST_MESSAGE(format("ISB: %f (true: %f), sigma: %f")
+      % ins_gps.inter_system_bias() % scenario.isb % sigma_isb);
+  BOOST_CHECK(sigma_isb < 1);
+  BOOST_CHECK_SMALL(ins_gps.inter_system_bias() - scenario.isb, 1.0);
+  BOOST_CHECK_SMALL(ins_gps.clock_error() - scenario.clock(t - 1), 2.0);
+  { // position is not biased by ISB
+    space_node_t::xyz_t pos(space_node_t::llh_t(
+        ins_gps.latitude(), ins_gps.longitude(), ins_gps.height()).xyz());
+    BOOST_CHECK_SMALL(pos.dist(scenario.usr), 3.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(isb_pvt){
+  // ISB of PVT solution, which is provided by the grouped solver with RAIM/FDE, is used.
+  scenario_t scenario;
+  ins_gps_isb_t ins_gps(scenario);
+  ins_gps_isb_t::raw_data_t::pvt_t pvt;
+  pvt.error_code = pvt.ERROR_NO;
+  pvt.clock_index = 0;
+  pvt.receiver_time = scenario.t0;
+  pvt.user_position.xyz = scenario.usr;
+  pvt.user_position.llh = scenario.usr.llh();
+  pvt.user_velocity_enu = space_node_t::enu_t(0, 0, 0);
+  pvt.receiver_error = scenario.clock_error;
+  pvt.receiver_error_rate = scenario.clock_error_rate;
+  pvt.hdop = pvt.vdop = pvt.pdop = 1;
+
+  pvt.system_groups = 0x1; // without the second group
+  const unsigned int rows(ins_gps.correct_info(pvt).z.rows());
+
+  pvt.system_groups = 0x3;
+  pvt.inter_system_bias[1] = scenario.isb;
+  CorrectInfo<double> info(ins_gps.correct_info(pvt));
+  BOOST_REQUIRE_EQUAL(info.z.rows(), rows + 1);
+  BOOST_CHECK_EQUAL(info.H(rows, ins_gps_isb_t::P_SIZE - 1), -1);
+  BOOST_CHECK_EQUAL(info.z(rows, 0), scenario.isb);
+
+  pvt.system_groups = 0x2; // only the second group, whose clock is the reference
+  BOOST_CHECK_EQUAL(ins_gps.correct_info(pvt).z.rows(), rows);
+
+  for(int i(0); i < 20; ++i){
+    pvt.system_groups = 0x3;
+    ins_gps.correct(pvt);
+  }
+  BOOST_CHECK_SMALL(ins_gps.inter_system_bias() - scenario.isb, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(debug_trace){
+  // Each filter holds its own trace writer, which is carried over by copy.
+  typedef INS_GPS_Debug_Covariance<INS_GPS2_Tightly<> > ins_gps_debug_t;
+  ins_gps_debug_t::prop_t prop;
+  BOOST_REQUIRE(prop.check_debug_property_spec("KF_P_trace"));
+  ins_gps_debug_t a, b;
+  a.setup_debug(prop);
+  b.setup_debug(prop);
+  std::stringstream ss_a, ss_b;
+  a.trace(ss_a, 0);
+  b.trace(ss_b, 0);
+  a.trace(ss_a, 1);
+  ins_gps_debug_t a2(a, true);
+  {
+    ins_gps_debug_t::mat_t P(a2.getFilter().getP());
+    P(0, 0) += 1;
+    a2.getFilter().setP(P);
+  }
+  a2.trace(ss_a, 2); // continued by the copy
+
+  const double t_a[] = {0, 1, 2}, t_b[] = {0};
+  std::stringstream *ss[] = {&ss_a, &ss_b};
+  const double *t_expected[] = {t_a, t_b};
+  const unsigned int records[] = {3, 1};
+  for(int k(0); k < 2; ++k){
+    DeltaTrace::Reader reader(*ss[k]);
+    BOOST_CHECK_EQUAL(reader.get_header().size, ins_gps_debug_t::P_SIZE);
+    double t;
+    std::vector<double> values;
+    for(unsigned int i(0); i < records[k]; ++i){
+      BOOST_REQUIRE(reader.read(t, values));
+      BOOST_CHECK_EQUAL(t, t_expected[k][i]);
+      const ins_gps_debug_t &target((k == 0) ? ((i < 2) ? a : a2) : b);
+      ins_gps_debug_t::mat_t P(const_cast<ins_gps_debug_t &>(target).getFilter().getP());
+      BOOST_CHECK_EQUAL(values[reader.get_header().index(0, 0)], P(0, 0));
+      BOOST_CHECK_EQUAL(values[reader.get_header().index(1, 2)], P(1, 2));
+    }
+    BOOST_CHECK(!reader.read(t, values));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,4 +1,11 @@
+#include <vector>
+#include <sstream>
+
 #include "analyze_common.h"
+#include "calibration.h"
+#include "util/delta_trace.h"
+#include "SylphideProcessor.h"
+#include "SylphideStream.h"
 
 #define BOOST_TEST_MAIN
 #include <boost/test/included/unit_test.hpp>
@@ -38,4 +45,242 @@ BOOST_AUTO_TEST_CASE(roll_over_monitor){
   BOOST_CHECK_EQUAL(true, monitor.abnormal_jump_detected);
 }
 
+BOOST_AUTO_TEST_CASE(calibration_inverse){
+  StandardCalibration<double> calib;
+  GlobalOptions<double>::set_typical_calibration_specs(calib);
+  static const char *specs[] = {
+    "acc_bias_tc 1 -2 3",
+    "acc_mis 1 0.01 -0.02 0.015 1 0.005 -0.01 0.02 1",
+    "gyro_mis 1 -0.03 0.01 0.02 1 -0.01 0.005 0.01 1",
+  };
+  BOOST_REQUIRE(calib.check_specs(specs, GlobalOptions<double>::get_value2));
+
+  double accel[] = {0.5, -1.5, -9.8}, omega[] = {0.1, -0.2, 0.3};
+  int raw[9] = {0};
+  raw[8] = 100; // temperature
+  calib.accel2raw(accel, raw);
+  calib.omega2raw(omega, raw);
+
+  StandardCalibration<double>::result_t
+      accel2(calib.raw2accel(raw)), omega2(calib.raw2omega(raw));
+  for(int i(0); i < 3; ++i){ // quantization error (< 1 LSB) remains
+    BOOST_CHECK_SMALL(accel2.values[i] - accel[i], 2. / calib.accel.sf[i]);
+    BOOST_CHECK_SMALL(omega2.values[i] - omega[i], 2. / calib.gyro.sf[i]);
+  }
+}
+
+struct delta_trace_mat_t {
+  double v[4][4];
+  double operator()(const unsigned int &i, const unsigned int &j) const {return v[i][j];}
+};
+
+BOOST_AUTO_TEST_CASE(delta_trace){
+  static const unsigned int n(4), steps(10);
+  DeltaTrace::header_t header(DeltaTrace::LAYOUT_UPPER_TRIANGLE, n, 3);
+  BOOST_REQUIRE_EQUAL(header.elements(), 10);
+  for(unsigned int i(0), k(0); i < n; ++i){
+    for(unsigned int j(i); j < n; ++j, ++k){
+      BOOST_CHECK_EQUAL(header.index(i, j), k);
+      BOOST_CHECK_EQUAL(header.index(j, i), k);
+      unsigned int row, column;
+      header.position(k, row, column);
+      BOOST_CHECK_EQUAL(row, i);
+      BOOST_CHECK_EQUAL(column, j);
+    }
+  }
+
+  delta_trace_mat_t mat;
+  std::stringstream ss;
+  {
+    DeltaTrace::Writer writer(ss, header);
+    for(unsigned int step(0); step < steps; ++step){
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){
+          mat.v[i][j] = mat.v[j][i] = (i == j) ? (1. + step * 0.1) : ((i + j) * 1E-3 / (step + 1));
+        }
+      }
+      mat.v[0][n - 1] = mat.v[n - 1][0] = (step % 2) ? -0. : 0.;
+      writer.write_matrix(step * 0.01, mat);
+    }
+  }
+  std::string encoded(ss.str());
+  BOOST_CHECK(encoded.size() < DeltaTrace::header_t::bytes + (13 + sizeof(double) * 10) * steps);
+
+  { // sequential
+    std::stringstream in(encoded);
+    DeltaTrace::Reader reader(in);
+    BOOST_CHECK_EQUAL(reader.get_header().size, n);
+    double t;
+    std::vector<double> values;
+    for(unsigned int step(0); step < steps; ++step){
+      BOOST_REQUIRE(reader.read(t, values));
+      BOOST_CHECK_EQUAL(t, step * 0.01);
+      BOOST_CHECK_EQUAL(values[header.index(1, 1)], 1. + step * 0.1);
+      BOOST_CHECK_EQUAL(values[header.index(2, 1)], 3E-3 / (step + 1));
+      BOOST_CHECK_EQUAL( // sign of zero is kept
+          DeltaTrace::to_bits(values[header.index(0, n - 1)]) >> 63, step % 2);
+    }
+    BOOST_CHECK(!reader.read(t, values));
+  }
+  { // seek over a keyframe
+    std::stringstream in(encoded);
+    DeltaTrace::Reader reader(in);
+    BOOST_REQUIRE(reader.seek(7));
+    BOOST_CHECK_EQUAL(reader.get_records(), 7);
+    double t;
+    std::vector<double> values;
+    BOOST_REQUIRE(reader.read(t, values));
+    BOOST_CHECK_EQUAL(t, 7 * 0.01);
+    BOOST_CHECK_EQUAL(values[header.index(3, 3)], 1. + 7 * 0.1);
+    BOOST_CHECK(!reader.seek(steps));
+  }
+  { // broken
+    std::stringstream in("DTRX");
+    BOOST_CHECK_THROW(DeltaTrace::Reader reader(in), std::runtime_error);
+    std::stringstream in2(encoded.substr(0, encoded.size() - 1));
+    DeltaTrace::Reader reader(in2);
+    BOOST_CHECK(reader.seek(steps - 1));
+    double t;
+    std::vector<double> values;
+    BOOST_CHECK_THROW(reader.read(t, values), std::runtime_error);
+  }
+  { // broken header, whose fields are validated before use
+    const std::string valid(encoded.substr(0, DeltaTrace::header_t::bytes));
+    std::string broken[4] = {valid, valid, valid, valid};
+    broken[0][4] = 2; // version
+    broken[1][5] = 2; // layout
+    broken[2].replace(8, 4, std::string("\xFF\xFF\x00\x00", 4)); // too large size
+    broken[3].replace(12, 4, std::string(4, '\0')); // keyframe interval
+    for(unsigned int i(0); i < sizeof(broken) / sizeof(broken[0]); ++i){
+      std::stringstream in(broken[i]);
+      BOOST_CHECK_THROW(DeltaTrace::Reader reader(in), std::runtime_error);
+    }
+  }
+  { // payload shorter than nibbles
+    std::string broken(encoded.substr(0, DeltaTrace::header_t::bytes + 13));
+    broken.replace(DeltaTrace::header_t::bytes + 9, 4, std::string("\x02\x00\x00\x00", 4));
+    broken.append(2, '\0');
+    std::stringstream in(broken);
+    DeltaTrace::Reader reader(in);
+    double t;
+    std::vector<double> values;
+    BOOST_CHECK_THROW(reader.read(t, values), std::runtime_error);
+  }
+}
+
+static std::vector<SylphideProcessor<double>::I_Observer_t::values_t> I_page_values;
+static std::vector<double> I_page_itow;
+static void I_page_handler(const SylphideProcessor<double>::I_Observer_t &observer){
+  I_page_values.push_back(observer.fetch_values());
+  I_page_itow.push_back(observer.fetch_ITOW());
+}
+
+BOOST_AUTO_TEST_CASE(I_page){
+  // Synthetic register dump of FIFO of MPU-9250, 21 bytes per record;
+  // accelerometer XYZ, temperature, gyro XYZ (big endian), and AK8963 via slave 0
+  static const unsigned int records(3), smplrt_div(1);
+  static const short accel[records][3] = {{0, -1, 4096}, {1, -2, 4096}, {-32768, 32767, -4096}};
+  static const short gyro[records][3] = {{0, 0, 0}, {3, -3, 0}, {100, -100, 1}};
+  static const short temperature(0x0A5A);
+  unsigned char fifo[records][21] = {{0}};
+  for(unsigned int i(0); i < records; ++i){
+    for(int j(0); j < 3; ++j){
+      fifo[i][j * 2] = (unsigned short)accel[i][j] >> 8;
+      fifo[i][j * 2 + 1] = (unsigned short)accel[i][j] & 0xFF;
+      fifo[i][j * 2 + 8] = (unsigned short)gyro[i][j] >> 8;
+      fifo[i][j * 2 + 9] = (unsigned short)gyro[i][j] & 0xFF;
+    }
+    fifo[i][6] = (unsigned short)temperature >> 8;
+    fifo[i][7] = (unsigned short)temperature & 0xFF;
+  }
+
+  // Pack them into I pages in the same manner as the firmware (mpu9250.c)
+  static const unsigned int itow_ms(123456);
+  SylphideProcessor<double> processor;
+  processor.set_i_handler(I_page_handler);
+  for(unsigned int i(0); i < records; i += 2){
+    char page[SYLPHIDE_PAGE_SIZE] = {0};
+    unsigned int samples((records - i) >= 2 ? 2 : 1);
+    unsigned int t(itow_ms - (records - i - samples) * (smplrt_div + 1));
+    page[0] = 'I';
+    page[1] = (char)((samples << 6) | smplrt_div);
+    page[2] = (char)(fifo[i + samples - 1][6] ^ 0x80);
+    for(int j(0); j < 4; ++j){
+      page[4 + j] = (char)((t >> (j * 8)) & 0xFF);
+    }
+    for(unsigned int k(0); k < samples; ++k){
+      for(int j(0); j < 12; ++j){
+        unsigned char v(fifo[i + k][j + (j < 6 ? 0 : 2)]);
+        page[8 + k * 12 + j] = (char)((j % 2) ? v : (v ^ 0x80));
+      }
+    }
+    processor.process(page, sizeof(page));
+  }
+
+  BOOST_REQUIRE_EQUAL(I_page_values.size(), 2);
+  BOOST_CHECK_EQUAL(I_page_values[0].samples, 2);
+  BOOST_CHECK_EQUAL(I_page_values[1].samples, 1);
+  for(unsigned int i(0), k(0); i < I_page_values.size(); ++i){
+    const SylphideProcessor<double>::I_Observer_t::values_t &values(I_page_values[i]);
+    BOOST_CHECK_EQUAL(values.interval_ms, smplrt_div + 1);
+    BOOST_CHECK_EQUAL(values.temperature >> 8, ((unsigned short)temperature ^ 0x8000) >> 8);
+    for(unsigned int j(0); j < values.samples; ++j, ++k){
+      // The same offset binary as A page
+      for(int l(0); l < 3; ++l){
+        BOOST_CHECK_EQUAL(values.values[j][l], (unsigned int)(accel[k][l] + 0x8000));
+        BOOST_CHECK_EQUAL(values.values[j][l + 3], (unsigned int)(gyro[k][l] + 0x8000));
+      }
+      BOOST_CHECK_CLOSE(
+          I_page_itow[i] + values.time_offset(j),
+          1E-3 * (itow_ms - (records - 1 - k) * (smplrt_div + 1)),
+          1E-9);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sylphide_stream_batch){
+  // Pages sent one by one (fixed length), or in a batch (variable length) by the firmware
+  static const struct {
+    unsigned int pages;
+    bool corrupted, accepted;
+  } packets[] = {
+    {1, false, true},
+    {4, false, true},
+    {16, false, true}, // maximum of cdc_pages
+    {2, true, false}, // CRC error
+    {3, false, false}, // not a power of 2
+    {32, false, false}, // exceeding the maximum
+    {1, true, false},
+    {8, false, true},
+  };
+  std::string stream, expected;
+  unsigned char c(0);
+  for(unsigned int i(0); i < sizeof(packets) / sizeof(packets[0]); ++i){
+    std::string payload;
+    for(unsigned int j(0); j < packets[i].pages * SYLPHIDE_PAGE_SIZE; ++j){
+      payload.push_back((char)(c++ & 0x7F)); // never be the header (0xF7)
+    }
+    std::stringstream ss;
+    {
+      SylphideOStream out(ss, payload.size());
+      out.write(payload.data(), payload.size());
+    }
+    std::string packet(ss.str());
+    BOOST_REQUIRE_EQUAL(packet.size(), SylphideProtocol::Encoder::packet_size(payload.size()));
+    if(packets[i].corrupted){packet[packet.size() / 2] ^= 0x01;}
+    stream += packet;
+    if(packets[i].accepted){expected += payload;}
+  }
+
+  std::stringstream ss(stream);
+  SylphideIStream in(ss, SYLPHIDE_PAGE_SIZE);
+  std::string decoded;
+  char page[SYLPHIDE_PAGE_SIZE];
+  while(in.read(page, sizeof(page)).gcount() > 0){
+    decoded.append(page, in.gcount());
+  }
+  BOOST_CHECK_EQUAL(decoded.size(), expected.size());
+  BOOST_CHECK(decoded == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
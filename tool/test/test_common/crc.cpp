@@ -0,0 +1,2 @@
+// CRC table required by SylphideStream.h
+#include "util/crc.cpp"
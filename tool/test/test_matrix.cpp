@@ -97,6 +97,16 @@ BOOST_AUTO_TEST_CASE(assign_null_matrix){
   matrix_compare(*A, _A);
 }
 
+BOOST_AUTO_TEST_CASE(copy_null_matrix){
+  matrix_t _A;
+  {
+    matrix_t __A(_A), ___A(__A);
+    BOOST_REQUIRE_EQUAL(__A.rows(), 0);
+    BOOST_REQUIRE_EQUAL(___A.columns(), 0);
+  }
+  BOOST_REQUIRE_EQUAL(_A.rows(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(properties){
   prologue_print();
   BOOST_TEST_MESSAGE("rows:" << A->rows());
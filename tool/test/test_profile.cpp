@@ -0,0 +1,90 @@
+#include <vector>
+#include <string>
+#include <sstream>
+
+/* The global operator new and delete are replaced in this test program only,
+ * because PROFILE_MAIN affects the whole program.
+ */
+#define USE_PROFILE
+#define PROFILE_MAIN
+#include "util/profile.h"
+#include "util/thread_pool.h"
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(profile)
+
+static std::vector<int> *profile_target(){
+  PROFILE_SCOPE("profile_target");
+  return new std::vector<int>(10);
+}
+
+static const Profile::entry_t *find_entry(
+    const std::vector<Profile::entry_t> &entries, const std::string &name){
+  for(std::vector<Profile::entry_t>::const_iterator it(entries.begin());
+      it != entries.end(); ++it){
+    if(it->name == name){return &(*it);}
+  }
+  return NULL;
+}
+
+BOOST_AUTO_TEST_CASE(scope_and_counter){
+  Profile::reset();
+  for(int i(0); i < 3; ++i){
+    delete profile_target();
+    PROFILE_COUNT("profile_counter");
+  }
+  { // same name in another site is merged
+    PROFILE_SCOPE("profile_target");
+  }
+
+  std::vector<Profile::entry_t> entries(Profile::summary());
+  BOOST_REQUIRE_EQUAL(entries.size(), 2);
+  const Profile::entry_t *target(find_entry(entries, "profile_target"));
+  BOOST_REQUIRE(target);
+  BOOST_CHECK_EQUAL(target->calls, 4);
+  BOOST_CHECK(target->seconds >= 0);
+  BOOST_CHECK_EQUAL(target->allocation.count, 6); // vector and its storage
+  BOOST_CHECK(target->allocation.bytes >= sizeof(int) * 10 * 3);
+  const Profile::entry_t *counter(find_entry(entries, "profile_counter"));
+  BOOST_REQUIRE(counter);
+  BOOST_CHECK_EQUAL(counter->calls, 3);
+  BOOST_CHECK_EQUAL(counter->seconds, 0);
+
+  std::stringstream ss;
+  Profile::report(ss, true);
+  BOOST_CHECK(ss.str().find("{\"name\": \"profile_target\", \"calls\": 4,") != std::string::npos);
+}
+
+struct profile_task_t {
+  unsigned int loops;
+  void operator()(const unsigned int &i){
+    for(unsigned int j(0); j < loops; ++j){
+      delete profile_target();
+      PROFILE_COUNT("profile_counter");
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(threads){
+  Profile::reset();
+  profile_task_t task = {1000};
+  ThreadPool pool(4);
+  static const unsigned int tasks(16);
+  pool.run(task, tasks);
+
+  // Neither calls nor allocations are lost or charged to a scope in another thread.
+  std::vector<Profile::entry_t> entries(Profile::summary());
+  const Profile::entry_t *target(find_entry(entries, "profile_target"));
+  BOOST_REQUIRE(target);
+  BOOST_CHECK_EQUAL(target->calls, task.loops * tasks);
+  BOOST_CHECK_EQUAL(target->allocation.count, task.loops * tasks * 2);
+  const Profile::entry_t *counter(find_entry(entries, "profile_counter"));
+  BOOST_REQUIRE(counter);
+  BOOST_CHECK_EQUAL(counter->calls, task.loops * tasks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,234 @@
+/**
+ * @file Converter of binary trace to CSV
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program converts a binary trace, which is generated by INS_GPS with
+ * --debug=KF_P_trace option, to a CSV table whose row consists of a step number,
+ * a time stamp, and values of selected elements.
+ *
+ * Its usage is
+ *   trace_CSV [option(s)] <trace_file>,
+ * where - (hyphen) for <trace_file> stands for the standard input.
+ *
+ * The options are
+ *   --steps=<first>[:<last>]
+ *     specifies the range of steps (0-origin, inclusive) to be output.
+ *     Its default is all steps. Steps before the last keyframe preceding <first> are
+ *     skipped without decoding.
+ *   --element=<index> or --element=<row>,<column>
+ *     specifies an element to be output, which can be specified multiple times.
+ *     <row>,<column> is available for a trace of a matrix, and the lower triangle is
+ *     mapped to the upper one. All elements are output if not specified.
+ *   --diag
+ *     adds the diagonal elements of a matrix to the output.
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <stdexcept>
+
+#include "util/delta_trace.h"
+
+#include "analyze_common.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  unsigned long step_first, step_last;
+  struct element_t {
+    int row, column; ///< row < 0 means that column is an index of element
+  };
+  vector<element_t> elements;
+  bool diag;
+
+  Options()
+      : super_t(),
+      step_first(0), step_last((unsigned long)-1), elements(), diag(false) {}
+  ~Options(){}
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+    if(value = get_value(spec, "steps", false)){
+      long first(-1), last(-1);
+      switch(std::sscanf(value, "%ld:%ld", &first, &last)){
+        case 1: last = -1; break;
+        case 2: if(last >= first){break;}
+        default: first = -1;
+      }
+      if(first < 0){
+        cerr << "(error!) Invalid steps!" << value << endl;
+        exit(-1);
+      }
+      step_first = (unsigned long)first;
+      step_last = (last < 0) ? (unsigned long)-1 : (unsigned long)last;
+      cerr << "steps: " << value << endl;
+      return true;
+    }
+    if(value = get_value(spec, "element", false)){
+      element_t e = {-1, -1};
+      switch(std::sscanf(value, "%d,%d", &e.row, &e.column)){
+        case 1: e.column = e.row; e.row = -1; break;
+        case 2: if(e.row >= 0){break;}
+        default: e.column = -1;
+      }
+      if(e.column < 0){
+        cerr << "(error!) Invalid element!" << value << endl;
+        exit(-1);
+      }
+      elements.push_back(e);
+      cerr << "element: " << value << endl;
+      return true;
+    }
+    if(value = get_value(spec, "diag", true)){
+      diag = is_true(value);
+      cerr << "diag: " << (diag ? "on" : "off") << endl;
+      return true;
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "Trace to CSV converter" << endl;
+  cerr << "Usage: (exe) [options] trace_file" << endl;
+  if(argc < 2){
+    cerr << "Error: too few arguments; " << argc << " < min(2)" << endl;
+    return -1;
+  }
+
+  int in_index(0);
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    if(in_index != 0){ // Detect unknown option by multiple substitution to in_index.
+      cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+      return -1;
+    }
+    in_index = i;
+  }
+
+  if(in_index == 0){
+    cerr << "(error!) No trace file." << endl;
+    return -1;
+  }
+
+  cerr << "Trace file: ";
+  istream &in(options.spec2istream(argv[in_index]));
+
+  try{
+    DeltaTrace::Reader reader(in);
+    const DeltaTrace::header_t &header(reader.get_header());
+    bool is_matrix(header.layout == DeltaTrace::LAYOUT_UPPER_TRIANGLE);
+    cerr << "Trace: " << (is_matrix ? "matrix " : "vector ") << header.size
+        << " (keyframe interval " << header.keyframe_interval << ")" << endl;
+
+    // Resolve selected elements
+    vector<unsigned int> indices;
+    for(vector<Options::element_t>::const_iterator it(options.elements.begin());
+        it != options.elements.end(); ++it){
+      unsigned int index;
+      if(it->row < 0){
+        index = (unsigned int)it->column;
+      }else if(is_matrix
+          && ((unsigned int)it->row < header.size) && ((unsigned int)it->column < header.size)){
+        index = header.index(it->row, it->column);
+      }else{
+        index = header.elements();
+      }
+      if(index >= header.elements()){
+        cerr << "(error!) Element out of range!" << endl;
+        return -1;
+      }
+      indices.push_back(index);
+    }
+    if(options.diag){
+      for(unsigned int i(0); i < header.size; ++i){
+        indices.push_back(header.index(i, i));
+      }
+    }
+    if(indices.empty()){
+      for(unsigned int i(0); i < header.elements(); ++i){indices.push_back(i);}
+    }
+
+    options.out() << "step,time";
+    for(vector<unsigned int>::const_iterator it(indices.begin()); it != indices.end(); ++it){
+      unsigned int row, column;
+      header.position(*it, row, column);
+      if(is_matrix){
+        options.out() << ",P(" << row << ";" << column << ")";
+      }else{
+        options.out() << ",v(" << column << ")";
+      }
+    }
+    options.out() << endl;
+    options.out() << setprecision(16);
+
+    double t;
+    vector<double> values;
+    for(reader.seek(options.step_first);
+        (reader.get_records() <= options.step_last) && reader.read(t, values); ){
+      options.out() << (reader.get_records() - 1) << ',' << t;
+      for(vector<unsigned int>::const_iterator it(indices.begin()); it != indices.end(); ++it){
+        options.out() << ',' << values[*it];
+      }
+      options.out() << endl;
+    }
+    cerr << "Steps: " << reader.get_records() << endl;
+  }catch(std::runtime_error &e){
+    cerr << "(error!) " << e.what() << endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,840 @@
+/**
+ * @file Unifier of multiple CSV time series
+ *
+ */
+
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program aligns multiple CSV time series, such as outputs of log_CSV and INS_GPS,
+ * and joins them into a single CSV, which is a native replacement of unify_csv.rb.
+ * Each input must be sorted by its time, which is GPS time of week [s]
+ * (cumulative GPS seconds are also acceptable); the roll over of week is compensated.
+ * Inputs are streamed through a k-way merge, and only two lines (the preceding and
+ * the following ones of the current output time) of each input are held,
+ * therefore the memory usage does not depend on the length of the inputs.
+ *
+ * Each output line consists of the time followed by the columns of the inputs
+ * except for their time (and index) columns; the columns of an input are blank
+ * when no value is available at the time. Separators of the inputs are comma or tab.
+ * The first line of an input whose time column is not numeric is treated as a header;
+ * if any input has a header, a header line is output. Other non-numeric lines are skipped.
+ *
+ * Its usage is
+ *   unify_csv [option(s)] csv_0 [csv_1 ...],
+ * where - (hyphen) stands for the standard input.
+ *
+ * The options are
+ *   --csv=<file>
+ *     specifies an input, which is equivalent to a positional argument.
+ *   --time_column=<n>
+ *     specifies the column (zero-based) of time of the following inputs (default 0).
+ *     For example, 1 is used for A page of log_CSV, whose first column is a counter.
+ *   --index_column=<n>, --index_interval=<seconds>
+ *     specify the column of sub-sample index and its interval for the following inputs,
+ *     whose time is corrected by (time + index * interval). They are used for M and P pages
+ *     of log_CSV, which combine several samples; for example, --index_column=1
+ *     --index_interval=0.01. A negative column disables the correction (default -1).
+ *   --reference=<n>
+ *     specifies the input (zero-based, in order of specification) whose time stamps
+ *     are used as output times. The others are resampled at the times.
+ *   --rate=<Hz>
+ *     specifies the output times as an equally spaced grid, on which all inputs are resampled.
+ *     If neither --reference nor --rate is specified, the output times are the union
+ *     of the time stamps of all inputs, which is the same as unify_csv.rb.
+ *   --interpolation=<none|nearest|linear>
+ *     specifies how to obtain values of an input at an output time (default none for the union,
+ *     otherwise linear). none uses only a line whose time is the same as the output time,
+ *     nearest uses the nearest line, and linear interpolates the preceding and following lines
+ *     in the same manner as magnetic sensor values in INS_GPS. A non-numeric column is
+ *     taken from the nearer line in linear interpolation.
+ *   --max_gap=<seconds>
+ *     specifies the maximum time difference between an output time and lines used for
+ *     nearest and linear interpolation (default 1). Farther lines are not used.
+ *   --tolerance=<seconds>
+ *     specifies time difference regarded as the same time (default 1E-6).
+ *   --precision=<n>
+ *     specifies significant digits of time and interpolated values (default 12).
+ *     Values which are not interpolated are copied as they are.
+ *   --week=<GPS week>
+ *     specifies the GPS week of the first line of the first input, which is required to
+ *     use week-qualified --start_gpst/--end_gpst and --calendar_time.
+ *   --calendar_time[=(+/-hr)]
+ *     changes the time column to (year, month, day, hour, min, sec) in UTC with the optional time zone.
+ *   --start_gpst=[week:]seconds, --end_gpst=[week:]seconds
+ *     specify the range of output times.
+ *   --out=<file>
+ *     specifies the output file; its default is the standard output.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "analyze_common.h"
+
+using namespace std;
+
+typedef double float_sylph_t;
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+  struct input_t {
+    const char *spec;
+    int time_column;
+    int index_column;
+    float_sylph_t index_interval;
+  };
+  vector<input_t> inputs;
+  input_t input_template; ///< settings applied to inputs specified later
+  int reference;
+  float_sylph_t rate;
+  enum interpolation_t {
+    INTERPOLATION_DEFAULT,
+    INTERPOLATION_NONE,
+    INTERPOLATION_NEAREST,
+    INTERPOLATION_LINEAR,
+  } interpolation;
+  float_sylph_t max_gap;
+  float_sylph_t tolerance;
+  int precision;
+  int week;
+  typedef CalendarTime<float_sylph_t> calendar_time_t;
+  calendar_time_t::Converter time_gps2local;
+  bool use_calendar_time;
+
+  Options()
+      : super_t(),
+      inputs(), reference(-1), rate(0),
+      interpolation(INTERPOLATION_DEFAULT),
+      max_gap(1), tolerance(1E-6), precision(12),
+      week(gps_time_t::WN_INVALID),
+      time_gps2local(), use_calendar_time(false) {
+    input_template.spec = NULL;
+    input_template.time_column = 0;
+    input_template.index_column = -1;
+    input_template.index_interval = 0;
+  }
+  ~Options(){}
+
+  void add_input(const char *spec){
+    input_t input(input_template);
+    input.spec = spec;
+    inputs.push_back(input);
+  }
+
+  /**
+   * Check spec
+   *
+   * @param spec
+   * @return (bool) True when interpreted, otherwise false.
+   */
+  bool check_spec(const char *spec){
+    const char *value;
+    if(value = get_value(spec, "csv", false)){
+      add_input(value);
+      return true;
+    }
+    if(value = get_value(spec, "time_column", false)){
+      input_template.time_column = std::atoi(value);
+      if(input_template.time_column < 0){
+        cerr << "(error!) Invalid time_column: " << value << endl;
+        exit(-1);
+      }
+      cerr << "time_column: " << input_template.time_column << endl;
+      return true;
+    }
+    if(value = get_value(spec, "index_column", false)){
+      input_template.index_column = std::atoi(value);
+      cerr << "index_column: " << input_template.index_column << endl;
+      return true;
+    }
+    if(value = get_value(spec, "index_interval", false)){
+      input_template.index_interval = std::atof(value);
+      cerr << "index_interval: " << input_template.index_interval << endl;
+      return true;
+    }
+    if(value = get_value(spec, "reference", false)){
+      reference = std::atoi(value);
+      cerr << "reference: " << reference << endl;
+      return true;
+    }
+    if(value = get_value(spec, "rate", false)){
+      rate = std::atof(value);
+      if(rate <= 0){
+        cerr << "(error!) Invalid rate: " << value << endl;
+        exit(-1);
+      }
+      cerr << "rate: " << rate << " [Hz]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "interpolation", false)){
+      if(std::strcmp(value, "none") == 0){
+        interpolation = INTERPOLATION_NONE;
+      }else if(std::strcmp(value, "nearest") == 0){
+        interpolation = INTERPOLATION_NEAREST;
+      }else if(std::strcmp(value, "linear") == 0){
+        interpolation = INTERPOLATION_LINEAR;
+      }else{
+        cerr << "(error!) Unknown interpolation: " << value << endl;
+        exit(-1);
+      }
+      cerr << "interpolation: " << value << endl;
+      return true;
+    }
+    if(value = get_value(spec, "max_gap", false)){
+      max_gap = std::atof(value);
+      cerr << "max_gap: " << max_gap << " [s]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "tolerance", false)){
+      tolerance = std::atof(value);
+      cerr << "tolerance: " << tolerance << " [s]" << endl;
+      return true;
+    }
+    if(value = get_value(spec, "precision", false)){
+      precision = std::atoi(value);
+      if((precision < 1) || (precision > 17)){
+        cerr << "(error!) Invalid precision: " << value << endl;
+        exit(-1);
+      }
+      cerr << "precision: " << precision << endl;
+      return true;
+    }
+    if(value = get_value(spec, "week", false)){
+      week = std::atoi(value);
+      cerr << "week: " << week << endl;
+      return true;
+    }
+    if(value = get_value(spec, "calendar_time")){
+      int correction_hr(0);
+      if(!is_true(value)){
+        correction_hr = std::atoi(value); // Specify time zone by hour.
+      }
+      use_calendar_time = true;
+      time_gps2local.correction_sec = 60 * 60 * correction_hr;
+      cerr << "use_calendar_time: UTC "
+          << (correction_hr >= 0 ? '+' : '-')
+          << correction_hr << " [hr]" << endl;
+      return true;
+    }
+    return super_t::check_spec(spec);
+  }
+} options;
+
+/**
+ * Parse a decimal number, which is faster than std::strtod for typical inputs.
+ * The result is exact when the number of significant digits is at most 15
+ * and the decimal exponent is small, because both the mantissa and the power of ten
+ * are exactly represented in double; otherwise std::strtod is used.
+ *
+ * @param str beginning of the number, which must be followed by a character
+ * which cannot be a part of a number, such as a separator or '\0'
+ * @param str_end end of the number
+ * @param res parsed value (output)
+ * @return (bool) true when [str, str_end) is entirely a number, otherwise false
+ */
+static bool parse_number(const char *str, const char *str_end, double &res){
+  static const double pow10[] = {
+    1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10,
+    1E11, 1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21, 1E22,
+  };
+  const char *p(str);
+  bool negative(false);
+  if((p < str_end) && ((*p == '-') || (*p == '+'))){negative = (*(p++) == '-');}
+  unsigned long long mantissa(0);
+  int digits(0), exponent(0);
+  bool has_digit(false);
+  for(; (p < str_end) && (*p >= '0') && (*p <= '9'); ++p){
+    has_digit = true;
+    if((mantissa == 0) && (*p == '0')){continue;} // leading zeros
+    if(digits < 19){
+      mantissa = mantissa * 10 + (*p - '0');
+    }else{
+      ++exponent; // dropped digit, which is handled by strtod below
+    }
+    ++digits;
+  }
+  if((p < str_end) && (*p == '.')){
+    for(++p; (p < str_end) && (*p >= '0') && (*p <= '9'); ++p){
+      has_digit = true;
+      if((mantissa == 0) && (*p == '0')){
+        --exponent;
+        continue;
+      }
+      if(digits < 19){
+        mantissa = mantissa * 10 + (*p - '0');
+        --exponent;
+      }
+      ++digits;
+    }
+  }
+  if(!has_digit){
+    return false;
+  }
+  if((p < str_end) && ((*p == 'e') || (*p == 'E'))){
+    ++p;
+    bool exp_negative(false);
+    if((p < str_end) && ((*p == '-') || (*p == '+'))){exp_negative = (*(p++) == '-');}
+    if((p == str_end) || (*p < '0') || (*p > '9')){return false;}
+    int exp_value(0);
+    for(; (p < str_end) && (*p >= '0') && (*p <= '9'); ++p){
+      if(exp_value < 10000){exp_value = exp_value * 10 + (*p - '0');}
+    }
+    exponent += (exp_negative ? -exp_value : exp_value);
+  }
+  if(p != str_end){return false;}
+  if((digits <= 15) && (exponent >= -22) && (exponent <= 22)){
+    res = (double)mantissa;
+    res = (exponent < 0) ? (res / pow10[-exponent]) : (res * pow10[exponent]);
+  }else{ // slow path
+    char *p_end;
+    res = std::strtod(str, &p_end);
+    if(p_end != str_end){return false;}
+    return true;
+  }
+  if(negative){res = -res;}
+  return true;
+}
+
+/**
+ * Format a number in the same manner as std::printf("%.*g"), which is faster for typical values.
+ * Unusual values, such as tiny, huge, or non-finite ones, and precision more than 15
+ * are formatted by std::sprintf, as well as values close to the midpoint of rounding,
+ * whose last digit depends on the exact decimal expansion.
+ *
+ * @param str destination, whose size must be at least 32
+ * @param v value
+ * @param precision significant digits (1-17)
+ * @return (int) length of the string
+ */
+static int format_number(char *str, const double &v, const int &precision){
+  static const unsigned long long pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL,
+  };
+  if(precision > 15){ // scaled value may not be exact in double
+    return std::sprintf(str, "%.*g", precision, v);
+  }
+  double abs_v(v < 0 ? -v : v);
+  if(abs_v == 0){
+    str[0] = '0';
+    str[1] = '\0';
+    return 1;
+  }
+  int digits(1); // of integer part
+  while((digits < precision) && (abs_v >= (double)pow10[digits])){++digits;}
+  if((!(abs_v >= 1E-4)) || (abs_v >= (double)pow10[digits])){ // exponential notation or NaN
+    return std::sprintf(str, "%.*g", precision, v);
+  }
+  int decimals(precision - digits);
+  if(abs_v < 1){
+    decimals = precision;
+    for(double threshold(0.1); abs_v < threshold; threshold *= 0.1){++decimals;}
+  }
+  double scaled(abs_v * std::pow(10., decimals)), scaled_floor(std::floor(scaled));
+  if((decimals > 17)
+      || (std::abs(scaled - scaled_floor - 0.5) <= scaled * DBL_EPSILON)){ // close to midpoint
+    return std::sprintf(str, "%.*g", precision, v);
+  }
+  unsigned long long n((unsigned long long)(scaled + 0.5));
+  if(n >= pow10[precision]){ // carry, such as 9.99.. to 10.0
+    return std::sprintf(str, "%.*g", precision, v);
+  }
+  char *p(str);
+  if(v < 0){*(p++) = '-';}
+  unsigned long long integer(n / pow10[decimals]), fraction(n % pow10[decimals]);
+  char buf[24], *q(buf + sizeof(buf));
+  do{
+    *(--q) = (char)('0' + (integer % 10));
+  }while((integer /= 10) > 0);
+  while(q < buf + sizeof(buf)){*(p++) = *(q++);}
+  if(fraction > 0){
+    *(p++) = '.';
+    for(; fraction % 10 == 0; fraction /= 10, --decimals); // remove trailing zeros
+    for(int i(decimals - 1); i >= 0; --i){
+      p[i] = (char)('0' + (fraction % 10));
+      fraction /= 10;
+    }
+    p += decimals;
+  }
+  *p = '\0';
+  return (int)(p - str);
+}
+
+/**
+ * Line of CSV, whose fields are kept as texts and parsed on demand
+ */
+struct row_t {
+  std::string line;
+  struct field_t {
+    std::string::size_type offset, length;
+  };
+  std::vector<field_t> fields; ///< fields to be output, i.e., except for time and index
+  float_sylph_t t; ///< time, which is continuous over week boundaries
+  std::vector<float_sylph_t> values; ///< parsed fields, NaN for non-numeric one
+  bool values_parsed;
+
+  row_t() : line(), fields(), t(0), values(), values_parsed(false) {}
+
+  const float_sylph_t &value(const unsigned int &i){
+    if(!values_parsed){
+      values.resize(fields.size());
+      for(unsigned int j(0); j < fields.size(); ++j){
+        const char *p(line.data() + fields[j].offset);
+        if(!parse_number(p, p + fields[j].length, values[j])){
+          values[j] = std::numeric_limits<float_sylph_t>::quiet_NaN();
+        }
+      }
+      values_parsed = true;
+    }
+    return values[i];
+  }
+};
+
+/**
+ * CSV input holding two lines around the current output time
+ */
+struct csv_source_t {
+  typedef CalendarTime<float_sylph_t>::Converter::roll_over_monitor_t monitor_t;
+  istream &in;
+  std::vector<char> buffer;
+  std::vector<char>::size_type buffer_head, buffer_tail;
+  const Options::input_t &spec;
+  monitor_t monitor;
+  bool t_valid;
+  row_t rows[2];
+  row_t *prev, *next; ///< lines at/before and after the current output time, respectively
+  bool has_prev, has_next;
+  bool fresh; ///< true when prev has not been output yet
+  std::vector<row_t::field_t> spans; ///< work area to split a line
+  std::vector<std::string> header;
+  unsigned int columns; ///< number of fields to be output
+  unsigned long lines, skipped, irregular, unsorted;
+
+  csv_source_t(istream &in_, const Options::input_t &spec_)
+      : in(in_), buffer(0x10000), buffer_head(0), buffer_tail(0), spec(spec_), monitor(), t_valid(false),
+      prev(&rows[0]), next(&rows[1]),
+      has_prev(false), has_next(false), fresh(false),
+      spans(), header(), columns(0),
+      lines(0), skipped(0), irregular(0), unsorted(0) {
+    has_next = read(*next);
+  }
+
+  /**
+   * Read a line, which is faster than std::getline due to block read
+   *
+   * @param line destination, which does not contain the line terminator
+   * @return (bool) false when the input is exhausted, otherwise true
+   */
+  bool read_line(std::string &line){
+    line.clear();
+    while(true){
+      if(buffer_head == buffer_tail){
+        in.read(&buffer[0], buffer.size());
+        if(in.gcount() <= 0){return !line.empty();}
+        buffer_head = 0;
+        buffer_tail = in.gcount();
+      }
+      const char *head(&buffer[buffer_head]);
+      const char *found((const char *)std::memchr(head, '\n', buffer_tail - buffer_head));
+      if(found){
+        line.append(head, found);
+        buffer_head += (found - head) + 1;
+        return true;
+      }
+      line.append(head, buffer_tail - buffer_head);
+      buffer_head = buffer_tail;
+    }
+  }
+
+  /**
+   * Read a line which has a numeric time
+   *
+   * @param row destination
+   * @return (bool) false when the input is exhausted, otherwise true
+   */
+  bool read(row_t &row){
+    while(read_line(row.line)){
+      ++lines;
+      std::string::size_type length(row.line.size());
+      if((length > 0) && (row.line[length - 1] == '\r')){row.line.resize(--length);}
+      if(length == 0){continue;}
+
+      // Split into fields with trimming spaces
+      spans.clear();
+      const char *head(row.line.data()), *end(head + length);
+      for(const char *p(head); ; ++p){
+        const char *p_end(p);
+        while((p_end < end) && (*p_end != ',') && (*p_end != '\t')){++p_end;}
+        const char *p_next(p_end);
+        while((p < p_end) && (*p == ' ')){++p;}
+        while((p < p_end) && (*(p_end - 1) == ' ')){--p_end;}
+        row_t::field_t span = {
+            (std::string::size_type)(p - head), (std::string::size_type)(p_end - p)};
+        spans.push_back(span);
+        if((p = p_next) >= end){break;}
+      }
+
+      double itow, index(0);
+      if((spans.size() <= (unsigned int)spec.time_column)
+          || (!parse_number(head + spans[spec.time_column].offset,
+            head + spans[spec.time_column].offset + spans[spec.time_column].length, itow))
+          || ((spec.index_column >= 0)
+            && ((spans.size() <= (unsigned int)spec.index_column)
+              || (!parse_number(head + spans[spec.index_column].offset,
+                head + spans[spec.index_column].offset + spans[spec.index_column].length, index))))){
+        if(t_valid || (lines > 1)){ // non-numeric
+          ++skipped;
+        }else{ // header
+          for(unsigned int i(0); i < spans.size(); ++i){
+            if(((int)i == spec.time_column) || ((int)i == spec.index_column)){continue;}
+            header.push_back(row.line.substr(spans[i].offset, spans[i].length));
+          }
+          columns = header.size();
+        }
+        continue;
+      }
+
+      row.fields.clear();
+      for(unsigned int i(0); i < spans.size(); ++i){
+        if(((int)i == spec.time_column) || ((int)i == spec.index_column)){continue;}
+        row.fields.push_back(spans[i]);
+      }
+      if(columns == 0){
+        columns = row.fields.size();
+      }else if(row.fields.size() != columns){
+        ++irregular;
+      }
+
+      if(!t_valid){
+        monitor.itow_previous = itow; // to prevent false detection of roll over
+        t_valid = true;
+      }
+      row.t = monitor(itow);
+      if(spec.index_column >= 0){row.t += index * spec.index_interval;}
+      row.values_parsed = false;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Move to the next line
+   */
+  void shift(){
+    std::swap(prev, next);
+    has_prev = fresh = true;
+    if((has_next = read(*next)) && (next->t < prev->t - options.tolerance)){
+      ++unsorted;
+    }
+  }
+
+  /**
+   * Move to the line at or just before the time
+   */
+  void shift_until(const float_sylph_t &t){
+    while(has_next && (next->t <= t + options.tolerance)){shift();}
+  }
+
+  /**
+   * Append values at the time
+   *
+   * @param buf destination
+   * @param t time
+   */
+  void append(std::string &buf, const float_sylph_t &t){
+    row_t *src[2] = {NULL, NULL}; // nearer, farther
+    switch(options.interpolation){
+      case Options::INTERPOLATION_NONE:
+        if(fresh && (std::abs(prev->t - t) <= options.tolerance)){
+          src[0] = prev;
+          fresh = false;
+        }
+        break;
+      default: {
+        float_sylph_t
+            gap_prev(has_prev ? std::abs(prev->t - t) : options.max_gap + 1),
+            gap_next(has_next ? std::abs(next->t - t) : options.max_gap + 1);
+        if(gap_prev <= options.max_gap){
+          src[0] = prev;
+          if(gap_next <= options.max_gap){
+            src[1] = next;
+            if(gap_next < gap_prev){std::swap(src[0], src[1]);}
+          }
+        }else if(gap_next <= options.max_gap){
+          src[0] = next;
+        }
+        fresh = false;
+      }
+    }
+
+    bool interpolated((options.interpolation == Options::INTERPOLATION_LINEAR)
+        && src[1] && (next->t - prev->t > options.tolerance));
+    float_sylph_t weight_prev(0);
+    if(interpolated){
+      weight_prev = (next->t - t) / (next->t - prev->t);
+      if(weight_prev >= 1){ // t is (almost) the same as prev
+        interpolated = false;
+      }else if(weight_prev <= 0){
+        interpolated = false;
+      }
+    }
+
+    for(unsigned int i(0); i < columns; ++i){
+      buf += ',';
+      if(!src[0] || (i >= src[0]->fields.size())){continue;}
+      if(interpolated){
+        float_sylph_t v_prev(prev->value(i)), v_next(next->value(i));
+        if((v_prev == v_prev) && (v_next == v_next) // both are numeric
+            && (v_prev != v_next)){ // otherwise the original text is copied
+          char str[32];
+          buf.append(str, format_number(str,
+              v_prev * weight_prev + v_next * (1. - weight_prev), options.precision));
+          continue;
+        }
+      }
+      const row_t::field_t &field(src[0]->fields[i]);
+      buf.append(src[0]->line.data() + field.offset, field.length);
+    }
+  }
+};
+
+int main(int argc, char *argv[]){
+
+  cerr << setprecision(10);
+
+  cerr << "CSV unifier" << endl;
+  cerr << "Usage: (exe) [options] csv_0 [csv_1 ...]" << endl;
+
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    if((argv[i][0] == '-') && (argv[i][1] == '-')){
+      cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+      return -1;
+    }
+    options.add_input(argv[i]);
+  }
+  if(options.inputs.empty()){
+    cerr << "(error!) No input." << endl;
+    return -1;
+  }
+  if(options.reference >= (int)options.inputs.size()){
+    cerr << "(error!) Invalid reference: " << options.reference << endl;
+    return -1;
+  }
+  if((options.reference >= 0) && (options.rate > 0)){
+    cerr << "(error!) --reference and --rate are exclusive." << endl;
+    return -1;
+  }
+  if(options.use_calendar_time && (options.week == Options::gps_time_t::WN_INVALID)){
+    cerr << "(error!) --calendar_time requires --week." << endl;
+    return -1;
+  }
+  if(options.interpolation == Options::INTERPOLATION_DEFAULT){
+    options.interpolation = ((options.reference >= 0) || (options.rate > 0))
+        ? Options::INTERPOLATION_LINEAR
+        : Options::INTERPOLATION_NONE;
+  }
+
+  std::vector<csv_source_t *> sources;
+  for(unsigned int i(0); i < options.inputs.size(); ++i){
+    cerr << "CSV[" << i << "]: ";
+    sources.push_back(new csv_source_t(
+        options.spec2istream(options.inputs[i].spec), options.inputs[i]));
+  }
+
+  // Align roll over of week; the first line of the first available input is the basis.
+  float_sylph_t t_base(0);
+  bool t_base_valid(false);
+  for(unsigned int i(0); i < sources.size(); ++i){
+    csv_source_t &src(*sources[i]);
+    if(!src.has_next){continue;}
+    if(!t_base_valid){
+      t_base = src.next->t;
+      t_base_valid = true;
+      continue;
+    }
+    static const int one_week(csv_source_t::monitor_t::one_week);
+    while(src.next->t - t_base > (one_week / 2)){
+      src.monitor.roll_over_offset -= one_week;
+      src.next->t -= one_week;
+    }
+    while(src.next->t - t_base < -(one_week / 2)){
+      src.monitor.roll_over_offset += one_week;
+      src.next->t += one_week;
+    }
+  }
+  float_sylph_t week_offset(0);
+  if(t_base_valid){
+    week_offset = -std::floor(t_base / csv_source_t::monitor_t::one_week);
+  }
+
+  ostream &out(options.out());
+  std::string buf;
+  char str[64];
+
+  { // header
+    bool has_header(false);
+    for(unsigned int i(0); i < sources.size(); ++i){
+      if(!sources[i]->header.empty()){has_header = true;}
+    }
+    if(has_header){
+      buf += (options.use_calendar_time ? "year,month,mday,hour,min,sec" : "itow");
+      for(unsigned int i(0); i < sources.size(); ++i){
+        for(unsigned int j(0); j < sources[i]->columns; ++j){
+          buf += ',';
+          if(j < sources[i]->header.size()){buf += sources[i]->header[j];}
+        }
+      }
+      buf += '\n';
+    }
+  }
+
+  // Grid for --rate
+  long long grid_index(0);
+  if(options.rate > 0){
+    float_sylph_t t_min(0);
+    bool t_min_valid(false);
+    for(unsigned int i(0); i < sources.size(); ++i){
+      if(!sources[i]->has_next){continue;}
+      if((!t_min_valid) || (sources[i]->next->t < t_min)){
+        t_min = sources[i]->next->t;
+        t_min_valid = true;
+      }
+    }
+    grid_index = (long long)std::ceil((t_min - options.tolerance) * options.rate);
+  }
+
+  unsigned long long outputs(0);
+  while(true){
+    float_sylph_t t;
+    if(options.reference >= 0){
+      csv_source_t &ref(*sources[options.reference]);
+      if(!ref.has_next){break;}
+      t = ref.next->t;
+      ref.shift();
+      for(unsigned int i(0); i < sources.size(); ++i){
+        if((int)i != options.reference){sources[i]->shift_until(t);}
+      }
+    }else if(options.rate > 0){
+      t = (float_sylph_t)(grid_index++) / options.rate;
+      bool finished(true);
+      for(unsigned int i(0); i < sources.size(); ++i){
+        csv_source_t &src(*sources[i]);
+        src.shift_until(t);
+        if(src.has_next || (src.has_prev && (src.prev->t >= t - options.tolerance))){
+          finished = false;
+        }
+      }
+      if(finished){break;}
+    }else{
+      // k-way merge; the number of inputs is small, therefore linear search is used.
+      int selected(-1);
+      for(unsigned int i(0); i < sources.size(); ++i){
+        if(!sources[i]->has_next){continue;}
+        if((selected < 0) || (sources[i]->next->t < sources[selected]->next->t)){
+          selected = i;
+        }
+      }
+      if(selected < 0){break;}
+      t = sources[selected]->next->t;
+      for(unsigned int i(0); i < sources.size(); ++i){
+        csv_source_t &src(*sources[i]);
+        if(src.has_next && (src.next->t <= t + options.tolerance)){src.shift();}
+      }
+    }
+
+    // GPS time of the output
+    float_sylph_t t_week(std::floor(t / csv_source_t::monitor_t::one_week));
+    float_sylph_t itow(t - t_week * csv_source_t::monitor_t::one_week);
+    int wn(Options::gps_time_t::WN_INVALID);
+    if(options.week != Options::gps_time_t::WN_INVALID){
+      wn = options.week + (int)(t_week + week_offset);
+    }
+    if(!options.is_time_after_start(itow, wn)){continue;}
+    if(!options.is_time_before_end(itow, wn)){break;}
+
+    if(options.use_calendar_time){
+      Options::calendar_time_t t2(options.time_gps2local.convert(itow, wn));
+      std::sprintf(str, "%d,%d,%d,%d,%d,%.*g",
+          t2.year, t2.month, t2.mday, t2.hour, t2.min, options.precision, t2.sec);
+    }else{
+      format_number(str, itow, options.precision);
+    }
+    buf += str;
+    for(unsigned int i(0); i < sources.size(); ++i){
+      sources[i]->append(buf, t);
+    }
+    buf += '\n';
+    ++outputs;
+
+    if(buf.size() >= 0x10000){
+      out.write(buf.data(), buf.size());
+      buf.clear();
+    }
+  }
+  out.write(buf.data(), buf.size());
+  out.flush();
+
+  for(unsigned int i(0); i < sources.size(); ++i){
+    csv_source_t &src(*sources[i]);
+    cerr << "CSV[" << i << "]: " << src.lines << " [lines]";
+    if(src.skipped > 0){cerr << ", " << src.skipped << " skipped";}
+    if(src.irregular > 0){cerr << ", " << src.irregular << " with irregular columns";}
+    cerr << endl;
+    if(src.unsorted > 0){
+      cerr << "(warning!) CSV[" << i << "] is not sorted by time at "
+          << src.unsorted << " line(s)." << endl;
+    }
+    if(src.monitor.abnormal_jump_detected){
+      cerr << "(warning!) Time of CSV[" << i << "] jumps." << endl;
+    }
+    delete sources[i];
+  }
+
+  cerr << "Unified: " << outputs << " [lines]" << endl;
+
+  return 0;
+}
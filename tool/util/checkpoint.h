@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+/** @file
+ * @brief Binary checkpoint of object states
+ *
+ * A checkpoint consists of a header followed by values, all of which are little endian.
+ *
+ * Header
+ *   "NSCK", version (u8, 1), reserved (u8 x 3), signature length (u32), signature
+ * The signature identifies the layout of the following values, for example a type name,
+ * and a checkpoint is rejected when it is restored with another signature.
+ *
+ * Values
+ *   bool (u8), integers (32 or 64 bits), floating point numbers (bits of IEEE 754),
+ *   and containers, each of which is (number of elements (u32), elements).
+ * Floating point numbers are stored in bits so that restored states are bitwise identical.
+ *
+ * An object to be checkpointed provides
+ * @code
+ * template <class Archive> void checkpoint(Archive &ar){ar & member1 & member2;}
+ * @endcode
+ * which is used for both saving (Checkpoint::Writer) and restoring (Checkpoint::Reader);
+ * Archive::loading distinguishes them when necessary.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <map>
+#include <cstring>
+#include <stdexcept>
+
+template <class FloatT> class Vector3;
+template <class FloatT> class Quaternion;
+template <class T, class Array2D_Type, class ViewType> class Matrix;
+
+struct Checkpoint {
+  typedef unsigned long long bits_t;
+  static const unsigned int version = 1;
+
+  static bits_t to_bits(const double &v){
+    bits_t res;
+    std::memcpy(&res, &v, sizeof(res));
+    return res;
+  }
+  static double from_bits(const bits_t &bits){
+    double res;
+    std::memcpy(&res, &bits, sizeof(res));
+    return res;
+  }
+
+  class Writer {
+    protected:
+      std::ostream &out;
+      std::vector<char> buf;
+      void put(const bits_t &v, const unsigned int &bytes){
+        for(unsigned int i(0); i < bytes; ++i){buf.push_back((char)((v >> (i * 8)) & 0xFF));}
+      }
+      template <class Container>
+      Writer &sequence(Container &c){
+        unsigned int n((unsigned int)c.size());
+        put(n, 4);
+        for(typename Container::iterator it(c.begin()); it != c.end(); ++it){
+          *this & *it;
+        }
+        return *this;
+      }
+    public:
+      static const bool loading = false;
+      /**
+       * Constructor, which prepares a header
+       *
+       * @param out_ output stream, which should be opened in binary mode
+       * @param signature identifier of the layout of values
+       */
+      Writer(std::ostream &out_, const std::string &signature) : out(out_), buf() {
+        buf.insert(buf.end(), "NSCK", "NSCK" + 4);
+        put(version, 1);
+        put(0, 3);
+        put(signature.size(), 4);
+        buf.insert(buf.end(), signature.begin(), signature.end());
+      }
+      /**
+       * Destructor, which writes values to the stream if they are not written yet.
+       */
+      ~Writer(){
+        if(!buf.empty()){out.write(&buf[0], buf.size());}
+      }
+      /**
+       * Write all values to the stream at once
+       *
+       * @return (bool) true when success, otherwise false
+       */
+      bool flush(){
+        if(!buf.empty()){out.write(&buf[0], buf.size());}
+        buf.clear();
+        out.flush();
+        return out.good();
+      }
+      /**
+       * @return (std::size_t) size of values not written yet
+       */
+      std::size_t size() const {return buf.size();}
+
+      Writer &operator&(bool &v){put(v ? 1 : 0, 1); return *this;}
+      Writer &operator&(int &v){put((unsigned int)v, 4); return *this;}
+      Writer &operator&(unsigned int &v){put(v, 4); return *this;}
+      Writer &operator&(long long &v){put((bits_t)v, 8); return *this;}
+      Writer &operator&(unsigned long long &v){put(v, 8); return *this;}
+      Writer &operator&(double &v){put(to_bits(v), 8); return *this;}
+      Writer &operator&(float &v){
+        unsigned int bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        put(bits, 4);
+        return *this;
+      }
+      template <class E>
+      Writer &enumeration(E &v){
+        int i((int)v);
+        return *this & i;
+      }
+      template <class T>
+      Writer &operator&(T &v){
+        v.checkpoint(*this);
+        return *this;
+      }
+      template <class FloatT>
+      Writer &operator&(Vector3<FloatT> &v){
+        for(unsigned int i(0); i < 3; ++i){*this & v[i];}
+        return *this;
+      }
+      template <class FloatT>
+      Writer &operator&(Quaternion<FloatT> &q){
+        for(unsigned int i(0); i < 4; ++i){*this & q[i];}
+        return *this;
+      }
+      template <class T, class Array2D_Type, class ViewType>
+      Writer &operator&(Matrix<T, Array2D_Type, ViewType> &m){
+        unsigned int rows(m.rows()), columns(m.columns());
+        *this & rows & columns;
+        for(unsigned int i(0); i < rows; ++i){
+          for(unsigned int j(0); j < columns; ++j){*this & m(i, j);}
+        }
+        return *this;
+      }
+      template <class T, class Allocator>
+      Writer &operator&(std::vector<T, Allocator> &c){return sequence(c);}
+      template <class T, class Allocator>
+      Writer &operator&(std::deque<T, Allocator> &c){return sequence(c);}
+      template <class T, class Allocator>
+      Writer &operator&(std::list<T, Allocator> &c){return sequence(c);}
+      template <class K, class V, class Compare, class Allocator>
+      Writer &operator&(std::map<K, V, Compare, Allocator> &c){
+        unsigned int n((unsigned int)c.size());
+        put(n, 4);
+        for(typename std::map<K, V, Compare, Allocator>::iterator it(c.begin());
+            it != c.end(); ++it){
+          K k(it->first);
+          *this & k & it->second;
+        }
+        return *this;
+      }
+  };
+
+  class Reader {
+    protected:
+      std::istream &in;
+      bits_t get(const unsigned int &bytes){
+        char b[8];
+        in.read(b, bytes);
+        if(in.gcount() != (std::streamsize)bytes){
+          throw std::runtime_error("Checkpoint: truncated");
+        }
+        bits_t res(0);
+        for(unsigned int i(0); i < bytes; ++i){res |= ((bits_t)(unsigned char)b[i] << (i * 8));}
+        return res;
+      }
+      template <class Container>
+      Reader &sequence(Container &c){
+        unsigned int n((unsigned int)get(4));
+        c.clear();
+        for(unsigned int i(0); i < n; ++i){
+          typename Container::value_type v;
+          *this & v;
+          c.push_back(v);
+        }
+        return *this;
+      }
+    public:
+      static const bool loading = true;
+      /**
+       * Constructor, which reads and checks a header
+       *
+       * @param in_ input stream, which should be opened in binary mode
+       * @param signature identifier of the layout of values, which must be identical
+       * to the one used for saving
+       * @throw std::runtime_error when the header is invalid or its signature is different
+       */
+      Reader(std::istream &in_, const std::string &signature) : in(in_) {
+        char b[4];
+        in.read(b, sizeof(b));
+        if((in.gcount() != sizeof(b)) || (std::memcmp(b, "NSCK", 4) != 0)){
+          throw std::runtime_error("Checkpoint: invalid header");
+        }
+        if(get(1) != version){throw std::runtime_error("Checkpoint: unsupported version");}
+        get(3);
+        std::string signature_saved((std::string::size_type)get(4), '\0');
+        if(!signature_saved.empty()){
+          in.read(&signature_saved[0], signature_saved.size());
+        }
+        if(signature_saved != signature){
+          throw std::runtime_error("Checkpoint: signature mismatch");
+        }
+      }
+
+      Reader &operator&(bool &v){v = (get(1) != 0); return *this;}
+      Reader &operator&(int &v){v = (int)(unsigned int)get(4); return *this;}
+      Reader &operator&(unsigned int &v){v = (unsigned int)get(4); return *this;}
+      Reader &operator&(long long &v){v = (long long)get(8); return *this;}
+      Reader &operator&(unsigned long long &v){v = get(8); return *this;}
+      Reader &operator&(double &v){v = from_bits(get(8)); return *this;}
+      Reader &operator&(float &v){
+        unsigned int bits((unsigned int)get(4));
+        std::memcpy(&v, &bits, sizeof(v));
+        return *this;
+      }
+      template <class E>
+      Reader &enumeration(E &v){
+        int i;
+        *this & i;
+        v = (E)i;
+        return *this;
+      }
+      template <class T>
+      Reader &operator&(T &v){
+        v.checkpoint(*this);
+        return *this;
+      }
+      template <class FloatT>
+      Reader &operator&(Vector3<FloatT> &v){
+        Vector3<FloatT> v2;
+        for(unsigned int i(0); i < 3; ++i){*this & v2[i];}
+        v = v2; // assign newly allocated one in order not to affect its copies
+        return *this;
+      }
+      template <class FloatT>
+      Reader &operator&(Quaternion<FloatT> &q){
+        Quaternion<FloatT> q2;
+        for(unsigned int i(0); i < 4; ++i){*this & q2[i];}
+        q = q2;
+        return *this;
+      }
+      template <class T, class Array2D_Type, class ViewType>
+      Reader &operator&(Matrix<T, Array2D_Type, ViewType> &m){
+        unsigned int rows, columns;
+        *this & rows & columns;
+        Matrix<T, Array2D_Type, ViewType> m2(rows, columns);
+        for(unsigned int i(0); i < rows; ++i){
+          for(unsigned int j(0); j < columns; ++j){*this & m2(i, j);}
+        }
+        m = m2;
+        return *this;
+      }
+      template <class T, class Allocator>
+      Reader &operator&(std::vector<T, Allocator> &c){return sequence(c);}
+      template <class T, class Allocator>
+      Reader &operator&(std::deque<T, Allocator> &c){return sequence(c);}
+      template <class T, class Allocator>
+      Reader &operator&(std::list<T, Allocator> &c){return sequence(c);}
+      template <class K, class V, class Compare, class Allocator>
+      Reader &operator&(std::map<K, V, Compare, Allocator> &c){
+        unsigned int n((unsigned int)get(4));
+        c.clear();
+        for(unsigned int i(0); i < n; ++i){
+          K k;
+          V v;
+          *this & k & v;
+          c.insert(std::make_pair(k, v));
+        }
+        return *this;
+      }
+  };
+};
+
+#endif /* __CHECKPOINT_H__ */
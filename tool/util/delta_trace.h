@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __DELTA_TRACE_H__
+#define __DELTA_TRACE_H__
+
+/** @file
+ * @brief Binary trace of real-valued vectors or symmetric matrices with delta encoding
+ *
+ * A trace consists of a header followed by records, all of which are little endian.
+ *
+ * Header (16 bytes)
+ *   "DTRC", version (u8, 1), layout (u8), reserved (u16), size (u32), keyframe interval (u32)
+ * The layout is 0 for a vector of "size" elements, or 1 for the upper triangle
+ * (row major, diagonal included) of a symmetric "size" x "size" matrix,
+ * which has size * (size + 1) / 2 elements.
+ *
+ * Record
+ *   flags (u8, bit0 = keyframe), time (f64), payload length in bytes (u32), payload
+ * Each element is encoded as the bits of IEEE 754 double XORed with the bits of
+ * the same element in the previous record (or zero for a keyframe).
+ * Because a slowly changing value yields leading zero bytes, only the remaining lower bytes
+ * are stored. The numbers of the stored bytes (0-8) are packed into 4-bit nibbles
+ * (lower nibble first) at the beginning of the payload, and the stored bytes follow.
+ * Every (keyframe interval)-th record, beginning with the first one, is a keyframe,
+ * from which decoding can be started.
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+struct DeltaTrace {
+  typedef unsigned long long bits_t;
+
+  enum layout_t {
+    LAYOUT_VECTOR = 0,
+    LAYOUT_UPPER_TRIANGLE = 1,
+  };
+
+  struct header_t {
+    layout_t layout;
+    unsigned int size;
+    unsigned int keyframe_interval;
+
+    static const unsigned int bytes = 16;
+    /**
+     * Upper limit of elements in a record, which protects a reader from a broken header
+     */
+    static const unsigned int elements_max = 0x100000;
+
+    header_t(
+        const layout_t &layout_ = LAYOUT_VECTOR,
+        const unsigned int &size_ = 0,
+        const unsigned int &keyframe_interval_ = 0x100)
+        : layout(layout_), size(size_),
+        keyframe_interval(keyframe_interval_ > 0 ? keyframe_interval_ : 1) {}
+
+    /**
+     * @return (unsigned long long) number of elements in a record of the layout and size
+     */
+    static unsigned long long elements(const layout_t &layout, const unsigned int &size){
+      return (layout == LAYOUT_UPPER_TRIANGLE)
+          ? ((unsigned long long)size * (size + 1) / 2)
+          : size;
+    }
+    /**
+     * @return (unsigned int) number of elements in a record
+     */
+    unsigned int elements() const {
+      return (unsigned int)elements(layout, size);
+    }
+    /**
+     * @return (unsigned int) upper limit of payload length in bytes of a record
+     */
+    unsigned int payload_max() const {
+      unsigned int n(elements());
+      return ((n + 1) / 2) + (n * (unsigned int)sizeof(bits_t));
+    }
+    /**
+     * Convert a position of matrix to an element index
+     *
+     * @param row row index
+     * @param column column index
+     * @return (unsigned int) index of element, where the lower triangle is mapped to the upper one
+     */
+    unsigned int index(unsigned int row, unsigned int column) const {
+      if(layout != LAYOUT_UPPER_TRIANGLE){return column;}
+      if(row > column){std::swap(row, column);}
+      return row * size - (row * (row - 1) / 2) + (column - row);
+    }
+    /**
+     * Convert an element index to a position of matrix
+     *
+     * @param index index of element
+     * @param row row index (output)
+     * @param column column index (output)
+     */
+    void position(unsigned int index, unsigned int &row, unsigned int &column) const {
+      row = 0;
+      if(layout == LAYOUT_UPPER_TRIANGLE){
+        for(; (row < size) && (index >= (size - row)); ++row){index -= (size - row);}
+        column = row + index;
+      }else{
+        column = index;
+      }
+    }
+  };
+
+  static bits_t to_bits(const double &v){
+    bits_t res;
+    std::memcpy(&res, &v, sizeof(res));
+    return res;
+  }
+  static double from_bits(const bits_t &bits){
+    double res;
+    std::memcpy(&res, &bits, sizeof(res));
+    return res;
+  }
+
+  template <class T>
+  static void put_le(std::vector<char> &buf, const T &v, const unsigned int &bytes = sizeof(T)){
+    for(unsigned int i(0); i < bytes; ++i){buf.push_back((char)((v >> (i * 8)) & 0xFF));}
+  }
+  template <class T>
+  static T get_le(const char *buf, const unsigned int &bytes = sizeof(T)){
+    T res(0);
+    for(unsigned int i(0); i < bytes; ++i){res |= ((T)(unsigned char)buf[i] << (i * 8));}
+    return res;
+  }
+
+  class Writer {
+    protected:
+      std::ostream *out;
+      header_t header;
+      std::vector<bits_t> previous;
+      unsigned long records;
+      std::vector<char> nibbles, payload, buf;
+
+      void begin(){
+        buf.clear();
+        buf.insert(buf.end(), "DTRC", "DTRC" + 4);
+        put_le(buf, 1, 1); // version
+        put_le(buf, (unsigned int)header.layout, 1);
+        put_le(buf, 0, 2);
+        put_le(buf, header.size, 4);
+        put_le(buf, header.keyframe_interval, 4);
+        out->write(&buf[0], buf.size());
+        previous.assign(header.elements(), 0);
+        records = 0;
+      }
+      void add(const unsigned int &index, const double &v){
+        bits_t bits(to_bits(v)), diff(bits ^ previous[index]);
+        previous[index] = bits;
+        unsigned int bytes(0);
+        for(; (bytes < sizeof(bits_t)) && (diff >> (bytes * 8)); ++bytes);
+        put_le(payload, diff, bytes);
+        if(index % 2 == 0){
+          nibbles.push_back((char)bytes);
+        }else{
+          nibbles.back() |= (char)(bytes << 4);
+        }
+      }
+      template <class Functor>
+      void write(const double &t, Functor &values){
+        bool keyframe(records++ % header.keyframe_interval == 0);
+        if(keyframe){previous.assign(previous.size(), 0);}
+        nibbles.clear();
+        payload.clear();
+        for(unsigned int i(0), i_end(header.elements()); i < i_end; ++i){add(i, values(i));}
+        buf.clear();
+        put_le(buf, (keyframe ? 1 : 0), 1);
+        put_le(buf, to_bits(t), 8);
+        put_le(buf, (unsigned int)(nibbles.size() + payload.size()), 4);
+        out->write(&buf[0], buf.size());
+        if(!nibbles.empty()){out->write(&nibbles[0], nibbles.size());}
+        if(!payload.empty()){out->write(&payload[0], payload.size());}
+      }
+
+      struct array_values_t {
+        const double *values;
+        double operator()(const unsigned int &i) const {return values[i];}
+      };
+      template <class MatrixT>
+      struct matrix_values_t {
+        const MatrixT &mat;
+        const header_t &header;
+        double operator()(const unsigned int &i) const {
+          unsigned int row, column;
+          header.position(i, row, column);
+          return (double)mat(row, column);
+        }
+      };
+    public:
+      Writer() : out(NULL), header(), previous(), records(0), nibbles(), payload(), buf() {}
+      /**
+       * Constructor, which writes a header
+       *
+       * @param out_ output stream, which should be opened in binary mode
+       * @param header_ format
+       */
+      Writer(std::ostream &out_, const header_t &header_)
+          : out(&out_), header(header_), previous(), records(0), nibbles(), payload(), buf() {
+        begin();
+      }
+      bool is_open() const {return out != NULL;}
+      const header_t &get_header() const {return header;}
+      unsigned long get_records() const {return records;}
+
+      /**
+       * Write a record
+       *
+       * @param t time
+       * @param values array of header.elements() values
+       */
+      void write(const double &t, const double *values){
+        array_values_t f = {values};
+        write(t, f);
+      }
+      /**
+       * Write a record of matrix
+       *
+       * @param t time
+       * @param mat matrix whose element is accessible by mat(row, column).
+       * In case of LAYOUT_VECTOR, its first row is used.
+       */
+      template <class MatrixT>
+      void write_matrix(const double &t, const MatrixT &mat){
+        matrix_values_t<MatrixT> f = {mat, header};
+        write(t, f);
+      }
+  };
+
+  class Reader {
+    protected:
+      std::istream &in;
+      header_t header;
+      std::vector<bits_t> previous;
+      unsigned long records;
+      std::vector<char> buf;
+
+      bool read_record_header(bool &keyframe, double &t, unsigned int &length){
+        char b[13];
+        in.read(b, sizeof(b));
+        if(in.gcount() == 0){return false;}
+        if(in.gcount() != sizeof(b)){throw std::runtime_error("DeltaTrace: truncated record");}
+        keyframe = ((b[0] & 0x01) != 0);
+        t = from_bits(get_le<bits_t>(&b[1], 8));
+        length = get_le<unsigned int>(&b[9], 4);
+        // payload has at least the nibbles of all elements
+        if((length < (header.elements() + 1) / 2) || (length > header.payload_max())){
+          throw std::runtime_error("DeltaTrace: broken record");
+        }
+        return true;
+      }
+    public:
+      /**
+       * Constructor, which reads and validates a header
+       *
+       * @param in_ input stream, which should be opened in binary mode
+       * @throw std::runtime_error when the header is invalid
+       */
+      Reader(std::istream &in_) : in(in_), header(), previous(), records(0), buf(header_t::bytes) {
+        in.read(&buf[0], header_t::bytes);
+        if((in.gcount() != (std::streamsize)header_t::bytes)
+            || (std::memcmp(&buf[0], "DTRC", 4) != 0)){
+          throw std::runtime_error("DeltaTrace: invalid header");
+        }
+        if(get_le<unsigned int>(&buf[4], 1) != 1){
+          throw std::runtime_error("DeltaTrace: unsupported version");
+        }
+        unsigned int layout(get_le<unsigned int>(&buf[5], 1));
+        if((layout != LAYOUT_VECTOR) && (layout != LAYOUT_UPPER_TRIANGLE)){
+          throw std::runtime_error("DeltaTrace: unsupported layout");
+        }
+        unsigned int size(get_le<unsigned int>(&buf[8], 4)),
+            keyframe_interval(get_le<unsigned int>(&buf[12], 4));
+        if((keyframe_interval == 0)
+            || (header_t::elements((layout_t)layout, size) > header_t::elements_max)){
+          throw std::runtime_error("DeltaTrace: invalid size");
+        }
+        header = header_t((layout_t)layout, size, keyframe_interval);
+        previous.assign(header.elements(), 0);
+      }
+      const header_t &get_header() const {return header;}
+      /**
+       * @return (unsigned long) index of the next record
+       */
+      unsigned long get_records() const {return records;}
+
+      /**
+       * Read the next record
+       *
+       * @param t time (output)
+       * @param values values (output)
+       * @return (bool) true when a record is read, false at the end of trace
+       * @throw std::runtime_error when the trace is broken
+       */
+      bool read(double &t, std::vector<double> &values){
+        bool keyframe;
+        unsigned int length;
+        if(!read_record_header(keyframe, t, length)){return false;}
+        if((records % header.keyframe_interval == 0) != keyframe){
+          throw std::runtime_error("DeltaTrace: unexpected keyframe");
+        }
+        ++records;
+        if(keyframe){previous.assign(previous.size(), 0);}
+        buf.resize(length);
+        if((length > 0) && (in.read(&buf[0], length), in.gcount() != (std::streamsize)length)){
+          throw std::runtime_error("DeltaTrace: truncated record");
+        }
+        unsigned int n(header.elements()), offset((n + 1) / 2); // length >= offset is checked
+        values.resize(n);
+        for(unsigned int i(0); i < n; ++i){
+          unsigned int bytes((buf[i / 2] >> ((i % 2) * 4)) & 0x0F);
+          if((bytes > sizeof(bits_t)) || (offset + bytes > length)){
+            throw std::runtime_error("DeltaTrace: broken record");
+          }
+          previous[i] ^= get_le<bits_t>(&buf[0] + offset, bytes);
+          offset += bytes;
+          values[i] = from_bits(previous[i]);
+        }
+        if(offset != length){throw std::runtime_error("DeltaTrace: broken record");}
+        return true;
+      }
+
+      /**
+       * Move to a record. Records followed by the last keyframe before the target
+       * are skipped without decoding.
+       *
+       * @param index index of the target record, which can not be less than get_records()
+       * @return (bool) true when the next record is the target, false at the end of trace
+       */
+      bool seek(const unsigned long &index){
+        unsigned long keyframe_index(index - (index % header.keyframe_interval));
+        std::vector<double> values;
+        double t;
+        while(records < index){
+          if(records < keyframe_index){
+            bool keyframe;
+            unsigned int length;
+            if(!read_record_header(keyframe, t, length)){return false;}
+            in.seekg(length, std::ios::cur);
+            if(!in){return false;}
+            ++records;
+          }else if(!read(t, values)){
+            return false;
+          }
+        }
+        return in.peek() != std::char_traits<char>::eof();
+      }
+  };
+};
+
+#endif /* __DELTA_TRACE_H__ */
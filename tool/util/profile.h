@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+/** @file
+ * @brief Compile-time switchable instrumentation with scoped timers and counters
+ *
+ * Instrumentation points are written with the following macros;
+ *   PROFILE_SCOPE("name"); measures elapsed time until the end of the enclosing scope,
+ *   PROFILE_COUNT("name"); counts how many times the point is passed.
+ * They are expanded only when USE_PROFILE is defined, otherwise they vanish.
+ *
+ * Each point has its own static record. Records having the same name,
+ * for example, ones in different instantiations of a template, are summed up in the report.
+ * Elapsed time is inclusive; time of a nested scope is also counted in its outer scopes.
+ * Time is measured with the time stamp counter on x86, and with the steady clock otherwise.
+ *
+ * If PROFILE_MAIN is defined before inclusion in exactly one translation unit,
+ * the global operator new and delete are replaced in order to count allocations,
+ * which are attributed to the scopes where they occur. Because the replacement affects
+ * the whole program, PROFILE_MAIN should be defined only in a program to be profiled.
+ *
+ * With C++11 (or a compatible MSVC), the records are atomic counters and
+ * allocations are counted per thread, therefore the instrumented paths,
+ * for example, ones called from ThreadPool workers, may run concurrently;
+ * a scope is charged with the allocations of its own thread only.
+ * Otherwise, the instrumented paths are assumed to run in a single thread.
+ * In either case, reset() must not be called during measurement.
+ */
+
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if __cplusplus >= 201103L
+#include <chrono>
+#else
+#include <ctime>
+#endif
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#define PROFILE_THREAD_SAFE
+#include <atomic>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PROFILE_RDTSC() __rdtsc()
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILE_RDTSC() __rdtsc()
+#endif
+
+struct Profile {
+  typedef unsigned long long tick_t;
+
+  /**
+   * @return (double) current time in seconds with arbitrary origin
+   */
+  static double now(){
+#if __cplusplus >= 201103L
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+  }
+
+  static tick_t tick(){
+#if defined(PROFILE_RDTSC)
+    return PROFILE_RDTSC();
+#elif __cplusplus >= 201103L
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return std::clock();
+#endif
+  }
+
+  struct epoch_t {
+    tick_t tick;
+    double time;
+  };
+  /**
+   * @return (const epoch_t &) time when the profiling is started,
+   * which is used to convert ticks to seconds.
+   */
+  static const epoch_t &epoch(){
+    static const epoch_t res = {tick(), now()};
+    return res;
+  }
+
+  static double seconds_per_tick(){
+#if defined(PROFILE_RDTSC)
+    const epoch_t &e(epoch());
+    tick_t ticks(tick() - e.tick);
+    return (ticks > 0) ? ((now() - e.time) / ticks) : 0;
+#elif __cplusplus >= 201103L
+    return 1E-9;
+#else
+    return 1. / CLOCKS_PER_SEC;
+#endif
+  }
+
+#if defined(PROFILE_THREAD_SAFE)
+  typedef std::atomic<unsigned long long> counter_t;
+#else
+  typedef unsigned long long counter_t;
+#endif
+  static void add(counter_t &counter, const unsigned long long &delta){
+#if defined(PROFILE_THREAD_SAFE)
+    counter.fetch_add(delta, std::memory_order_relaxed);
+#else
+    counter += delta;
+#endif
+  }
+
+  struct allocation_t {
+    unsigned long long count, bytes;
+  };
+  /**
+   * @return (allocation_t &) allocations of the current thread
+   */
+  static allocation_t &allocation(){
+#if defined(PROFILE_THREAD_SAFE)
+    static thread_local allocation_t res = {0, 0};
+#else
+    static allocation_t res = {0, 0};
+#endif
+    return res;
+  }
+  struct allocation_counter_t {
+    counter_t count, bytes;
+  };
+  /**
+   * @return (allocation_counter_t &) allocations of all threads
+   */
+  static allocation_counter_t &allocation_total(){
+    static allocation_counter_t res; // zero-initialized
+    return res;
+  }
+  /**
+   * Record an allocation, which is called from the replaced operator new
+   */
+  static void allocated(const std::size_t &bytes){
+    allocation_t &current(allocation());
+    ++current.count;
+    current.bytes += bytes;
+    allocation_counter_t &total(allocation_total());
+    add(total.count, 1);
+    add(total.bytes, bytes);
+  }
+
+  struct site_t {
+    const char *name;
+    counter_t calls;
+    counter_t ticks;
+    allocation_counter_t allocation;
+    site_t *next;
+    site_t(const char *name_)
+        : name(name_), calls(0), ticks(0), next(NULL) {
+      allocation.count = allocation.bytes = 0;
+      epoch();
+#if defined(PROFILE_THREAD_SAFE)
+      // Sites in different threads may be registered concurrently.
+      next = head().load();
+      while(!head().compare_exchange_weak(next, this)){}
+#else
+      next = head();
+      head() = this;
+#endif
+    }
+  };
+#if defined(PROFILE_THREAD_SAFE)
+  typedef std::atomic<site_t *> head_t;
+#else
+  typedef site_t *head_t;
+#endif
+  static head_t &head(){
+    static head_t res(NULL);
+    return res;
+  }
+
+  /**
+   * Timer which adds elapsed time and allocations during its life to a site
+   */
+  struct scope_t {
+    site_t &site;
+    allocation_t allocation_begin;
+    tick_t tick_begin;
+    scope_t(site_t &site_)
+        : site(site_), allocation_begin(allocation()), tick_begin(tick()) {}
+    ~scope_t(){
+      add(site.ticks, tick() - tick_begin);
+      add(site.calls, 1);
+      const allocation_t &current(allocation());
+      add(site.allocation.count, current.count - allocation_begin.count);
+      add(site.allocation.bytes, current.bytes - allocation_begin.bytes);
+    }
+  };
+
+  struct entry_t {
+    std::string name;
+    unsigned long long calls;
+    double seconds;
+    allocation_t allocation;
+    bool operator<(const entry_t &another) const {
+      return (seconds != another.seconds)
+          ? (seconds > another.seconds)
+          : (calls > another.calls);
+    }
+  };
+  /**
+   * @return (std::vector<entry_t>) records merged by name, sorted in descending order of time
+   */
+  static std::vector<entry_t> summary(){
+    double sec_per_tick(seconds_per_tick());
+    std::map<std::string, entry_t> merged;
+    for(const site_t *site(head()); site; site = site->next){
+      if(site->calls == 0){continue;}
+      std::map<std::string, entry_t>::iterator it(merged.find(site->name));
+      if(it == merged.end()){
+        entry_t entry = {site->name, 0, 0, {0, 0}};
+        it = merged.insert(std::make_pair(entry.name, entry)).first;
+      }
+      it->second.calls += site->calls;
+      it->second.seconds += sec_per_tick * site->ticks;
+      it->second.allocation.count += site->allocation.count;
+      it->second.allocation.bytes += site->allocation.bytes;
+    }
+    std::vector<entry_t> res;
+    for(std::map<std::string, entry_t>::const_iterator it(merged.begin());
+        it != merged.end(); ++it){
+      res.push_back(it->second);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+  }
+
+  /**
+   * Clear all records
+   */
+  static void reset(){
+    for(site_t *site(head()); site; site = site->next){
+      site->calls = site->ticks = 0;
+      site->allocation.count = site->allocation.bytes = 0;
+    }
+  }
+
+  /**
+   * Print records
+   *
+   * @param out output stream
+   * @param json if true, the output is a JSON document, otherwise a table
+   */
+  static void report(std::ostream &out, const bool &json = false){
+    std::vector<entry_t> entries(summary());
+    double elapsed(now() - epoch().time);
+    const allocation_counter_t &total_counter(allocation_total());
+    const allocation_t total = {total_counter.count, total_counter.bytes};
+    std::ios::fmtflags flags(out.flags());
+    std::streamsize precision(out.precision());
+    if(json){
+      out << "{\"elapsed\": " << elapsed
+          << ", \"allocations\": " << total.count
+          << ", \"bytes\": " << total.bytes
+          << ", \"results\": [";
+      for(std::vector<entry_t>::const_iterator it(entries.begin());
+          it != entries.end(); ++it){
+        out << (it == entries.begin() ? "" : ",")
+            << "\n  {\"name\": \"" << it->name << "\""
+            << ", \"calls\": " << it->calls
+            << ", \"seconds\": " << it->seconds
+            << ", \"allocations\": " << it->allocation.count
+            << ", \"bytes\": " << it->allocation.bytes << "}";
+      }
+      out << (entries.empty() ? "" : "\n") << "]}" << std::endl;
+    }else{
+      out << "Profile (elapsed: " << elapsed << " [s], allocations: "
+          << total.count << " (" << total.bytes << " [bytes]))" << std::endl;
+      out << std::left << std::setw(48) << "name" << std::right
+          << std::setw(12) << "calls"
+          << std::setw(12) << "total[s]"
+          << std::setw(8) << "%"
+          << std::setw(12) << "[ns/call]"
+          << std::setw(12) << "allocs"
+          << std::setw(14) << "[bytes]" << std::endl;
+      out << std::fixed;
+      for(std::vector<entry_t>::const_iterator it(entries.begin());
+          it != entries.end(); ++it){
+        out << std::left << std::setw(48) << it->name << std::right
+            << std::setw(12) << it->calls
+            << std::setw(12) << std::setprecision(3) << it->seconds
+            << std::setw(8) << std::setprecision(1) << (elapsed > 0 ? (it->seconds / elapsed * 100) : 0)
+            << std::setw(12) << std::setprecision(0) << (it->seconds / it->calls * 1E9)
+            << std::setw(12) << it->allocation.count
+            << std::setw(14) << it->allocation.bytes << std::endl;
+      }
+    }
+    out.flags(flags);
+    out.precision(precision);
+  }
+};
+
+#define PROFILE_CONCAT2(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+#if defined(USE_PROFILE)
+#define PROFILE_SCOPE(name) \
+  static Profile::site_t PROFILE_CONCAT(profile_site_, __LINE__)(name); \
+  Profile::scope_t PROFILE_CONCAT(profile_scope_, __LINE__)(PROFILE_CONCAT(profile_site_, __LINE__))
+#define PROFILE_COUNT(name) { \
+  static Profile::site_t profile_site(name); \
+  Profile::add(profile_site.calls, 1); \
+}
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name)
+#endif
+
+#if defined(USE_PROFILE) && defined(PROFILE_MAIN)
+
+#if __cplusplus >= 201103L
+#define PROFILE_THROW_BAD_ALLOC
+#define PROFILE_NOTHROW noexcept
+#else
+#define PROFILE_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define PROFILE_NOTHROW throw()
+#endif
+
+void *operator new(std::size_t size) PROFILE_THROW_BAD_ALLOC {
+  Profile::allocated(size);
+  void *res(std::malloc(size > 0 ? size : 1));
+  if(!res){throw std::bad_alloc();}
+  return res;
+}
+void *operator new[](std::size_t size) PROFILE_THROW_BAD_ALLOC {
+  return operator new(size);
+}
+void operator delete(void *ptr) PROFILE_NOTHROW {
+  std::free(ptr);
+}
+void operator delete[](void *ptr) PROFILE_NOTHROW {
+  std::free(ptr);
+}
+
+#undef PROFILE_THROW_BAD_ALLOC
+#undef PROFILE_NOTHROW
+
+#endif /* defined(USE_PROFILE) && defined(PROFILE_MAIN) */
+
+#endif /* __PROFILE_H__ */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2020, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+/** @file
+ * @brief Persistent worker threads for data parallel loops
+ *
+ * ThreadPool::run(task, n) calls task(i) for i = 0, ..., n - 1, and returns
+ * after all of them are finished. The caller also works on the tasks,
+ * and the other threads are created once at construction and sleep between runs,
+ * therefore repetitive short loops, for example, batches of epochs, are cheap.
+ * A task must not throw an exception; it should catch and record errors by itself.
+ *
+ * Threads are used only when C++11 (or a compatible MSVC) is available
+ * and THREAD_POOL_WITHOUT_THREAD is not defined;
+ * otherwise the tasks are sequentially processed by the caller.
+ */
+
+#if !defined(THREAD_POOL_WITHOUT_THREAD) \
+    && ((__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1700)))
+#define THREAD_POOL_THREAD
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#endif
+
+class ThreadPool {
+  protected:
+    unsigned int threads; ///< number of threads including the caller
+#if defined(THREAD_POOL_THREAD)
+    typedef void (*invoker_t)(void *, const unsigned int &);
+    std::vector<std::thread> pool;
+    std::mutex mutex;
+    std::condition_variable cv_start, cv_finish;
+    invoker_t invoker;
+    void *task;
+    unsigned int next, total, finished; ///< task indices
+    unsigned long generation; ///< incremented at each run
+    bool quit;
+
+    template <class Task>
+    static void invoke(void *task, const unsigned int &i){
+      (*static_cast<Task *>(task))(i);
+    }
+
+    /**
+     * Process tasks of the current run until none remains
+     * @param lock locked on entry and exit, and unlocked during a task
+     */
+    void work(std::unique_lock<std::mutex> &lock){
+      while(next < total){
+        unsigned int i(next++);
+        lock.unlock();
+        invoker(task, i);
+        lock.lock();
+        if(++finished == total){cv_finish.notify_all();}
+      }
+    }
+
+    void loop(){
+      std::unique_lock<std::mutex> lock(mutex);
+      unsigned long generation_done(generation);
+      while(true){
+        cv_start.wait(lock, [&]{return quit || (generation != generation_done);});
+        if(quit){return;}
+        generation_done = generation;
+        work(lock);
+      }
+    }
+#endif
+
+  public:
+    /**
+     * Constructor
+     * @param threads_ number of threads including the caller of run();
+     * 0 means hardware concurrency
+     */
+    ThreadPool(const unsigned int &threads_ = 0)
+        : threads(threads_ > 0 ? threads_ : concurrency())
+#if defined(THREAD_POOL_THREAD)
+        , pool(), mutex(), cv_start(), cv_finish(),
+        invoker(NULL), task(NULL), next(0), total(0), finished(0), generation(0), quit(false)
+#endif
+        {
+#if defined(THREAD_POOL_THREAD)
+      for(unsigned int i(1); i < threads; ++i){
+        pool.push_back(std::thread(&ThreadPool::loop, this));
+      }
+#else
+      threads = 1;
+#endif
+    }
+
+    ~ThreadPool(){
+#if defined(THREAD_POOL_THREAD)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+      }
+      cv_start.notify_all();
+      for(unsigned int i(0); i < pool.size(); ++i){pool[i].join();}
+#endif
+    }
+
+    /**
+     * @return (unsigned int) number of threads including the caller
+     */
+    unsigned int size() const {return threads;}
+
+    /**
+     * Call task(i) for i = 0, ..., n - 1 in parallel, and wait for them.
+     * This is not reentrant; only one thread can call run() at a time.
+     * @param task functor having operator()(const unsigned int &)
+     * @param n number of tasks
+     */
+    template <class Task>
+    void run(Task &task, const unsigned int &n){
+#if defined(THREAD_POOL_THREAD)
+      if((threads > 1) && (n > 1)){
+        std::unique_lock<std::mutex> lock(mutex);
+        this->invoker = invoke<Task>;
+        this->task = &task;
+        next = finished = 0;
+        total = n;
+        ++generation;
+        cv_start.notify_all();
+        work(lock);
+        cv_finish.wait(lock, [&]{return finished == total;});
+        total = 0;
+        return;
+      }
+#endif
+      for(unsigned int i(0); i < n; ++i){task(i);}
+    }
+
+    /**
+     * Hardware concurrency hint
+     * @return (unsigned int) number of available cores, or 1 when unknown or without thread
+     */
+    static unsigned int concurrency(){
+#if defined(THREAD_POOL_THREAD)
+      unsigned int res(std::thread::hardware_concurrency());
+      return (res > 0) ? res : 1;
+#else
+      return 1;
+#endif
+    }
+
+  private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif /* __THREAD_POOL_H__ */